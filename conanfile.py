@@ -10,6 +10,7 @@ class LibarcConan(ConanFile):
         "fmt/9.1.0",
         "openssl/[~1.1.1q]",
         "libcurl/[~7.84.0]",
+        "zlib/[~1.2.13]",
     ]
     generators = "cmake", "cmake_find_package"
     options = {
@@ -32,7 +32,7 @@
 
 using namespace arc::http;
 
-void PrintRequest(const HttpRequest& request) {
+void PrintRequest(const OwnedHttpRequest& request) {
   std::cout << "request queries are: " << std::endl;
   for (const auto& [query_key, query_value] : request.queries) {
     std::cout << "\t" << query_key << ": " << query_value << std::endl;
@@ -60,7 +60,7 @@ void PrintResponse(const HttpResponse& response) {
 arc::coro::Task<void> InnerTask() {
   // %E5%A5%A5%E9%87%91%E6%96%A7
   HttpClient client({"tavern.blizzard.cn", 443});
-  HttpRequest request;
+  OwnedHttpRequest request;
   request.path = "/action/api/common/v3/wow/classic/meetinghorn/list";
   std::cout << request.path << std::endl;
   request.method = HttpMethod::HTTP_GET;
@@ -55,7 +55,7 @@ int main(int argc, char** argv) {
         std::cout << "\t" << request->http_major_version << "."
                   << request->http_minor_version << std::endl;
         std::cout << "query strings are: " << std::endl;
-        for (const auto& [query_key, query_value] : request->queries) {
+        for (const auto& [query_key, query_value] : request->GetQueries()) {
           std::cout << "\t" << query_key << ": " << query_value << std::endl;
         }
         std::cout << "headers are: " << std::endl;
@@ -76,12 +76,51 @@ int main(int argc, char** argv) {
          arc::http::HttpResponse* response,
          const arc::http::Context* context) -> arc::coro::Task<void> {
         std::cout << "get a RESTful request" << std::endl;
-        std::cout << request->RESTful_params.find("name")->second << std::endl;
-        std::cout << request->RESTful_params.find("id")->second << std::endl;
+        std::cout << *request->RESTful_params.Get("name") << std::endl;
+        std::cout << *request->RESTful_params.Get("id") << std::endl;
         // Mimic a long time function
         // co_await arc::coro::SleepFor(std::chrono::seconds(2));
         co_return;
       });
+  server.RegisterHandler(
+      "/upload", arc::http::HttpMethod::HTTP_POST,
+      [](const arc::http::HttpRequest* request,
+         arc::http::HttpResponse* response,
+         const arc::http::Context* context) -> arc::coro::Task<void> {
+        // bodies larger than HttpConfig::max_buffered_body_size are in a file
+        std::size_t body_size = request->body_file
+                                    ? request->body_file->GetSize()
+                                    : request->body.size();
+        response->body = "received " + std::to_string(body_size) + " bytes";
+        co_return;
+      });
+  server.RegisterHandler(
+      "/stream", arc::http::HttpMethod::HTTP_GET,
+      [](const arc::http::HttpRequest* request,
+         arc::http::HttpResponse* response,
+         const arc::http::Context* context) -> arc::coro::Task<void> {
+        // sent in chunks as they are written
+        response->headers["Content-Type"] = "text/plain";
+        for (int i = 0; i < 5; i++) {
+          if (!co_await context->writer->Write("line " + std::to_string(i) +
+                                               "\n")) {
+            co_return;
+          }
+          co_await arc::coro::SleepFor(std::chrono::milliseconds(100));
+        }
+      });
+  server.RegisterWebSocketHandler(
+      "/echo",
+      [](const arc::http::HttpRequest* request,
+         arc::http::WebSocket* websocket) -> arc::coro::Task<void> {
+        while (auto message = co_await websocket->Receive()) {
+          if (!co_await websocket->Send(message->data, message->opcode)) {
+            break;
+          }
+        }
+      });
+  // files under the working directory, e.g. /static/README.md
+  server.RegisterStaticHandler("/static", ".");
   server.Start();
   return 0;
 }
@@ -0,0 +1,214 @@
+/*
+ * File: async_generator.h
+ * Project: libarc
+ * File Created: Saturday, 17th October 2026 10:02:16 am
+ * Author: Minjun Xu (mjxu96@outlook.com)
+ * -----
+ * MIT License
+ * Copyright (c) 2020 Minjun Xu
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef LIBARC__CORO__ASYNC_GENERATOR_H
+#define LIBARC__CORO__ASYNC_GENERATOR_H
+
+#include <arc/coro/task.h>
+
+#ifdef __clang__
+#include <experimental/coroutine>
+namespace std {
+using experimental::coroutine_handle;
+}
+#else
+#include <coroutine>
+#endif
+#include <exception>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+
+namespace arc {
+namespace coro {
+
+template <typename T>
+class [[nodiscard]] AsyncGenerator;
+
+namespace detail {
+
+template <typename T>
+class AsyncGeneratorPromise : public PromiseBase {
+ public:
+  using ValueType = std::remove_reference_t<T>;
+
+  AsyncGeneratorPromise() = default;
+
+  AsyncGeneratorPromise* get_return_object() { return this; }
+
+  // hands the element over to the consumer, which resumes us when it wants
+  // the next one
+  auto yield_value(ValueType& value) {
+    value_ = std::addressof(value);
+    return FinalAwaiter{};
+  }
+
+  auto yield_value(ValueType&& value) {
+    value_ = std::addressof(value);
+    return FinalAwaiter{};
+  }
+
+  void unhandled_exception() { exception_ptr_ = std::current_exception(); }
+
+  void return_void() { value_ = nullptr; }
+
+  ValueType& Value() { return *value_; }
+
+  void RethrowIfFailed() {
+    if (exception_ptr_) {
+      std::rethrow_exception(exception_ptr_);
+    }
+  }
+
+ private:
+  ValueType* value_{nullptr};
+  std::exception_ptr exception_ptr_{nullptr};
+};
+
+}  // namespace detail
+
+// A coroutine producing a sequence of elements lazily with co_yield. It may
+// co_await anything a Task can in between. The consumer walks it with
+//
+//   auto gen = ReadRows();
+//   for (auto itr = co_await gen.begin(); itr != gen.end(); co_await ++itr) {
+//     Process(*itr);
+//   }
+//
+// A yielded element is only valid until the consumer asks for the next one.
+// Destroying the generator before it finishes is fine, as it is always
+// suspended at a co_yield while the consumer runs.
+template <typename T>
+class [[nodiscard]] AsyncGenerator {
+ public:
+  using promise_type = detail::AsyncGeneratorPromise<T>;
+  using ValueType = typename promise_type::ValueType;
+
+  class Iterator;
+
+  class [[nodiscard]] AdvanceAwaiter {
+   public:
+    AdvanceAwaiter(std::coroutine_handle<promise_type> coroutine)
+        : coroutine_(coroutine) {}
+
+    bool await_ready() { return !coroutine_ || coroutine_.done(); }
+
+    std::coroutine_handle<> await_suspend(
+        std::coroutine_handle<> continuation) {
+      coroutine_.promise().SetContinuation(continuation);
+      return coroutine_;
+    }
+
+    Iterator await_resume() {
+      if (coroutine_) {
+        coroutine_.promise().RethrowIfFailed();
+      }
+      return Iterator(coroutine_);
+    }
+
+   private:
+    std::coroutine_handle<promise_type> coroutine_{nullptr};
+  };
+
+  class Iterator {
+   public:
+    using iterator_category = std::input_iterator_tag;
+    using difference_type = std::ptrdiff_t;
+    using value_type = std::remove_cv_t<ValueType>;
+    using reference = ValueType&;
+    using pointer = ValueType*;
+
+    Iterator(std::coroutine_handle<promise_type> coroutine)
+        : coroutine_(coroutine) {}
+
+    // the iterator becomes equal to end() once the generator finishes
+    AdvanceAwaiter operator++() { return AdvanceAwaiter(coroutine_); }
+
+    reference operator*() const { return coroutine_.promise().Value(); }
+
+    pointer operator->() const {
+      return std::addressof(coroutine_.promise().Value());
+    }
+
+    bool operator==(const Iterator& other) const {
+      if (IsEnd() || other.IsEnd()) {
+        return IsEnd() == other.IsEnd();
+      }
+      return coroutine_ == other.coroutine_;
+    }
+
+    bool operator!=(const Iterator& other) const { return !(*this == other); }
+
+   private:
+    inline bool IsEnd() const { return !coroutine_ || coroutine_.done(); }
+
+    std::coroutine_handle<promise_type> coroutine_{nullptr};
+  };
+
+  AsyncGenerator(promise_type* promise)
+      : coroutine_(
+            std::coroutine_handle<promise_type>::from_promise(*promise)) {}
+
+  AsyncGenerator(AsyncGenerator&& other) : coroutine_(other.coroutine_) {
+    other.coroutine_ = nullptr;
+  }
+
+  AsyncGenerator(const AsyncGenerator&) = delete;
+
+  ~AsyncGenerator() {
+    if (coroutine_) {
+      coroutine_.destroy();
+    }
+  }
+
+  AsyncGenerator& operator=(AsyncGenerator&& other) {
+    if (std::addressof(other) != this) {
+      if (coroutine_) {
+        coroutine_.destroy();
+      }
+      coroutine_ = other.coroutine_;
+      other.coroutine_ = nullptr;
+    }
+    return *this;
+  }
+
+  AsyncGenerator& operator=(const AsyncGenerator& other) = delete;
+
+  // runs the generator until its first element
+  AdvanceAwaiter begin() { return AdvanceAwaiter(coroutine_); }
+
+  Iterator end() { return Iterator(nullptr); }
+
+ private:
+  std::coroutine_handle<promise_type> coroutine_{nullptr};
+};
+
+}  // namespace coro
+}  // namespace arc
+
+#endif /* LIBARC__CORO__ASYNC_GENERATOR_H */
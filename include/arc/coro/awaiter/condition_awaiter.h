@@ -145,9 +145,7 @@ class [[nodiscard]] ConditionAwaiter {
       : core_(core),
         lock_core_(lock_core),
         abort_handle_(
-            std::chrono::duration_cast<std::chrono::milliseconds>(
-                (std::chrono::steady_clock::now() + timeout).time_since_epoch())
-                .count()) {}
+            ToTimeEventTime(std::chrono::steady_clock::now() + timeout)) {}
 
   bool await_ready() { return false; }
 
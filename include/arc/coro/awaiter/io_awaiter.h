@@ -31,58 +31,110 @@
 
 #include <arc/concept/coro.h>
 #include <arc/coro/eventloop.h>
+#include <arc/coro/events/completion_event.h>
 #include <arc/coro/events/io_event.h>
 #include <arc/coro/events/timeout_event.h>
 #include <arc/coro/utils/cancellation_token.h>
 #include <arc/exception/io.h>
 
+#include <cerrno>
 #include <functional>
+#include <optional>
 #include <variant>
 
 namespace arc {
 namespace coro {
 
+// ReadyFunctor either returns a bool, or an std::optional of the resume
+// result when it already performed the io itself, in which case that result
+// is returned without suspending.
+//
+// Given a CompletionOp, an event loop that IsCompletionBased() leaves the
+// whole io to the kernel instead and the functors are not called. Its result
+// is then that of the op, or -1 with errno set, which is EAGAIN if the op is
+// interrupted before doing anything, as what the functors would report.
 template <typename ReadyFunctor, typename ResumeFunctor>
 class [[nodiscard]] IOAwaiter {
+  using ResultType = std::invoke_result_t<ResumeFunctor>;
+  constexpr static bool kIsEagerReady_ =
+      std::is_same_v<std::invoke_result_t<ReadyFunctor>,
+                     std::optional<ResultType>>;
+
  public:
   IOAwaiter(ReadyFunctor&& ready_functor, ResumeFunctor&& resume_functor,
-            int fd, io::IOType io_type)
+            int fd, io::IOType io_type,
+            std::optional<CompletionOp> completion_op = std::nullopt)
       : ready_functor_(std::forward<ReadyFunctor>(ready_functor)),
         resume_functor_(std::forward<ResumeFunctor>(resume_functor)),
         resume_interrupted_functor_(resume_functor_),
         fd_(fd),
-        io_type_(io_type) {}
+        io_type_(io_type),
+        completion_op_(completion_op) {}
 
   IOAwaiter(ReadyFunctor&& ready_functor, ResumeFunctor&& resume_functor,
             ResumeFunctor&& resume_interrucpted_functor, int fd,
-            io::IOType io_type, const CancellationToken& token)
+            io::IOType io_type, const CancellationToken& token,
+            std::optional<CompletionOp> completion_op = std::nullopt)
       : ready_functor_(std::forward<ReadyFunctor>(ready_functor)),
         resume_interrupted_functor_(
             std::forward<ResumeFunctor>(resume_interrucpted_functor)),
         resume_functor_(std::forward<ResumeFunctor>(resume_functor)),
         fd_(fd),
         io_type_(io_type),
-        abort_handle_(std::make_shared<CancellationToken>(token)) {}
+        abort_handle_(std::make_shared<CancellationToken>(token)),
+        completion_op_(completion_op) {}
 
   IOAwaiter(ReadyFunctor&& ready_functor, ResumeFunctor&& resume_functor,
             ResumeFunctor&& resume_interrucpted_functor, int fd,
             io::IOType io_type,
-            const std::chrono::steady_clock::duration& sleep_time)
+            const std::chrono::steady_clock::duration& sleep_time,
+            std::optional<CompletionOp> completion_op = std::nullopt)
       : ready_functor_(std::forward<ReadyFunctor>(ready_functor)),
         resume_interrupted_functor_(
             std::forward<ResumeFunctor>(resume_interrucpted_functor)),
         resume_functor_(std::forward<ResumeFunctor>(resume_functor)),
         fd_(fd),
         io_type_(io_type),
-        abort_handle_(std::chrono::duration_cast<std::chrono::milliseconds>(
-                          (std::chrono::steady_clock::now() + sleep_time)
-                              .time_since_epoch())
-                          .count()) {}
-
-  bool await_ready() { return ready_functor_(); }
+        abort_handle_(
+            ToTimeEventTime(std::chrono::steady_clock::now() + sleep_time)),
+        completion_op_(completion_op) {}
+
+  bool await_ready() {
+    if constexpr (std::is_integral_v<ResultType>) {
+      if (completion_op_.has_value() &&
+          EventLoop::GetLocalInstance().IsCompletionBased()) {
+        is_completion_based_ = true;
+        return false;
+      }
+    }
+    if constexpr (kIsEagerReady_) {
+      eager_result_ = ready_functor_();
+      return eager_result_.has_value();
+    } else {
+      return ready_functor_();
+    }
+  }
 
-  typename std::invoke_result_t<ResumeFunctor> await_resume() {
-    if (abort_handle_.index() != 0 && io_event_->IsInterrupted()) [[unlikely]] {
+  ResultType await_resume() {
+    if constexpr (kIsEagerReady_) {
+      if (eager_result_.has_value()) {
+        return std::move(*eager_result_);
+      }
+    }
+    if constexpr (std::is_integral_v<ResultType>) {
+      if (is_completion_based_) {
+        int result = static_cast<CompletionEvent*>(io_event_)->GetResult();
+        if (result >= 0) {
+          return result;
+        }
+        errno = (result == -ECANCELED && io_event_->IsInterrupted())
+                    ? EAGAIN
+                    : -result;
+        return -1;
+      }
+    }
+    if (abort_handle_.index() != 0 && io_event_ &&
+        io_event_->IsInterrupted()) [[unlikely]] {
       return resume_interrupted_functor_();
     }
     return resume_functor_();
@@ -90,9 +142,16 @@ class [[nodiscard]] IOAwaiter {
 
   template <arc::concepts::PromiseT PromiseType>
   void await_suspend(std::coroutine_handle<PromiseType> handle) {
-    io_event_ = new coro::IOEvent(fd_, io_type_, handle);
     auto event_loop = &EventLoop::GetLocalInstance();
-    event_loop->AddIOEvent(io_event_);
+    if (is_completion_based_) {
+      auto completion_event =
+          new coro::CompletionEvent(fd_, io_type_, handle, *completion_op_);
+      event_loop->AddCompletionEvent(completion_event);
+      io_event_ = completion_event;
+    } else {
+      io_event_ = new coro::IOEvent(fd_, io_type_, handle);
+      event_loop->AddIOEvent(io_event_);
+    }
     if (abort_handle_.index() == 1) [[unlikely]] {
       auto cancellation_event = new coro::CancellationEvent(io_event_);
       std::get<1>(abort_handle_)
@@ -116,6 +175,12 @@ class [[nodiscard]] IOAwaiter {
       abort_handle_;
 
   IOEvent* io_event_{nullptr};
+
+  std::optional<CompletionOp> completion_op_{};
+  bool is_completion_based_{false};
+
+  std::conditional_t<kIsEagerReady_, std::optional<ResultType>, std::monostate>
+      eager_result_{};
 };
 
 }  // namespace coro
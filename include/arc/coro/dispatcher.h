@@ -44,8 +44,10 @@ using experimental::suspend_never;
 #else
 #include <coroutine>
 #endif
+#include <algorithm>
 #include <atomic>
 #include <condition_variable>
+#include <cstdint>
 #include <iostream>
 #include <mutex>
 #include <unordered_map>
@@ -68,14 +70,48 @@ class CoroutineConsumerToken {
   moodycamel::ConsumerToken token;
 };
 
-// MPSC queue
+enum class ConsumerPolicy {
+  // only runs coroutines dispatched to itself
+  NO_STEALING = 0U,
+  // steals coroutines from other work stealing consumers when idle, and lets
+  // them steal the ones dispatched to any consumer from itself
+  WORK_STEALING,
+};
+
+enum class DispatchPolicy {
+  ROUND_ROBIN = 0U,
+  // the less loaded one of two randomly picked consumers
+  POWER_OF_TWO_CHOICES,
+  // the least loaded one of all consumers
+  LEAST_LOADED,
+};
+
+// MPSC queue, MPMC for the items which can be stolen by other consumers
 class CoroutineQueue {
  public:
   CoroutineQueue(int capacity, int max_explicit_producer_count,
-                 int max_implicit_producer_count, EventLoopWakeUpHandle id)
+                 int max_implicit_producer_count, EventLoopWakeUpHandle id,
+                 ConsumerPolicy policy = ConsumerPolicy::NO_STEALING,
+                 std::atomic<bool>* is_consumer_sleeping = nullptr)
       : queue_(capacity, max_explicit_producer_count,
                max_implicit_producer_count),
-        token_(queue_, id) {}
+        token_(queue_, id),
+        policy_(policy),
+        is_consumer_sleeping_(is_consumer_sleeping) {
+    if (policy_ == ConsumerPolicy::WORK_STEALING) {
+      // coroutines dispatched to this consumer specifically are never stolen
+      pinned_queue_ =
+          new moodycamel::ConcurrentQueue<std::coroutine_handle<void>>(
+              capacity, max_explicit_producer_count,
+              max_implicit_producer_count);
+      pinned_token_ = new moodycamel::ConsumerToken(*pinned_queue_);
+    }
+  }
+
+  ~CoroutineQueue() {
+    delete pinned_token_;
+    delete pinned_queue_;
+  }
 
   inline bool Enqueue(std::coroutine_handle<void>&& item) {
     bool ret = queue_.try_enqueue(item);
@@ -94,6 +130,29 @@ class CoroutineQueue {
     return ret;
   }
 
+  inline bool EnqueuePinned(std::coroutine_handle<void>&& item) {
+    if (!pinned_queue_) {
+      return Enqueue(std::move(item));
+    }
+    bool ret = pinned_queue_->try_enqueue(item);
+    if (ret) {
+      pinned_items_.fetch_add(1, std::memory_order::release);
+    }
+    return ret;
+  }
+
+  template <typename It>
+  inline bool EnqueuePinnedBulk(It it, int count) {
+    if (!pinned_queue_) {
+      return EnqueueBulk(it, count);
+    }
+    bool ret = pinned_queue_->try_enqueue_bulk(it, count);
+    if (ret) {
+      pinned_items_.fetch_add(count, std::memory_order::release);
+    }
+    return ret;
+  }
+
   inline bool Deque(std::coroutine_handle<void>&& item) {
     bool ret = queue_.try_dequeue(token_.token, item);
     if (ret) {
@@ -109,6 +168,7 @@ class CoroutineQueue {
     return ret;
   }
 
+  // May return less than count items if some of them have been stolen
   std::vector<std::coroutine_handle<void>> DequeAll(int count) {
     if (count <= 0) {
       return std::vector<std::coroutine_handle<void>>();
@@ -116,204 +176,343 @@ class CoroutineQueue {
     std::vector<std::coroutine_handle<void>> ret(count, 0);
     std::coroutine_handle<void>* now = &ret[0];
     int remained_size = count;
+    if (pinned_queue_) {
+      int pinned_size =
+          std::min(pinned_items_.load(std::memory_order::acquire), count);
+      int remained_pinned_size = pinned_size;
+      while (remained_pinned_size > 0) {
+        std::size_t this_size = pinned_queue_->try_dequeue_bulk(
+            *pinned_token_, now, remained_pinned_size);
+        now += this_size;
+        remained_pinned_size -= this_size;
+      }
+      pinned_items_.fetch_add(-pinned_size, std::memory_order::release);
+      remained_size -= pinned_size;
+    }
+    int stealable_size = remained_size;
     while (remained_size > 0) {
       std::size_t this_size =
           queue_.try_dequeue_bulk(token_.token, now, remained_size);
+      if (this_size == 0 && pinned_queue_) {
+        // stolen by others, the rest (if any) is left to the next round
+        break;
+      }
       now += this_size;
       remained_size -= this_size;
     }
-    remained_items_.fetch_add(-count, std::memory_order::release);
+    remained_items_.fetch_add(-(stealable_size - remained_size),
+                              std::memory_order::release);
+    ret.resize(count - remained_size);
+    return ret;
+  }
+
+  // Called by other consumers, takes at most half of the stealable items
+  inline std::size_t StealBulk(std::coroutine_handle<void>* it, int count) {
+    count = std::min(count, (GetStealableItemsCount() + 1) / 2);
+    if (count <= 0) {
+      return 0;
+    }
+    std::size_t ret = queue_.try_dequeue_bulk(it, count);
+    remained_items_.fetch_add(-static_cast<int>(ret),
+                              std::memory_order::release);
     return ret;
   }
 
   inline int GetRemainedItemsCount() {
+    return remained_items_.load(std::memory_order::acquire) +
+           pinned_items_.load(std::memory_order::acquire);
+  }
+
+  inline int GetStealableItemsCount() {
+    if (policy_ != ConsumerPolicy::WORK_STEALING) {
+      return 0;
+    }
     return remained_items_.load(std::memory_order::acquire);
   }
 
+  inline ConsumerPolicy GetPolicy() const { return policy_; }
+
+  // Called by the consumer once per loop iteration
+  inline void ReportLoad(int io_events_count,
+                         std::int64_t average_iteration_time) {
+    io_events_count_.store(io_events_count, std::memory_order::relaxed);
+    average_iteration_time_.store(average_iteration_time,
+                                  std::memory_order::relaxed);
+  }
+
+  // Rough time in microseconds before a newly enqueued coroutine gets run,
+  // assuming each queued coroutine or in flight io event takes an iteration
+  inline std::int64_t GetLoad() {
+    std::int64_t pending_count =
+        GetRemainedItemsCount() +
+        io_events_count_.load(std::memory_order::relaxed) + 1;
+    return pending_count *
+           (average_iteration_time_.load(std::memory_order::relaxed) + 1);
+  }
+
+  // A parked consumer does not try to steal until it is woken up by the
+  // dispatcher.
+  inline bool IsParked() const {
+    return is_parked_.load(std::memory_order::acquire);
+  }
+
+  inline void SetParked(bool is_parked) { is_parked_.store(is_parked); }
+
+  // returns true if it was parked
+  inline bool TryUnpark() { return is_parked_.exchange(false); }
+
+  // Returns false if the consumer is awake and will find what has been
+  // enqueued before this call without being notified.
+  inline bool TakeWakeUp() {
+    if (!is_consumer_sleeping_) {
+      return true;
+    }
+    // pairs with the one in Poller::SetSleeping()
+    std::atomic_thread_fence(std::memory_order::seq_cst);
+    return is_consumer_sleeping_->exchange(false);
+  }
+
   friend class CoroutineConsumerToken;
 
  private:
   moodycamel::ConcurrentQueue<std::coroutine_handle<void>> queue_;
   CoroutineConsumerToken token_;
   std::atomic<int> remained_items_{0};
+
+  const ConsumerPolicy policy_;
+  moodycamel::ConcurrentQueue<std::coroutine_handle<void>>* pinned_queue_{
+      nullptr};
+  moodycamel::ConsumerToken* pinned_token_{nullptr};
+  std::atomic<int> pinned_items_{0};
+  std::atomic<bool> is_parked_{true};
+  std::atomic<bool>* is_consumer_sleeping_{nullptr};
+
+  // load reported by the consumer
+  std::atomic<int> io_events_count_{0};
+  std::atomic<std::int64_t> average_iteration_time_{0};
 };
 
-class CoroutineDispatcher {
- public:
-  CoroutineDispatcher()
-      : kMaxAllowedProducerCount_(std::thread::hardware_concurrency()) {
-    queues_.reserve(kMaxInVecQueueCount_);
-    for (int i = 0; i < kMaxInVecQueueCount_; i++) {
-      queues_.push_back(nullptr);
-    }
-  }
+namespace detail {
+
+// An immutable snapshot of the registered consumers. It is replaced as a whole
+// on every registration so that producers can read it without any lock.
+struct ConsumerTable {
+  ConsumerTable(int in_vec_queue_count) : queues(in_vec_queue_count, nullptr) {}
 
-  ~CoroutineDispatcher() {
-    for (EventLoopWakeUpHandle id : consumer_ids_) {
-      auto queue_ptr = GetCoroutineQueue(id);
-      assert(queue_ptr != nullptr);
-      delete queue_ptr;
+  inline CoroutineQueue* GetCoroutineQueue(EventLoopWakeUpHandle id) const {
+    if (id < static_cast<int>(queues.size())) [[likely]] {
+      return queues[id];
     }
+    auto itr = extra_queues.find(id);
+    return itr == extra_queues.end() ? nullptr : itr->second;
   }
 
+  std::vector<CoroutineQueue*> queues;
+  std::unordered_map<EventLoopWakeUpHandle, CoroutineQueue*> extra_queues;
+  std::vector<EventLoopWakeUpHandle> consumer_ids;
+  std::vector<EventLoopWakeUpHandle> stealer_ids;
+};
+
+}  // namespace detail
+
+class CoroutineDispatcher {
+ public:
+  CoroutineDispatcher();
+  ~CoroutineDispatcher();
+
   static CoroutineDispatcher& GetInstance();
 
   std::vector<EventLoopWakeUpHandle> GetAvailableDispatchDestinations() {
-    std::lock_guard guard(global_addition_lock_);
-    return consumer_ids_;
+    TableReadGuard table(*this);
+    return table->consumer_ids;
   }
 
-  bool EnqueueToAny(std::coroutine_handle<void>&& handle) {
-    std::lock_guard guard(global_addition_lock_);
-    EventLoopWakeUpHandle next_consumer_id = GetNextConsumer();
-    auto queue_ptr = GetCoroutineQueue(next_consumer_id);
+  bool EnqueueToAny(std::coroutine_handle<void>&& handle,
+                    DispatchPolicy policy = DispatchPolicy::ROUND_ROBIN) {
+    TableReadGuard table(*this);
+    EventLoopWakeUpHandle next_consumer_id =
+        GetNextConsumer(table.Get(), policy);
+    auto queue_ptr = table->GetCoroutineQueue(next_consumer_id);
     bool ret = queue_ptr->Enqueue(std::move(handle));
     if (ret) {
-      NotifyEventLoop(next_consumer_id, 1);
+      NotifyEventLoop(next_consumer_id, queue_ptr, 1);
+      WakeUpStealer(table.Get(), next_consumer_id, queue_ptr);
     }
     return ret;
   }
 
   bool EnqueueToSpecific(EventLoopWakeUpHandle consumer_id,
                          std::coroutine_handle<void>&& handle) {
-    std::lock_guard guard(global_addition_lock_);
-    auto queue_ptr = GetCoroutineQueue(consumer_id);
-    bool ret = queue_ptr->Enqueue(std::move(handle));
+    TableReadGuard table(*this);
+    auto queue_ptr = GetRegisteredCoroutineQueue(table.Get(), consumer_id);
+    bool ret = queue_ptr->EnqueuePinned(std::move(handle));
     if (ret) {
-      NotifyEventLoop(consumer_id, 1);
+      NotifyEventLoop(consumer_id, queue_ptr, 1);
     }
     return ret;
   }
 
   template <typename It>
-  bool EnqueueAllToAny(It it, int count) {
-    std::lock_guard guard(global_addition_lock_);
-    return EnqueueAllToAnyNoLock(it, count);
+  bool EnqueueAllToAny(It it, int count,
+                       DispatchPolicy policy = DispatchPolicy::ROUND_ROBIN) {
+    TableReadGuard table(*this);
+    return EnqueueAllToAny(table.Get(), it, count, policy);
   }
 
   template <typename It>
   bool EnqueueAllToSpecific(EventLoopWakeUpHandle consumer_id, It it,
                             int count) {
-    std::lock_guard guard(global_addition_lock_);
-    auto queue_ptr = GetCoroutineQueue(consumer_id);
-    bool ret = queue_ptr->EnqueueBulk(it, count);
+    TableReadGuard table(*this);
+    auto queue_ptr = GetRegisteredCoroutineQueue(table.Get(), consumer_id);
+    bool ret = queue_ptr->EnqueuePinnedBulk(it, count);
     if (ret) {
-      NotifyEventLoop(consumer_id, count);
+      NotifyEventLoop(consumer_id, queue_ptr, count);
     }
     return ret;
   }
 
-  CoroutineQueue* Register(EventLoopWakeUpHandle consumer_id) {
-    std::lock_guard guard(global_addition_lock_);
-    bool existed = consumer_id < kMaxInVecQueueCount_
-                       ? queues_[consumer_id] != nullptr
-                       : extra_queues_.find(consumer_id) != extra_queues_.end();
-    if (existed) {
-      throw arc::exception::detail::ExceptionBase(
-          "Consumer id " + std::to_string(consumer_id) +
-          " has already been registered.");
-    }
+  CoroutineQueue* Register(
+      EventLoopWakeUpHandle consumer_id,
+      ConsumerPolicy policy = ConsumerPolicy::NO_STEALING,
+      std::atomic<bool>* is_consumer_sleeping = nullptr);
 
-    auto queue_ptr = new CoroutineQueue(kCoroutineQueueDefaultSize_, 0,
-                                        kMaxAllowedProducerCount_, consumer_id);
-    if (consumer_id < kMaxInVecQueueCount_) {
-      queues_[consumer_id] = queue_ptr;
-    } else {
-      extra_queues_[consumer_id] = queue_ptr;
-    }
-    consumer_ids_.push_back(consumer_id);
-    consumer_id_itr_ = consumer_ids_.begin();
-    return queue_ptr;
-  }
+  void DeRegister(EventLoopWakeUpHandle consumer_id);
 
-  void DeRegister(EventLoopWakeUpHandle consumer_id) {
-    std::lock_guard guard(global_addition_lock_);
-    bool existed = consumer_id < kMaxInVecQueueCount_
-                       ? queues_[consumer_id] != nullptr
-                       : extra_queues_.find(consumer_id) != extra_queues_.end();
-    if (!existed) {
-      throw arc::exception::detail::ExceptionBase(
-          "Consumer id " + std::to_string(consumer_id) +
-          " has not been registered before.");
+  // Steals coroutines from the most loaded work stealing consumer other than
+  // the thief. The thief gets parked if there is nothing to steal.
+  std::vector<std::coroutine_handle<void>> Steal(
+      EventLoopWakeUpHandle thief_id);
+
+ private:
+  constexpr static int kCoroutineQueueDefaultSize_ = 1024;
+  constexpr static int kMaxInVecQueueCount_ = 512;
+  constexpr static int kMaxStealCount_ = 64;
+  constexpr static int kReaderCounterCount_ = 32;
+
+  // Readers of the consumer table count themselves in the counter of the
+  // current epoch, spread over several cache lines to avoid contention.
+  struct alignas(64) ReaderCounter {
+    std::atomic<int> counts[2] = {0, 0};
+  };
+
+  class TableReadGuard {
+   public:
+    explicit TableReadGuard(CoroutineDispatcher& dispatcher) {
+      unsigned int epoch = dispatcher.epoch_.load();
+      count_ = &dispatcher.reader_counters_[GetReaderCounterIndex()]
+                    .counts[epoch & 1];
+      count_->fetch_add(1);
+      table_ = dispatcher.table_.load();
     }
 
-    auto queue_ptr = GetCoroutineQueue(consumer_id);
-    auto coroutines = queue_ptr->DequeAll(queue_ptr->GetRemainedItemsCount());
+    ~TableReadGuard() { count_->fetch_sub(1); }
 
-    if (consumer_id < kMaxInVecQueueCount_) {
-      delete queues_[consumer_id];
-      queues_[consumer_id] = nullptr;
-    } else {
-      delete extra_queues_[consumer_id];
-      extra_queues_.erase(consumer_id);
-    }
+    TableReadGuard(const TableReadGuard&) = delete;
+    TableReadGuard& operator=(const TableReadGuard&) = delete;
 
-    for (auto itr = consumer_ids_.begin(); itr != consumer_ids_.end(); itr++) {
-      if (*itr == consumer_id) {
-        consumer_id_itr_ = consumer_ids_.erase(itr);
-        if (consumer_id_itr_ == consumer_ids_.end()) {
-          consumer_id_itr_ = consumer_ids_.begin();
-        }
-        break;
-      }
-    }
+    inline const detail::ConsumerTable* Get() const { return table_; }
+    inline const detail::ConsumerTable* operator->() const { return table_; }
 
-    if (!consumer_ids_.empty() && !coroutines.empty()) {
-      EnqueueAllToAnyNoLock(coroutines.begin(), coroutines.size());
-    }
-  }
+   private:
+    std::atomic<int>* count_{nullptr};
+    const detail::ConsumerTable* table_{nullptr};
+  };
 
- private:
-  void NotifyEventLoop(EventLoopWakeUpHandle id, std::uint64_t count) {
+  static int GetReaderCounterIndex();
+
+  // Replaces the consumer table and waits until no reader can see the old one
+  void UpdateTable(detail::ConsumerTable* table);
+
+  void NotifyEventLoop(EventLoopWakeUpHandle id, CoroutineQueue* queue_ptr,
+                       std::uint64_t count) {
+    if (!queue_ptr->TakeWakeUp()) {
+      return;
+    }
     int wrote = write(id, &count, sizeof(count));
     if (wrote < 0) {
       throw arc::exception::IOException("Notify EventLoop Error");
     }
   }
 
+  // The consumer may be too busy to run what was just enqueued, so let one
+  // parked stealer have a try. A stealer is woken up at most once until it
+  // fails to steal and gets parked again.
+  void WakeUpStealer(const detail::ConsumerTable* table,
+                     EventLoopWakeUpHandle consumer_id,
+                     CoroutineQueue* queue_ptr) {
+    if (queue_ptr->GetPolicy() != ConsumerPolicy::WORK_STEALING) {
+      return;
+    }
+    // pairs with the one in Steal() so that either the stealer sees what was
+    // just enqueued, or we see that it has been parked
+    std::atomic_thread_fence(std::memory_order::seq_cst);
+    for (EventLoopWakeUpHandle id : table->stealer_ids) {
+      auto stealer_queue_ptr = table->GetCoroutineQueue(id);
+      if (id != consumer_id && stealer_queue_ptr->TryUnpark()) {
+        NotifyEventLoop(id, stealer_queue_ptr, 1);
+        return;
+      }
+    }
+  }
+
   template <typename It>
-  bool EnqueueAllToAnyNoLock(It it, int count) {
-    EventLoopWakeUpHandle next_consumer_id = GetNextConsumer();
-    auto queue_ptr = GetCoroutineQueue(next_consumer_id);
+  bool EnqueueAllToAny(const detail::ConsumerTable* table, It it, int count,
+                       DispatchPolicy policy = DispatchPolicy::ROUND_ROBIN) {
+    EventLoopWakeUpHandle next_consumer_id = GetNextConsumer(table, policy);
+    auto queue_ptr = table->GetCoroutineQueue(next_consumer_id);
     bool ret = queue_ptr->EnqueueBulk(it, count);
     if (ret) {
-      NotifyEventLoop(next_consumer_id, count);
+      NotifyEventLoop(next_consumer_id, queue_ptr, count);
+      WakeUpStealer(table, next_consumer_id, queue_ptr);
     }
     return ret;
   }
 
-  EventLoopWakeUpHandle GetNextConsumer() {
-    if (consumer_ids_.empty()) {
+  EventLoopWakeUpHandle GetNextConsumer(const detail::ConsumerTable* table,
+                                        DispatchPolicy policy) {
+    if (table->consumer_ids.empty()) {
       throw arc::exception::detail::ExceptionBase("No consumer available");
     }
-    EventLoopWakeUpHandle next_consumer_id = *consumer_id_itr_;
-    consumer_id_itr_++;
-    if (consumer_id_itr_ == consumer_ids_.end()) {
-      consumer_id_itr_ = consumer_ids_.begin();
+    switch (policy) {
+      case DispatchPolicy::POWER_OF_TWO_CHOICES:
+        return GetLessLoadedOfTwoConsumers(table);
+      case DispatchPolicy::LEAST_LOADED:
+        return GetLeastLoadedConsumer(table);
+      default:
+        break;
     }
-    return next_consumer_id;
+    unsigned int index =
+        next_consumer_index_.fetch_add(1, std::memory_order::relaxed);
+    return table->consumer_ids[index % table->consumer_ids.size()];
   }
 
-  CoroutineQueue* GetCoroutineQueue(EventLoopWakeUpHandle id) {
-    if (id < kMaxInVecQueueCount_) [[likely]] {
-      assert(queues_[id]);
-      return queues_[id];
+  EventLoopWakeUpHandle GetLessLoadedOfTwoConsumers(
+      const detail::ConsumerTable* table);
+  EventLoopWakeUpHandle GetLeastLoadedConsumer(
+      const detail::ConsumerTable* table);
+
+  CoroutineQueue* GetRegisteredCoroutineQueue(
+      const detail::ConsumerTable* table, EventLoopWakeUpHandle id) {
+    auto queue_ptr = table->GetCoroutineQueue(id);
+    if (!queue_ptr) [[unlikely]] {
+      throw arc::exception::detail::ExceptionBase(
+          "Consumer id " + std::to_string(id) + " has not been registered.");
     }
-    assert(extra_queues_[id]);
-    return extra_queues_[id];
+    return queue_ptr;
   }
 
-  std::mutex global_addition_lock_;
+  std::vector<std::coroutine_handle<void>> TrySteal(
+      const detail::ConsumerTable* table, EventLoopWakeUpHandle thief_id);
 
   const int kMaxAllowedProducerCount_;
 
-  constexpr static int kCoroutineQueueDefaultSize_ = 1024;
-  constexpr static int kMaxInVecQueueCount_ = 512;
-  std::vector<CoroutineQueue*> queues_;
-  std::unordered_map<EventLoopWakeUpHandle, CoroutineQueue*> extra_queues_;
+  std::atomic<detail::ConsumerTable*> table_{nullptr};
+  std::atomic<unsigned int> epoch_{0};
+  ReaderCounter reader_counters_[kReaderCounterCount_];
+  std::atomic<unsigned int> next_consumer_index_{0};
 
-  std::vector<EventLoopWakeUpHandle> consumer_ids_;
-  std::vector<EventLoopWakeUpHandle>::iterator consumer_id_itr_;
+  // only serializes registrations, producers never take it
+  std::mutex table_update_lock_;
 };
 
 }  // namespace coro
@@ -50,6 +50,7 @@ using experimental::coroutine_handle;
 #else
 #include <coroutine>
 #endif
+#include <atomic>
 #include <list>
 #include <vector>
 
@@ -77,10 +78,41 @@ class EventLoop {
 
   static EventLoop& GetLocalInstance();
 
+  // only affects event loops created after this call
+  static void SetDefaultPollerBackend(PollerBackend backend);
+
+  inline PollerBackend GetPollerBackend() const {
+    return poller_->GetBackend();
+  }
+
+  // only affects event loops created after this call
+  static void SetDefaultTimerBackend(TimerBackend backend);
+
+  inline TimerBackend GetTimerBackend() const {
+    return poller_->GetTimerBackend();
+  }
+
+  // with the io_uring backend on kernels with fast poll, see
+  // Poller::IsCompletionBased()
+  inline bool IsCompletionBased() const {
+    return poller_->IsCompletionBased();
+  }
+
   inline EventLoopID GetEventLoopID() { return id_; }
 
+  // The steady clock as read once per loop iteration, right after waking up.
+  // Cheaper than steady_clock::now() but behind it by the time the resumed
+  // coroutines have been running.
+  inline std::chrono::steady_clock::time_point Now() const {
+    return poller_->GetCurrentTime();
+  }
+
   inline void AddIOEvent(coro::IOEvent* event) { poller_->AddIOEvent(event); }
 
+  inline void AddCompletionEvent(coro::CompletionEvent* event) {
+    poller_->AddCompletionEvent(event);
+  }
+
   inline void AddTimeEvent(coro::TimeEvent* event) {
     poller_->AddTimeEvent(event);
   }
@@ -95,6 +127,14 @@ class EventLoop {
 
   inline void RemoveAllIOEvents(int fd) { poller_->RemoveAllIOEvents(fd); }
 
+  inline bool IsIOReady(int fd, io::IOType event_type) {
+    return poller_->IsIOReady(fd, event_type);
+  }
+
+  inline void ResetIOReady(int fd, io::IOType event_type) {
+    poller_->ResetIOReady(fd, event_type);
+  }
+
   inline coro::EventLoopWakeUpHandle GetEventHandle() const {
     return poller_->GetEventHandle();
   }
@@ -110,10 +150,13 @@ class EventLoop {
   void AddToCleanUpCoroutine(std::coroutine_handle<> handle);
   void CleanUpFinishedCoroutines();
 
-  void Dispatch(Task<void>&& task);
+  void Dispatch(Task<void>&& task,
+                DispatchPolicy policy = DispatchPolicy::ROUND_ROBIN);
   void DispatchTo(Task<void>&& task, EventLoopWakeUpHandle event_loop_id);
 
-  void ResigerConsumer();
+  // A work stealing consumer runs coroutines dispatched to other work stealing
+  // consumers when it has nothing else to do.
+  void ResigerConsumer(ConsumerPolicy policy = ConsumerPolicy::NO_STEALING);
   void DeResigerConsumer();
   void ResigerProducer();
   void DeResigerProducer();
@@ -121,6 +164,10 @@ class EventLoop {
  private:
   EventLoop();
   void Trim();
+  bool HasPendingWakeUp();
+
+  static std::atomic<PollerBackend> default_poller_backend_;
+  static std::atomic<TimerBackend> default_timer_backend_;
 
   Poller* poller_{nullptr};
 
@@ -130,6 +177,7 @@ class EventLoop {
 
   const static int kMaxEventsSizePerWait_ = Poller::kMaxEventsSizePerWait;
   const static int kMaxConsumableCoroutineNum_ = 4;
+  const static int kLoadAverageWeight_ = 8;
 
   // poller related
   coro::EventBase* todo_events_[2 * kMaxEventsSizePerWait_] = {nullptr};
@@ -138,14 +186,21 @@ class EventLoop {
 
   // dispatched events
   std::list<std::coroutine_handle<>> to_randomly_dispatched_coroutines_{};
+  std::list<std::pair<std::coroutine_handle<>, DispatchPolicy>>
+      to_load_aware_dispatched_coroutines_{};
   std::unordered_map<EventLoopWakeUpHandle, std::list<std::coroutine_handle<>>>
       to_dispatched_coroutines_with_dests_{};
   int to_dispatched_coroutines_count_{0};
   EventLoopWakeUpHandle register_id_{-1};
   EventLoopType event_loop_type_{EventLoopType::NONE};
+  ConsumerPolicy consumer_policy_{ConsumerPolicy::NO_STEALING};
   CoroutineDispatcher* global_dispatcher_{nullptr};
   CoroutineQueue* dispatcher_queue_{nullptr};
-  void ConsumeCoroutine();
+  // moving average of the time spent per loop iteration, in microseconds
+  std::int64_t average_iteration_time_{0};
+  void ReportLoad();
+  // returns true if there are still coroutines to consume right away
+  bool ConsumeCoroutine();
   void ProduceCoroutine();
 };
 
@@ -0,0 +1,90 @@
+/*
+ * File: completion_event.h
+ * Project: libarc
+ * File Created: Saturday, 17th October 2026 9:41:05 am
+ * Author: Minjun Xu (mjxu96@outlook.com)
+ * -----
+ * MIT License
+ * Copyright (c) 2020 Minjun Xu
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef LIBARC__CORO__EVENTS__COMPLETION_EVENT_H
+#define LIBARC__CORO__EVENTS__COMPLETION_EVENT_H
+
+#include <arc/coro/events/io_event.h>
+#include <linux/io_uring.h>
+
+#include <cstdint>
+
+namespace arc {
+namespace coro {
+
+// An io the kernel performs by itself with io_uring, instead of telling us
+// that the fd is ready so that we do the syscall.
+struct CompletionOp {
+  std::uint8_t opcode{IORING_OP_NOP};
+  std::uint64_t addr{0};
+  std::uint32_t len{0};
+  // msg_flags of send and recv, or the flags of accept4
+  std::uint32_t flags{0};
+  std::uint64_t addr2{0};
+
+  static CompletionOp Recv(char* buf, int len) {
+    return {IORING_OP_RECV, reinterpret_cast<std::uint64_t>(buf),
+            static_cast<std::uint32_t>(len), 0, 0};
+  }
+
+  static CompletionOp Send(const void* data, int len) {
+    return {IORING_OP_SEND, reinterpret_cast<std::uint64_t>(data),
+            static_cast<std::uint32_t>(len), MSG_NOSIGNAL, 0};
+  }
+
+  // the accepted fd is non blocking and close-on-exec, as with AcceptAll()
+  static CompletionOp Accept(sockaddr* addr, socklen_t* addrlen) {
+    return {IORING_OP_ACCEPT, reinterpret_cast<std::uint64_t>(addr), 0,
+            SOCK_NONBLOCK | SOCK_CLOEXEC,
+            reinterpret_cast<std::uint64_t>(addrlen)};
+  }
+};
+
+// Lives until the kernel posts the completion of its op, even if it is
+// cancelled or timed out before, as the kernel may still write its buffer.
+class CompletionEvent : public IOEvent {
+ public:
+  CompletionEvent(int fd, io::IOType io_type,
+                  std::coroutine_handle<void> handle, const CompletionOp& op)
+      : IOEvent(fd, io_type, handle), op_(op) {}
+
+  inline const CompletionOp& GetOp() const noexcept { return op_; }
+
+  // what the syscall of the op would return, or -errno
+  inline void SetResult(int result) noexcept { result_ = result; }
+  inline int GetResult() const noexcept { return result_; }
+
+ private:
+  CompletionOp op_;
+  int result_{0};
+};
+
+}  // namespace coro
+}  // namespace arc
+
+#endif /* LIBARC__CORO__EVENTS__COMPLETION_EVENT_H */
@@ -0,0 +1,57 @@
+/*
+ * File: event_allocator.h
+ * Project: libarc
+ * File Created: Friday, 16th October 2026 11:48:05 am
+ * Author: Minjun Xu (mjxu96@outlook.com)
+ * -----
+ * MIT License
+ * Copyright (c) 2020 Minjun Xu
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef LIBARC__CORO__EVENTS__EVENT_ALLOCATOR_H
+#define LIBARC__CORO__EVENTS__EVENT_ALLOCATOR_H
+
+#include <cstddef>
+
+namespace arc {
+namespace coro {
+namespace detail {
+
+// Per thread free lists of event blocks, grouped by size. Events are created
+// and destroyed on every suspension, so after warming up they are served
+// from here instead of the heap. A block freed by another thread simply goes
+// to that thread's free lists.
+class EventAllocator {
+ public:
+  constexpr static std::size_t kAlignment = 16;
+  constexpr static std::size_t kMaxPooledSize = 256;
+  constexpr static std::size_t kSizeClassNum = kMaxPooledSize / kAlignment;
+  constexpr static std::size_t kMaxCachedBlocksPerClass = 4096;
+
+  static void* Allocate(std::size_t size);
+  static void Deallocate(void* ptr, std::size_t size);
+};
+
+}  // namespace detail
+}  // namespace coro
+}  // namespace arc
+
+#endif /* LIBARC__CORO__EVENTS__EVENT_ALLOCATOR_H */
@@ -29,7 +29,9 @@
 #ifndef LIBARC__CORO__EVENTS__EVENT_BASE_H
 #define LIBARC__CORO__EVENTS__EVENT_BASE_H
 
+#include <arc/coro/events/event_allocator.h>
 #include <unistd.h>
+
 #include <cassert>
 #ifdef __clang__
 #include <experimental/coroutine>
@@ -50,6 +52,16 @@ class EventBase {
   EventBase(std::coroutine_handle<void> handle) : handle_(handle) {}
   virtual ~EventBase() {}
 
+  // events are short-lived and allocated on every suspension, keep them off
+  // the general heap
+  static void* operator new(std::size_t size) {
+    return detail::EventAllocator::Allocate(size);
+  }
+
+  static void operator delete(void* ptr, std::size_t size) {
+    detail::EventAllocator::Deallocate(ptr, size);
+  }
+
   virtual void Resume() {
     assert(!handle_.done());
     handle_.resume();
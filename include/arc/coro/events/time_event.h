@@ -35,6 +35,29 @@
 namespace arc {
 namespace coro {
 
+class TimeEvent;
+
+// time events are measured in microseconds of the steady clock
+inline std::int64_t ToTimeEventTime(
+    const std::chrono::steady_clock::time_point& time_point) {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             time_point.time_since_epoch())
+      .count();
+}
+
+namespace detail {
+
+class TimerWheel;
+
+// intrusive link of a time event in a timer wheel slot
+struct TimerWheelHook {
+  TimerWheelHook* prev{nullptr};
+  TimerWheelHook* next{nullptr};
+  TimeEvent* event{nullptr};
+};
+
+}  // namespace detail
+
 class TimeEvent : virtual public EventBase {
  public:
   TimeEvent(std::int64_t wakeup_time, std::coroutine_handle<void> handle)
@@ -50,11 +73,13 @@ class TimeEvent : virtual public EventBase {
   const inline bool IsTrigger() const { return is_trigger_; }
 
   friend class TimeEventComparator;
+  friend class detail::TimerWheel;
 
  protected:
   std::int64_t wakeup_time_ = 0;
   bool is_valid_{true};
   bool is_trigger_{false};
+  detail::TimerWheelHook wheel_hook_{nullptr, nullptr, this};
 };
 
 class TimeEventComparator {
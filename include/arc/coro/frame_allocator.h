@@ -0,0 +1,132 @@
+/*
+ * File: frame_allocator.h
+ * Project: libarc
+ * File Created: Friday, 16th October 2026 4:27:40 pm
+ * Author: Minjun Xu (mjxu96@outlook.com)
+ * -----
+ * MIT License
+ * Copyright (c) 2020 Minjun Xu
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef LIBARC__CORO__FRAME_ALLOCATOR_H
+#define LIBARC__CORO__FRAME_ALLOCATOR_H
+
+#include <cstddef>
+#include <memory>
+#include <new>
+
+namespace arc {
+namespace coro {
+namespace detail {
+
+// Allocates coroutine frames. Each frame is followed by the function which
+// frees it, so that frames from the per thread pools and from user supplied
+// allocators can be told apart with only the frame size at hand.
+//
+// Pooled frames are grouped by size in per thread free lists. A frame freed
+// by another thread simply goes to that thread's free lists.
+class FrameAllocator {
+ public:
+  using DeallocateFunction = void (*)(void* ptr, std::size_t size);
+
+  constexpr static std::size_t kAlignment = 64;
+  constexpr static std::size_t kMaxPooledSize = 4096;
+  constexpr static std::size_t kSizeClassNum = kMaxPooledSize / kAlignment;
+  constexpr static std::size_t kMaxCachedBytesPerClass = 256 * 1024;
+
+  static void* Allocate(std::size_t size);
+
+  template <typename Alloc>
+  static void* Allocate(std::size_t size, const Alloc& alloc) {
+    using BlockAlloc = typename std::allocator_traits<
+        Alloc>::template rebind_alloc<AlignedBlock>;
+    BlockAlloc block_alloc(alloc);
+    std::size_t alloc_offset = GetAllocatorOffset<BlockAlloc>(size);
+    void* ptr = std::allocator_traits<BlockAlloc>::allocate(
+        block_alloc, GetBlockCount<BlockAlloc>(size));
+    ::new (static_cast<char*>(ptr) + alloc_offset)
+        BlockAlloc(std::move(block_alloc));
+    SetDeallocateFunction(ptr, size, &DeallocateWith<BlockAlloc>);
+    return ptr;
+  }
+
+  static inline void Deallocate(void* ptr, std::size_t size) {
+    (*GetDeallocateFunctionPtr(ptr, size))(ptr, size);
+  }
+
+ private:
+  struct alignas(__STDCPP_DEFAULT_NEW_ALIGNMENT__) AlignedBlock {
+    char data[__STDCPP_DEFAULT_NEW_ALIGNMENT__];
+  };
+
+  constexpr static std::size_t RoundUp(std::size_t size,
+                                       std::size_t alignment) {
+    return (size + alignment - 1) / alignment * alignment;
+  }
+
+  constexpr static std::size_t GetDeallocateFunctionOffset(std::size_t size) {
+    return RoundUp(size, alignof(DeallocateFunction));
+  }
+
+  template <typename BlockAlloc>
+  constexpr static std::size_t GetAllocatorOffset(std::size_t size) {
+    return RoundUp(
+        GetDeallocateFunctionOffset(size) + sizeof(DeallocateFunction),
+        alignof(BlockAlloc));
+  }
+
+  template <typename BlockAlloc>
+  constexpr static std::size_t GetBlockCount(std::size_t size) {
+    return RoundUp(GetAllocatorOffset<BlockAlloc>(size) + sizeof(BlockAlloc),
+                   sizeof(AlignedBlock)) /
+           sizeof(AlignedBlock);
+  }
+
+  static inline DeallocateFunction* GetDeallocateFunctionPtr(void* ptr,
+                                                             std::size_t size) {
+    return reinterpret_cast<DeallocateFunction*>(
+        static_cast<char*>(ptr) + GetDeallocateFunctionOffset(size));
+  }
+
+  static inline void SetDeallocateFunction(void* ptr, std::size_t size,
+                                           DeallocateFunction function) {
+    ::new (GetDeallocateFunctionPtr(ptr, size)) DeallocateFunction(function);
+  }
+
+  static void DeallocatePooled(void* ptr, std::size_t size);
+
+  template <typename BlockAlloc>
+  static void DeallocateWith(void* ptr, std::size_t size) {
+    auto stored_alloc = std::launder(reinterpret_cast<BlockAlloc*>(
+        static_cast<char*>(ptr) + GetAllocatorOffset<BlockAlloc>(size)));
+    BlockAlloc block_alloc(std::move(*stored_alloc));
+    stored_alloc->~BlockAlloc();
+    std::allocator_traits<BlockAlloc>::deallocate(
+        block_alloc, static_cast<AlignedBlock*>(ptr),
+        GetBlockCount<BlockAlloc>(size));
+  }
+};
+
+}  // namespace detail
+}  // namespace coro
+}  // namespace arc
+
+#endif /* LIBARC__CORO__FRAME_ALLOCATOR_H */
@@ -32,13 +32,17 @@
 #ifdef __linux__
 
 #include <arc/coro/events/cancellation_event.h>
+#include <arc/coro/events/completion_event.h>
 #include <arc/coro/events/condition_event.h>
 #include <arc/coro/events/io_event.h>
 #include <arc/coro/events/time_event.h>
 #include <arc/coro/events/timeout_event.h>
+#include <arc/coro/poller/io_uring.h>
+#include <arc/coro/poller/timer_wheel.h>
 #include <arc/io/io_base.h>
 #include <sys/epoll.h>
 
+#include <array>
 #include <atomic>
 #include <deque>
 #include <list>
@@ -51,18 +55,56 @@
 namespace arc {
 namespace coro {
 
+enum class PollerBackend {
+  EPOLL = 0U,
+  // one-shot polls through io_uring, recv, send and accept are left to the
+  // kernel as a whole where it has fast poll, see IsCompletionBased()
+  IO_URING,
+  // every fd is registered once with EPOLLIN | EPOLLOUT | EPOLLET and its
+  // readiness is cached, see IsIOReady()
+  EPOLL_EDGE_TRIGGERED,
+};
+
+enum class TimerBackend {
+  PRIORITY_QUEUE = 0U,
+  // O(1) insertion and removal, better with lots of cancelled timeouts
+  TIMER_WHEEL,
+};
+
 class Poller : public io::detail::IOBase {
  public:
-  Poller();
+  // falls back to epoll if io_uring is not available on this kernel
+  Poller(PollerBackend backend = PollerBackend::EPOLL,
+         TimerBackend timer_backend = TimerBackend::PRIORITY_QUEUE);
   ~Poller();
 
+  inline PollerBackend GetBackend() const { return backend_; }
+  inline TimerBackend GetTimerBackend() const { return timer_backend_; }
+
+  // whether recv, send and accept can be left to the kernel as a whole, see
+  // AddCompletionEvent()
+  inline bool IsCompletionBased() const {
+    return backend_ == PollerBackend::IO_URING && ring_.HasFastPoll();
+  }
+
   void AddIOEvent(coro::IOEvent* event);
+  // Submits the op of the event, which is resumed with its result once the
+  // kernel has completed it. Only when IsCompletionBased().
+  void AddCompletionEvent(coro::CompletionEvent* event);
   void AddTimeEvent(coro::TimeEvent* event);
   void AddUserEvent(coro::UserEvent* event);
   void AddBoundEvent(coro::BoundEvent* event);
 
   void RemoveAllIOEvents(int target_fd);
 
+  // Only meaningful with the edge-triggered backend, always false otherwise.
+  // A fd stays ready in event_type direction from the edge reporting it until
+  // someone hits EAGAIN on it and calls ResetIOReady().
+  inline bool IsIOReady(int fd, io::IOType event_type) {
+    return GetIOReadyEvents(fd) & ToEpollEvent(event_type);
+  }
+  void ResetIOReady(int fd, io::IOType event_type);
+
   int WaitEvents(coro::EventBase** todo_events);
 
   void TrimIOEvents();
@@ -71,10 +113,35 @@ class Poller : public io::detail::IOBase {
 
   inline void SetNextTimeNoWait() { next_wait_timeout_ = 0; }
 
+  inline bool WillWait() const { return next_wait_timeout_ != 0; }
+
+  // Announces that the next wait is going to block, so that other threads
+  // start to write the eventfd to wake us up. Everything they publish before
+  // this must be checked again by the caller afterwards.
+  inline void SetSleeping(bool is_sleeping) {
+    is_sleeping_.store(is_sleeping);
+    if (is_sleeping) {
+      std::atomic_thread_fence(std::memory_order::seq_cst);
+    }
+  }
+
+  // for the dispatcher to wake up this poller only when it is sleeping
+  inline std::atomic<bool>* GetSleepingFlag() { return &is_sleeping_; }
+
+  // Thread safe, only writes the eventfd if the poller is sleeping
+  void WakeUp();
+
+  bool HasTriggeredEvents();
+
+  // the time read right after the last wait returned
+  inline std::chrono::steady_clock::time_point GetCurrentTime() const {
+    return current_time_point_;
+  }
+
   inline bool IsPollerDone() {
     std::lock_guard<std::mutex> guard(poller_lock_);
     auto ret =
-        (total_io_events_ + time_events_.size() + pending_user_events_.size() +
+        (total_io_events_ + GetTimeEventsCount() + pending_user_events_.size() +
              triggered_user_events_.size() + pending_bound_events_.size() +
              triggered_bound_events_.size() ==
          0) &&
@@ -82,6 +149,8 @@ class Poller : public io::detail::IOBase {
     return ret;
   }
 
+  inline int GetIOEventsCount() const { return total_io_events_; }
+
   inline int GetEventHandle() const { return user_event_fd_; }
   bool TriggerUserEvent(EventID event_id);
   void TriggerBoundEvent(EventID bound_event_id, coro::BoundEvent* event);
@@ -93,8 +162,23 @@ class Poller : public io::detail::IOBase {
 
  private:
   const static int kMaxFdInArray_ = 1024;
+  const static unsigned int kIOUringEntries_ = kMaxEventsSizePerWait;
+  const static std::uint64_t kIOUringIgnoredUserData_ = ~(std::uint64_t)0;
+  // completions of polls carry their fd, io type and generation, those of
+  // other ops carry the address of their CompletionEvent with this bit set
+  const static std::uint64_t kIOUringCompletionTag_ = (std::uint64_t)1 << 63;
+  const static std::uint32_t kIOUringGenerationMask_ = 0x7fffffff;
+  const static int kEdgeTriggeredEvents_ = EPOLLIN | EPOLLOUT | EPOLLET;
 
+  PollerBackend backend_{PollerBackend::EPOLL};
+  TimerBackend timer_backend_{TimerBackend::PRIORITY_QUEUE};
+
+  // either 0 or -1, timed waits go through the absolute next_wakeup_time_
   int next_wait_timeout_ = -1;
+  // in microseconds of the steady clock, -1 if there is no time event
+  std::int64_t next_wakeup_time_{-1};
+  std::chrono::steady_clock::time_point current_time_point_{};
+  std::int64_t current_time_{0};
 
   std::atomic<EventID> max_event_id_{0};
 
@@ -115,10 +199,13 @@ class Poller : public io::detail::IOBase {
   std::priority_queue<coro::TimeEvent*, std::vector<coro::TimeEvent*>,
                       coro::TimeEventComparator>
       time_events_;
+  detail::TimerWheel timer_wheel_;
+  coro::TimeEvent* expired_time_events_[kMaxEventsSizePerWait] = {nullptr};
 
   // user events
   int user_event_fd_{-1};
   bool is_event_fd_added_{false};
+  std::atomic<bool> is_sleeping_{false};
   std::mutex poller_lock_;
   std::list<coro::UserEvent*> pending_user_events_;
   std::list<coro::UserEvent*> triggered_user_events_;
@@ -136,6 +223,59 @@ class Poller : public io::detail::IOBase {
 
   // epoll related
   epoll_event events_[kMaxEventsSizePerWait];
+  int timer_fd_{-1};
+  std::int64_t armed_wakeup_time_{-1};
+
+  // edge-triggered epoll related
+  // io_prev_events_ records whether a fd is registered, the ready events are
+  // kept from the edge until the owner of the fd observes EAGAIN
+  int io_ready_events_[kMaxFdInArray_] = {0};
+  std::unordered_map<int, int> extra_io_ready_events_{};
+  // waiters that were added while their fd was already known ready, no edge
+  // will come for them so they are resumed in the next wait without blocking
+  std::vector<std::pair<int, io::IOType>> known_ready_io_events_{};
+
+  // io_uring related
+  // polls are one-shot, io_prev_events_ records which of them are armed and
+  // the generation tells completions of removed polls apart from live ones
+  detail::IOUring ring_;
+  __kernel_timespec ring_wait_timeout_{};
+  std::uint32_t io_generations_[kMaxFdInArray_][2] = {{0}};
+  std::unordered_map<int, std::array<std::uint32_t, 2>> extra_io_generations_{};
+  // ops submitted but not completed yet, {fd -> events}
+  std::unordered_multimap<int, coro::CompletionEvent*> completion_events_{};
+
+  int WaitEpollEvents(coro::EventBase** todo_events,
+                      bool* is_user_event_triggered);
+  int WaitIOUringEvents(coro::EventBase** todo_events,
+                        bool* is_user_event_triggered);
+  int WaitEdgeTriggeredEvents(coro::EventBase** todo_events,
+                              bool* is_user_event_triggered);
+  void TrimEdgeTriggeredEvents();
+  void TrimIOUringEvents(int fd, int prev_event, int cur_event);
+  void AddIOUringPoll(int fd, io::IOType event_type);
+  void RemoveIOUringPoll(int fd, io::IOType event_type);
+  std::uint32_t& GetIOUringGeneration(int fd, io::IOType event_type);
+  std::uint64_t GetIOUringPollUserData(int fd, io::IOType event_type);
+  void CancelCompletionEvent(coro::CompletionEvent* event);
+
+  inline static int ToEpollEvent(io::IOType event_type) {
+    return event_type == io::IOType::READ ? EPOLLIN : EPOLLOUT;
+  }
+  inline int GetIOReadyEvents(int fd) {
+    if (fd < kMaxFdInArray_) [[likely]] {
+      return io_ready_events_[fd];
+    }
+    auto itr = extra_io_ready_events_.find(fd);
+    return itr == extra_io_ready_events_.end() ? 0 : itr->second;
+  }
+
+  void ArmTimerFd();
+  int PopTimerWheelEvents(coro::EventBase** todo_events, int todo_cnt);
+  inline std::size_t GetTimeEventsCount() const {
+    return timer_backend_ == TimerBackend::TIMER_WHEEL ? timer_wheel_.Size()
+                                                       : time_events_.size();
+  }
 
   int GetExistingIOEvent(int fd);
   coro::IOEvent* PopIOEvent(int fd, io::IOType event_type);
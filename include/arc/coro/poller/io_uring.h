@@ -0,0 +1,116 @@
+/*
+ * File: io_uring.h
+ * Project: libarc
+ * File Created: Friday, 16th October 2026 10:12:37 am
+ * Author: Minjun Xu (mjxu96@outlook.com)
+ * -----
+ * MIT License
+ * Copyright (c) 2020 Minjun Xu
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef LIBARC__CORO__POLLER__IO_URING_H
+#define LIBARC__CORO__POLLER__IO_URING_H
+
+#ifdef __linux__
+
+#include <linux/io_uring.h>
+
+#include <cstdint>
+
+namespace arc {
+namespace coro {
+namespace detail {
+
+// A minimal io_uring ring built directly on the raw syscalls, so that no
+// liburing dependency is needed. Only used by the Poller.
+class IOUring {
+ public:
+  IOUring() = default;
+  ~IOUring();
+
+  IOUring(const IOUring&) = delete;
+  IOUring& operator=(const IOUring&) = delete;
+
+  // returns false if io_uring is not supported or not permitted
+  bool Init(unsigned int entries);
+
+  inline bool IsInitialized() const { return ring_fd_ >= 0; }
+
+  // Without fast poll the kernel blocks a worker thread on every recv, send
+  // or accept that cannot complete right away, so only polls are worth it.
+  inline bool HasFastPoll() const {
+    return features_ & IORING_FEAT_FAST_POLL;
+  }
+
+  // never returns nullptr, pending submissions are flushed if sq is full
+  io_uring_sqe* GetSqe();
+
+  // submit all pending sqes and wait for at least wait_nr completions
+  int SubmitAndWait(unsigned int wait_nr);
+
+  // peek the next completion, nullptr if cq is empty
+  inline io_uring_cqe* PeekCqe() {
+    unsigned int head = *cq_head_;
+    if (head == __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE)) {
+      return nullptr;
+    }
+    return &cqes_[head & *cq_ring_mask_];
+  }
+
+  inline void AdvanceCq() {
+    __atomic_store_n(cq_head_, *cq_head_ + 1, __ATOMIC_RELEASE);
+  }
+
+ private:
+  int Enter(unsigned int to_submit, unsigned int wait_nr, unsigned int flags);
+
+  int ring_fd_{-1};
+  unsigned int features_{0};
+
+  void* sq_ring_ptr_{nullptr};
+  std::size_t sq_ring_size_{0};
+  void* cq_ring_ptr_{nullptr};
+  std::size_t cq_ring_size_{0};
+  io_uring_sqe* sqes_{nullptr};
+  std::size_t sqes_size_{0};
+
+  // submission queue
+  unsigned int* sq_head_{nullptr};
+  unsigned int* sq_tail_{nullptr};
+  unsigned int* sq_ring_mask_{nullptr};
+  unsigned int* sq_ring_entries_{nullptr};
+  unsigned int* sq_array_{nullptr};
+  unsigned int sq_local_tail_{0};
+  unsigned int to_submit_{0};
+
+  // completion queue
+  unsigned int* cq_head_{nullptr};
+  unsigned int* cq_tail_{nullptr};
+  unsigned int* cq_ring_mask_{nullptr};
+  io_uring_cqe* cqes_{nullptr};
+};
+
+}  // namespace detail
+}  // namespace coro
+}  // namespace arc
+
+#endif  // __linux__
+#endif
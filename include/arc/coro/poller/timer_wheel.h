@@ -0,0 +1,128 @@
+/*
+ * File: timer_wheel.h
+ * Project: libarc
+ * File Created: Friday, 16th October 2026 02:26:41 pm
+ * Author: Minjun Xu (mjxu96@outlook.com)
+ * -----
+ * MIT License
+ * Copyright (c) 2020 Minjun Xu
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef LIBARC__CORO__POLLER__TIMER_WHEEL_H
+#define LIBARC__CORO__POLLER__TIMER_WHEEL_H
+
+#include <arc/coro/events/time_event.h>
+
+#include <cstdint>
+
+namespace arc {
+namespace coro {
+namespace detail {
+
+// A hierarchical timing wheel with microsecond ticks. Level 0 has one slot
+// per tick and every upper level has one slot per revolution of the level
+// below, whose events are cascaded down when their slot comes up. Adding and
+// removing a time event is O(1), expired events are collected in batches.
+class TimerWheel {
+ public:
+  TimerWheel(std::int64_t current_time);
+  ~TimerWheel() = default;
+
+  TimerWheel(const TimerWheel&) = delete;
+  TimerWheel& operator=(const TimerWheel&) = delete;
+
+  void Add(TimeEvent* event);
+
+  // no-op if the event is not in the wheel
+  void Remove(TimeEvent* event);
+
+  // Moves all events due at current_time to the expired list and pops at
+  // most max_cnt of them into events, returns the popped number.
+  int PopExpired(std::int64_t current_time, TimeEvent** events, int max_cnt);
+
+  // The time the next event might be due, which may be in the past. It is
+  // never later than the real due time but can be earlier. -1 if empty.
+  std::int64_t GetNextExpireTime();
+
+  inline std::size_t Size() const { return size_; }
+  inline bool Empty() const { return size_ == 0; }
+
+ private:
+  constexpr static int kLevelBits_ = 8;
+  constexpr static int kSlotNum_ = 1 << kLevelBits_;
+  constexpr static std::int64_t kSlotMask_ = kSlotNum_ - 1;
+  constexpr static int kLevelNum_ = 4;
+  constexpr static std::int64_t kMaxTimeSpan_ =
+      (std::int64_t(1) << (kLevelBits_ * kLevelNum_)) - 1;
+  constexpr static int kBitmapWordNum_ = kSlotNum_ / 64;
+
+  // all ticks before current_tick_ have been processed
+  std::int64_t current_tick_{0};
+  std::size_t size_{0};
+
+  // circular lists whose heads are sentinels
+  TimerWheelHook slots_[kLevelNum_][kSlotNum_];
+  TimerWheelHook expired_;
+  // a set bit means the slot may be non-empty, cleared lazily
+  std::uint64_t bitmaps_[kLevelNum_][kBitmapWordNum_] = {{0}};
+
+  void Advance(std::int64_t current_time);
+  void Place(TimerWheelHook* hook);
+  void Cascade(int level, int slot);
+
+  // the tick of the nearest non-empty level 0 slot
+  std::int64_t GetNextSlotTick();
+  // the nearest tick at which some events get cascaded
+  std::int64_t GetNextCascadeTick();
+  int FindNextSlot(int level, int from);
+  inline bool IsSlotEmpty(int level, int slot) const {
+    return slots_[level][slot].next == &slots_[level][slot];
+  }
+  inline void MarkSlot(int level, int slot) {
+    bitmaps_[level][slot / 64] |= (std::uint64_t(1) << (slot % 64));
+  }
+  inline void UnmarkSlot(int level, int slot) {
+    bitmaps_[level][slot / 64] &= ~(std::uint64_t(1) << (slot % 64));
+  }
+
+  inline static void InitList(TimerWheelHook* head) {
+    head->prev = head;
+    head->next = head;
+  }
+  inline static void PushBack(TimerWheelHook* head, TimerWheelHook* hook) {
+    hook->prev = head->prev;
+    hook->next = head;
+    head->prev->next = hook;
+    head->prev = hook;
+  }
+  inline static void Unlink(TimerWheelHook* hook) {
+    hook->prev->next = hook->next;
+    hook->next->prev = hook->prev;
+    hook->prev = nullptr;
+    hook->next = nullptr;
+  }
+};
+
+}  // namespace detail
+}  // namespace coro
+}  // namespace arc
+
+#endif
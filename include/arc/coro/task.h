@@ -32,6 +32,7 @@
 #include <arc/concept/coro.h>
 #include <arc/coro/awaiter/time_awaiter.h>
 #include <arc/coro/eventloop.h>
+#include <arc/coro/frame_allocator.h>
 #include <unistd.h>
 
 #ifdef __clang__
@@ -46,6 +47,7 @@ using experimental::suspend_never;
 #include <coroutine>
 #endif
 #include <exception>
+#include <memory>
 #include <string>
 
 namespace arc {
@@ -70,6 +72,31 @@ class PromiseBase {
 
   void SetNeedClean(bool need_clean = true) { need_manual_clean_ = need_clean; }
 
+  // Coroutine frames come from per thread pools by default. A coroutine taking
+  // std::allocator_arg_t followed by an allocator as its first parameters, or
+  // right after the object for member functions, is allocated with that
+  // allocator instead.
+  static void* operator new(std::size_t size) {
+    return detail::FrameAllocator::Allocate(size);
+  }
+
+  template <typename Alloc, typename... Args>
+  static void* operator new(std::size_t size, std::allocator_arg_t,
+                            const Alloc& alloc, const Args&...) {
+    return detail::FrameAllocator::Allocate(size, alloc);
+  }
+
+  template <typename Class, typename Alloc, typename... Args>
+  static void* operator new(std::size_t size, const Class&,
+                            std::allocator_arg_t, const Alloc& alloc,
+                            const Args&...) {
+    return detail::FrameAllocator::Allocate(size, alloc);
+  }
+
+  static void operator delete(void* ptr, std::size_t size) {
+    detail::FrameAllocator::Deallocate(ptr, size);
+  }
+
  protected:
   friend struct FinalAwaiter;
   struct FinalAwaiter {
@@ -0,0 +1,363 @@
+/*
+ * File: task_group.h
+ * Project: libarc
+ * File Created: Saturday, 17th October 2026 9:14:52 am
+ * Author: Minjun Xu (mjxu96@outlook.com)
+ * -----
+ * MIT License
+ * Copyright (c) 2020 Minjun Xu
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef LIBARC__CORO__TASK_GROUP_H
+#define LIBARC__CORO__TASK_GROUP_H
+
+#include <arc/concept/coro.h>
+#include <arc/coro/task.h>
+#include <arc/coro/utils/cancellation_token.h>
+#include <assert.h>
+
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <optional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace arc {
+namespace coro {
+
+namespace detail {
+
+template <typename T>
+using ResultType = std::conditional_t<std::is_void_v<T>, std::monostate, T>;
+
+// Hands the finishing child over to the given coroutine, if any, once the
+// child returns. So the awaiting coroutine is resumed without another trip
+// through the event loop.
+class [[nodiscard]] TransferAwaiter {
+ public:
+  TransferAwaiter(std::coroutine_handle<> continuation)
+      : continuation_(continuation) {}
+
+  bool await_ready() { return !continuation_; }
+
+  template <arc::concepts::PromiseT PromiseType>
+  bool await_suspend(std::coroutine_handle<PromiseType> handle) {
+    handle.promise().SetContinuation(continuation_);
+    return false;
+  }
+
+  void await_resume() {}
+
+ private:
+  std::coroutine_handle<> continuation_{nullptr};
+};
+
+// All children run on the same event loop as the joining coroutine, so none
+// of the states below need synchronization.
+class JoinState {
+ public:
+  JoinState(const CancellationToken& token) : token_(token) {}
+
+  inline void Add() { count_++; }
+
+  // returns the coroutine to resume if the caller is the last one to arrive
+  std::coroutine_handle<> Arrive() {
+    if (--count_ > 0) {
+      return nullptr;
+    }
+    return std::exchange(continuation_, nullptr);
+  }
+
+  inline void SetContinuation(std::coroutine_handle<> continuation) {
+    continuation_ = continuation;
+  }
+
+  void SetException(std::exception_ptr exception) {
+    if (!exception_) {
+      exception_ = exception;
+      token_.Cancel();
+    }
+  }
+
+  void RethrowIfFailed() {
+    if (exception_) {
+      std::rethrow_exception(std::exchange(exception_, nullptr));
+    }
+  }
+
+  inline CancellationToken& GetCancellationToken() { return token_; }
+
+ private:
+  // the joining coroutine holds one count until it starts waiting
+  std::size_t count_{1};
+  std::coroutine_handle<> continuation_{nullptr};
+  std::exception_ptr exception_{nullptr};
+  CancellationToken token_;
+};
+
+class [[nodiscard]] JoinAwaiter {
+ public:
+  JoinAwaiter(JoinState* state) : state_(state) {}
+
+  bool await_ready() { return false; }
+
+  bool await_suspend(std::coroutine_handle<> handle) {
+    state_->SetContinuation(handle);
+    if (state_->Arrive()) {
+      // all children have finished already
+      return false;
+    }
+    return true;
+  }
+
+  void await_resume() {
+    // hold the count again for the next join
+    state_->Add();
+    state_->RethrowIfFailed();
+  }
+
+ private:
+  JoinState* state_{nullptr};
+};
+
+inline Task<void> RunInGroup(Task<void> task,
+                             std::shared_ptr<JoinState> state) {
+  try {
+    co_await task;
+  } catch (...) {
+    state->SetException(std::current_exception());
+  }
+  co_await TransferAwaiter(state->Arrive());
+}
+
+template <typename T>
+Task<void> StoreResult(Task<T> task, std::optional<ResultType<T>>* result) {
+  if constexpr (std::is_void_v<T>) {
+    co_await task;
+    result->emplace();
+  } else {
+    result->emplace(co_await task);
+  }
+}
+
+template <typename T>
+class AnyState {
+ public:
+  AnyState(const CancellationToken& token) : token_(token) {}
+
+  // returns the coroutine to resume if the caller is the first one to arrive
+  std::coroutine_handle<> Arrive(std::size_t index,
+                                 std::optional<ResultType<T>>&& result,
+                                 std::exception_ptr exception) {
+    if (is_done_) {
+      return nullptr;
+    }
+    is_done_ = true;
+    index_ = index;
+    result_ = std::move(result);
+    exception_ = exception;
+    token_.Cancel();
+    return std::exchange(continuation_, nullptr);
+  }
+
+  inline bool IsDone() const { return is_done_; }
+
+  inline void SetContinuation(std::coroutine_handle<> continuation) {
+    continuation_ = continuation;
+  }
+
+  std::size_t GetIndex() const { return index_; }
+
+  ResultType<T>&& GetResult() {
+    if (exception_) {
+      std::rethrow_exception(exception_);
+    }
+    return std::move(*result_);
+  }
+
+ private:
+  bool is_done_{false};
+  std::size_t index_{0};
+  std::optional<ResultType<T>> result_{};
+  std::exception_ptr exception_{nullptr};
+  std::coroutine_handle<> continuation_{nullptr};
+  CancellationToken token_;
+};
+
+template <typename T>
+class [[nodiscard]] AnyAwaiter {
+ public:
+  AnyAwaiter(AnyState<T>* state) : state_(state) {}
+
+  bool await_ready() { return state_->IsDone(); }
+
+  void await_suspend(std::coroutine_handle<> handle) {
+    state_->SetContinuation(handle);
+  }
+
+  void await_resume() {}
+
+ private:
+  AnyState<T>* state_{nullptr};
+};
+
+template <typename T>
+Task<void> RunInAny(Task<T> task, std::size_t index,
+                    std::shared_ptr<AnyState<T>> state) {
+  std::optional<ResultType<T>> result{};
+  std::exception_ptr exception{nullptr};
+  try {
+    if constexpr (std::is_void_v<T>) {
+      co_await task;
+      result.emplace();
+    } else {
+      result.emplace(co_await task);
+    }
+  } catch (...) {
+    exception = std::current_exception();
+  }
+  co_await TransferAwaiter(
+      state->Arrive(index, std::move(result), std::move(exception)));
+}
+
+}  // namespace detail
+
+// Runs tasks concurrently on the current event loop and joins them.
+//
+//   TaskGroup group;
+//   group.Spawn(Fetch(group.GetCancellationToken()));
+//   group.Spawn(Fetch(group.GetCancellationToken()));
+//   co_await group.Join();
+//
+// The first exception thrown by a task cancels the group's token and is
+// rethrown by Join() once all tasks have finished. Tasks still running when
+// the group goes away without being joined are left running on their own.
+class TaskGroup {
+ public:
+  TaskGroup() : TaskGroup(CancellationToken()) {}
+  TaskGroup(const CancellationToken& token)
+      : state_(std::make_shared<detail::JoinState>(token)) {}
+
+  TaskGroup(const TaskGroup&) = delete;
+  TaskGroup& operator=(const TaskGroup&) = delete;
+
+  // the task starts running right away, until its first suspension
+  void Spawn(Task<void>&& task) {
+    state_->Add();
+    EnsureFuture(detail::RunInGroup(std::move(task), state_));
+  }
+
+  detail::JoinAwaiter Join() { return detail::JoinAwaiter(state_.get()); }
+
+  CancellationToken& GetCancellationToken() {
+    return state_->GetCancellationToken();
+  }
+
+  void Cancel() { state_->GetCancellationToken().Cancel(); }
+
+ private:
+  std::shared_ptr<detail::JoinState> state_{nullptr};
+};
+
+// Runs all tasks concurrently on the current event loop and returns their
+// results in order, void results as std::monostate. Waits for all of them
+// even if some fail, then rethrows the first exception.
+template <typename... Ts>
+Task<std::tuple<detail::ResultType<Ts>...>> WhenAll(Task<Ts>... tasks) {
+  std::tuple<std::optional<detail::ResultType<Ts>>...> results{};
+  TaskGroup group;
+  [&]<std::size_t... I>(std::index_sequence<I...>) {
+    (group.Spawn(detail::StoreResult(std::move(tasks), &std::get<I>(results))),
+     ...);
+  }(std::index_sequence_for<Ts...>{});
+  co_await group.Join();
+  co_return std::apply(
+      [](auto&... result) {
+        return std::tuple<detail::ResultType<Ts>...>(std::move(*result)...);
+      },
+      results);
+}
+
+template <typename T>
+  requires(!std::is_void_v<T>)
+Task<std::vector<T>> WhenAll(std::vector<Task<T>> tasks) {
+  std::vector<std::optional<T>> results(tasks.size());
+  TaskGroup group;
+  for (std::size_t i = 0; i < tasks.size(); i++) {
+    group.Spawn(detail::StoreResult(std::move(tasks[i]), &results[i]));
+  }
+  co_await group.Join();
+  std::vector<T> ret;
+  ret.reserve(results.size());
+  for (auto& result : results) {
+    ret.push_back(std::move(*result));
+  }
+  co_return ret;
+}
+
+inline Task<void> WhenAll(std::vector<Task<void>> tasks) {
+  TaskGroup group;
+  for (auto& task : tasks) {
+    group.Spawn(std::move(task));
+  }
+  co_await group.Join();
+}
+
+// Runs all tasks concurrently on the current event loop and returns once the
+// first of them finishes, with its index and its result. The token is
+// cancelled then, so the other tasks should wait with it in order to stop
+// early. They are left running on their own until they do.
+template <typename T>
+Task<std::conditional_t<std::is_void_v<T>, std::size_t,
+                        std::pair<std::size_t, detail::ResultType<T>>>>
+WhenAny(CancellationToken token, std::vector<Task<T>> tasks) {
+  assert(!tasks.empty());
+  auto state = std::make_shared<detail::AnyState<T>>(token);
+  for (std::size_t i = 0; i < tasks.size(); i++) {
+    EnsureFuture(detail::RunInAny(std::move(tasks[i]), i, state));
+  }
+  co_await detail::AnyAwaiter<T>(state.get());
+  if constexpr (std::is_void_v<T>) {
+    state->GetResult();
+    co_return state->GetIndex();
+  } else {
+    co_return std::pair<std::size_t, T>(state->GetIndex(), state->GetResult());
+  }
+}
+
+template <typename T, typename... Ts>
+  requires(std::is_same_v<T, Ts> && ...)
+auto WhenAny(CancellationToken token, Task<T>&& task, Task<Ts>&&... tasks) {
+  std::vector<Task<T>> all_tasks;
+  all_tasks.reserve(sizeof...(Ts) + 1);
+  all_tasks.push_back(std::move(task));
+  (all_tasks.push_back(std::move(tasks)), ...);
+  return WhenAny(std::move(token), std::move(all_tasks));
+}
+
+}  // namespace coro
+}  // namespace arc
+
+#endif /* LIBARC__CORO__TASK_GROUP_H */
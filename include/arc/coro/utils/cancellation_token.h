@@ -48,17 +48,28 @@ class CancellationTokenCore {
 
   void SetEventAndLoop(BoundEvent* event, EventLoop* loop) {
     std::lock_guard guard(lock_);
+    loop->AddBoundEvent(event);
+    if (is_cancelled_) {
+      // cancelled before this wait started, abort it right away
+      loop->TriggerBoundEvent(event->GetBountEventID(), event);
+      return;
+    }
     registered_events_pairs_.push_back(
         {event->GetBountEventID(), event, loop->GetEventLoopID()});
-    loop->AddBoundEvent(event);
   }
 
   void Cancel() {
     std::lock_guard guard(lock_);
+    is_cancelled_ = true;
     TriggerCancel();
     registered_events_pairs_.clear();
   }
 
+  bool IsCancelled() {
+    std::lock_guard guard(lock_);
+    return is_cancelled_;
+  }
+
  private:
   void TriggerCancel() {
     std::lock_guard guard(EventLoopGroup::GetInstance().EventLoopGroupLock());
@@ -73,6 +84,7 @@ class CancellationTokenCore {
   }
 
   std::mutex lock_;
+  bool is_cancelled_{false};
 
   // vector of {bound_event_id, trigger_event_pair}
   std::vector<std::tuple<EventID, BoundEvent*, EventLoopID>>
@@ -90,8 +102,11 @@ class CancellationToken {
     core_->SetEventAndLoop(event, loop);
   }
 
+  // waits started after cancelling are aborted right away as well
   void Cancel() { core_->Cancel(); }
 
+  bool IsCancelled() const { return core_->IsCancelled(); }
+
  private:
   std::shared_ptr<detail::CancellationTokenCore> core_{nullptr};
 };
@@ -26,6 +26,7 @@
  * IN THE SOFTWARE.
  */
 
+#include <arc/coro/async_generator.h>
 #include <mariadb/mysql.h>
 
 #include "sql.h"
@@ -85,6 +86,10 @@ class MySQLResult {
 
   coro::Task<MySQLResultRow> FetchNextRow();
 
+  // fetches the rows one by one as the consumer walks through them, so a
+  // large result is never held in memory at once
+  coro::AsyncGenerator<MySQLResultRow> FetchRows();
+
  private:
   MySQLConnection* conn_;
   ::MYSQL_RES* res_{nullptr};
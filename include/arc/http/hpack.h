@@ -0,0 +1,150 @@
+/*
+ * File: hpack.h
+ * Project: libarc
+ * File Created: Saturday, 17th October 2026 11:04:16 pm
+ * Author: Minjun Xu (mjxu96@outlook.com)
+ * -----
+ * MIT License
+ * Copyright (c) 2022 Minjun Xu
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <string>
+#include <string_view>
+
+namespace arc {
+namespace http {
+
+namespace detail {
+
+// appends value with an N-bit prefix, the bits above it in the first byte
+// taken from flags
+void EncodeHpackInteger(std::uint64_t value, int prefix_bits,
+                        std::uint8_t flags, std::string* out);
+// advances data past the integer, false if it is truncated or too large
+bool DecodeHpackInteger(std::string_view* data, int prefix_bits,
+                        std::uint64_t* value);
+
+std::size_t GetHuffmanEncodedSize(std::string_view data);
+void EncodeHuffman(std::string_view data, std::string* out);
+// appends to out, false if data is not a valid encoding
+bool DecodeHuffman(std::string_view data, std::string* out);
+
+// The static table followed by the dynamic one of one direction of a
+// connection, indexed from 1.
+class HpackTable {
+ public:
+  constexpr static std::size_t kStaticTableSize = 61;
+  // what each entry costs on top of its name and value
+  constexpr static std::size_t kEntryOverhead = 32;
+
+  HpackTable(std::size_t max_size) : max_size_(max_size) {}
+
+  // false if there is no such entry
+  bool Get(std::size_t index, std::string_view* name,
+           std::string_view* value) const;
+  // The index of an entry with both name and value, else of one with the
+  // name, else 0.
+  std::size_t Find(std::string_view name, std::string_view value,
+                   bool* is_value_matched) const;
+
+  // evicts the oldest entries to make room for it
+  void Add(std::string_view name, std::string_view value);
+  void SetMaxSize(std::size_t max_size);
+  inline std::size_t GetMaxSize() const { return max_size_; }
+
+ private:
+  struct Entry {
+    std::string name;
+    std::string value;
+  };
+
+  void Evict(std::size_t max_size);
+
+  // the newest entry in the front
+  std::deque<Entry> entries_;
+  std::size_t size_{0};
+  std::size_t max_size_{0};
+};
+
+}  // namespace detail
+
+// Decodes the header blocks received on a connection, in their order.
+class HpackDecoder {
+ public:
+  // max_table_size is the SETTINGS_HEADER_TABLE_SIZE sent to the peer
+  HpackDecoder(std::size_t max_table_size = 4096);
+
+  // Calls on_field with every field of the block, the views are only valid
+  // during the call. Returns false if the block cannot be decoded, which is
+  // a connection error as the table may be out of sync since.
+  bool Decode(std::string_view block,
+              const std::function<void(std::string_view, std::string_view)>&
+                  on_field);
+
+ private:
+  // a string literal, either a view into data or decoded into buffer
+  bool DecodeString(std::string_view* data, std::string* buffer,
+                    std::string_view* str);
+
+  detail::HpackTable table_;
+  std::size_t max_table_size_{0};
+  std::string name_buffer_;
+  std::string value_buffer_;
+};
+
+// Encodes the header blocks sent on a connection. Blocks have to be sent in
+// the order they are encoded in.
+class HpackEncoder {
+ public:
+  // the peer may allow a larger table, which is not used to keep the memory
+  // taken per connection bounded
+  constexpr static std::size_t kDefaultTableSize = 4096;
+
+  HpackEncoder() : table_(kDefaultTableSize) {}
+
+  // the SETTINGS_HEADER_TABLE_SIZE received from the peer, applied from the
+  // next block on
+  void SetMaxTableSize(std::size_t max_size);
+
+  // name must be in lower case
+  void Encode(std::string_view name, std::string_view value,
+              std::string* block);
+  // to be called before the first field of every block
+  void BeginBlock(std::string* block);
+
+ private:
+  void EncodeString(std::string_view str, std::string* block);
+
+  detail::HpackTable table_;
+  // the smallest and the final size the table has been set to since the
+  // last block, to be announced at the start of the next one
+  std::size_t min_pending_table_size_{0};
+  bool is_table_size_changed_{false};
+};
+
+}  // namespace http
+}  // namespace arc
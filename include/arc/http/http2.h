@@ -0,0 +1,256 @@
+/*
+ * File: http2.h
+ * Project: libarc
+ * File Created: Saturday, 17th October 2026 11:41:07 pm
+ * Author: Minjun Xu (mjxu96@outlook.com)
+ * -----
+ * MIT License
+ * Copyright (c) 2022 Minjun Xu
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <arc/coro/locks/condition.h>
+#include <arc/coro/locks/lock.h>
+#include <arc/coro/task.h>
+#include <arc/io/socket.h>
+#include <arc/net/address.h>
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "hpack.h"
+#include "http_parser.h"
+
+namespace arc {
+namespace http {
+
+class HttpServer;
+class HttpFile;
+
+namespace detail {
+
+// what a client starts with to speak HTTP/2 without upgrading
+constexpr std::string_view kHttp2Preface = "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n";
+constexpr std::size_t kHttp2FrameHeaderSize = 9;
+
+enum class Http2FrameType : std::uint8_t {
+  DATA = 0x0U,
+  HEADERS = 0x1U,
+  PRIORITY = 0x2U,
+  RST_STREAM = 0x3U,
+  SETTINGS = 0x4U,
+  PUSH_PROMISE = 0x5U,
+  PING = 0x6U,
+  GOAWAY = 0x7U,
+  WINDOW_UPDATE = 0x8U,
+  CONTINUATION = 0x9U,
+};
+
+enum class Http2ErrorCode : std::uint32_t {
+  NO_ERROR = 0x0U,
+  PROTOCOL_ERROR = 0x1U,
+  INTERNAL_ERROR = 0x2U,
+  FLOW_CONTROL_ERROR = 0x3U,
+  SETTINGS_TIMEOUT = 0x4U,
+  STREAM_CLOSED = 0x5U,
+  FRAME_SIZE_ERROR = 0x6U,
+  REFUSED_STREAM = 0x7U,
+  CANCEL = 0x8U,
+  COMPRESSION_ERROR = 0x9U,
+  CONNECT_ERROR = 0xAU,
+  ENHANCE_YOUR_CALM = 0xBU,
+  INADEQUATE_SECURITY = 0xCU,
+  HTTP_1_1_REQUIRED = 0xDU,
+};
+
+struct Http2FrameHeader {
+  std::uint32_t length{0};
+  Http2FrameType type{Http2FrameType::DATA};
+  std::uint8_t flags{0};
+  std::uint32_t stream_id{0};
+};
+
+// data and out take kHttp2FrameHeaderSize bytes
+void ParseHttp2FrameHeader(const char* data, Http2FrameHeader* header);
+void WriteHttp2FrameHeader(const Http2FrameHeader& header, char* out);
+
+// A stream opened by a request, holding what the views of the request refer
+// to.
+struct Http2Stream {
+  std::uint32_t id{0};
+  HttpRequest request;
+  // the decoded header fields back to back
+  std::string fields;
+  std::string body;
+  // the fd of a temporary file the body is written to once it is too large
+  int body_fd{-1};
+  std::size_t body_size{0};
+  bool is_end_stream_received{false};
+  // whether its handler has been started
+  bool is_dispatched{false};
+
+  // flow control windows, the one for sending may go below 0 when the peer
+  // shrinks it
+  std::int64_t send_window{0};
+  std::int64_t recv_window{0};
+
+  ~Http2Stream();
+};
+
+// An HTTP/2 connection taken over from HttpServer after the preface. Reads
+// frames on the connection coroutine and runs every request in a coroutine
+// of its own, so responses go out in the order they are ready in. Kept
+// alive by those coroutines until the last of them is done.
+class Http2Connection : public std::enable_shared_from_this<Http2Connection> {
+ public:
+  // received holds the bytes that came after the preface
+  Http2Connection(
+      HttpServer* server,
+      arc::io::Socket<arc::net::Domain::IPV4, arc::net::Protocol::TCP,
+                      arc::io::Pattern::ASYNC>&& socket,
+      std::string_view received);
+
+  // returns once the connection is closed or broken
+  arc::coro::Task<void> Run();
+
+  // The sending side of a stream, all of them false once the stream has
+  // been reset or the connection is broken. Data waits for the flow control
+  // windows to open.
+  arc::coro::Task<bool> SendHeaders(std::uint32_t stream_id,
+                                    HttpResponse* response,
+                                    bool is_end_stream);
+  arc::coro::Task<bool> SendData(std::uint32_t stream_id,
+                                 std::string_view data, bool is_end_stream);
+  arc::coro::Task<bool> ResetStream(std::uint32_t stream_id,
+                                    Http2ErrorCode code);
+
+ private:
+  using MaybeError = std::optional<Http2ErrorCode>;
+
+  arc::coro::Task<MaybeError> HandleFrame(const Http2FrameHeader& header,
+                                          std::string_view payload);
+  arc::coro::Task<MaybeError> HandleData(const Http2FrameHeader& header,
+                                         std::string_view payload);
+  // a whole header block, after its CONTINUATION frames if any
+  arc::coro::Task<MaybeError> HandleHeaders(std::uint32_t stream_id,
+                                            std::uint8_t flags,
+                                            std::string_view block);
+  arc::coro::Task<MaybeError> HandleSettings(const Http2FrameHeader& header,
+                                             std::string_view payload);
+  arc::coro::Task<MaybeError> HandleWindowUpdate(
+      const Http2FrameHeader& header, std::string_view payload);
+  // Fills in the request of the stream, false if it is malformed. Sets
+  // error if the block cannot be decoded at all or decodes to more than
+  // kMaxHeaderListSize_, which fails the connection.
+  bool DecodeRequest(std::string_view block, Http2Stream* stream,
+                     MaybeError* error);
+  bool WriteBody(Http2Stream* stream, std::string_view data);
+  // Forgets a stream before it has ended, false if there is no such stream.
+  // Its handler keeps running and counts as open until it returns.
+  bool EraseStream(std::uint32_t stream_id);
+  void Dispatch(std::shared_ptr<Http2Stream> stream);
+  arc::coro::Task<void> RunStream(std::shared_ptr<Http2Connection> self,
+                                  std::shared_ptr<Http2Stream> stream);
+  arc::coro::Task<bool> SendResponse(std::uint32_t stream_id,
+                                     HttpResponse* response, bool is_head);
+
+  // a part of the file is sent instead of data if file is set
+  arc::coro::Task<bool> SendDataFrames(std::uint32_t stream_id,
+                                       std::string_view data,
+                                       const HttpFile* file,
+                                       std::size_t file_offset,
+                                       std::size_t size, bool is_end_stream);
+  arc::coro::Task<bool> SendFrame(Http2FrameType type, std::uint8_t flags,
+                                  std::uint32_t stream_id,
+                                  std::string_view payload);
+  arc::coro::Task<bool> SendWindowUpdate(std::uint32_t stream_id,
+                                         std::uint32_t increment);
+  arc::coro::Task<bool> GoAway(Http2ErrorCode code);
+  // with the write lock held
+  arc::coro::Task<bool> SendAll(std::string_view data);
+
+  const static std::uint32_t kDefaultWindowSize_ = 65535;
+  const static std::uint32_t kMaxWindowSize_ = 0x7FFFFFFFU;
+  const static std::uint32_t kDefaultMaxFrameSize_ = 16384;
+  const static std::uint32_t kMaxConcurrentStreams_ = 100;
+  // more streams reset by the peer within a second fail the connection, as
+  // resetting streams right after opening them lets the peer start handlers
+  // faster than they finish
+  const static std::uint32_t kMaxPeerResetsPerSecond_ = 200;
+  const static std::uint32_t kStreamWindowSize_ = 256 * 1024;
+  const static std::uint32_t kConnectionWindowSize_ = 1024 * 1024;
+  // header blocks taking more CONTINUATION frames are refused
+  const static std::size_t kMaxHeaderBlockSize_ = 256 * 1024;
+  // the most a header block may decode to, counted as in
+  // SETTINGS_MAX_HEADER_LIST_SIZE
+  const static std::uint32_t kMaxHeaderListSize_ = 64 * 1024;
+
+  HttpServer* server_{nullptr};
+  arc::io::Socket<arc::net::Domain::IPV4, arc::net::Protocol::TCP,
+                  arc::io::Pattern::ASYNC>
+      socket_;
+  HttpBuffer buffer_;
+
+  HpackDecoder decoder_;
+  HpackEncoder encoder_;
+
+  std::unordered_map<std::uint32_t, std::shared_ptr<Http2Stream>> streams_;
+  std::uint32_t last_stream_id_{0};
+  // the handlers still running for streams erased already
+  std::uint32_t erased_running_stream_num_{0};
+  // the streams reset by the peer since peer_reset_window_begin_
+  std::uint32_t peer_reset_num_{0};
+  std::chrono::steady_clock::time_point peer_reset_window_begin_;
+
+  // the header block being continued, if any
+  std::uint32_t header_block_stream_id_{0};
+  std::uint8_t header_block_flags_{0};
+  std::string header_block_;
+
+  // what the peer has set
+  std::uint32_t peer_initial_window_size_{kDefaultWindowSize_};
+  std::uint32_t peer_max_frame_size_{kDefaultMaxFrameSize_};
+
+  std::int64_t send_window_{kDefaultWindowSize_};
+  std::int64_t recv_window_{kConnectionWindowSize_};
+
+  bool is_settings_received_{false};
+  bool is_broken_{false};
+  bool is_goaway_sent_{false};
+
+  // one write at a time, header blocks have to go out in the order they
+  // are encoded in
+  arc::coro::Lock write_lock_;
+  // notified whenever a send window grows, a stream is reset or the
+  // connection is broken
+  arc::coro::Condition window_condition_;
+};
+
+}  // namespace detail
+
+}  // namespace http
+}  // namespace arc
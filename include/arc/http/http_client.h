@@ -46,7 +46,7 @@ class HttpClient {
       arc::io::Socket<D, arc::net::Protocol::TCP, arc::io::Pattern::ASYNC>>;
   HttpClient(const arc::net::Address<D>& server_addr)
       : server_addr_(server_addr) {}
-  arc::coro::Task<HttpResponse> Request(const HttpRequest& request) {
+  arc::coro::Task<HttpResponse> Request(const OwnedHttpRequest& request) {
     HttpResponse response;
     co_await conn_.Connect(server_addr_);
     auto wrote_string = arc::http::GetReturnStringFromHttpRequest(request);
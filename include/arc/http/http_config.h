@@ -28,16 +28,55 @@
 
 #include <arc/logging/logging.h>
 
+#include <cstddef>
 #include <functional>
 #include <string>
+#include <vector>
 
 namespace arc {
 namespace http {
 
 struct HttpConfig {
   unsigned int working_thread_num = 1;
+  // the CPU each working thread is pinned to, thread i to
+  // worker_cpus[i % worker_cpus.size()], empty leaves them unpinned
+  std::vector<int> worker_cpus;
+  // Hands every connection to the thread pinned to the CPU it was received
+  // on, so that the connection, its thread and their cache lines stay on one
+  // core. Needs worker_cpus with one thread per CPU and the NIC queues
+  // spread over the same CPUs. Connections received on other CPUs are
+  // spread by hash as usual.
+  bool steer_connections_by_cpu = false;
   unsigned int read_buffer_size = 1024;
-  unsigned int read_timeout_ms = -1;  // NOT USED
+  // the most connections a working thread accepts per wakeup
+  unsigned int accept_batch_size = 64;
+  // timeouts below are disabled when set to 0
+  // from the first byte of a request till the end of its headers
+  unsigned int header_read_timeout_ms = 10000;
+  // between two reads of a request body
+  unsigned int body_read_timeout_ms = 30000;
+  // waiting for the next request on a connection, or the first one
+  unsigned int keep_alive_timeout_ms = 60000;
+  // between two writes to a connection
+  unsigned int write_timeout_ms = 30000;
+  // larger request bodies are written to an unnamed temporary file in
+  // body_temp_dir as they arrive instead of being kept in memory, 0 keeps
+  // all of them in memory
+  unsigned int max_buffered_body_size = 1024 * 1024;
+  std::string body_temp_dir = "/tmp";
+  // larger request bodies are answered with 413 and the connection is
+  // closed (the stream is reset on HTTP/2), 0 for no limit
+  std::size_t max_request_body_size = 1024UL * 1024 * 1024;
+  // larger websocket messages close the connection with 1009
+  unsigned int websocket_max_message_size = 16 * 1024 * 1024;
+  // whether permessage-deflate is accepted when a client offers it
+  bool websocket_compression = true;
+  // a websocket connection receiving nothing for this long is pinged, and
+  // closed with 1001 if it stays quiet for as long again
+  unsigned int websocket_idle_timeout_ms = 60000;
+  // whether connections starting with the HTTP/2 preface are served with
+  // HTTP/2 (h2c with prior knowledge)
+  bool enable_h2c = true;
   arc::logging::Logger* logger = &arc::logging::GetLogger("");
 };
 
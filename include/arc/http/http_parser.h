@@ -452,7 +452,13 @@ void http_parser_set_max_header_size(uint32_t size);
 
 #pragma once
 
+#include <arc/utils/data_structures/small_vector.h>
+
+#include <cstddef>
+#include <memory>
+#include <optional>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 
 namespace arc {
@@ -461,7 +467,62 @@ namespace http {
 using HttpMethod = http_method;
 using HttpStatus = http_status;
 
-struct HttpRequest {
+bool EqualsIgnoreCase(std::string_view a, std::string_view b);
+
+struct HttpField {
+  std::string_view key;
+  std::string_view value;
+};
+
+// Flat storage of key value views, looked up linearly, which beats hashing
+// for the handful of fields a request usually has.
+template <bool kIgnoreCase>
+class HttpFields {
+ public:
+  constexpr static std::size_t kInlineFieldNum = 16;
+
+  // the first value of the key, if any
+  std::optional<std::string_view> Get(std::string_view key) const {
+    for (const auto &field : fields_) {
+      if (IsSameKey(field.key, key)) {
+        return field.value;
+      }
+    }
+    return std::nullopt;
+  }
+
+  inline bool Contains(std::string_view key) const {
+    return Get(key).has_value();
+  }
+
+  inline void Add(std::string_view key, std::string_view value) {
+    fields_.push_back({key, value});
+  }
+
+  inline std::size_t size() const { return fields_.size(); }
+  inline bool empty() const { return fields_.empty(); }
+  inline const HttpField *begin() const { return fields_.begin(); }
+  inline const HttpField *end() const { return fields_.end(); }
+  inline void clear() { fields_.clear(); }
+
+ private:
+  static inline bool IsSameKey(std::string_view a, std::string_view b) {
+    if constexpr (kIgnoreCase) {
+      return EqualsIgnoreCase(a, b);
+    } else {
+      return a == b;
+    }
+  }
+
+  arc::utils::SmallVector<HttpField, kInlineFieldNum> fields_;
+};
+
+using HttpHeaders = HttpFields<true>;
+using HttpParams = HttpFields<false>;
+
+// A request holding its own copies of everything, for keeping a request
+// around or building one to send.
+struct OwnedHttpRequest {
   std::string method_string;
   HttpMethod method{HttpMethod::HTTP_GET};
   std::string path;
@@ -471,11 +532,40 @@ struct HttpRequest {
   std::unordered_map<std::string, std::string> queries;
   std::string body;
 
+  std::unordered_map<std::string, std::string> RESTful_params;
+};
+
+class HttpFile;
+
+// A request parsed in place. All views point into the receive buffer of the
+// connection and are only valid until its handler returns. Copy out what
+// has to live longer, e.g. with ToOwned().
+struct HttpRequest {
+  std::string_view method_string;
+  HttpMethod method{HttpMethod::HTTP_GET};
+  // not percent decoded
+  std::string_view path;
+  std::string_view query_string;
+  unsigned short http_major_version{1};
+  unsigned short http_minor_version{1};
+  HttpHeaders headers;
+  // empty if the body has been written to body_file instead
+  std::string_view body;
+  // a temporary file holding a body too large to be kept in memory, deleted
+  // with the last reference to it
+  std::shared_ptr<const HttpFile> body_file{nullptr};
+
   bool is_complete{false};
 
-  std::unordered_map<std::string, std::string> RESTful_params;
+  HttpParams RESTful_params;
 
-  std::string temporary_store;
+  // percent decodes the query string into new strings
+  std::unordered_map<std::string, std::string> GetQueries() const;
+
+  OwnedHttpRequest ToOwned() const;
+
+  // keeps the storage for the next request on the connection
+  void Clear();
 };
 
 struct HttpResponse {
@@ -485,6 +575,11 @@ struct HttpResponse {
   std::string status_string;
   std::unordered_map<std::string, std::string> headers;
   std::string body;
+  // a part of a file sent after the body straight from the page cache, the
+  // file is kept open till then
+  std::shared_ptr<const HttpFile> file{nullptr};
+  std::size_t file_offset{0};
+  std::size_t file_length{0};
 
   bool is_complete{false};
   bool is_valid{true};
@@ -492,18 +587,131 @@ struct HttpResponse {
   std::string temporary_store;
 };
 
+// The bytes received on one connection. Requests parsed in place refer to
+// them, so they are only moved when room for more has to be made.
+class HttpBuffer {
+ public:
+  HttpBuffer(std::size_t initial_capacity);
+
+  // the received bytes not consumed yet
+  inline char *Data() { return data_.get() + begin_; }
+  inline std::size_t Size() const { return end_ - begin_; }
+
+  // room for at least min_size more bytes, may move the unconsumed bytes
+  char *PrepareWrite(std::size_t min_size);
+  inline std::size_t WritableSize() const { return capacity_ - end_; }
+  inline void Commit(std::size_t size) { end_ += size; }
+
+  void Consume(std::size_t size);
+  // drops the bytes in [offset, offset + size) of Data()
+  void Erase(std::size_t offset, std::size_t size);
+
+ private:
+  std::unique_ptr<char[]> data_{nullptr};
+  std::size_t capacity_{0};
+  std::size_t begin_{0};
+  std::size_t end_{0};
+};
+
+namespace detail {
+
+// offsets from the start of the message, so that they survive moving it
+struct HttpSpan {
+  std::size_t offset{0};
+  std::size_t length{0};
+
+  inline std::size_t End() const { return offset + length; }
+  inline std::string_view ToView(const char *message) const {
+    return std::string_view(message + offset, length);
+  }
+};
+
+struct HttpFieldSpan {
+  HttpSpan key{};
+  HttpSpan value{};
+};
+
+struct HttpRequestParseState {
+  constexpr static std::size_t kInlineHeaderNum = 16;
+
+  enum class LastField { NONE = 0U, HEADER_KEY, HEADER_VALUE };
+
+  char *message{nullptr};
+  HttpRequest *request{nullptr};
+  std::size_t parsed_size{0};
+
+  HttpSpan url{};
+  arc::utils::SmallVector<HttpFieldSpan, kInlineHeaderNum> headers{};
+  LastField last_field{LastField::NONE};
+  bool is_headers_complete{false};
+  HttpSpan body{};
+  // all of the body parsed so far, spilled or not
+  std::size_t body_size{0};
+
+  // where the body is written to once it is spilled, and from which offset
+  // on the parsed bytes are not needed any more then
+  int body_fd{-1};
+  std::size_t spill_begin{0};
+};
+
+}  // namespace detail
+
 class HttpParser {
  public:
   HttpParser(http_parser_type http_type);
-  int ParseOnce(const std::string &recv, HttpRequest *request_ptr);
+  ~HttpParser();
+
+  HttpParser(const HttpParser &) = delete;
+  HttpParser &operator=(const HttpParser &) = delete;
+
+  // Parses more of the request in the first size bytes of data. The request
+  // starts at data, and the bytes parsed by previous calls must be kept
+  // there. The parser stops at the end of the request, so the bytes after
+  // GetParsedSize() belong to the next one. The request gets filled once
+  // it is complete. Chunked bodies are joined in place. Returns 0 on
+  // success, even if the request is incomplete, otherwise an error.
+  int ParseRequest(char *data, std::size_t size, HttpRequest *request_ptr);
+
   int ParseResponse(const std::string &recv, HttpResponse *response_ptr);
 
+  inline std::size_t GetParsedSize() const { return state_.parsed_size; }
+
+  // whether the request being parsed is only missing (part of) its body
+  inline bool IsHeadersComplete() const { return state_.is_headers_complete; }
+
+  // The rest are only meaningful once the headers are complete.
+
+  // whether the client waits for a 100 Continue before sending the body
+  bool IsExpectingContinue(const char *data) const;
+
+  // the size of the body as far as it is known yet
+  std::size_t GetExpectedBodySize() const;
+
+  // Writes the body to fd, which is taken over, from now on instead of
+  // keeping it in the buffer, starting with the part parsed already. The
+  // request gets the file as body_file once complete. Returns false if the
+  // file cannot be written.
+  bool SpillBody(const char *data, int fd);
+  inline bool IsBodySpilled() const { return state_.body_fd >= 0; }
+
+  // The parsed part of a spilled body, which has to be erased from the
+  // buffer before parsing goes on.
+  detail::HttpSpan ReleaseSpilledBody();
+
+  // gets ready for the next request on the connection
+  void Reset();
+
  private:
   http_parser parser_;
+  http_parser_type http_type_;
+  detail::HttpRequestParseState state_{};
 };
 
+// appends the status line and the headers, so that the body can be sent from
+// where it is instead of being copied behind them
+void WriteHttpResponseHead(HttpResponse *response, std::string *head);
 std::string GetReturnStringFromHttpResponse(HttpResponse *response);
-std::string GetReturnStringFromHttpRequest(const HttpRequest &request);
+std::string GetReturnStringFromHttpRequest(const OwnedHttpRequest &request);
 
 }  // namespace http
 }  // namespace arc
@@ -0,0 +1,225 @@
+/*
+ * File: http_router.h
+ * Project: libarc
+ * File Created: Saturday, 17th October 2026 1:05:27 pm
+ * Author: Minjun Xu (mjxu96@outlook.com)
+ * -----
+ * MIT License
+ * Copyright (c) 2022 Minjun Xu
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "http_parser.h"
+
+namespace arc {
+namespace http {
+
+// Routes paths to values with one radix tree per method, built once at
+// registration. A path is matched in a single walk over it, trying static
+// segments first, then {param} captures, then a trailing * wildcard.
+//
+//   /api/v1/{name}/{id}   captures two whole segments as "name" and "id"
+//   /static/*             captures the rest of the path, slashes included,
+//                         as "*"
+template <typename T>
+class HttpRouter {
+ public:
+  // the most captures a route may have, as Find() keeps them on its stack
+  constexpr static std::size_t kMaxCaptureNum = 32;
+
+  // returns false if the pattern is malformed, a {param} has to span a whole
+  // segment and * may only come last, right after a /, or if it captures
+  // more than kMaxCaptureNum parts
+  bool Insert(HttpMethod method, std::string_view pattern, const T& value) {
+    Node* node = &roots_[method];
+    std::vector<std::string> param_names;
+    while (!pattern.empty()) {
+      if (pattern.front() == '{') {
+        auto close_pos = pattern.find('}');
+        if (close_pos == std::string_view::npos || close_pos == 1 ||
+            (close_pos + 1 < pattern.size() && pattern[close_pos + 1] != '/')) {
+          return false;
+        }
+        if (param_names.size() == kMaxCaptureNum) {
+          return false;
+        }
+        param_names.emplace_back(pattern.substr(1, close_pos - 1));
+        if (!node->param_child) {
+          node->param_child = std::make_unique<Node>();
+        }
+        node = node->param_child.get();
+        pattern.remove_prefix(close_pos + 1);
+      } else if (pattern.front() == '*') {
+        if (pattern.size() != 1 || param_names.size() == kMaxCaptureNum) {
+          return false;
+        }
+        param_names.emplace_back("*");
+        node->wildcard = std::make_unique<Route>(
+            Route{.value = value, .param_names = std::move(param_names)});
+        return true;
+      } else {
+        auto static_size = pattern.find_first_of("{*");
+        if (static_size != std::string_view::npos &&
+            pattern[static_size - 1] != '/') {
+          // e.g. /v{version} or /files/a*
+          return false;
+        }
+        node = InsertStatic(node, pattern.substr(0, static_size));
+        pattern.remove_prefix(std::min(static_size, pattern.size()));
+      }
+    }
+    node->route = std::make_unique<Route>(
+        Route{.value = value, .param_names = std::move(param_names)});
+    return true;
+  }
+
+  // the value routed to, with the captures added to params, or nullptr
+  const T* Find(HttpMethod method, std::string_view path,
+                HttpParams* params) const {
+    auto root_itr = roots_.find(method);
+    if (root_itr == roots_.end()) {
+      return nullptr;
+    }
+    std::string_view captures[kMaxCaptureNum];
+    const Route* route = Match(&root_itr->second, path, captures, 0);
+    if (!route) {
+      return nullptr;
+    }
+    for (std::size_t i = 0; i < route->param_names.size(); i++) {
+      params->Add(route->param_names[i], captures[i]);
+    }
+    return &route->value;
+  }
+
+ private:
+  struct Route {
+    T value;
+    std::vector<std::string> param_names;
+  };
+
+  struct Node {
+    // the static part leading to this node from its parent
+    std::string prefix;
+    // static children, which start with distinct characters
+    std::vector<std::unique_ptr<Node>> children;
+    std::unique_ptr<Node> param_child{nullptr};
+    std::unique_ptr<Route> route{nullptr};
+    std::unique_ptr<Route> wildcard{nullptr};
+  };
+
+  static Node* InsertStatic(Node* node, std::string_view str) {
+    while (!str.empty()) {
+      Node* next = nullptr;
+      for (auto& child : node->children) {
+        if (child->prefix.front() == str.front()) {
+          next = child.get();
+          break;
+        }
+      }
+      if (!next) {
+        auto child = std::make_unique<Node>();
+        child->prefix = str;
+        next = child.get();
+        node->children.push_back(std::move(child));
+        return next;
+      }
+
+      std::size_t common_size = 0;
+      while (common_size < next->prefix.size() && common_size < str.size() &&
+             next->prefix[common_size] == str[common_size]) {
+        common_size++;
+      }
+      if (common_size < next->prefix.size()) {
+        // split the child at the end of the common part
+        auto split = std::make_unique<Node>();
+        split->prefix = next->prefix.substr(0, common_size);
+        for (auto& child : node->children) {
+          if (child.get() == next) {
+            child->prefix.erase(0, common_size);
+            split->children.push_back(std::move(child));
+            child = std::move(split);
+            next = child.get();
+            break;
+          }
+        }
+      }
+      node = next;
+      str.remove_prefix(common_size);
+    }
+    return node;
+  }
+
+  static const Route* Match(const Node* node, std::string_view path,
+                            std::string_view* captures,
+                            std::size_t capture_num) {
+    if (path.empty() && node->route) {
+      return node->route.get();
+    }
+    if (!path.empty()) {
+      for (const auto& child : node->children) {
+        if (child->prefix.front() != path.front()) {
+          continue;
+        }
+        if (path.starts_with(child->prefix)) {
+          const Route* route =
+              Match(child.get(), path.substr(child->prefix.size()), captures,
+                    capture_num);
+          if (route) {
+            return route;
+          }
+        }
+        break;
+      }
+    }
+    if (node->param_child && capture_num < kMaxCaptureNum) {
+      std::string_view segment = path.substr(0, path.find('/'));
+      if (!segment.empty()) {
+        captures[capture_num] = segment;
+        const Route* route =
+            Match(node->param_child.get(), path.substr(segment.size()),
+                  captures, capture_num + 1);
+        if (route) {
+          return route;
+        }
+      }
+    }
+    if (node->wildcard && capture_num < kMaxCaptureNum) {
+      captures[capture_num] = path;
+      return node->wildcard.get();
+    }
+    return nullptr;
+  }
+
+  std::unordered_map<HttpMethod, Node> roots_;
+};
+
+}  // namespace http
+}  // namespace arc
@@ -35,23 +35,147 @@
 #include <arc/net/address.h>
 
 #include <functional>
-#include <regex>
+#include <optional>
+#include <string_view>
 #include <thread>
+#include <utility>
+#include <vector>
 
+#include "http2.h"
 #include "http_config.h"
 #include "http_parser.h"
+#include "http_router.h"
+#include "http_static.h"
+#include "websocket.h"
 
 namespace arc {
 namespace http {
 
+namespace detail {
+
+// lets string keyed maps be searched with views without a copy
+struct StringHash {
+  using is_transparent = void;
+  std::size_t operator()(std::string_view str) const {
+    return std::hash<std::string_view>{}(str);
+  }
+};
+
+// an unnamed file in dir, which is gone once closed, -1 on failure
+int OpenTempFile(const std::string& dir);
+
+// the CPU working thread i is pinned to, worker_cpus must not be empty
+int GetWorkerCpu(const HttpConfig& config, unsigned int i);
+
+// The CPUs connections are steered by, each with the index of the listening
+// socket in the SO_REUSEPORT group that gets them. The first working thread
+// pinned to a CPU gets all of its connections.
+std::vector<std::pair<int, unsigned int>> GetCpuSteering(
+    const HttpConfig& config);
+
+// Attaches a classic BPF program to the SO_REUSEPORT group of fd, picking
+// the socket given by GetCpuSteering for the CPU a connection is received
+// on. Connections received on other CPUs are spread by hash.
+bool AttachCpuSteeringProgram(int fd, const HttpConfig& config);
+
+// Responses to pipelined requests, held back until no complete request is
+// left in the receive buffer and then sent in one gathered write.
+class PipelinedResponses {
+ public:
+  // takes the response to the next request and writes its head, the body
+  // is left out for a HEAD request
+  void Add(HttpResponse&& response, bool is_head = false);
+  inline const HttpResponse& Get(std::size_t i) const { return responses_[i]; }
+
+  // the heads and bodies of the responses in [begin, end) in order, valid
+  // until the next call
+  std::vector<iovec>& GetIOVec(std::size_t begin, std::size_t end);
+  void Clear();
+
+  inline std::size_t Count() const { return responses_.size(); }
+  inline std::size_t Size() const { return size_; }
+
+ private:
+  std::vector<HttpResponse> responses_;
+  // the heads back to back, with the offset each of them ends at
+  std::string heads_;
+  std::vector<std::size_t> head_ends_;
+  std::vector<iovec> iov_;
+  std::size_t size_{0};
+};
+
+}  // namespace detail
+
+class HttpServer;
+
+// Streams the body of a response while it is being produced, instead of
+// sending it from HttpResponse::body once the handler returns. The status
+// and headers of the response are sent with the first write, after which
+// they cannot change any more. The body is chunked unless a Content-Length
+// header has been set. HTTP/1.0 clients cannot take chunks, so the body is
+// collected in HttpResponse::body for them and sent as usual. On HTTP/2 the
+// body goes out in DATA frames of the stream. Only the head is sent for a
+// HEAD request and the body written is dropped. A body that does not match
+// the Content-Length set by the handler breaks the response, the connection
+// is closed then (the stream is reset on HTTP/2).
+class HttpResponseWriter {
+ public:
+  HttpResponseWriter(
+      HttpServer* server,
+      arc::io::Socket<arc::net::Domain::IPV4, arc::net::Protocol::TCP,
+                      arc::io::Pattern::ASYNC>* socket,
+      detail::PipelinedResponses* responses, HttpResponse* response,
+      bool is_head);
+  HttpResponseWriter(detail::Http2Connection* connection,
+                     std::uint32_t stream_id, HttpResponse* response,
+                     bool is_head);
+
+  // Suspends while the connection cannot take more. Returns false if the
+  // connection is broken, the handler should stop writing then.
+  arc::coro::Task<bool> Write(std::string_view data);
+  // ends the body, done by the server if the handler has not
+  arc::coro::Task<bool> Finish();
+
+  inline bool IsStarted() const { return is_started_; }
+
+ private:
+  arc::coro::Task<bool> Start();
+  // breaks the response once the body cannot match its Content-Length
+  arc::coro::Task<bool> Break();
+
+  HttpServer* server_{nullptr};
+  arc::io::Socket<arc::net::Domain::IPV4, arc::net::Protocol::TCP,
+                  arc::io::Pattern::ASYNC>* socket_{nullptr};
+  detail::PipelinedResponses* responses_{nullptr};
+  HttpResponse* response_{nullptr};
+  detail::Http2Connection* http2_connection_{nullptr};
+  std::uint32_t stream_id_{0};
+
+  bool is_head_{false};
+  bool is_started_{false};
+  bool is_chunked_{false};
+  bool is_finished_{false};
+  bool is_broken_{false};
+  // the Content-Length set by the handler, if any
+  std::optional<std::size_t> content_length_;
+  std::size_t written_size_{0};
+  std::string head_;
+  // the size line of a chunk
+  char chunk_head_[24];
+};
+
 struct Context {
   arc::io::Socket<arc::net::Domain::IPV4, arc::net::Protocol::TCP,
                   arc::io::Pattern::ASYNC>* conn{nullptr};
+  // for the body to be written bit by bit instead of all at once
+  HttpResponseWriter* writer{nullptr};
 };
 
 class HttpServer {
  public:
   HttpServer(const HttpConfig& config = HttpConfig());
+  // Ignores SIGPIPE from then on, as files in responses are sent with
+  // sendfile.
   void Start(const std::string& ip = "0.0.0.0", uint16_t port = 8080u);
 
   void RegisterHandler(
@@ -69,14 +193,62 @@ class HttpServer {
       const std::function<arc::coro::Task<void>(
           const HttpRequest*, HttpResponse*, const Context*)>& func);
 
- private:
-  void InitDefaultHandlers();
-  bool Bind(const std::string& ip, uint16_t port);
+  // Serves GET and HEAD requests for path/... with the files under root_dir,
+  // sent with sendfile. Keeps up to cache_capacity of them open.
+  void RegisterStaticHandler(const std::string& path,
+                             const std::string& root_dir,
+                             std::size_t cache_capacity = 256);
+
+  // Takes over the connection of a websocket opening handshake for path
+  // until func returns, after which the connection is closed. Other
+  // requests for path go to the handlers above.
+  void RegisterWebSocketHandler(
+      const std::string& path,
+      const std::function<arc::coro::Task<void>(const HttpRequest*,
+                                                WebSocket*)>& func);
+
+  // Serves a connection until it is closed, the way the ones accepted after
+  // Start() are, e.g. for a connection accepted elsewhere.
   arc::coro::Task<void> HandleNewConn(
       arc::io::Socket<arc::net::Domain::IPV4, arc::net::Protocol::TCP,
                       arc::io::Pattern::ASYNC>
           socket_ptr);
-  arc::coro::Task<void> StartAccept(int i);
+
+ private:
+  friend class HttpResponseWriter;
+  friend class WebSocket;
+  friend class detail::Http2Connection;
+
+  void InitDefaultHandlers();
+  bool Bind(const std::string& ip, uint16_t port);
+  arc::coro::Task<bool> SendResponses(
+      arc::io::Socket<arc::net::Domain::IPV4, arc::net::Protocol::TCP,
+                      arc::io::Pattern::ASYNC>& socket,
+      detail::PipelinedResponses* responses);
+  // false if the connection is broken or the file got shorter
+  arc::coro::Task<bool> SendFileAll(
+      arc::io::Socket<arc::net::Domain::IPV4, arc::net::Protocol::TCP,
+                      arc::io::Pattern::ASYNC>& socket,
+      const HttpFile& file, std::size_t offset, std::size_t length);
+  // sends all of the buffers, false if the connection is broken
+  arc::coro::Task<bool> SendAll(
+      arc::io::Socket<arc::net::Domain::IPV4, arc::net::Protocol::TCP,
+                      arc::io::Pattern::ASYNC>& socket,
+      iovec* iov, int iovcnt);
+  // answers the handshake and runs func on the connection, received holds
+  // the bytes after the request
+  arc::coro::Task<void> HandleWebSocket(
+      arc::io::Socket<arc::net::Domain::IPV4, arc::net::Protocol::TCP,
+                      arc::io::Pattern::ASYNC>& socket,
+      const HttpRequest& request, std::string_view received,
+      detail::PipelinedResponses* responses,
+      const std::function<arc::coro::Task<void>(const HttpRequest*,
+                                                WebSocket*)>& func);
+  bool IsKeepAlive(const HttpRequest& request);
+  arc::coro::Task<void> HandleRequest(HttpRequest* request,
+                                      HttpResponse* response,
+                                      const Context* context);
+  arc::coro::Task<void> StartAccept(unsigned int i);
   void InnerStart();
 
   std::vector<std::shared_ptr<
@@ -86,7 +258,8 @@ class HttpServer {
       std::string,
       std::unordered_map<
           HttpMethod, std::function<arc::coro::Task<void>(
-                          const HttpRequest*, HttpResponse*, const Context*)>>>
+                          const HttpRequest*, HttpResponse*, const Context*)>>,
+      detail::StringHash, std::equal_to<>>
       handlers_;
 
   std::unordered_map<arc::http::HttpStatus,
@@ -94,16 +267,21 @@ class HttpServer {
                          const HttpRequest*, HttpResponse*, const Context*)>>
       default_handlers_;
 
-  std::string GenerateRegexStr(const std::string& path);
-  std::vector<std::string> GenerateInitialRESTfulNames(const std::string& path);
-  std::unordered_map<
-      std::string,
-      std::unordered_map<
-          HttpMethod,
-          std::pair<std::vector<std::string>,
-                    std::function<arc::coro::Task<void>(
-                        const HttpRequest*, HttpResponse*, const Context*)>>>>
-      RESTful_handlers_{};
+  // paths with {param} captures or a trailing * wildcard
+  HttpRouter<std::function<arc::coro::Task<void>(
+      const HttpRequest*, HttpResponse*, const Context*)>>
+      RESTful_router_{};
+
+  std::unordered_map<std::string,
+                     std::function<arc::coro::Task<void>(const HttpRequest*,
+                                                         WebSocket*)>,
+                     detail::StringHash, std::equal_to<>>
+      websocket_handlers_;
+
+  // pipelined responses are sent once there are this many of them or their
+  // bodies reach this size, even if more requests are buffered
+  const static std::size_t kMaxPipelinedResponseCount_ = 16;
+  const static std::size_t kMaxPipelinedResponseSize_ = 64 * 1024;
 
   HttpConfig config_;
 };
@@ -0,0 +1,148 @@
+/*
+ * File: http_static.h
+ * Project: libarc
+ * File Created: Saturday, 17th October 2026 3:42:18 pm
+ * Author: Minjun Xu (mjxu96@outlook.com)
+ * -----
+ * MIT License
+ * Copyright (c) 2022 Minjun Xu
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <sys/stat.h>
+
+#include <chrono>
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "http_parser.h"
+
+namespace arc {
+namespace http {
+
+namespace detail {
+
+// the decoded path relative to the root directory, empty if it would leave
+// it or has a NUL in it
+std::string DecodePath(std::string_view path);
+
+enum class RangeResult {
+  NONE = 0U,
+  SATISFIABLE,
+  UNSATISFIABLE,
+};
+
+// Only a single range is honoured, NONE for any other, so that the whole
+// file is sent.
+RangeResult ParseRange(std::string_view range, std::size_t file_size,
+                       std::size_t* offset, std::size_t* length);
+
+// whether an If-None-Match list has etag or * in it, compared weakly
+bool MatchesETag(std::string_view if_none_match, std::string_view etag);
+
+}  // namespace detail
+
+// An open file along with what conditional and range requests are answered
+// from. The fd is closed with the last reference to it.
+class HttpFile {
+ public:
+  HttpFile(int fd, const struct stat& file_stat);
+  ~HttpFile();
+
+  HttpFile(const HttpFile&) = delete;
+  HttpFile& operator=(const HttpFile&) = delete;
+
+  inline int GetFd() const { return fd_; }
+  inline std::size_t GetSize() const { return size_; }
+  inline const std::string& GetETag() const { return etag_; }
+  inline const std::string& GetLastModified() const { return last_modified_; }
+
+  // whether the file has been replaced or modified since it was opened
+  bool IsStale(const struct stat& file_stat) const;
+
+ private:
+  int fd_{-1};
+  std::size_t size_{0};
+  dev_t dev_{0};
+  ino_t ino_{0};
+  timespec mtime_{};
+  std::string etag_;
+  std::string last_modified_;
+};
+
+// Keeps the most recently used files under a root directory open, so that
+// serving one of them again costs no open or stat. Entries are checked
+// against the file system again once they are a second old. Thread safe.
+class HttpFileCache {
+ public:
+  HttpFileCache(const std::string& root_dir, std::size_t capacity);
+  ~HttpFileCache();
+
+  HttpFileCache(const HttpFileCache&) = delete;
+  HttpFileCache& operator=(const HttpFileCache&) = delete;
+
+  // path is relative to the root directory and must not go above it,
+  // nullptr if it is not a regular file that can be read
+  std::shared_ptr<const HttpFile> Open(const std::string& path);
+
+ private:
+  constexpr static std::chrono::seconds kRevalidateInterval{1};
+
+  struct Entry {
+    std::shared_ptr<const HttpFile> file;
+    std::chrono::steady_clock::time_point validated_at;
+    std::list<std::string>::iterator lru_itr;
+  };
+
+  std::shared_ptr<const HttpFile> OpenFile(const std::string& path);
+
+  int root_fd_{-1};
+  std::size_t capacity_{0};
+
+  std::mutex lock_;
+  // most recently used in the front
+  std::list<std::string> lru_;
+  std::unordered_map<std::string, Entry> entries_;
+};
+
+// Answers GET and HEAD requests for the files under a root directory, with
+// ETag and Last-Modified validation and single byte ranges. The file itself
+// is attached to the response instead of being read into its body.
+class HttpStaticFiles {
+ public:
+  HttpStaticFiles(const std::string& root_dir, std::size_t cache_capacity);
+
+  // path is the part of the request path below the root directory
+  void Serve(const HttpRequest& request, std::string_view path,
+             HttpResponse* response);
+
+ private:
+  HttpFileCache cache_;
+};
+
+}  // namespace http
+}  // namespace arc
@@ -0,0 +1,199 @@
+/*
+ * File: websocket.h
+ * Project: libarc
+ * File Created: Saturday, 17th October 2026 9:26:41 pm
+ * Author: Minjun Xu (mjxu96@outlook.com)
+ * -----
+ * MIT License
+ * Copyright (c) 2022 Minjun Xu
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <arc/coro/locks/lock.h>
+#include <arc/coro/task.h>
+#include <arc/io/socket.h>
+#include <arc/net/address.h>
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "http_parser.h"
+
+struct z_stream_s;
+
+namespace arc {
+namespace http {
+
+enum class WebSocketOpcode : std::uint8_t {
+  CONTINUATION = 0x0U,
+  TEXT = 0x1U,
+  BINARY = 0x2U,
+  CLOSE = 0x8U,
+  PING = 0x9U,
+  PONG = 0xAU,
+};
+
+// application defined codes go from 4000 to 4999
+enum class WebSocketCloseCode : std::uint16_t {
+  NORMAL = 1000U,
+  GOING_AWAY = 1001U,
+  PROTOCOL_ERROR = 1002U,
+  UNSUPPORTED_DATA = 1003U,
+  NO_STATUS = 1005U,
+  INVALID_PAYLOAD = 1007U,
+  POLICY_VIOLATION = 1008U,
+  MESSAGE_TOO_BIG = 1009U,
+  INTERNAL_ERROR = 1011U,
+};
+
+struct WebSocketMessage {
+  // TEXT or BINARY
+  WebSocketOpcode opcode{WebSocketOpcode::TEXT};
+  std::string_view data;
+};
+
+namespace detail {
+
+constexpr std::size_t kMaxWebSocketFrameHeaderSize = 14;
+
+struct WebSocketFrameHeader {
+  bool is_fin{false};
+  // RSV1, set on the first frame of a compressed message
+  bool is_compressed{false};
+  // RSV2 or RSV3, which no extension here defines
+  bool has_reserved_bits{false};
+  WebSocketOpcode opcode{WebSocketOpcode::CONTINUATION};
+  bool is_masked{false};
+  std::uint64_t payload_size{0};
+  unsigned char mask[4]{0};
+};
+
+// the size of the frame header at the start of data, 0 if not all of it has
+// been received yet
+std::size_t ParseWebSocketFrameHeader(const char* data, std::size_t size,
+                                      WebSocketFrameHeader* header);
+
+// writes the header of an unmasked frame to out, which has room for
+// kMaxWebSocketFrameHeaderSize bytes, and returns its size
+std::size_t WriteWebSocketFrameHeader(WebSocketOpcode opcode, bool is_fin,
+                                      bool is_compressed,
+                                      std::uint64_t payload_size, char* out);
+
+// unmasks in place, a word at a time
+void UnmaskWebSocketPayload(char* data, std::size_t size,
+                            const unsigned char mask[4]);
+
+bool IsValidUtf8(std::string_view data);
+
+// whether a close frame may carry code, which excludes the codes only meant
+// for the local side (1005, 1006, 1015) and the unassigned ones
+bool IsValidWebSocketCloseCode(std::uint16_t code);
+
+}  // namespace detail
+
+// whether the request is a websocket opening handshake that can be accepted
+bool IsWebSocketUpgrade(const HttpRequest& request);
+
+// whether the client offers permessage-deflate in a form that is accepted,
+// which is without context takeover in both directions
+bool IsWebSocketDeflateOffered(const HttpRequest& request);
+
+// the Sec-WebSocket-Accept value answering a Sec-WebSocket-Key
+std::string GetWebSocketAccept(std::string_view key);
+
+class HttpServer;
+
+// A websocket connection taken over from HttpServer once the opening
+// handshake is done. Pings are answered and closes are replied to while
+// receiving. Messages may be sent by several coroutines at once, but only
+// from the thread the connection belongs to.
+class WebSocket {
+ public:
+  // received holds the bytes that came after the upgrade request
+  WebSocket(HttpServer* server,
+            arc::io::Socket<arc::net::Domain::IPV4, arc::net::Protocol::TCP,
+                            arc::io::Pattern::ASYNC>* socket,
+            std::string_view received, bool is_deflate_enabled);
+  ~WebSocket();
+
+  WebSocket(const WebSocket&) = delete;
+  WebSocket& operator=(const WebSocket&) = delete;
+
+  // The next whole message, with fragments joined. Its data is only valid
+  // until the next call. std::nullopt once the connection is closed, by the
+  // peer, by an error or after a close has been replied to.
+  arc::coro::Task<std::optional<WebSocketMessage>> Receive();
+
+  // false if the connection is closed or broken
+  arc::coro::Task<bool> Send(std::string_view data,
+                             WebSocketOpcode opcode = WebSocketOpcode::TEXT);
+  arc::coro::Task<bool> Ping(std::string_view data = {});
+  // Starts the closing handshake, Receive() returns std::nullopt once the
+  // peer has replied. Nothing can be sent after it.
+  arc::coro::Task<bool> Close(
+      WebSocketCloseCode code = WebSocketCloseCode::NORMAL,
+      std::string_view reason = {});
+
+  inline bool IsClosed() const { return is_closed_ || is_close_sent_; }
+
+ private:
+  // sends a single frame, compressing data messages if it pays off
+  arc::coro::Task<bool> SendFrame(WebSocketOpcode opcode,
+                                  std::string_view data);
+  // fails the connection with code, always std::nullopt
+  arc::coro::Task<std::optional<WebSocketMessage>> Fail(
+      WebSocketCloseCode code);
+  // into deflated_, false if it cannot be compressed
+  bool Deflate(std::string_view data);
+  // into inflated_, the code to fail the connection with if it cannot be
+  // decompressed
+  std::optional<WebSocketCloseCode> Inflate(std::string_view data);
+
+  // messages smaller than this are not worth compressing
+  const static std::size_t kMinDeflateSize_ = 64;
+
+  HttpServer* server_{nullptr};
+  arc::io::Socket<arc::net::Domain::IPV4, arc::net::Protocol::TCP,
+                  arc::io::Pattern::ASYNC>* socket_{nullptr};
+  std::size_t max_message_size_{0};
+  bool is_deflate_enabled_{false};
+
+  // the last message is unmasked and joined in place at the front of it
+  HttpBuffer buffer_;
+  std::size_t consumed_size_{0};
+
+  bool is_closed_{false};
+  bool is_close_sent_{false};
+
+  // one frame is sent at a time
+  arc::coro::Lock send_lock_;
+
+  z_stream_s* deflater_{nullptr};
+  z_stream_s* inflater_{nullptr};
+  std::string deflated_;
+  std::string inflated_;
+};
+
+}  // namespace http
+}  // namespace arc
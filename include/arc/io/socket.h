@@ -29,6 +29,10 @@
 #ifndef LIBARC__IO__SOCKET_H
 #define LIBARC__IO__SOCKET_H
 
+#include <algorithm>
+#include <optional>
+#include <queue>
+
 #include "socket_base.h"
 
 namespace arc {
@@ -69,6 +73,16 @@ class Socket : public detail::SocketBase<AF,
       this->SetNonBlocking(true);
     }
   }
+  // takes fd as it is, e.g. accepted with SOCK_NONBLOCK already, without
+  // changing its flags
+  Socket(int fd, const net::Address<AF>& in_addr, bool is_non_blocking)
+      : detail::SocketBase<AF,
+                           ((P == net::Protocol::TCP)
+                                ? net::SocketType::STREAM
+                                : net::SocketType::DATAGRAM),
+                           P>(fd, in_addr) {
+    this->is_non_blocking_ = is_non_blocking;
+  }
   Socket(const Socket&) = delete;
   Socket& operator=(const Socket&) = delete;
   Socket(Socket&& other)
@@ -108,19 +122,21 @@ class Socket : public detail::SocketBase<AF,
     requires(UP == Pattern::ASYNC)
   auto Send(const void* data, int num) {
     return coro::IOAwaiter(
-        std::bind(&Socket<AF, P, PP>::IOReadyFunctor<PP>, this),
+        std::bind(&Socket<AF, P, PP>::SendReadyFunctor<PP>, this, data, num),
         std::bind(&Socket<AF, P, PP>::SendResumeFunctor<PP>, this, data, num),
-        this->fd_, io::IOType::WRITE);
+        this->fd_, io::IOType::WRITE,
+        coro::CompletionOp::Send(data, num));
   }
 
   template <Pattern UP = PP>
     requires(UP == Pattern::ASYNC)
   auto Send(const void* data, int num, const coro::CancellationToken& token) {
     return coro::IOAwaiter(
-        std::bind(&Socket<AF, P, PP>::IOReadyFunctor<PP>, this),
+        std::bind(&Socket<AF, P, PP>::SendReadyFunctor<PP>, this, data, num),
         std::bind(&Socket<AF, P, PP>::SendResumeFunctor<PP>, this, data, num),
         std::bind(&Socket<AF, P, PP>::SendResumeFunctor<PP>, this, data, num),
-        this->fd_, io::IOType::WRITE, token);
+        this->fd_, io::IOType::WRITE, token,
+        coro::CompletionOp::Send(data, num));
   }
 
   template <Pattern UP = PP>
@@ -128,9 +144,89 @@ class Socket : public detail::SocketBase<AF,
   auto Send(const void* data, int num,
             const std::chrono::steady_clock::duration& timeout) {
     return coro::IOAwaiter(
-        std::bind(&Socket<AF, P, PP>::IOReadyFunctor<PP>, this),
+        std::bind(&Socket<AF, P, PP>::SendReadyFunctor<PP>, this, data, num),
         std::bind(&Socket<AF, P, PP>::SendResumeFunctor<PP>, this, data, num),
         std::bind(&Socket<AF, P, PP>::SendResumeFunctor<PP>, this, data, num),
+        this->fd_, io::IOType::WRITE, timeout,
+        coro::CompletionOp::Send(data, num));
+  }
+
+  // gathers the buffers into one send, may send only part of them
+  template <net::Protocol UP = P, Pattern UPP = PP>
+    requires(UP == net::Protocol::TCP) && (UPP == Pattern::SYNC)
+  ssize_t SendV(const iovec* iov, int iovcnt) {
+    return ParentType::template SendV<UP>(iov, iovcnt);
+  }
+
+  template <net::Protocol UP = P, Pattern UPP = PP>
+    requires(UP == net::Protocol::TCP) && (UPP == Pattern::ASYNC)
+  auto SendV(const iovec* iov, int iovcnt) {
+    return coro::IOAwaiter(
+        std::bind(&Socket<AF, P, PP>::SendVReadyFunctor<PP>, this, iov,
+                  iovcnt),
+        std::bind(&Socket<AF, P, PP>::SendVResumeFunctor<PP>, this, iov,
+                  iovcnt),
+        this->fd_, io::IOType::WRITE);
+  }
+
+  template <net::Protocol UP = P, Pattern UPP = PP>
+    requires(UP == net::Protocol::TCP) && (UPP == Pattern::ASYNC)
+  auto SendV(const iovec* iov, int iovcnt,
+             const coro::CancellationToken& token) {
+    return coro::IOAwaiter(
+        std::bind(&Socket<AF, P, PP>::SendVReadyFunctor<PP>, this, iov,
+                  iovcnt),
+        std::bind(&Socket<AF, P, PP>::SendVResumeFunctor<PP>, this, iov,
+                  iovcnt),
+        std::bind(&Socket<AF, P, PP>::SendVResumeFunctor<PP>, this, iov,
+                  iovcnt),
+        this->fd_, io::IOType::WRITE, token);
+  }
+
+  template <net::Protocol UP = P, Pattern UPP = PP>
+    requires(UP == net::Protocol::TCP) && (UPP == Pattern::ASYNC)
+  auto SendV(const iovec* iov, int iovcnt,
+             const std::chrono::steady_clock::duration& timeout) {
+    return coro::IOAwaiter(
+        std::bind(&Socket<AF, P, PP>::SendVReadyFunctor<PP>, this, iov,
+                  iovcnt),
+        std::bind(&Socket<AF, P, PP>::SendVResumeFunctor<PP>, this, iov,
+                  iovcnt),
+        std::bind(&Socket<AF, P, PP>::SendVResumeFunctor<PP>, this, iov,
+                  iovcnt),
+        this->fd_, io::IOType::WRITE, timeout);
+  }
+
+  // sends count bytes of in_fd from *offset on, which gets advanced by what
+  // has been sent, may send only part of them
+  template <net::Protocol UP = P, Pattern UPP = PP>
+    requires(UP == net::Protocol::TCP) && (UPP == Pattern::SYNC)
+  ssize_t SendFile(int in_fd, off_t* offset, std::size_t count) {
+    return ParentType::template SendFile<UP>(in_fd, offset, count);
+  }
+
+  template <net::Protocol UP = P, Pattern UPP = PP>
+    requires(UP == net::Protocol::TCP) && (UPP == Pattern::ASYNC)
+  auto SendFile(int in_fd, off_t* offset, std::size_t count) {
+    return coro::IOAwaiter(
+        std::bind(&Socket<AF, P, PP>::SendFileReadyFunctor<PP>, this, in_fd,
+                  offset, count),
+        std::bind(&Socket<AF, P, PP>::SendFileResumeFunctor<PP>, this, in_fd,
+                  offset, count),
+        this->fd_, io::IOType::WRITE);
+  }
+
+  template <net::Protocol UP = P, Pattern UPP = PP>
+    requires(UP == net::Protocol::TCP) && (UPP == Pattern::ASYNC)
+  auto SendFile(int in_fd, off_t* offset, std::size_t count,
+                const std::chrono::steady_clock::duration& timeout) {
+    return coro::IOAwaiter(
+        std::bind(&Socket<AF, P, PP>::SendFileReadyFunctor<PP>, this, in_fd,
+                  offset, count),
+        std::bind(&Socket<AF, P, PP>::SendFileResumeFunctor<PP>, this, in_fd,
+                  offset, count),
+        std::bind(&Socket<AF, P, PP>::SendFileResumeFunctor<PP>, this, in_fd,
+                  offset, count),
         this->fd_, io::IOType::WRITE, timeout);
   }
 
@@ -144,10 +240,12 @@ class Socket : public detail::SocketBase<AF,
     requires(UP == net::Protocol::TCP) && (UPP == Pattern::ASYNC)
   auto Recv(char* buf, int max_recv_bytes) {
     return coro::IOAwaiter(
-        std::bind(&Socket<AF, P, PP>::IOReadyFunctor<PP>, this),
+        std::bind(&Socket<AF, P, PP>::RecvReadyFunctor<PP>, this, buf,
+                  max_recv_bytes),
         std::bind(&Socket<AF, P, PP>::RecvResumeFunctor<PP>, this, buf,
                   max_recv_bytes),
-        this->fd_, io::IOType::READ);
+        this->fd_, io::IOType::READ,
+        coro::CompletionOp::Recv(buf, max_recv_bytes));
   }
 
   template <net::Protocol UP = P, Pattern UPP = PP>
@@ -155,12 +253,14 @@ class Socket : public detail::SocketBase<AF,
   auto Recv(char* buf, int max_recv_bytes,
             const coro::CancellationToken& token) {
     return coro::IOAwaiter(
-        std::bind(&Socket<AF, P, PP>::IOReadyFunctor<PP>, this),
+        std::bind(&Socket<AF, P, PP>::RecvReadyFunctor<PP>, this, buf,
+                  max_recv_bytes),
         std::bind(&Socket<AF, P, PP>::RecvResumeFunctor<PP>, this, buf,
                   max_recv_bytes),
         std::bind(&Socket<AF, P, PP>::RecvResumeFunctor<PP>, this, buf,
                   max_recv_bytes),
-        this->fd_, io::IOType::READ, token);
+        this->fd_, io::IOType::READ, token,
+        coro::CompletionOp::Recv(buf, max_recv_bytes));
   }
 
   template <net::Protocol UP = P, Pattern UPP = PP>
@@ -168,12 +268,14 @@ class Socket : public detail::SocketBase<AF,
   auto Recv(char* buf, int max_recv_bytes,
             const std::chrono::steady_clock::duration& timeout) {
     return coro::IOAwaiter(
-        std::bind(&Socket<AF, P, PP>::IOReadyFunctor<PP>, this),
+        std::bind(&Socket<AF, P, PP>::RecvReadyFunctor<PP>, this, buf,
+                  max_recv_bytes),
         std::bind(&Socket<AF, P, PP>::RecvResumeFunctor<PP>, this, buf,
                   max_recv_bytes),
         std::bind(&Socket<AF, P, PP>::RecvResumeFunctor<PP>, this, buf,
                   max_recv_bytes),
-        this->fd_, io::IOType::READ, timeout);
+        this->fd_, io::IOType::READ, timeout,
+        coro::CompletionOp::Recv(buf, max_recv_bytes));
   }
 
   template <net::Protocol UP = P, Pattern UPP = PP>
@@ -195,24 +297,273 @@ class Socket : public detail::SocketBase<AF,
   }
 
   // UDP
-  // TODO add coroutine functions
   template <net::Protocol UP = P, Pattern UPP = PP>
     requires(UP == net::Protocol::UDP) && (UPP == Pattern::SYNC)
   int SendTo(const void* data, int num, const net::Address<AF>& addr) {
-    return ParentType::SendTo<AF>(data, num, &addr);
+    return ParentType::template SendTo<AF>(data, num, &addr);
+  }
+
+  template <net::Protocol UP = P, Pattern UPP = PP>
+    requires(UP == net::Protocol::UDP) && (UPP == Pattern::ASYNC)
+  auto SendTo(const void* data, int num, const net::Address<AF>& addr) {
+    return coro::IOAwaiter(
+        std::bind(&Socket<AF, P, PP>::SendToReadyFunctor<PP>, this, data, num,
+                  addr),
+        std::bind(&Socket<AF, P, PP>::SendToResumeFunctor<PP>, this, data,
+                  num, addr),
+        this->fd_, io::IOType::WRITE);
   }
 
   template <net::Protocol UP = P, Pattern UPP = PP>
     requires(UP == net::Protocol::UDP) && (UPP == Pattern::SYNC)
   ssize_t RecvFrom(char* buf, int max_recv_bytes, net::Address<AF>& addr) {
-    return ParentType::RecvFrom<AF>(buf, max_recv_bytes, &addr);
+    return ParentType::template RecvFrom<AF>(buf, max_recv_bytes, &addr);
+  }
+
+  template <net::Protocol UP = P, Pattern UPP = PP>
+    requires(UP == net::Protocol::UDP) && (UPP == Pattern::ASYNC)
+  auto RecvFrom(char* buf, int max_recv_bytes, net::Address<AF>& addr) {
+    return coro::IOAwaiter(
+        std::bind(&Socket<AF, P, PP>::RecvFromReadyFunctor<PP>, this, buf,
+                  max_recv_bytes, &addr),
+        std::bind(&Socket<AF, P, PP>::RecvFromResumeFunctor<PP>, this, buf,
+                  max_recv_bytes, &addr),
+        this->fd_, io::IOType::READ);
+  }
+
+  template <net::Protocol UP = P, Pattern UPP = PP>
+    requires(UP == net::Protocol::UDP) && (UPP == Pattern::ASYNC)
+  auto RecvFrom(char* buf, int max_recv_bytes, net::Address<AF>& addr,
+                const coro::CancellationToken& token) {
+    return coro::IOAwaiter(
+        std::bind(&Socket<AF, P, PP>::RecvFromReadyFunctor<PP>, this, buf,
+                  max_recv_bytes, &addr),
+        std::bind(&Socket<AF, P, PP>::RecvFromResumeFunctor<PP>, this, buf,
+                  max_recv_bytes, &addr),
+        std::bind(&Socket<AF, P, PP>::RecvFromResumeFunctor<PP>, this, buf,
+                  max_recv_bytes, &addr),
+        this->fd_, io::IOType::READ, token);
+  }
+
+  template <net::Protocol UP = P, Pattern UPP = PP>
+    requires(UP == net::Protocol::UDP) && (UPP == Pattern::ASYNC)
+  auto RecvFrom(char* buf, int max_recv_bytes, net::Address<AF>& addr,
+                const std::chrono::steady_clock::duration& timeout) {
+    return coro::IOAwaiter(
+        std::bind(&Socket<AF, P, PP>::RecvFromReadyFunctor<PP>, this, buf,
+                  max_recv_bytes, &addr),
+        std::bind(&Socket<AF, P, PP>::RecvFromResumeFunctor<PP>, this, buf,
+                  max_recv_bytes, &addr),
+        std::bind(&Socket<AF, P, PP>::RecvFromResumeFunctor<PP>, this, buf,
+                  max_recv_bytes, &addr),
+        this->fd_, io::IOType::READ, timeout);
+  }
+
+  // Sends up to kMaxDatagramBatchSize datagrams with one syscall, returns
+  // how many of them have been sent, which may be fewer than count, or -1.
+  template <net::Protocol UP = P, Pattern UPP = PP>
+    requires(UP == net::Protocol::UDP) && (UPP == Pattern::SYNC)
+  int SendBatch(const Datagram<AF>* datagrams, unsigned int count) {
+    return ParentType::template SendBatch<AF>(datagrams, count);
+  }
+
+  template <net::Protocol UP = P, Pattern UPP = PP>
+    requires(UP == net::Protocol::UDP) && (UPP == Pattern::ASYNC)
+  auto SendBatch(const Datagram<AF>* datagrams, unsigned int count) {
+    return coro::IOAwaiter(
+        std::bind(&Socket<AF, P, PP>::SendBatchReadyFunctor<PP>, this,
+                  datagrams, count),
+        std::bind(&Socket<AF, P, PP>::SendBatchResumeFunctor<PP>, this,
+                  datagrams, count),
+        this->fd_, io::IOType::WRITE);
+  }
+
+  // Receives up to kMaxDatagramBatchSize datagrams with one syscall, returns
+  // how many of them have been received or -1.
+  template <net::Protocol UP = P, Pattern UPP = PP>
+    requires(UP == net::Protocol::UDP) && (UPP == Pattern::SYNC)
+  int RecvBatch(Datagram<AF>* datagrams, unsigned int count) {
+    return ParentType::template RecvBatch<AF>(datagrams, count);
+  }
+
+  template <net::Protocol UP = P, Pattern UPP = PP>
+    requires(UP == net::Protocol::UDP) && (UPP == Pattern::ASYNC)
+  auto RecvBatch(Datagram<AF>* datagrams, unsigned int count) {
+    return coro::IOAwaiter(
+        std::bind(&Socket<AF, P, PP>::RecvBatchReadyFunctor<PP>, this,
+                  datagrams, count),
+        std::bind(&Socket<AF, P, PP>::RecvBatchResumeFunctor<PP>, this,
+                  datagrams, count),
+        this->fd_, io::IOType::READ);
+  }
+
+  template <net::Protocol UP = P, Pattern UPP = PP>
+    requires(UP == net::Protocol::UDP) && (UPP == Pattern::ASYNC)
+  auto RecvBatch(Datagram<AF>* datagrams, unsigned int count,
+                 const coro::CancellationToken& token) {
+    return coro::IOAwaiter(
+        std::bind(&Socket<AF, P, PP>::RecvBatchReadyFunctor<PP>, this,
+                  datagrams, count),
+        std::bind(&Socket<AF, P, PP>::RecvBatchResumeFunctor<PP>, this,
+                  datagrams, count),
+        std::bind(&Socket<AF, P, PP>::RecvBatchResumeFunctor<PP>, this,
+                  datagrams, count),
+        this->fd_, io::IOType::READ, token);
+  }
+
+  template <net::Protocol UP = P, Pattern UPP = PP>
+    requires(UP == net::Protocol::UDP) && (UPP == Pattern::ASYNC)
+  auto RecvBatch(Datagram<AF>* datagrams, unsigned int count,
+                 const std::chrono::steady_clock::duration& timeout) {
+    return coro::IOAwaiter(
+        std::bind(&Socket<AF, P, PP>::RecvBatchReadyFunctor<PP>, this,
+                  datagrams, count),
+        std::bind(&Socket<AF, P, PP>::RecvBatchResumeFunctor<PP>, this,
+                  datagrams, count),
+        std::bind(&Socket<AF, P, PP>::RecvBatchResumeFunctor<PP>, this,
+                  datagrams, count),
+        this->fd_, io::IOType::READ, timeout);
+  }
+
+  // lets the kernel coalesce datagrams of a flow into one received buffer,
+  // see Datagram::segment_size
+  template <net::Protocol UP = P>
+    requires(UP == net::Protocol::UDP)
+  void SetGro(bool is_enabled = true) {
+    int opt_value = is_enabled ? 1 : 0;
+    if (setsockopt(this->fd_, IPPROTO_UDP, UDP_GRO, &opt_value,
+                   sizeof(opt_value)) < 0) {
+      throw arc::exception::IOException();
+    }
   }
 
  protected:
+  // Try the io right away if the poller already knows the fd is ready, so
+  // that the awaiter does not need to suspend. This only happens with the
+  // edge-triggered poller backend.
   template <Pattern UPP = PP>
-    requires(UPP == Pattern::ASYNC) bool
-  IOReadyFunctor() {
-    return false;
+    requires(UPP == Pattern::ASYNC)
+  std::optional<ssize_t> SendReadyFunctor(const void* buf, int num) {
+    auto& event_loop = coro::EventLoop::GetLocalInstance();
+    if (!event_loop.IsIOReady(this->fd_, io::IOType::WRITE)) {
+      return std::nullopt;
+    }
+    ssize_t ret = ParentType::template Send<P>(buf, num);
+    if (ret < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      event_loop.ResetIOReady(this->fd_, io::IOType::WRITE);
+      return std::nullopt;
+    }
+    return ret;
+  }
+
+  template <Pattern UPP = PP>
+    requires(UPP == Pattern::ASYNC)
+  std::optional<ssize_t> SendVReadyFunctor(const iovec* iov, int iovcnt) {
+    auto& event_loop = coro::EventLoop::GetLocalInstance();
+    if (!event_loop.IsIOReady(this->fd_, io::IOType::WRITE)) {
+      return std::nullopt;
+    }
+    ssize_t ret = ParentType::template SendV<P>(iov, iovcnt);
+    if (ret < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      event_loop.ResetIOReady(this->fd_, io::IOType::WRITE);
+      return std::nullopt;
+    }
+    return ret;
+  }
+
+  template <Pattern UPP = PP>
+    requires(UPP == Pattern::ASYNC)
+  std::optional<ssize_t> SendFileReadyFunctor(int in_fd, off_t* offset,
+                                              std::size_t count) {
+    auto& event_loop = coro::EventLoop::GetLocalInstance();
+    if (!event_loop.IsIOReady(this->fd_, io::IOType::WRITE)) {
+      return std::nullopt;
+    }
+    ssize_t ret = ParentType::template SendFile<P>(in_fd, offset, count);
+    if (ret < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      event_loop.ResetIOReady(this->fd_, io::IOType::WRITE);
+      return std::nullopt;
+    }
+    return ret;
+  }
+
+  template <Pattern UPP = PP>
+    requires(UPP == Pattern::ASYNC)
+  std::optional<ssize_t> RecvReadyFunctor(char* buf, int num) {
+    auto& event_loop = coro::EventLoop::GetLocalInstance();
+    if (!event_loop.IsIOReady(this->fd_, io::IOType::READ)) {
+      return std::nullopt;
+    }
+    ssize_t ret = ParentType::template Recv<P>(buf, num);
+    if (ret < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      event_loop.ResetIOReady(this->fd_, io::IOType::READ);
+      return std::nullopt;
+    }
+    return ret;
+  }
+
+  template <Pattern UPP = PP>
+    requires(UPP == Pattern::ASYNC)
+  std::optional<ssize_t> SendToReadyFunctor(const void* buf, int num,
+                                            const net::Address<AF>& addr) {
+    auto& event_loop = coro::EventLoop::GetLocalInstance();
+    if (!event_loop.IsIOReady(this->fd_, io::IOType::WRITE)) {
+      return std::nullopt;
+    }
+    ssize_t ret = ParentType::template SendTo<AF>(buf, num, &addr);
+    if (ret < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      event_loop.ResetIOReady(this->fd_, io::IOType::WRITE);
+      return std::nullopt;
+    }
+    return ret;
+  }
+
+  template <Pattern UPP = PP>
+    requires(UPP == Pattern::ASYNC)
+  std::optional<ssize_t> RecvFromReadyFunctor(char* buf, int num,
+                                              net::Address<AF>* addr) {
+    auto& event_loop = coro::EventLoop::GetLocalInstance();
+    if (!event_loop.IsIOReady(this->fd_, io::IOType::READ)) {
+      return std::nullopt;
+    }
+    ssize_t ret = ParentType::template RecvFrom<AF>(buf, num, addr);
+    if (ret < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      event_loop.ResetIOReady(this->fd_, io::IOType::READ);
+      return std::nullopt;
+    }
+    return ret;
+  }
+
+  template <Pattern UPP = PP>
+    requires(UPP == Pattern::ASYNC)
+  std::optional<int> SendBatchReadyFunctor(const Datagram<AF>* datagrams,
+                                           unsigned int count) {
+    auto& event_loop = coro::EventLoop::GetLocalInstance();
+    if (!event_loop.IsIOReady(this->fd_, io::IOType::WRITE)) {
+      return std::nullopt;
+    }
+    int ret = ParentType::template SendBatch<AF>(datagrams, count);
+    if (ret < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      event_loop.ResetIOReady(this->fd_, io::IOType::WRITE);
+      return std::nullopt;
+    }
+    return ret;
+  }
+
+  template <Pattern UPP = PP>
+    requires(UPP == Pattern::ASYNC)
+  std::optional<int> RecvBatchReadyFunctor(Datagram<AF>* datagrams,
+                                           unsigned int count) {
+    auto& event_loop = coro::EventLoop::GetLocalInstance();
+    if (!event_loop.IsIOReady(this->fd_, io::IOType::READ)) {
+      return std::nullopt;
+    }
+    int ret = ParentType::template RecvBatch<AF>(datagrams, count);
+    if (ret < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      event_loop.ResetIOReady(this->fd_, io::IOType::READ);
+      return std::nullopt;
+    }
+    return ret;
   }
 
   template <Pattern UPP = PP>
@@ -231,14 +582,92 @@ class Socket : public detail::SocketBase<AF,
   template <Pattern UPP = PP>
     requires(UPP == Pattern::ASYNC)
   ssize_t SendResumeFunctor(const void* buf, int num) {
-    return ParentType::template Send<P>(buf, num);
+    ssize_t ret = ParentType::template Send<P>(buf, num);
+    if (ret < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) [[unlikely]] {
+      coro::EventLoop::GetLocalInstance().ResetIOReady(this->fd_,
+                                                       io::IOType::WRITE);
+    }
+    return ret;
+  }
+
+  template <Pattern UPP = PP>
+    requires(UPP == Pattern::ASYNC)
+  ssize_t SendVResumeFunctor(const iovec* iov, int iovcnt) {
+    ssize_t ret = ParentType::template SendV<P>(iov, iovcnt);
+    if (ret < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) [[unlikely]] {
+      coro::EventLoop::GetLocalInstance().ResetIOReady(this->fd_,
+                                                       io::IOType::WRITE);
+    }
+    return ret;
+  }
+
+  template <Pattern UPP = PP>
+    requires(UPP == Pattern::ASYNC)
+  ssize_t SendFileResumeFunctor(int in_fd, off_t* offset, std::size_t count) {
+    ssize_t ret = ParentType::template SendFile<P>(in_fd, offset, count);
+    if (ret < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) [[unlikely]] {
+      coro::EventLoop::GetLocalInstance().ResetIOReady(this->fd_,
+                                                       io::IOType::WRITE);
+    }
+    return ret;
   }
 
   template <Pattern UPP = PP>
     requires(UPP == Pattern::ASYNC)
   ssize_t RecvResumeFunctor(char* buf, int num) {
-    return ParentType::template Recv<P>(buf, num);
+    ssize_t ret = ParentType::template Recv<P>(buf, num);
+    if (ret < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) [[unlikely]] {
+      coro::EventLoop::GetLocalInstance().ResetIOReady(this->fd_,
+                                                       io::IOType::READ);
+    }
+    return ret;
+  }
+  template <Pattern UPP = PP>
+    requires(UPP == Pattern::ASYNC)
+  ssize_t SendToResumeFunctor(const void* buf, int num,
+                              const net::Address<AF>& addr) {
+    ssize_t ret = ParentType::template SendTo<AF>(buf, num, &addr);
+    if (ret < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) [[unlikely]] {
+      coro::EventLoop::GetLocalInstance().ResetIOReady(this->fd_,
+                                                       io::IOType::WRITE);
+    }
+    return ret;
+  }
+
+  template <Pattern UPP = PP>
+    requires(UPP == Pattern::ASYNC)
+  ssize_t RecvFromResumeFunctor(char* buf, int num, net::Address<AF>* addr) {
+    ssize_t ret = ParentType::template RecvFrom<AF>(buf, num, addr);
+    if (ret < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) [[unlikely]] {
+      coro::EventLoop::GetLocalInstance().ResetIOReady(this->fd_,
+                                                       io::IOType::READ);
+    }
+    return ret;
   }
+
+  template <Pattern UPP = PP>
+    requires(UPP == Pattern::ASYNC)
+  int SendBatchResumeFunctor(const Datagram<AF>* datagrams,
+                             unsigned int count) {
+    int ret = ParentType::template SendBatch<AF>(datagrams, count);
+    if (ret < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) [[unlikely]] {
+      coro::EventLoop::GetLocalInstance().ResetIOReady(this->fd_,
+                                                       io::IOType::WRITE);
+    }
+    return ret;
+  }
+
+  template <Pattern UPP = PP>
+    requires(UPP == Pattern::ASYNC)
+  int RecvBatchResumeFunctor(Datagram<AF>* datagrams, unsigned int count) {
+    int ret = ParentType::template RecvBatch<AF>(datagrams, count);
+    if (ret < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) [[unlikely]] {
+      coro::EventLoop::GetLocalInstance().ResetIOReady(this->fd_,
+                                                       io::IOType::READ);
+    }
+    return ret;
+  }
+
   template <Pattern UPP = PP>
     requires(UPP == Pattern::ASYNC)
   void ConnectResumeFunctor() {
@@ -264,6 +693,12 @@ class Acceptor : virtual public Socket<AF, net::Protocol::TCP, PP> {
     is_listened_ = true;
   }
 
+  // the most connections accepted at once when the socket becomes readable,
+  // the rest of the backlog is accepted by the next calls
+  void SetAcceptBatchSize(int batch_size) {
+    accept_batch_size_ = std::max(batch_size, 1);
+  }
+
   template <Pattern UPP = PP>
     requires(UPP == Pattern::SYNC)
   Socket<AF, net::Protocol::TCP, PP> Accept() {
@@ -280,52 +715,121 @@ class Acceptor : virtual public Socket<AF, net::Protocol::TCP, PP> {
 
   template <Pattern UPP = PP>
     requires(UPP == Pattern::ASYNC)
-  auto Accept() {
-    return coro::IOAwaiter(
-        std::bind(&Acceptor<AF, UPP>::template IOReadyFunctor<UPP>, this),
-        std::bind(&Acceptor<AF, UPP>::template GetNextAvailableSocket<UPP>,
-                  this),
-        this->fd_, io::IOType::READ);
+  coro::Task<Socket<AF, net::Protocol::TCP, PP>> Accept() {
+    if (coro::EventLoop::GetLocalInstance().IsCompletionBased()) {
+      co_return co_await AcceptOne<UPP>();
+    }
+    while (true) {
+      auto next_socket = co_await coro::IOAwaiter(
+          std::bind(&Acceptor<AF, UPP>::template IOReadyFunctor<UPP>, this),
+          std::bind(&Acceptor<AF, UPP>::template GetNextAvailableSocket<UPP>,
+                    this),
+          this->fd_, io::IOType::READ);
+      if (next_socket) {
+        co_return std::move(*next_socket);
+      }
+      // woken up, but the connections were gone before they could be
+      // accepted, so wait for the next ones
+    }
   }
 
  protected:
   template <Pattern UPP = PP>
     requires(UPP == Pattern::ASYNC) bool
   IOReadyFunctor() {
+    if (accepted_sockets_.empty() &&
+        coro::EventLoop::GetLocalInstance().IsIOReady(this->fd_,
+                                                      io::IOType::READ)) {
+      AcceptAll<UPP>();
+    }
     return !accepted_sockets_.empty();
   }
 
+  // Accepts up to accept_batch_size_ connections, already non blocking and
+  // close-on-exec. Only EAGAIN resets the cached readiness of the fd, so
+  // the fd stays ready if the batch ends before the backlog does.
   template <Pattern UPP = PP>
     requires(UPP == Pattern::ASYNC)
-  Socket<AF, net::Protocol::TCP, UPP> GetNextAvailableSocket() {
-    if (!accepted_sockets_.empty()) {
-      Socket<AF, net::Protocol::TCP, UPP> next_socket =
-          std::move(accepted_sockets_.front());
-      accepted_sockets_.pop();
-      return std::move(next_socket);
+  void AcceptAll() {
+    typename detail::SocketBase<AF, net::SocketType::STREAM,
+                                net::Protocol::TCP>::CAddressType in_addr;
+    for (int i = 0; i < accept_batch_size_; i++) {
+      socklen_t addrlen = sizeof(in_addr);
+      int accept_fd = accept4(this->fd_, (struct sockaddr*)&in_addr, &addrlen,
+                              SOCK_NONBLOCK | SOCK_CLOEXEC);
+      if (accept_fd < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+          coro::EventLoop::GetLocalInstance().ResetIOReady(this->fd_,
+                                                           io::IOType::READ);
+          break;
+        }
+        // reset by the peer while still in the backlog
+        if (errno == ECONNABORTED || errno == EINTR) {
+          continue;
+        }
+        throw arc::exception::IOException("Accept Error");
+      }
+      accepted_sockets_.emplace(accept_fd, in_addr, true);
     }
+  }
+
+  // Leaves the accept to the kernel, one connection per completion.
+  template <Pattern UPP = PP>
+    requires(UPP == Pattern::ASYNC)
+  coro::Task<Socket<AF, net::Protocol::TCP, UPP>> AcceptOne() {
     typename detail::SocketBase<AF, net::SocketType::STREAM,
                                 net::Protocol::TCP>::CAddressType in_addr;
-    socklen_t addrlen = sizeof(in_addr);
-    int accept_fd = 0;
-    while (accept_fd == 0) {
-      int accept_fd =
-          accept(this->fd_, (struct sockaddr*)&in_addr, (socklen_t*)&addrlen);
-      if (accept_fd < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+    while (true) {
+      socklen_t addrlen = sizeof(in_addr);
+      int accept_fd = co_await coro::IOAwaiter(
+          std::bind(&Acceptor<AF, UPP>::template AcceptOneReadyFunctor<UPP>,
+                    this),
+          std::bind(&Acceptor<AF, UPP>::template AcceptOneResumeFunctor<UPP>,
+                    this, &in_addr, &addrlen),
+          this->fd_, io::IOType::READ,
+          coro::CompletionOp::Accept((struct sockaddr*)&in_addr, &addrlen));
+      if (accept_fd >= 0) {
+        co_return Socket<AF, net::Protocol::TCP, UPP>(accept_fd, in_addr, true);
+      }
+      // reset by the peer while still in the backlog
+      if (errno != ECONNABORTED && errno != EINTR && errno != EAGAIN) {
         throw arc::exception::IOException("Accept Error");
       }
-      if (accept_fd < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
-        break;
+    }
+  }
+
+  template <Pattern UPP = PP>
+    requires(UPP == Pattern::ASYNC)
+  bool AcceptOneReadyFunctor() {
+    return false;
+  }
+
+  // only called if the event loop does not leave the accept to the kernel
+  template <Pattern UPP = PP>
+    requires(UPP == Pattern::ASYNC)
+  int AcceptOneResumeFunctor(void* in_addr, socklen_t* addrlen) {
+    return accept4(this->fd_, (struct sockaddr*)in_addr, addrlen,
+                   SOCK_NONBLOCK | SOCK_CLOEXEC);
+  }
+
+  // std::nullopt if nothing has been left to accept
+  template <Pattern UPP = PP>
+    requires(UPP == Pattern::ASYNC)
+  std::optional<Socket<AF, net::Protocol::TCP, UPP>> GetNextAvailableSocket() {
+    if (accepted_sockets_.empty()) {
+      AcceptAll<UPP>();
+      if (accepted_sockets_.empty()) {
+        return std::nullopt;
       }
-      accepted_sockets_.emplace(accept_fd, in_addr);
     }
-    Socket<AF, net::Protocol::TCP, UPP> next_socket =
-        std::move(accepted_sockets_.front());
+    std::optional<Socket<AF, net::Protocol::TCP, UPP>> next_socket(
+        std::move(accepted_sockets_.front()));
     accepted_sockets_.pop();
-    return std::move(next_socket);
+    return next_socket;
   }
 
   std::queue<Socket<AF, net::Protocol::TCP, PP>> accepted_sockets_;
+  int accept_batch_size_{64};
   bool is_listened_{false};
 };
 
@@ -40,9 +40,16 @@
 #include <arc/net/address.h>
 #include <fcntl.h>
 #include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/udp.h>
+#include <sys/sendfile.h>
 #include <sys/socket.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
 #include <functional>
 #include <iostream>
 
@@ -53,6 +60,23 @@
 namespace arc {
 namespace io {
 
+// the most datagrams sent or received by one batch call
+constexpr unsigned int kMaxDatagramBatchSize = 64;
+
+// One datagram of a batch. Sending takes size bytes of data to addr, split
+// by the kernel into datagrams of segment_size bytes if it is not 0 (UDP
+// GSO). Receiving fills up to capacity bytes of data, sets size and the
+// sender in addr, and sets segment_size to the size of the datagrams the
+// kernel has coalesced into data if UDP GRO is on, or to 0 for a single one.
+template <net::Domain AF = net::Domain::IPV4>
+struct Datagram {
+  char* data{nullptr};
+  std::size_t capacity{0};
+  std::size_t size{0};
+  net::Address<AF> addr{};
+  std::uint16_t segment_size{0};
+};
+
 namespace detail {
 
 template <net::Domain AF = net::Domain::IPV4,
@@ -178,6 +202,30 @@ class SocketBase : public IOBase {
     return Send<UP>(data, num);
   }
 
+  // sendmsg rather than writev, which cannot be told not to raise SIGPIPE
+  template <net::Protocol UP = P>
+    requires(UP != net::Protocol::UDP)
+  ssize_t SendV(const iovec* iov, int iovcnt, int flags = MSG_NOSIGNAL) {
+    msghdr msg{};
+    msg.msg_iov = const_cast<iovec*>(iov);
+    msg.msg_iovlen = iovcnt;
+    return sendmsg(this->fd_, &msg, flags);
+  }
+
+  template <net::Protocol UP = P>
+    requires(UP != net::Protocol::UDP)
+  ssize_t Writev(const iovec* iov, int iovcnt) {
+    return SendV<UP>(iov, iovcnt);
+  }
+
+  // Unlike send, sendfile raises SIGPIPE on a connection closed by the peer
+  // unless the signal is ignored.
+  template <net::Protocol UP = P>
+    requires(UP != net::Protocol::UDP)
+  ssize_t SendFile(int in_fd, off_t* offset, std::size_t count) {
+    return sendfile(this->fd_, in_fd, offset, count);
+  }
+
   template <net::Domain UAF, net::Protocol UP = P>
     requires(UP == net::Protocol::UDP)
   ssize_t SendTo(const void* data, int num, const net::Address<UAF>* addr) {
@@ -202,16 +250,92 @@ class SocketBase : public IOBase {
   template <net::Domain UAF, net::Protocol UP = P>
     requires(UP == net::Protocol::UDP)
   ssize_t RecvFrom(char* buf, int max_recv_bytes, net::Address<UAF>* addr) {
-    sockaddr in_addr;
-    socklen_t in_addr_len;
-    ssize_t tmp_read =
-        recvfrom(this->fd_, buf, max_recv_bytes, 0, &in_addr, &in_addr_len);
+    CAddressType in_addr;
+    socklen_t in_addr_len = sizeof(in_addr);
+    ssize_t tmp_read = recvfrom(this->fd_, buf, max_recv_bytes, 0,
+                                (sockaddr*)&in_addr, &in_addr_len);
     if (tmp_read >= 0) {
-      (*addr) = *((CAddressType*)(&in_addr));
+      (*addr) = in_addr;
     }
     return tmp_read;
   }
 
+  // one sendmmsg for up to kMaxDatagramBatchSize datagrams, returns how many
+  // of them have been sent
+  template <net::Domain UAF, net::Protocol UP = P>
+    requires(UP == net::Protocol::UDP)
+  int SendBatch(const Datagram<UAF>* datagrams, unsigned int count) {
+    count = std::min(count, kMaxDatagramBatchSize);
+    mmsghdr msgs[kMaxDatagramBatchSize];
+    iovec iov[kMaxDatagramBatchSize];
+    // room for a UDP_SEGMENT message each
+    alignas(cmsghdr) char
+        control[kMaxDatagramBatchSize][CMSG_SPACE(sizeof(std::uint16_t))];
+    for (unsigned int i = 0; i < count; i++) {
+      const Datagram<UAF>& datagram = datagrams[i];
+      iov[i] = {datagram.data, datagram.size};
+      msghdr& msg = msgs[i].msg_hdr;
+      msg = {};
+      msg.msg_name = const_cast<sockaddr*>(datagram.addr.GetCStyleAddress());
+      msg.msg_namelen = datagram.addr.AddressSize();
+      msg.msg_iov = &iov[i];
+      msg.msg_iovlen = 1;
+      if (datagram.segment_size > 0) {
+        msg.msg_control = control[i];
+        msg.msg_controllen = sizeof(control[i]);
+        cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = IPPROTO_UDP;
+        cmsg->cmsg_type = UDP_SEGMENT;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(std::uint16_t));
+        std::memcpy(CMSG_DATA(cmsg), &datagram.segment_size,
+                    sizeof(std::uint16_t));
+      }
+    }
+    return sendmmsg(this->fd_, msgs, count, 0);
+  }
+
+  // one recvmmsg for up to kMaxDatagramBatchSize datagrams, returns how many
+  // of them have been received
+  template <net::Domain UAF, net::Protocol UP = P>
+    requires(UP == net::Protocol::UDP)
+  int RecvBatch(Datagram<UAF>* datagrams, unsigned int count) {
+    count = std::min(count, kMaxDatagramBatchSize);
+    mmsghdr msgs[kMaxDatagramBatchSize];
+    iovec iov[kMaxDatagramBatchSize];
+    CAddressType addrs[kMaxDatagramBatchSize];
+    // room for the UDP_GRO message of each
+    alignas(cmsghdr) char
+        control[kMaxDatagramBatchSize][CMSG_SPACE(sizeof(int))];
+    for (unsigned int i = 0; i < count; i++) {
+      iov[i] = {datagrams[i].data, datagrams[i].capacity};
+      msghdr& msg = msgs[i].msg_hdr;
+      msg = {};
+      msg.msg_name = &addrs[i];
+      msg.msg_namelen = sizeof(addrs[i]);
+      msg.msg_iov = &iov[i];
+      msg.msg_iovlen = 1;
+      msg.msg_control = control[i];
+      msg.msg_controllen = sizeof(control[i]);
+    }
+    int ret = recvmmsg(this->fd_, msgs, count, 0, nullptr);
+    for (int i = 0; i < ret; i++) {
+      Datagram<UAF>& datagram = datagrams[i];
+      datagram.size = msgs[i].msg_len;
+      datagram.addr = addrs[i];
+      datagram.segment_size = 0;
+      msghdr& msg = msgs[i].msg_hdr;
+      for (cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg;
+           cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+        if (cmsg->cmsg_level == IPPROTO_UDP && cmsg->cmsg_type == UDP_GRO) {
+          int segment_size = 0;
+          std::memcpy(&segment_size, CMSG_DATA(cmsg), sizeof(segment_size));
+          datagram.segment_size = segment_size;
+        }
+      }
+    }
+    return ret;
+  }
+
  private:
   void MoveFrom(SocketBase&& other) {
     addr_ = std::move(other.addr_);
@@ -64,6 +64,7 @@ enum class SocketLevel {
 enum class SocketOption {
   REUSEADDR = SO_REUSEADDR,
   REUSEPORT = SO_REUSEPORT,
+  INCOMING_CPU = SO_INCOMING_CPU,
 };
 
 }  // namespace net
@@ -0,0 +1,119 @@
+/*
+ * File: small_vector.h
+ * Project: libarc
+ * File Created: Saturday, 17th October 2026 11:20:43 am
+ * Author: Minjun Xu (mjxu96@outlook.com)
+ * -----
+ * MIT License
+ * Copyright (c) 2020 Minjun Xu
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef LIBARC__UTILS__DATA_STRUCTURES__SMALL_VECTOR_H
+#define LIBARC__UTILS__DATA_STRUCTURES__SMALL_VECTOR_H
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+
+namespace arc {
+namespace utils {
+
+// A vector keeping up to N elements inline, only going to the heap when it
+// grows beyond that. Limited to trivially copyable elements, e.g. views.
+template <typename T, std::size_t N>
+  requires std::is_trivially_copyable_v<T>
+class SmallVector {
+ public:
+  SmallVector() = default;
+
+  SmallVector(const SmallVector& other) { Assign(other); }
+
+  SmallVector& operator=(const SmallVector& other) {
+    if (std::addressof(other) != this) {
+      clear();
+      Assign(other);
+    }
+    return *this;
+  }
+
+  inline std::size_t size() const { return size_; }
+  inline bool empty() const { return size_ == 0; }
+
+  inline T* begin() { return data_; }
+  inline T* end() { return data_ + size_; }
+  inline const T* begin() const { return data_; }
+  inline const T* end() const { return data_ + size_; }
+
+  inline T& operator[](std::size_t i) {
+    assert(i < size_);
+    return data_[i];
+  }
+
+  inline const T& operator[](std::size_t i) const {
+    assert(i < size_);
+    return data_[i];
+  }
+
+  inline T& back() {
+    assert(size_ > 0);
+    return data_[size_ - 1];
+  }
+
+  void push_back(const T& value) {
+    if (size_ == capacity_) [[unlikely]] {
+      Grow(capacity_ * 2);
+    }
+    data_[size_++] = value;
+  }
+
+  // keeps the capacity, so a reused vector does not allocate again
+  inline void clear() { size_ = 0; }
+
+ private:
+  void Grow(std::size_t capacity) {
+    std::unique_ptr<T[]> heap_data(new T[capacity]);
+    std::copy(data_, data_ + size_, heap_data.get());
+    heap_data_ = std::move(heap_data);
+    data_ = heap_data_.get();
+    capacity_ = capacity;
+  }
+
+  void Assign(const SmallVector& other) {
+    if (other.size_ > capacity_) {
+      Grow(other.size_);
+    }
+    std::copy(other.begin(), other.end(), data_);
+    size_ = other.size_;
+  }
+
+  T inline_data_[N];
+  std::unique_ptr<T[]> heap_data_{nullptr};
+  T* data_{inline_data_};
+  std::size_t size_{0};
+  std::size_t capacity_{N};
+};
+
+}  // namespace utils
+}  // namespace arc
+
+#endif /* LIBARC__UTILS__DATA_STRUCTURES__SMALL_VECTOR_H */
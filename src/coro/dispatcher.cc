@@ -28,9 +28,192 @@
 
 #include <arc/coro/dispatcher.h>
 
+#include <random>
+#include <thread>
+
 using namespace arc::coro;
 
+CoroutineDispatcher::CoroutineDispatcher()
+    : kMaxAllowedProducerCount_(std::thread::hardware_concurrency()) {
+  table_.store(new detail::ConsumerTable(kMaxInVecQueueCount_));
+}
+
+CoroutineDispatcher::~CoroutineDispatcher() {
+  auto table = table_.load();
+  for (EventLoopWakeUpHandle id : table->consumer_ids) {
+    auto queue_ptr = table->GetCoroutineQueue(id);
+    assert(queue_ptr != nullptr);
+    delete queue_ptr;
+  }
+  delete table;
+}
+
 CoroutineDispatcher& CoroutineDispatcher::GetInstance() {
   static CoroutineDispatcher dispatcher;
   return dispatcher;
 }
+
+CoroutineQueue* CoroutineDispatcher::Register(
+    EventLoopWakeUpHandle consumer_id, ConsumerPolicy policy,
+    std::atomic<bool>* is_consumer_sleeping) {
+  std::lock_guard guard(table_update_lock_);
+  auto table = table_.load();
+  if (table->GetCoroutineQueue(consumer_id)) {
+    throw arc::exception::detail::ExceptionBase(
+        "Consumer id " + std::to_string(consumer_id) +
+        " has already been registered.");
+  }
+
+  auto queue_ptr = new CoroutineQueue(kCoroutineQueueDefaultSize_, 0,
+                                      kMaxAllowedProducerCount_, consumer_id,
+                                      policy, is_consumer_sleeping);
+  auto new_table = new detail::ConsumerTable(*table);
+  if (consumer_id < kMaxInVecQueueCount_) {
+    new_table->queues[consumer_id] = queue_ptr;
+  } else {
+    new_table->extra_queues[consumer_id] = queue_ptr;
+  }
+  new_table->consumer_ids.push_back(consumer_id);
+  if (policy == ConsumerPolicy::WORK_STEALING) {
+    new_table->stealer_ids.push_back(consumer_id);
+  }
+  UpdateTable(new_table);
+  return queue_ptr;
+}
+
+void CoroutineDispatcher::DeRegister(EventLoopWakeUpHandle consumer_id) {
+  std::vector<std::coroutine_handle<void>> coroutines;
+  {
+    std::lock_guard guard(table_update_lock_);
+    auto table = table_.load();
+    auto queue_ptr = table->GetCoroutineQueue(consumer_id);
+    if (!queue_ptr) {
+      throw arc::exception::detail::ExceptionBase(
+          "Consumer id " + std::to_string(consumer_id) +
+          " has not been registered before.");
+    }
+
+    auto new_table = new detail::ConsumerTable(*table);
+    if (consumer_id < kMaxInVecQueueCount_) {
+      new_table->queues[consumer_id] = nullptr;
+    } else {
+      new_table->extra_queues.erase(consumer_id);
+    }
+    std::erase(new_table->consumer_ids, consumer_id);
+    std::erase(new_table->stealer_ids, consumer_id);
+    UpdateTable(new_table);
+
+    // no producer or stealer can reach this queue any more
+    coroutines = queue_ptr->DequeAll(queue_ptr->GetRemainedItemsCount());
+    delete queue_ptr;
+  }
+
+  if (!coroutines.empty()) {
+    TableReadGuard table(*this);
+    if (!table->consumer_ids.empty()) {
+      EnqueueAllToAny(table.Get(), coroutines.begin(), coroutines.size());
+    }
+  }
+}
+
+std::vector<std::coroutine_handle<void>> CoroutineDispatcher::Steal(
+    EventLoopWakeUpHandle thief_id) {
+  TableReadGuard table(*this);
+  auto ret = TrySteal(table.Get(), thief_id);
+  if (!ret.empty()) {
+    return ret;
+  }
+
+  auto thief_queue_ptr = table->GetCoroutineQueue(thief_id);
+  thief_queue_ptr->SetParked(true);
+  // pairs with the one in WakeUpStealer(), a producer which has not seen
+  // the parked flag must have its coroutines seen by the second try
+  std::atomic_thread_fence(std::memory_order::seq_cst);
+  ret = TrySteal(table.Get(), thief_id);
+  if (!ret.empty()) {
+    thief_queue_ptr->SetParked(false);
+  }
+  return ret;
+}
+
+std::vector<std::coroutine_handle<void>> CoroutineDispatcher::TrySteal(
+    const detail::ConsumerTable* table, EventLoopWakeUpHandle thief_id) {
+  CoroutineQueue* victim_queue_ptr = nullptr;
+  int victim_count = 0;
+  for (EventLoopWakeUpHandle id : table->stealer_ids) {
+    if (id == thief_id) {
+      continue;
+    }
+    auto queue_ptr = table->GetCoroutineQueue(id);
+    int count = queue_ptr->GetStealableItemsCount();
+    if (count > victim_count) {
+      victim_queue_ptr = queue_ptr;
+      victim_count = count;
+    }
+  }
+
+  std::vector<std::coroutine_handle<void>> ret;
+  if (victim_queue_ptr) {
+    ret.resize(std::min(victim_count, kMaxStealCount_), nullptr);
+    ret.resize(victim_queue_ptr->StealBulk(&ret[0], ret.size()));
+  }
+  return ret;
+}
+
+EventLoopWakeUpHandle CoroutineDispatcher::GetLessLoadedOfTwoConsumers(
+    const detail::ConsumerTable* table) {
+  thread_local std::minstd_rand random_engine(std::random_device{}());
+  int size = table->consumer_ids.size();
+  if (size == 1) {
+    return table->consumer_ids[0];
+  }
+  int first_index = random_engine() % size;
+  // a different one from the first
+  int second_index = (first_index + 1 + random_engine() % (size - 1)) % size;
+  EventLoopWakeUpHandle first_id = table->consumer_ids[first_index];
+  EventLoopWakeUpHandle second_id = table->consumer_ids[second_index];
+  if (table->GetCoroutineQueue(second_id)->GetLoad() <
+      table->GetCoroutineQueue(first_id)->GetLoad()) {
+    return second_id;
+  }
+  return first_id;
+}
+
+EventLoopWakeUpHandle CoroutineDispatcher::GetLeastLoadedConsumer(
+    const detail::ConsumerTable* table) {
+  EventLoopWakeUpHandle least_loaded_id = table->consumer_ids[0];
+  std::int64_t least_load =
+      table->GetCoroutineQueue(least_loaded_id)->GetLoad();
+  for (EventLoopWakeUpHandle id : table->consumer_ids) {
+    std::int64_t load = table->GetCoroutineQueue(id)->GetLoad();
+    if (load < least_load) {
+      least_loaded_id = id;
+      least_load = load;
+    }
+  }
+  return least_loaded_id;
+}
+
+int CoroutineDispatcher::GetReaderCounterIndex() {
+  static std::atomic<int> next_index{0};
+  thread_local int index =
+      next_index.fetch_add(1, std::memory_order::relaxed) %
+      kReaderCounterCount_;
+  return index;
+}
+
+void CoroutineDispatcher::UpdateTable(detail::ConsumerTable* table) {
+  auto old_table = table_.exchange(table);
+  // Flip the epoch twice. Readers counted in the old epoch may still hold the
+  // old table. Readers which read the old epoch but counted themselves after
+  // the first flip hold the new table, and are waited for by the next update.
+  for (int i = 0; i < 2; i++) {
+    unsigned int index = epoch_.fetch_add(1) & 1;
+    for (auto& reader_counter : reader_counters_) {
+      while (reader_counter.counts[index].load() != 0) {
+        std::this_thread::yield();
+      }
+    }
+  }
+  delete old_table;
+}
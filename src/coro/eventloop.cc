@@ -47,8 +47,14 @@ inline EventLoopType operator~(EventLoopType a) {
   return static_cast<EventLoopType>(~static_cast<int>(a));
 }
 
+std::atomic<PollerBackend> EventLoop::default_poller_backend_{
+    PollerBackend::EPOLL};
+std::atomic<TimerBackend> EventLoop::default_timer_backend_{
+    TimerBackend::PRIORITY_QUEUE};
+
 EventLoop::EventLoop() {
-  poller_ = new Poller();
+  poller_ = new Poller(default_poller_backend_.load(),
+                       default_timer_backend_.load());
   id_ = EventLoopGroup::GetInstance().RegisterEventLoop(this);
 }
 
@@ -82,6 +88,10 @@ void EventLoop::Do() {
   }
 
   Trim();
+
+  if (dispatcher_queue_) {
+    ReportLoad();
+  }
 }
 
 EventLoop& EventLoop::GetLocalInstance() {
@@ -89,6 +99,14 @@ EventLoop& EventLoop::GetLocalInstance() {
   return loop;
 }
 
+void EventLoop::SetDefaultPollerBackend(PollerBackend backend) {
+  default_poller_backend_.store(backend);
+}
+
+void EventLoop::SetDefaultTimerBackend(TimerBackend backend) {
+  default_timer_backend_.store(backend);
+}
+
 void EventLoop::AddToCleanUpCoroutine(std::coroutine_handle<> handle) {
   to_clean_up_handles_.push_back(handle);
 }
@@ -100,9 +118,15 @@ void EventLoop::CleanUpFinishedCoroutines() {
   to_clean_up_handles_.clear();
 }
 
-void EventLoop::Dispatch(arc::coro::Task<void>&& task) {
+void EventLoop::Dispatch(arc::coro::Task<void>&& task,
+                         DispatchPolicy policy) {
   task.SetNeedClean(true);
-  to_randomly_dispatched_coroutines_.push_back(task.GetCoroutine());
+  if (policy == DispatchPolicy::ROUND_ROBIN) {
+    to_randomly_dispatched_coroutines_.push_back(task.GetCoroutine());
+  } else {
+    to_load_aware_dispatched_coroutines_.push_back(
+        {task.GetCoroutine(), policy});
+  }
   to_dispatched_coroutines_count_++;
 }
 
@@ -119,11 +143,13 @@ void EventLoop::DispatchTo(arc::coro::Task<void>&& task,
   to_dispatched_coroutines_count_++;
 }
 
-void EventLoop::ResigerConsumer() {
+void EventLoop::ResigerConsumer(ConsumerPolicy policy) {
   event_loop_type_ = EventLoopType::CONSUMER | event_loop_type_;
+  consumer_policy_ = policy;
   global_dispatcher_ = &CoroutineDispatcher::GetInstance();
   register_id_ = poller_->Register();
-  dispatcher_queue_ = global_dispatcher_->Register(register_id_);
+  dispatcher_queue_ = global_dispatcher_->Register(
+      register_id_, policy, poller_->GetSleepingFlag());
 }
 
 void EventLoop::DeResigerConsumer() {
@@ -134,6 +160,8 @@ void EventLoop::DeResigerConsumer() {
     poller_->DeRegister();
     dispatcher_queue_ = nullptr;
     register_id_ = -1;
+    average_iteration_time_ = 0;
+    consumer_policy_ = ConsumerPolicy::NO_STEALING;
   }
 }
 
@@ -150,8 +178,9 @@ void EventLoop::DeResigerProducer() {
 }
 
 void EventLoop::Trim() {
+  bool has_coroutines_to_consume = false;
   if ((EventLoopType::CONSUMER & event_loop_type_) == EventLoopType::CONSUMER) {
-    ConsumeCoroutine();
+    has_coroutines_to_consume = ConsumeCoroutine();
   }
   if ((EventLoopType::PRODUCER & event_loop_type_) == EventLoopType::PRODUCER) {
     ProduceCoroutine();
@@ -163,20 +192,68 @@ void EventLoop::Trim() {
 
   CleanUpFinishedCoroutines();
 
-  if (to_dispatched_coroutines_count_ != 0) [[unlikely]] {
+  if (to_dispatched_coroutines_count_ != 0 || has_coroutines_to_consume)
+      [[unlikely]] {
     poller_->SetNextTimeNoWait();
+  } else if (poller_->WillWait()) {
+    // Other threads only wake us up once we are sleeping, so what they have
+    // published before that has to be checked here.
+    poller_->SetSleeping(true);
+    if (HasPendingWakeUp()) {
+      poller_->SetSleeping(false);
+      poller_->SetNextTimeNoWait();
+    }
   }
 }
 
-void EventLoop::ConsumeCoroutine() {
+bool EventLoop::HasPendingWakeUp() {
+  if (dispatcher_queue_) {
+    if (dispatcher_queue_->GetRemainedItemsCount() > 0) {
+      return true;
+    }
+    if (consumer_policy_ == ConsumerPolicy::WORK_STEALING &&
+        !dispatcher_queue_->IsParked()) {
+      return true;
+    }
+  }
+  return poller_->HasTriggeredEvents();
+}
+
+bool EventLoop::ConsumeCoroutine() {
   auto triggered_count = dispatcher_queue_->GetRemainedItemsCount();
-  if (triggered_count == 0) {
-    return;
+  if (triggered_count > 0) {
+    auto coroutines = dispatcher_queue_->DequeAll(triggered_count);
+    for (auto& coro : coroutines) {
+      coro.resume();
+    }
+  }
+  if (consumer_policy_ != ConsumerPolicy::WORK_STEALING) {
+    return false;
   }
-  auto coroutines = dispatcher_queue_->DequeAll(triggered_count);
-  for (auto& coro : coroutines) {
-    coro.resume();
+
+  // do not steal while deregistering
+  if ((EventLoopType::CONSUMER & event_loop_type_) == EventLoopType::CONSUMER &&
+      !dispatcher_queue_->IsParked()) {
+    auto stolen_coroutines = global_dispatcher_->Steal(register_id_);
+    for (auto& coro : stolen_coroutines) {
+      coro.resume();
+    }
   }
+  // keep stealing until being parked
+  return dispatcher_queue_->GetRemainedItemsCount() > 0 ||
+         !dispatcher_queue_->IsParked();
+}
+
+void EventLoop::ReportLoad() {
+  // the busy part of this iteration, excluding the time blocked in waiting
+  std::int64_t iteration_time =
+      std::chrono::duration_cast<std::chrono::microseconds>(
+          std::chrono::steady_clock::now() - poller_->GetCurrentTime())
+          .count();
+  average_iteration_time_ +=
+      (iteration_time - average_iteration_time_) / kLoadAverageWeight_;
+  dispatcher_queue_->ReportLoad(poller_->GetIOEventsCount(),
+                                average_iteration_time_);
 }
 
 void EventLoop::ProduceCoroutine() {
@@ -202,6 +279,19 @@ void EventLoop::ProduceCoroutine() {
       to_randomly_dispatched_coroutines_.clear();
     }
   }
+  // load aware ones are placed one by one, so that each of them sees the load
+  // added by the previous ones
+  auto load_aware_itr = to_load_aware_dispatched_coroutines_.begin();
+  while (load_aware_itr != to_load_aware_dispatched_coroutines_.end()) {
+    if (global_dispatcher_->EnqueueToAny(std::move(load_aware_itr->first),
+                                         load_aware_itr->second)) {
+      load_aware_itr =
+          to_load_aware_dispatched_coroutines_.erase(load_aware_itr);
+      to_dispatched_coroutines_count_--;
+    } else {
+      break;
+    }
+  }
   auto map_itr = to_dispatched_coroutines_with_dests_.begin();
   while (map_itr != to_dispatched_coroutines_with_dests_.end()) {
     assert(!map_itr->second.empty());
@@ -0,0 +1,102 @@
+/*
+ * File: event_allocator.cc
+ * Project: libarc
+ * File Created: Friday, 16th October 2026 11:48:05 am
+ * Author: Minjun Xu (mjxu96@outlook.com)
+ * -----
+ * MIT License
+ * Copyright (c) 2020 Minjun Xu
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <arc/coro/events/event_allocator.h>
+
+#include <new>
+
+using namespace arc::coro::detail;
+
+namespace {
+
+struct FreeBlock {
+  FreeBlock* next{nullptr};
+};
+
+struct EventFreeLists {
+  FreeBlock* heads[EventAllocator::kSizeClassNum] = {nullptr};
+  std::size_t counts[EventAllocator::kSizeClassNum] = {0};
+
+  ~EventFreeLists();
+};
+
+// the free lists may be gone while events are still deleted during thread
+// exit, e.g. by the thread local event loop, so remember that
+thread_local bool is_free_lists_destroyed = false;
+thread_local EventFreeLists free_lists;
+
+EventFreeLists::~EventFreeLists() {
+  is_free_lists_destroyed = true;
+  for (auto head : heads) {
+    while (head) {
+      FreeBlock* next = head->next;
+      ::operator delete(head);
+      head = next;
+    }
+  }
+}
+
+inline std::size_t GetSizeClass(std::size_t size) {
+  return (size + EventAllocator::kAlignment - 1) / EventAllocator::kAlignment -
+         1;
+}
+
+}  // namespace
+
+void* EventAllocator::Allocate(std::size_t size) {
+  if (size > kMaxPooledSize || is_free_lists_destroyed) [[unlikely]] {
+    return ::operator new(size);
+  }
+  std::size_t size_class = GetSizeClass(size);
+  FreeBlock* block = free_lists.heads[size_class];
+  if (!block) {
+    return ::operator new((size_class + 1) * kAlignment);
+  }
+  free_lists.heads[size_class] = block->next;
+  free_lists.counts[size_class]--;
+  return block;
+}
+
+void EventAllocator::Deallocate(void* ptr, std::size_t size) {
+  if (!ptr) [[unlikely]] {
+    return;
+  }
+  if (size > kMaxPooledSize || is_free_lists_destroyed) [[unlikely]] {
+    ::operator delete(ptr);
+    return;
+  }
+  std::size_t size_class = GetSizeClass(size);
+  if (free_lists.counts[size_class] >= kMaxCachedBlocksPerClass) {
+    ::operator delete(ptr);
+    return;
+  }
+  FreeBlock* block = new (ptr) FreeBlock();
+  block->next = free_lists.heads[size_class];
+  free_lists.heads[size_class] = block;
+  free_lists.counts[size_class]++;
+}
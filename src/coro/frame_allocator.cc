@@ -0,0 +1,113 @@
+/*
+ * File: frame_allocator.cc
+ * Project: libarc
+ * File Created: Friday, 16th October 2026 4:27:40 pm
+ * Author: Minjun Xu (mjxu96@outlook.com)
+ * -----
+ * MIT License
+ * Copyright (c) 2020 Minjun Xu
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <arc/coro/frame_allocator.h>
+
+#include <new>
+
+using namespace arc::coro::detail;
+
+namespace {
+
+struct FreeFrame {
+  FreeFrame* next{nullptr};
+};
+
+struct FrameFreeLists {
+  FreeFrame* heads[FrameAllocator::kSizeClassNum] = {nullptr};
+  std::size_t counts[FrameAllocator::kSizeClassNum] = {0};
+
+  ~FrameFreeLists();
+};
+
+// coroutine frames may still be destroyed during thread exit after the free
+// lists are gone, e.g. by the thread local event loop, so remember that
+thread_local bool is_free_lists_destroyed = false;
+thread_local FrameFreeLists free_lists;
+
+FrameFreeLists::~FrameFreeLists() {
+  is_free_lists_destroyed = true;
+  for (auto head : heads) {
+    while (head) {
+      FreeFrame* next = head->next;
+      ::operator delete(head);
+      head = next;
+    }
+  }
+}
+
+inline std::size_t GetSizeClass(std::size_t size) {
+  return (size + FrameAllocator::kAlignment - 1) / FrameAllocator::kAlignment -
+         1;
+}
+
+inline std::size_t GetMaxCachedFrames(std::size_t size_class) {
+  return FrameAllocator::kMaxCachedBytesPerClass /
+         ((size_class + 1) * FrameAllocator::kAlignment);
+}
+
+}  // namespace
+
+void* FrameAllocator::Allocate(std::size_t size) {
+  std::size_t total_size =
+      GetDeallocateFunctionOffset(size) + sizeof(DeallocateFunction);
+  void* ptr = nullptr;
+  if (total_size > kMaxPooledSize || is_free_lists_destroyed) [[unlikely]] {
+    ptr = ::operator new(total_size);
+  } else {
+    std::size_t size_class = GetSizeClass(total_size);
+    FreeFrame* frame = free_lists.heads[size_class];
+    if (!frame) {
+      ptr = ::operator new((size_class + 1) * kAlignment);
+    } else {
+      free_lists.heads[size_class] = frame->next;
+      free_lists.counts[size_class]--;
+      ptr = frame;
+    }
+  }
+  SetDeallocateFunction(ptr, size, &DeallocatePooled);
+  return ptr;
+}
+
+void FrameAllocator::DeallocatePooled(void* ptr, std::size_t size) {
+  std::size_t total_size =
+      GetDeallocateFunctionOffset(size) + sizeof(DeallocateFunction);
+  if (total_size > kMaxPooledSize || is_free_lists_destroyed) [[unlikely]] {
+    ::operator delete(ptr);
+    return;
+  }
+  std::size_t size_class = GetSizeClass(total_size);
+  if (free_lists.counts[size_class] >= GetMaxCachedFrames(size_class)) {
+    ::operator delete(ptr);
+    return;
+  }
+  FreeFrame* frame = new (ptr) FreeFrame();
+  frame->next = free_lists.heads[size_class];
+  free_lists.heads[size_class] = frame;
+  free_lists.counts[size_class]++;
+}
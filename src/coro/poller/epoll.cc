@@ -28,17 +28,43 @@
 
 #include <arc/coro/poller/epoll.h>
 #include <arc/exception/io.h>
+#include <poll.h>
 #include <sys/eventfd.h>
+#include <sys/timerfd.h>
 
+#include <algorithm>
 #include <iostream>
 
 using namespace arc;
 using namespace arc::coro;
 
-Poller::Poller() {
-  fd_ = epoll_create1(0);
-  if (fd_ < 0) {
-    throw arc::exception::IOException("Epoll Creation Error");
+Poller::Poller(PollerBackend backend, TimerBackend timer_backend)
+    : backend_(backend),
+      timer_backend_(timer_backend),
+      current_time_point_(std::chrono::steady_clock::now()),
+      current_time_(ToTimeEventTime(current_time_point_)),
+      timer_wheel_(current_time_) {
+  if (backend_ == PollerBackend::IO_URING && !ring_.Init(kIOUringEntries_)) {
+    backend_ = PollerBackend::EPOLL;
+  }
+  if (backend_ != PollerBackend::IO_URING) {
+    fd_ = epoll_create1(0);
+    if (fd_ < 0) {
+      throw arc::exception::IOException("Epoll Creation Error");
+    }
+    // steady_clock is CLOCK_MONOTONIC, the timer is armed with absolute
+    // wakeup times so the clock need not be read before every wait
+    timer_fd_ = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (timer_fd_ < 0) {
+      throw arc::exception::IOException("TimerFd Creation Error");
+    }
+    // edge triggered, re-arming resets the expiration so it is never read
+    epoll_event e_event{};
+    e_event.events = EPOLLIN | EPOLLET;
+    e_event.data.fd = timer_fd_;
+    if (epoll_ctl(fd_, EPOLL_CTL_ADD, timer_fd_, &e_event) != 0) {
+      throw arc::exception::IOException("Epoll Error When Adding TimerFd");
+    }
   }
   user_event_fd_ = eventfd(0, EFD_NONBLOCK);
   if (user_event_fd_ < 0) {
@@ -46,6 +72,7 @@ Poller::Poller() {
   }
   interesting_fds_.reserve(kMaxFdInArray_);
   std::fill(std::begin(io_prev_events_), std::end(io_prev_events_), 0);
+  std::fill(std::begin(io_ready_events_), std::end(io_ready_events_), 0);
 }
 
 Poller::~Poller() {
@@ -53,50 +80,39 @@ Poller::~Poller() {
   if (user_event_fd_ >= 0) {
     close(user_event_fd_);
   }
+  if (timer_fd_ >= 0) {
+    close(timer_fd_);
+  }
 }
 
 int Poller::WaitEvents(coro::EventBase** todo_events) {
-  int event_cnt =
-      epoll_wait(fd_, events_, kMaxEventsSizePerWait, next_wait_timeout_);
-  int todo_cnt = 0;
-
   bool is_user_event_triggered = false;
-  bool is_dispatched_triggered = false;
 
   // io events
-  for (int i = 0; i < event_cnt; i++) {
-    int fd = events_[i].data.fd;
-    if (fd == user_event_fd_) {
-      is_user_event_triggered = true;
-      assert(events_[i].events & EPOLLIN);
-      continue;
-    }
-    int event_type = events_[i].events;
-    if (event_type & EPOLLIN) {
-      todo_events[todo_cnt] = PopIOEvent(fd, io::IOType::READ);
-      self_triggered_event_ids_[todo_cnt] = todo_events[todo_cnt]->GetEventID();
-      todo_cnt++;
-    }
-    if (event_type & EPOLLOUT) {
-      todo_events[todo_cnt] = PopIOEvent(fd, io::IOType::WRITE);
-      self_triggered_event_ids_[todo_cnt] = todo_events[todo_cnt]->GetEventID();
-      todo_cnt++;
-    }
-    if (event_type && ((event_type & EPOLLIN) == 0) &&
-        ((event_type & EPOLLOUT) == 0)) {
-      throw arc::exception::IOException(
-          "Returned Epoll Events Are Not Supported" +
-          std::to_string(event_type));
-    }
+  int todo_cnt = 0;
+  switch (backend_) {
+    case PollerBackend::IO_URING:
+      todo_cnt = WaitIOUringEvents(todo_events, &is_user_event_triggered);
+      break;
+    case PollerBackend::EPOLL_EDGE_TRIGGERED:
+      todo_cnt = WaitEdgeTriggeredEvents(todo_events, &is_user_event_triggered);
+      break;
+    default:
+      todo_cnt = WaitEpollEvents(todo_events, &is_user_event_triggered);
+      break;
   }
 
-  // time events
-  if (!time_events_.empty() && todo_cnt < kMaxEventsSizePerWait) {
-    std::int64_t current_time =
-        std::chrono::duration_cast<std::chrono::milliseconds>(
-            (std::chrono::steady_clock::now()).time_since_epoch())
-            .count();
+  // triggering threads skip the eventfd from now on, until the next sleep
+  is_sleeping_.store(false, std::memory_order::relaxed);
+
+  // the only clock read of this iteration
+  current_time_point_ = std::chrono::steady_clock::now();
+  current_time_ = ToTimeEventTime(current_time_point_);
 
+  // time events
+  if (timer_backend_ == TimerBackend::TIMER_WHEEL) {
+    todo_cnt = PopTimerWheelEvents(todo_events, todo_cnt);
+  } else if (!time_events_.empty() && todo_cnt < kMaxEventsSizePerWait) {
     while (!time_events_.empty()) {
       if (!time_events_.top()->IsValid()) {
         delete time_events_.top();
@@ -104,7 +120,7 @@ int Poller::WaitEvents(coro::EventBase** todo_events) {
         continue;
       }
       if ((todo_cnt >= kMaxEventsSizePerWait) ||
-          (current_time < time_events_.top()->GetWakeupTime())) {
+          (current_time_ < time_events_.top()->GetWakeupTime())) {
         break;
       }
       auto top_time_event = time_events_.top();
@@ -125,30 +141,26 @@ int Poller::WaitEvents(coro::EventBase** todo_events) {
 
   std::lock_guard guard(poller_lock_);
   // user events or dispatched events
-  bool need_to_write_again = false;
-  std::uint64_t event_read = 0;
   if (is_user_event_triggered) {
+    std::uint64_t event_read = 0;
     int read_bytes = read(user_event_fd_, &event_read, sizeof(event_read));
     if (read_bytes != sizeof(event_read)) {
       throw arc::exception::IOException(
           "Read user event or dispatched event error");
     }
+  }
 
-    // check triggered user event
-    auto triggered_event_itr = triggered_user_events_.begin();
-    while (triggered_event_itr != triggered_user_events_.end()) {
-      if (todo_cnt < kMaxEventsSizePerWait) {
-        todo_events[todo_cnt] = *triggered_event_itr;
-        self_triggered_event_ids_[todo_cnt] =
-            todo_events[todo_cnt]->GetEventID();
-        user_events_.erase(todo_events[todo_cnt]->GetEventID());
-        todo_cnt++;
-        triggered_event_itr = triggered_user_events_.erase(triggered_event_itr);
-      } else {
-        need_to_write_again = true;
-        break;
-      }
-    }
+  // Check triggered user events even if we are not woken up by them, the
+  // triggering thread does not notify us when we are awake. Those left over
+  // keep the next wait from blocking, see HasTriggeredEvents().
+  auto triggered_event_itr = triggered_user_events_.begin();
+  while (triggered_event_itr != triggered_user_events_.end() &&
+         todo_cnt < kMaxEventsSizePerWait) {
+    todo_events[todo_cnt] = *triggered_event_itr;
+    self_triggered_event_ids_[todo_cnt] = todo_events[todo_cnt]->GetEventID();
+    user_events_.erase(todo_events[todo_cnt]->GetEventID());
+    todo_cnt++;
+    triggered_event_itr = triggered_user_events_.erase(triggered_event_itr);
   }
 
   // remove triggered bound events
@@ -156,34 +168,223 @@ int Poller::WaitEvents(coro::EventBase** todo_events) {
 
   // check triggered bound event
   auto triggered_bound_event_itr = triggered_bound_events_.begin();
-  while (triggered_bound_event_itr != triggered_bound_events_.end()) {
-    if (todo_cnt < kMaxEventsSizePerWait) {
-      auto triggered_bound_event = PopBoundEvent(*triggered_bound_event_itr);
-      if (triggered_bound_event) {
-        triggered_bound_event->SetInterrupted(true);
-        todo_events[todo_cnt] = triggered_bound_event;
-        todo_cnt++;
-      }
-    } else {
-      need_to_write_again = true;
-      break;
+  while (triggered_bound_event_itr != triggered_bound_events_.end() &&
+         todo_cnt < kMaxEventsSizePerWait) {
+    auto triggered_bound_event = PopBoundEvent(*triggered_bound_event_itr);
+    if (triggered_bound_event) {
+      triggered_bound_event->SetInterrupted(true);
+      todo_events[todo_cnt] = triggered_bound_event;
+      todo_cnt++;
     }
     delete *triggered_bound_event_itr;
     triggered_bound_event_itr =
         triggered_bound_events_.erase(triggered_bound_event_itr);
   }
 
-  // re-write again if todo count supercede the max allowed events
-  if (need_to_write_again) {
-    // need to do it in the next wait routine
-    event_read = 1;
-    int wrote = write(user_event_fd_, &event_read, sizeof(event_read));
-    if (wrote != sizeof(event_read)) {
+  return todo_cnt;
+}
+
+int Poller::PopTimerWheelEvents(coro::EventBase** todo_events, int todo_cnt) {
+  if (timer_wheel_.Empty() || todo_cnt >= kMaxEventsSizePerWait) {
+    return todo_cnt;
+  }
+  int expired_cnt =
+      timer_wheel_.PopExpired(current_time_, expired_time_events_,
+                              kMaxEventsSizePerWait - todo_cnt);
+  for (int i = 0; i < expired_cnt; i++) {
+    auto time_event = expired_time_events_[i];
+    if (time_event->IsTrigger()) [[unlikely]] {
+      TriggerBoundEvent(
+          static_cast<TimeoutEvent*>(time_event)->GetBountEventID(),
+          static_cast<TimeoutEvent*>(time_event));
+    } else {
+      todo_events[todo_cnt] = time_event;
+      self_triggered_event_ids_[todo_cnt] = todo_events[todo_cnt]->GetEventID();
+      todo_cnt++;
+    }
+  }
+  return todo_cnt;
+}
+
+int Poller::WaitEpollEvents(coro::EventBase** todo_events,
+                            bool* is_user_event_triggered) {
+  ArmTimerFd();
+  int event_cnt =
+      epoll_wait(fd_, events_, kMaxEventsSizePerWait, next_wait_timeout_);
+  int todo_cnt = 0;
+
+  for (int i = 0; i < event_cnt; i++) {
+    int fd = events_[i].data.fd;
+    if (fd == user_event_fd_) {
+      *is_user_event_triggered = true;
+      assert(events_[i].events & EPOLLIN);
+      continue;
+    }
+    if (fd == timer_fd_) {
+      continue;
+    }
+    int event_type = events_[i].events;
+    if (event_type & EPOLLIN) {
+      todo_events[todo_cnt] = PopIOEvent(fd, io::IOType::READ);
+      self_triggered_event_ids_[todo_cnt] = todo_events[todo_cnt]->GetEventID();
+      todo_cnt++;
+    }
+    if (event_type & EPOLLOUT) {
+      todo_events[todo_cnt] = PopIOEvent(fd, io::IOType::WRITE);
+      self_triggered_event_ids_[todo_cnt] = todo_events[todo_cnt]->GetEventID();
+      todo_cnt++;
+    }
+    if (event_type && ((event_type & EPOLLIN) == 0) &&
+        ((event_type & EPOLLOUT) == 0)) {
       throw arc::exception::IOException(
-          "Write user event or dispatched event in epoll wait error");
+          "Returned Epoll Events Are Not Supported" +
+          std::to_string(event_type));
+    }
+  }
+  return todo_cnt;
+}
+
+int Poller::WaitEdgeTriggeredEvents(coro::EventBase** todo_events,
+                                    bool* is_user_event_triggered) {
+  int todo_cnt = 0;
+
+  // first resume waiters whose fd was already known ready when they were added
+  std::size_t known_ready_cnt =
+      std::min(known_ready_io_events_.size(),
+               static_cast<std::size_t>(kMaxEventsSizePerWait));
+  for (std::size_t i = 0; i < known_ready_cnt; i++) {
+    auto [fd, event_type] = known_ready_io_events_[i];
+    if ((GetExistingIOEvent(fd) & ToEpollEvent(event_type)) == 0) {
+      continue;
     }
+    todo_events[todo_cnt] = PopIOEvent(fd, event_type);
+    self_triggered_event_ids_[todo_cnt] = todo_events[todo_cnt]->GetEventID();
+    todo_cnt++;
+  }
+  known_ready_io_events_.erase(
+      known_ready_io_events_.begin(),
+      known_ready_io_events_.begin() + known_ready_cnt);
+
+  // every returned event may produce two todo events, keep them in bound
+  int max_event_cnt = kMaxEventsSizePerWait - static_cast<int>(known_ready_cnt);
+  if (max_event_cnt <= 0) {
+    return todo_cnt;
   }
+  ArmTimerFd();
+  int event_cnt =
+      epoll_wait(fd_, events_, max_event_cnt,
+                 (todo_cnt > 0 || !known_ready_io_events_.empty())
+                     ? 0
+                     : next_wait_timeout_);
+
+  for (int i = 0; i < event_cnt; i++) {
+    int fd = events_[i].data.fd;
+    if (fd == user_event_fd_) {
+      *is_user_event_triggered = true;
+      assert(events_[i].events & EPOLLIN);
+      continue;
+    }
+    if (fd == timer_fd_) {
+      continue;
+    }
+    int ready_event = events_[i].events & (EPOLLIN | EPOLLOUT);
+    if (events_[i].events & (EPOLLERR | EPOLLHUP)) {
+      // let the waiters find out the error by themselves
+      ready_event = EPOLLIN | EPOLLOUT;
+    }
+    if (fd < kMaxFdInArray_) [[likely]] {
+      io_ready_events_[fd] |= ready_event;
+    } else [[unlikely]] {
+      extra_io_ready_events_[fd] |= ready_event;
+    }
 
+    int waiting_event = GetExistingIOEvent(fd) & ready_event;
+    if (waiting_event & EPOLLIN) {
+      todo_events[todo_cnt] = PopIOEvent(fd, io::IOType::READ);
+      self_triggered_event_ids_[todo_cnt] = todo_events[todo_cnt]->GetEventID();
+      todo_cnt++;
+    }
+    if (waiting_event & EPOLLOUT) {
+      todo_events[todo_cnt] = PopIOEvent(fd, io::IOType::WRITE);
+      self_triggered_event_ids_[todo_cnt] = todo_events[todo_cnt]->GetEventID();
+      todo_cnt++;
+    }
+  }
+  return todo_cnt;
+}
+
+int Poller::WaitIOUringEvents(coro::EventBase** todo_events,
+                              bool* is_user_event_triggered) {
+  unsigned int wait_nr = (next_wait_timeout_ == 0 ? 0 : 1);
+  if (wait_nr > 0 && next_wakeup_time_ >= 0) {
+    // the timeout also completes as soon as any other completion is posted,
+    // so it never outlives this wait
+    ring_wait_timeout_.tv_sec = next_wakeup_time_ / 1000000;
+    ring_wait_timeout_.tv_nsec = (next_wakeup_time_ % 1000000) * 1000;
+    io_uring_sqe* sqe = ring_.GetSqe();
+    sqe->opcode = IORING_OP_TIMEOUT;
+    sqe->fd = -1;
+    sqe->addr = reinterpret_cast<std::uint64_t>(&ring_wait_timeout_);
+    sqe->len = 1;
+    sqe->off = 1;
+    sqe->timeout_flags = IORING_TIMEOUT_ABS;
+    sqe->user_data = kIOUringIgnoredUserData_;
+  }
+  // all poll additions and removals since the last wait go in this one call
+  ring_.SubmitAndWait(wait_nr);
+
+  int todo_cnt = 0;
+  io_uring_cqe* cqe = nullptr;
+  while (todo_cnt < kMaxEventsSizePerWait &&
+         (cqe = ring_.PeekCqe()) != nullptr) {
+    std::uint64_t user_data = cqe->user_data;
+    int result = cqe->res;
+    ring_.AdvanceCq();
+    if (user_data == kIOUringIgnoredUserData_) {
+      continue;
+    }
+    if (user_data & kIOUringCompletionTag_) {
+      auto event = reinterpret_cast<coro::CompletionEvent*>(
+          user_data & ~kIOUringCompletionTag_);
+      auto [itr, end] = completion_events_.equal_range(event->GetFd());
+      while (itr->second != event) {
+        itr++;
+      }
+      completion_events_.erase(itr);
+      total_io_events_--;
+      event->SetResult(result);
+      todo_events[todo_cnt] = event;
+      self_triggered_event_ids_[todo_cnt] = event->GetEventID();
+      todo_cnt++;
+      continue;
+    }
+    int fd = static_cast<int>((user_data & 0xffffffff) >> 1);
+    io::IOType event_type = static_cast<io::IOType>(user_data & 1);
+    if (static_cast<std::uint32_t>(user_data >> 32) !=
+        (GetIOUringGeneration(fd, event_type) & kIOUringGenerationMask_)) {
+      // completion of a poll we have already removed
+      continue;
+    }
+    if (fd == user_event_fd_) {
+      *is_user_event_triggered = true;
+      is_event_fd_added_ = false;
+      continue;
+    }
+
+    int armed_event = (event_type == io::IOType::READ ? EPOLLIN : EPOLLOUT);
+    if (fd < kMaxFdInArray_) [[likely]] {
+      io_prev_events_[fd] &= ~armed_event;
+    } else [[unlikely]] {
+      extra_io_prev_events_[fd] &= ~armed_event;
+    }
+    interesting_fds_.insert(fd);
+    if ((GetExistingIOEvent(fd) & armed_event) == 0) {
+      continue;
+    }
+    todo_events[todo_cnt] = PopIOEvent(fd, event_type);
+    self_triggered_event_ids_[todo_cnt] = todo_events[todo_cnt]->GetEventID();
+    todo_cnt++;
+  }
   return todo_cnt;
 }
 
@@ -209,10 +410,40 @@ void Poller::AddIOEvent(coro::IOEvent* event) {
 
   interesting_fds_.insert(target_fd);
   to_be_pushed_queue->push_back(event);
+
+  if (backend_ == PollerBackend::EPOLL_EDGE_TRIGGERED &&
+      IsIOReady(target_fd, event_type)) [[unlikely]] {
+    // The edge has already been consumed, so nothing would wake this waiter
+    // up. Resume it once and let it find out whether the fd is still ready.
+    ResetIOReady(target_fd, event_type);
+    known_ready_io_events_.emplace_back(target_fd, event_type);
+  }
+}
+
+void Poller::AddCompletionEvent(coro::CompletionEvent* event) {
+  event->SetEventID(max_event_id_.fetch_add(1, std::memory_order::relaxed));
+  total_io_events_++;
+  completion_events_.emplace(event->GetFd(), event);
+
+  const coro::CompletionOp& op = event->GetOp();
+  io_uring_sqe* sqe = ring_.GetSqe();
+  sqe->opcode = op.opcode;
+  sqe->fd = event->GetFd();
+  sqe->addr = op.addr;
+  sqe->len = op.len;
+  // the same field as accept_flags
+  sqe->msg_flags = op.flags;
+  sqe->addr2 = op.addr2;
+  sqe->user_data =
+      reinterpret_cast<std::uint64_t>(event) | kIOUringCompletionTag_;
 }
 
 void Poller::AddTimeEvent(coro::TimeEvent* event) {
   event->SetEventID(max_event_id_.fetch_add(1, std::memory_order::relaxed));
+  if (timer_backend_ == TimerBackend::TIMER_WHEEL) {
+    timer_wheel_.Add(event);
+    return;
+  }
   time_events_.push(event);
 }
 
@@ -231,18 +462,32 @@ void Poller::AddBoundEvent(coro::BoundEvent* event) {
   event_pending_bound_token_map_[event->GetBountEventID()] = itr;
   event->SetIterator(itr);
   if (event->GetTriggerType() == detail::TriggerType::TIME_EVENT) {
-    time_events_.push(static_cast<TimeoutEvent*>(event));
+    if (timer_backend_ == TimerBackend::TIMER_WHEEL) {
+      timer_wheel_.Add(static_cast<TimeoutEvent*>(event));
+    } else {
+      time_events_.push(static_cast<TimeoutEvent*>(event));
+    }
   }
 }
 
 void Poller::RemoveAllIOEvents(int target_fd) {
   bool need_epoll_ctl = false;
 
+  // their waiters are resumed with -ECANCELED once the kernel lets go of
+  // their buffers
+  auto [completion_itr, completion_end] =
+      completion_events_.equal_range(target_fd);
+  for (; completion_itr != completion_end; completion_itr++) {
+    CancelCompletionEvent(completion_itr->second);
+  }
+
+  int prev_event = 0;
   std::deque<arc::coro::IOEvent*>* read_queue = nullptr;
   std::deque<arc::coro::IOEvent*>* write_queue = nullptr;
   if (target_fd < kMaxFdInArray_) [[likely]] {
     read_queue = &io_events_[target_fd][static_cast<int>(io::IOType::READ)];
     write_queue = &io_events_[target_fd][static_cast<int>(io::IOType::WRITE)];
+    prev_event = io_prev_events_[target_fd];
     io_prev_events_[target_fd] = 0;
   } else [[unlikely]] {
     if (extra_io_events_.find(target_fd) == extra_io_events_.end()) {
@@ -252,7 +497,10 @@ void Poller::RemoveAllIOEvents(int target_fd) {
         &extra_io_events_[target_fd][static_cast<int>(io::IOType::READ)];
     write_queue =
         &extra_io_events_[target_fd][static_cast<int>(io::IOType::WRITE)];
-    extra_io_prev_events_.erase(0);
+    if (extra_io_prev_events_.find(target_fd) != extra_io_prev_events_.end()) {
+      prev_event = extra_io_prev_events_[target_fd];
+    }
+    extra_io_prev_events_.erase(target_fd);
   }
   auto itr = read_queue->begin();
   while (itr != read_queue->end()) {
@@ -275,6 +523,25 @@ void Poller::RemoveAllIOEvents(int target_fd) {
     interesting_fds_.erase(target_fd);
   }
 
+  if (backend_ == PollerBackend::IO_URING) {
+    // the fd is about to be closed, drop whatever polls are still armed
+    TrimIOUringEvents(target_fd, prev_event, 0);
+    return;
+  }
+
+  if (backend_ == PollerBackend::EPOLL_EDGE_TRIGGERED) {
+    if (target_fd < kMaxFdInArray_) [[likely]] {
+      io_ready_events_[target_fd] = 0;
+    } else [[unlikely]] {
+      extra_io_ready_events_.erase(target_fd);
+    }
+    std::erase_if(known_ready_io_events_, [target_fd](const auto& event) {
+      return event.first == target_fd;
+    });
+    // the registration lives as long as the fd, not as long as the waiters
+    need_epoll_ctl = (prev_event != 0);
+  }
+
   if (need_epoll_ctl) {
     int epoll_ret = epoll_ctl(fd_, EPOLL_CTL_DEL, target_fd, nullptr);
     if (epoll_ret != 0) [[unlikely]] {
@@ -286,6 +553,10 @@ void Poller::RemoveAllIOEvents(int target_fd) {
 }
 
 void Poller::TrimIOEvents() {
+  if (backend_ == PollerBackend::EPOLL_EDGE_TRIGGERED) {
+    TrimEdgeTriggeredEvents();
+    return;
+  }
   for (int fd : interesting_fds_) {
     int prev_event = 0;
     int cur_event = GetExistingIOEvent(fd);
@@ -303,6 +574,11 @@ void Poller::TrimIOEvents() {
       continue;
     }
 
+    if (backend_ == PollerBackend::IO_URING) {
+      TrimIOUringEvents(fd, prev_event, cur_event);
+      continue;
+    }
+
     int op = prev_event == 0 ? EPOLL_CTL_ADD
                              : (cur_event == 0 ? EPOLL_CTL_DEL : EPOLL_CTL_MOD);
     epoll_event e_event{};
@@ -323,6 +599,15 @@ void Poller::TrimUserEvents() {
   if (is_event_fd_added_ == should_add_epoll) {
     return;
   }
+  if (backend_ == PollerBackend::IO_URING) {
+    if (should_add_epoll) {
+      AddIOUringPoll(user_event_fd_, io::IOType::READ);
+    } else {
+      RemoveIOUringPoll(user_event_fd_, io::IOType::READ);
+    }
+    is_event_fd_added_ = should_add_epoll;
+    return;
+  }
   int op = should_add_epoll ? EPOLL_CTL_ADD : EPOLL_CTL_DEL;
   epoll_event e_event{};
   e_event.events = EPOLLIN;
@@ -335,22 +620,37 @@ void Poller::TrimUserEvents() {
 }
 
 void Poller::TrimTimeEvents() {
-  // first pop up invalid time event (e.g. triggered timeout event)
-  while (!time_events_.empty() && !time_events_.top()->IsValid()) {
-    delete time_events_.top();
-    time_events_.pop();
+  if (timer_backend_ == TimerBackend::TIMER_WHEEL) {
+    next_wakeup_time_ = timer_wheel_.GetNextExpireTime();
+  } else {
+    // first pop up invalid time event (e.g. triggered timeout event)
+    while (!time_events_.empty() && !time_events_.top()->IsValid()) {
+      delete time_events_.top();
+      time_events_.pop();
+    }
+    next_wakeup_time_ =
+        time_events_.empty() ? -1 : time_events_.top()->GetWakeupTime();
   }
-  if (time_events_.empty()) {
-    next_wait_timeout_ = -1;  // wait infinitely if no time event
+  // The wait itself blocks infinitely, the time events wake it up through
+  // the absolute timer. Only skip waiting when something is already due.
+  next_wait_timeout_ =
+      (next_wakeup_time_ >= 0 && next_wakeup_time_ <= current_time_) ? 0 : -1;
+}
+
+void Poller::ArmTimerFd() {
+  if (next_wait_timeout_ == 0 || next_wakeup_time_ < 0 ||
+      next_wakeup_time_ == armed_wakeup_time_) {
+    // a stale earlier expiration only costs a spurious wakeup
     return;
   }
-  auto top_event = time_events_.top();
-  std::int64_t current_time =
-      std::chrono::duration_cast<std::chrono::milliseconds>(
-          (std::chrono::steady_clock::now()).time_since_epoch())
-          .count();
-  next_wait_timeout_ =
-      std::max((std::int64_t)0, top_event->GetWakeupTime() - current_time);
+  itimerspec timer_spec{};
+  timer_spec.it_value.tv_sec = next_wakeup_time_ / 1000000;
+  timer_spec.it_value.tv_nsec = (next_wakeup_time_ % 1000000) * 1000;
+  if (timerfd_settime(timer_fd_, TFD_TIMER_ABSTIME, &timer_spec, nullptr) !=
+      0) {
+    throw arc::exception::IOException("TimerFd Arming Error");
+  }
+  armed_wakeup_time_ = next_wakeup_time_;
 }
 
 bool Poller::TriggerUserEvent(EventID event_id) {
@@ -364,10 +664,7 @@ bool Poller::TriggerUserEvent(EventID event_id) {
   triggered_user_events_.push_back(event);
 
   // trigger self
-  std::uint64_t i = 1;
-  if (write(user_event_fd_, &i, sizeof(i)) < 0) {
-    throw arc::exception::IOException("Trigger User Event Error");
-  }
+  WakeUp();
   return true;
 }
 
@@ -385,12 +682,27 @@ void Poller::TriggerBoundEvent(EventID bound_event_id,
   event_pending_bound_token_map_.erase(event_pending_bound_token_map_itr);
 
   // trigger self
+  WakeUp();
+}
+
+void Poller::WakeUp() {
+  // pairs with the one in SetSleeping(), either we see the poller sleeping,
+  // or it sees what has been published before this call
+  std::atomic_thread_fence(std::memory_order::seq_cst);
+  if (!is_sleeping_.exchange(false)) {
+    return;
+  }
   std::uint64_t i = 1;
   if (write(user_event_fd_, &i, sizeof(i)) < 0) {
-    throw arc::exception::IOException("Trigger Bound Event Error");
+    throw arc::exception::IOException("Wake Up Poller Error");
   }
 }
 
+bool Poller::HasTriggeredEvents() {
+  std::lock_guard guard(poller_lock_);
+  return !triggered_user_events_.empty() || !triggered_bound_events_.empty();
+}
+
 int Poller::Register() {
   std::lock_guard guard(poller_lock_);
   is_dispatcher_registered_ = true;
@@ -402,6 +714,99 @@ void Poller::DeRegister() {
   is_dispatcher_registered_ = false;
 }
 
+void Poller::ResetIOReady(int fd, io::IOType event_type) {
+  if (fd < kMaxFdInArray_) [[likely]] {
+    io_ready_events_[fd] &= ~ToEpollEvent(event_type);
+  } else [[unlikely]] {
+    auto itr = extra_io_ready_events_.find(fd);
+    if (itr != extra_io_ready_events_.end()) {
+      itr->second &= ~ToEpollEvent(event_type);
+    }
+  }
+}
+
+void Poller::TrimEdgeTriggeredEvents() {
+  // registered fds never need another epoll_ctl, so only the fds touched
+  // since the last trim are visited
+  for (int fd : interesting_fds_) {
+    int* registered_event = nullptr;
+    if (fd < kMaxFdInArray_) [[likely]] {
+      registered_event = &io_prev_events_[fd];
+    } else [[unlikely]] {
+      registered_event = &extra_io_prev_events_[fd];
+    }
+    if (*registered_event != 0 || GetExistingIOEvent(fd) == 0) {
+      continue;
+    }
+    epoll_event e_event{};
+    e_event.events = kEdgeTriggeredEvents_;
+    e_event.data.fd = fd;
+    if (epoll_ctl(fd_, EPOLL_CTL_ADD, fd, &e_event) != 0) {
+      throw arc::exception::IOException("Epoll Error When Trimming IO Events");
+    }
+    *registered_event = kEdgeTriggeredEvents_;
+  }
+  interesting_fds_.clear();
+}
+
+void Poller::TrimIOUringEvents(int fd, int prev_event, int cur_event) {
+  int added_event = cur_event & (~prev_event);
+  int removed_event = prev_event & (~cur_event);
+  if (added_event & EPOLLIN) {
+    AddIOUringPoll(fd, io::IOType::READ);
+  }
+  if (added_event & EPOLLOUT) {
+    AddIOUringPoll(fd, io::IOType::WRITE);
+  }
+  if (removed_event & EPOLLIN) {
+    RemoveIOUringPoll(fd, io::IOType::READ);
+  }
+  if (removed_event & EPOLLOUT) {
+    RemoveIOUringPoll(fd, io::IOType::WRITE);
+  }
+}
+
+void Poller::AddIOUringPoll(int fd, io::IOType event_type) {
+  io_uring_sqe* sqe = ring_.GetSqe();
+  sqe->opcode = IORING_OP_POLL_ADD;
+  sqe->fd = fd;
+  sqe->poll32_events = (event_type == io::IOType::READ ? POLLIN : POLLOUT);
+  sqe->user_data = GetIOUringPollUserData(fd, event_type);
+}
+
+void Poller::RemoveIOUringPoll(int fd, io::IOType event_type) {
+  io_uring_sqe* sqe = ring_.GetSqe();
+  sqe->opcode = IORING_OP_POLL_REMOVE;
+  sqe->fd = -1;
+  sqe->addr = GetIOUringPollUserData(fd, event_type);
+  sqe->user_data = kIOUringIgnoredUserData_;
+  GetIOUringGeneration(fd, event_type)++;
+}
+
+std::uint32_t& Poller::GetIOUringGeneration(int fd, io::IOType event_type) {
+  if (fd < kMaxFdInArray_) [[likely]] {
+    return io_generations_[fd][static_cast<int>(event_type)];
+  }
+  return extra_io_generations_[fd][static_cast<int>(event_type)];
+}
+
+std::uint64_t Poller::GetIOUringPollUserData(int fd, io::IOType event_type) {
+  // the generation keeps clear of kIOUringCompletionTag_
+  return (static_cast<std::uint64_t>(GetIOUringGeneration(fd, event_type) &
+                                     kIOUringGenerationMask_)
+          << 32) |
+         (static_cast<std::uint64_t>(fd) << 1) |
+         static_cast<std::uint64_t>(event_type);
+}
+
+void Poller::CancelCompletionEvent(coro::CompletionEvent* event) {
+  io_uring_sqe* sqe = ring_.GetSqe();
+  sqe->opcode = IORING_OP_ASYNC_CANCEL;
+  sqe->fd = -1;
+  sqe->addr = reinterpret_cast<std::uint64_t>(event) | kIOUringCompletionTag_;
+  sqe->user_data = kIOUringIgnoredUserData_;
+}
+
 coro::IOEvent* Poller::PopIOEvent(int fd, io::IOType event_type) {
   arc::coro::IOEvent* event = nullptr;
   if (fd < kMaxFdInArray_) {
@@ -442,6 +847,17 @@ EventBase* Poller::PopBoundEvent(coro::BoundEvent* event) {
   switch (event->GetBountEventType()) {
     case detail::BoundType::IO_EVENT: {
       int fd = static_cast<int>(event->GetBoundHelper());
+      auto [completion_itr, completion_end] = completion_events_.equal_range(fd);
+      for (; completion_itr != completion_end; completion_itr++) {
+        if (completion_itr->second->GetEventID() ==
+            event->GetBountEventID()) {
+          // resumed by its completion, which carries what has been done
+          // before the cancellation got to the op, if anything
+          completion_itr->second->SetInterrupted(true);
+          CancelCompletionEvent(completion_itr->second);
+          return nullptr;
+        }
+      }
       if (fd < kMaxFdInArray_) {
         for (auto& vec : io_events_[fd]) {
           for (auto itr = vec.begin(); itr != vec.end(); itr++) {
@@ -504,8 +920,13 @@ void Poller::RemoveBoundEvent(int count) {
       auto bound_event = *itr;
       pending_bound_events_.erase(itr);
       if (bound_event->GetTriggerType() == detail::TriggerType::TIME_EVENT) {
-        static_cast<TimeoutEvent*>(bound_event)->SetValidity(false);
-        continue;
+        if (timer_backend_ == TimerBackend::TIMER_WHEEL) {
+          // no lazy deletion needed, take it out of the wheel right away
+          timer_wheel_.Remove(static_cast<TimeoutEvent*>(bound_event));
+        } else {
+          static_cast<TimeoutEvent*>(bound_event)->SetValidity(false);
+          continue;
+        }
       }
       delete bound_event;
     }
@@ -0,0 +1,157 @@
+/*
+ * File: io_uring.cc
+ * Project: libarc
+ * File Created: Friday, 16th October 2026 10:12:37 am
+ * Author: Minjun Xu (mjxu96@outlook.com)
+ * -----
+ * MIT License
+ * Copyright (c) 2020 Minjun Xu
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <arc/coro/poller/io_uring.h>
+#include <arc/exception/io.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+
+using namespace arc::coro::detail;
+
+IOUring::~IOUring() {
+  if (sqes_) {
+    munmap(sqes_, sqes_size_);
+  }
+  if (cq_ring_ptr_ && cq_ring_ptr_ != sq_ring_ptr_) {
+    munmap(cq_ring_ptr_, cq_ring_size_);
+  }
+  if (sq_ring_ptr_) {
+    munmap(sq_ring_ptr_, sq_ring_size_);
+  }
+  if (ring_fd_ >= 0) {
+    close(ring_fd_);
+  }
+}
+
+bool IOUring::Init(unsigned int entries) {
+  io_uring_params params;
+  std::memset(&params, 0, sizeof(params));
+  int fd = syscall(__NR_io_uring_setup, entries, &params);
+  if (fd < 0) {
+    return false;
+  }
+  ring_fd_ = fd;
+  features_ = params.features;
+
+  sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  cq_ring_size_ =
+      params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+  if (params.features & IORING_FEAT_SINGLE_MMAP) {
+    sq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+    cq_ring_size_ = sq_ring_size_;
+  }
+
+  sq_ring_ptr_ = mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQ_RING);
+  if (sq_ring_ptr_ == MAP_FAILED) {
+    sq_ring_ptr_ = nullptr;
+    throw arc::exception::IOException("IOUring SQ Ring Mapping Error");
+  }
+  if (params.features & IORING_FEAT_SINGLE_MMAP) {
+    cq_ring_ptr_ = sq_ring_ptr_;
+  } else {
+    cq_ring_ptr_ =
+        mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE,
+             MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_CQ_RING);
+    if (cq_ring_ptr_ == MAP_FAILED) {
+      cq_ring_ptr_ = nullptr;
+      throw arc::exception::IOException("IOUring CQ Ring Mapping Error");
+    }
+  }
+
+  sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+  void* sqes_ptr = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQES);
+  if (sqes_ptr == MAP_FAILED) {
+    throw arc::exception::IOException("IOUring SQEs Mapping Error");
+  }
+  sqes_ = static_cast<io_uring_sqe*>(sqes_ptr);
+
+  char* sq_ptr = static_cast<char*>(sq_ring_ptr_);
+  sq_head_ = reinterpret_cast<unsigned int*>(sq_ptr + params.sq_off.head);
+  sq_tail_ = reinterpret_cast<unsigned int*>(sq_ptr + params.sq_off.tail);
+  sq_ring_mask_ =
+      reinterpret_cast<unsigned int*>(sq_ptr + params.sq_off.ring_mask);
+  sq_ring_entries_ =
+      reinterpret_cast<unsigned int*>(sq_ptr + params.sq_off.ring_entries);
+  sq_array_ = reinterpret_cast<unsigned int*>(sq_ptr + params.sq_off.array);
+  sq_local_tail_ = *sq_tail_;
+
+  char* cq_ptr = static_cast<char*>(cq_ring_ptr_);
+  cq_head_ = reinterpret_cast<unsigned int*>(cq_ptr + params.cq_off.head);
+  cq_tail_ = reinterpret_cast<unsigned int*>(cq_ptr + params.cq_off.tail);
+  cq_ring_mask_ =
+      reinterpret_cast<unsigned int*>(cq_ptr + params.cq_off.ring_mask);
+  cqes_ = reinterpret_cast<io_uring_cqe*>(cq_ptr + params.cq_off.cqes);
+  return true;
+}
+
+io_uring_sqe* IOUring::GetSqe() {
+  unsigned int head = __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+  if (sq_local_tail_ - head >= *sq_ring_entries_) [[unlikely]] {
+    // sq is full, flush what we have without waiting
+    SubmitAndWait(0);
+  }
+  unsigned int index = sq_local_tail_ & *sq_ring_mask_;
+  io_uring_sqe* sqe = &sqes_[index];
+  std::memset(sqe, 0, sizeof(io_uring_sqe));
+  sq_array_[index] = index;
+  sq_local_tail_++;
+  to_submit_++;
+  return sqe;
+}
+
+int IOUring::SubmitAndWait(unsigned int wait_nr) {
+  unsigned int flags = wait_nr > 0 ? IORING_ENTER_GETEVENTS : 0;
+  if (to_submit_ == 0 && wait_nr == 0) {
+    return 0;
+  }
+  // publish the filled sqes to the kernel
+  __atomic_store_n(sq_tail_, sq_local_tail_, __ATOMIC_RELEASE);
+  int ret = Enter(to_submit_, wait_nr, flags);
+  if (ret >= 0) {
+    to_submit_ -= std::min(to_submit_, static_cast<unsigned int>(ret));
+  }
+  return ret;
+}
+
+int IOUring::Enter(unsigned int to_submit, unsigned int wait_nr,
+                   unsigned int flags) {
+  int ret = syscall(__NR_io_uring_enter, ring_fd_, to_submit, wait_nr, flags,
+                    nullptr, 0);
+  if (ret < 0 && errno != EINTR && errno != EBUSY && errno != ETIME)
+      [[unlikely]] {
+    throw arc::exception::IOException("IOUring Enter Error");
+  }
+  return ret;
+}
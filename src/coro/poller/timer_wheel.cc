@@ -0,0 +1,225 @@
+/*
+ * File: timer_wheel.cc
+ * Project: libarc
+ * File Created: Friday, 16th October 2026 02:26:41 pm
+ * Author: Minjun Xu (mjxu96@outlook.com)
+ * -----
+ * MIT License
+ * Copyright (c) 2020 Minjun Xu
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <arc/coro/poller/timer_wheel.h>
+
+#include <algorithm>
+#include <limits>
+
+using namespace arc::coro;
+using namespace arc::coro::detail;
+
+TimerWheel::TimerWheel(std::int64_t current_time)
+    : current_tick_(current_time) {
+  for (auto& level_slots : slots_) {
+    for (auto& slot : level_slots) {
+      InitList(&slot);
+    }
+  }
+  InitList(&expired_);
+}
+
+void TimerWheel::Add(TimeEvent* event) {
+  Place(&event->wheel_hook_);
+  size_++;
+}
+
+void TimerWheel::Remove(TimeEvent* event) {
+  TimerWheelHook* hook = &event->wheel_hook_;
+  if (!hook->next) {
+    return;
+  }
+  Unlink(hook);
+  size_--;
+}
+
+int TimerWheel::PopExpired(std::int64_t current_time, TimeEvent** events,
+                           int max_cnt) {
+  Advance(current_time);
+  int cnt = 0;
+  while (cnt < max_cnt && expired_.next != &expired_) {
+    TimerWheelHook* hook = expired_.next;
+    Unlink(hook);
+    events[cnt] = hook->event;
+    cnt++;
+    size_--;
+  }
+  return cnt;
+}
+
+std::int64_t TimerWheel::GetNextExpireTime() {
+  if (size_ == 0) {
+    return -1;
+  }
+  if (expired_.next != &expired_) {
+    return current_tick_ - 1;
+  }
+  // waking up at a cascade is never later than the first event it moves
+  std::int64_t next_tick = std::min(GetNextSlotTick(), GetNextCascadeTick());
+  if (next_tick == std::numeric_limits<std::int64_t>::max()) [[unlikely]] {
+    return -1;
+  }
+  return next_tick;
+}
+
+void TimerWheel::Advance(std::int64_t current_time) {
+  while (current_tick_ <= current_time) {
+    int index = static_cast<int>(current_tick_ & kSlotMask_);
+    if (index == 0) {
+      for (int level = 1; level < kLevelNum_; level++) {
+        int slot = static_cast<int>(
+            (current_tick_ >> (kLevelBits_ * level)) & kSlotMask_);
+        Cascade(level, slot);
+        if (slot != 0) {
+          break;
+        }
+      }
+    }
+
+    TimerWheelHook* head = &slots_[0][index];
+    if (!IsSlotEmpty(0, index)) {
+      // splice the whole slot to the end of the expired list
+      head->next->prev = expired_.prev;
+      expired_.prev->next = head->next;
+      head->prev->next = &expired_;
+      expired_.prev = head->prev;
+      InitList(head);
+    }
+    UnmarkSlot(0, index);
+    current_tick_++;
+
+    // nothing can happen before the next marked slot or the next cascade
+    current_tick_ =
+        std::max(current_tick_, std::min({GetNextSlotTick(),
+                                          GetNextCascadeTick(),
+                                          current_time + 1}));
+  }
+}
+
+void TimerWheel::Place(TimerWheelHook* hook) {
+  std::int64_t expire_tick = hook->event->wakeup_time_;
+  if (expire_tick < current_tick_) {
+    PushBack(&expired_, hook);
+    return;
+  }
+  std::int64_t delta = expire_tick - current_tick_;
+  if (delta > kMaxTimeSpan_) [[unlikely]] {
+    // parked in the farthest slot and placed again when cascaded
+    expire_tick = current_tick_ + kMaxTimeSpan_;
+    delta = kMaxTimeSpan_;
+  }
+  int level = 0;
+  while (level < kLevelNum_ - 1 &&
+         delta >= (std::int64_t(1) << (kLevelBits_ * (level + 1)))) {
+    level++;
+  }
+  int slot =
+      static_cast<int>((expire_tick >> (kLevelBits_ * level)) & kSlotMask_);
+  PushBack(&slots_[level][slot], hook);
+  MarkSlot(level, slot);
+}
+
+void TimerWheel::Cascade(int level, int slot) {
+  UnmarkSlot(level, slot);
+  if (IsSlotEmpty(level, slot)) {
+    return;
+  }
+  // detach the slot first, parked events may be placed back into it
+  TimerWheelHook* head = &slots_[level][slot];
+  TimerWheelHook pending;
+  pending.next = head->next;
+  pending.prev = head->prev;
+  pending.next->prev = &pending;
+  pending.prev->next = &pending;
+  InitList(head);
+
+  while (pending.next != &pending) {
+    TimerWheelHook* hook = pending.next;
+    Unlink(hook);
+    Place(hook);
+  }
+}
+
+std::int64_t TimerWheel::GetNextSlotTick() {
+  // level 0 slots before the current one belong to the next revolution
+  int index = static_cast<int>(current_tick_ & kSlotMask_);
+  int slot = FindNextSlot(0, index);
+  if (slot < kSlotNum_) {
+    return current_tick_ + (slot - index);
+  }
+  slot = FindNextSlot(0, 0);
+  if (slot < index) {
+    return current_tick_ + (kSlotNum_ - index + slot);
+  }
+  return std::numeric_limits<std::int64_t>::max();
+}
+
+std::int64_t TimerWheel::GetNextCascadeTick() {
+  std::int64_t next_tick = std::numeric_limits<std::int64_t>::max();
+  for (int level = 1; level < kLevelNum_; level++) {
+    int shift = kLevelBits_ * level;
+    std::int64_t block = current_tick_ >> shift;
+    int cur = static_cast<int>(block & kSlotMask_);
+    // the current slot is cascaded at the very start of its block, after
+    // that it holds events of the next revolution
+    bool is_at_block_start =
+        (current_tick_ & ((std::int64_t(1) << shift) - 1)) == 0;
+    int slot = FindNextSlot(level, is_at_block_start ? cur : cur + 1);
+    if (slot == kSlotNum_) {
+      slot = FindNextSlot(level, 0);
+    }
+    if (slot == kSlotNum_) {
+      continue;
+    }
+    int distance = (slot - cur) & kSlotMask_;
+    if (distance == 0 && !is_at_block_start) {
+      distance = kSlotNum_;
+    }
+    next_tick = std::min(next_tick, (block + distance) << shift);
+  }
+  return next_tick;
+}
+
+int TimerWheel::FindNextSlot(int level, int from) {
+  // skips and clears the marks of slots that have been emptied by Remove
+  for (int word = from / 64; word < kBitmapWordNum_; word++) {
+    std::uint64_t bits = bitmaps_[level][word];
+    if (word == from / 64) {
+      bits &= (~std::uint64_t(0) << (from % 64));
+    }
+    while (bits) {
+      int slot = word * 64 + __builtin_ctzll(bits);
+      if (!IsSlotEmpty(level, slot)) {
+        return slot;
+      }
+      UnmarkSlot(level, slot);
+      bits &= bits - 1;
+    }
+  }
+  return kSlotNum_;
+}
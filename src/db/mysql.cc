@@ -54,6 +54,16 @@ arc::coro::Task<MySQLResultRow> MySQLResult::FetchNextRow() {
   co_return row;
 }
 
+arc::coro::AsyncGenerator<MySQLResultRow> MySQLResult::FetchRows() {
+  while (true) {
+    MySQLResultRow row = co_await FetchNextRow();
+    if (row.IsEmpty()) {
+      co_return;
+    }
+    co_yield row;
+  }
+}
+
 MySQLConnection::MySQLConnection() : SQLConnection(SQLType::TYPE_MYSQL) {
   mysql_connection_lock.lock();
   mysql_init(&mysql_);
@@ -0,0 +1,498 @@
+/*
+ * File: hpack.cc
+ * Project: libarc
+ * File Created: Saturday, 17th October 2026 11:04:29 pm
+ * Author: Minjun Xu (mjxu96@outlook.com)
+ * -----
+ * MIT License
+ * Copyright (c) 2022 Minjun Xu
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <arc/http/hpack.h>
+
+#include <algorithm>
+
+using namespace arc::http;
+
+namespace {
+
+const std::pair<std::string_view, std::string_view>
+    kStaticTable[detail::HpackTable::kStaticTableSize] = {
+        {":authority", ""},
+        {":method", "GET"},
+        {":method", "POST"},
+        {":path", "/"},
+        {":path", "/index.html"},
+        {":scheme", "http"},
+        {":scheme", "https"},
+        {":status", "200"},
+        {":status", "204"},
+        {":status", "206"},
+        {":status", "304"},
+        {":status", "400"},
+        {":status", "404"},
+        {":status", "500"},
+        {"accept-charset", ""},
+        {"accept-encoding", "gzip, deflate"},
+        {"accept-language", ""},
+        {"accept-ranges", ""},
+        {"accept", ""},
+        {"access-control-allow-origin", ""},
+        {"age", ""},
+        {"allow", ""},
+        {"authorization", ""},
+        {"cache-control", ""},
+        {"content-disposition", ""},
+        {"content-encoding", ""},
+        {"content-language", ""},
+        {"content-length", ""},
+        {"content-location", ""},
+        {"content-range", ""},
+        {"content-type", ""},
+        {"cookie", ""},
+        {"date", ""},
+        {"etag", ""},
+        {"expect", ""},
+        {"expires", ""},
+        {"from", ""},
+        {"host", ""},
+        {"if-match", ""},
+        {"if-modified-since", ""},
+        {"if-none-match", ""},
+        {"if-range", ""},
+        {"if-unmodified-since", ""},
+        {"last-modified", ""},
+        {"link", ""},
+        {"location", ""},
+        {"max-forwards", ""},
+        {"proxy-authenticate", ""},
+        {"proxy-authorization", ""},
+        {"range", ""},
+        {"referer", ""},
+        {"refresh", ""},
+        {"retry-after", ""},
+        {"server", ""},
+        {"set-cookie", ""},
+        {"strict-transport-security", ""},
+        {"transfer-encoding", ""},
+        {"user-agent", ""},
+        {"vary", ""},
+        {"via", ""},
+        {"www-authenticate", ""},
+};
+
+const int kMaxHuffmanCodeLength = 30;
+const std::uint16_t kHuffmanEos = 256;
+
+// The length of the code of every byte and of EOS last. The code is
+// canonical, so the codes themselves follow from the lengths.
+const std::uint8_t kHuffmanCodeLengths[257] = {
+    13, 23, 28, 28, 28, 28, 28, 28, 28, 24, 30, 28, 28, 30, 28, 28,
+    28, 28, 28, 28, 28, 28, 30, 28, 28, 28, 28, 28, 28, 28, 28, 28,
+    6, 10, 10, 12, 13, 6, 8, 11, 10, 10, 8, 11, 8, 6, 6, 6,
+    5, 5, 5, 6, 6, 6, 6, 6, 6, 6, 7, 8, 15, 6, 12, 10,
+    13, 6, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+    7, 7, 7, 7, 7, 7, 7, 7, 8, 7, 8, 13, 19, 13, 14, 6,
+    15, 5, 6, 5, 6, 5, 6, 6, 6, 5, 7, 7, 6, 6, 6, 5,
+    6, 7, 6, 5, 5, 6, 7, 7, 7, 7, 7, 15, 11, 14, 13, 28,
+    20, 22, 20, 20, 22, 22, 22, 23, 22, 23, 23, 23, 23, 23, 24, 23,
+    24, 24, 22, 23, 24, 23, 23, 23, 23, 21, 22, 23, 22, 23, 23, 24,
+    22, 21, 20, 22, 22, 23, 23, 21, 23, 22, 22, 24, 21, 22, 23, 23,
+    21, 21, 22, 21, 23, 22, 23, 23, 20, 22, 22, 22, 23, 22, 22, 23,
+    26, 26, 20, 19, 22, 23, 22, 25, 26, 26, 26, 27, 27, 26, 24, 25,
+    19, 21, 26, 27, 27, 26, 27, 24, 21, 21, 26, 26, 28, 27, 27, 27,
+    20, 24, 20, 21, 22, 21, 21, 23, 22, 22, 25, 25, 24, 24, 26, 23,
+    26, 27, 26, 26, 27, 27, 27, 27, 27, 28, 27, 27, 27, 27, 27, 26,
+    30,
+};
+
+struct HuffmanTable {
+  std::uint32_t codes[257];
+  // the symbols ordered by their codes, and per code length the first code
+  // of that length and where its symbols start
+  std::uint16_t symbols[257];
+  std::uint32_t first_codes[kMaxHuffmanCodeLength + 1];
+  std::uint16_t counts[kMaxHuffmanCodeLength + 1];
+  std::uint16_t offsets[kMaxHuffmanCodeLength + 1];
+
+  HuffmanTable() {
+    std::uint16_t symbol_num = 0;
+    for (int length = 0; length <= kMaxHuffmanCodeLength; length++) {
+      offsets[length] = symbol_num;
+      counts[length] = 0;
+      for (std::uint16_t symbol = 0; symbol <= kHuffmanEos; symbol++) {
+        if (kHuffmanCodeLengths[symbol] == length) {
+          symbols[symbol_num++] = symbol;
+          counts[length]++;
+        }
+      }
+    }
+    // codes of the same length are consecutive, shorter ones come first
+    std::uint32_t code = 0;
+    for (int length = 1; length <= kMaxHuffmanCodeLength; length++) {
+      first_codes[length] = code;
+      for (std::uint16_t i = 0; i < counts[length]; i++) {
+        codes[symbols[offsets[length] + i]] = code + i;
+      }
+      code = (code + counts[length]) << 1;
+    }
+  }
+};
+
+const HuffmanTable& GetHuffmanTable() {
+  static const HuffmanTable table;
+  return table;
+}
+
+// fields whose values change with almost every response and would only
+// push the others out of the table
+bool IsIndexable(std::string_view name) {
+  return name != "content-length" && name != "date" && name != "etag" &&
+         name != "last-modified" && name != "content-range" &&
+         name != "set-cookie";
+}
+
+}  // namespace
+
+void arc::http::detail::EncodeHpackInteger(std::uint64_t value,
+                                           int prefix_bits,
+                                           std::uint8_t flags,
+                                           std::string* out) {
+  std::uint64_t max_prefix = (1U << prefix_bits) - 1;
+  if (value < max_prefix) {
+    out->push_back(static_cast<char>(flags | value));
+    return;
+  }
+  out->push_back(static_cast<char>(flags | max_prefix));
+  value -= max_prefix;
+  while (value >= 0x80U) {
+    out->push_back(static_cast<char>((value & 0x7FU) | 0x80U));
+    value >>= 7;
+  }
+  out->push_back(static_cast<char>(value));
+}
+
+bool arc::http::detail::DecodeHpackInteger(std::string_view* data,
+                                           int prefix_bits,
+                                           std::uint64_t* value) {
+  if (data->empty()) {
+    return false;
+  }
+  auto bytes = reinterpret_cast<const unsigned char*>(data->data());
+  std::uint64_t max_prefix = (1U << prefix_bits) - 1;
+  std::uint64_t result = bytes[0] & max_prefix;
+  std::size_t size = 1;
+  if (result == max_prefix) {
+    int shift = 0;
+    while (true) {
+      // far beyond any size or index that can be valid
+      if (size == data->size() || shift > 28) {
+        return false;
+      }
+      unsigned char byte = bytes[size++];
+      result += static_cast<std::uint64_t>(byte & 0x7FU) << shift;
+      shift += 7;
+      if ((byte & 0x80U) == 0) {
+        break;
+      }
+    }
+  }
+  data->remove_prefix(size);
+  *value = result;
+  return true;
+}
+
+std::size_t arc::http::detail::GetHuffmanEncodedSize(std::string_view data) {
+  std::size_t bit_num = 0;
+  for (unsigned char c : data) {
+    bit_num += kHuffmanCodeLengths[c];
+  }
+  return (bit_num + 7) / 8;
+}
+
+void arc::http::detail::EncodeHuffman(std::string_view data,
+                                      std::string* out) {
+  const HuffmanTable& table = GetHuffmanTable();
+  std::uint64_t bits = 0;
+  int bit_num = 0;
+  for (unsigned char c : data) {
+    bits = (bits << kHuffmanCodeLengths[c]) | table.codes[c];
+    bit_num += kHuffmanCodeLengths[c];
+    while (bit_num >= 8) {
+      bit_num -= 8;
+      out->push_back(static_cast<char>(bits >> bit_num));
+    }
+    bits &= (1U << bit_num) - 1;
+  }
+  if (bit_num > 0) {
+    // padded with the most significant bits of EOS, which are all ones
+    out->push_back(
+        static_cast<char>((bits << (8 - bit_num)) | (0xFFU >> bit_num)));
+  }
+}
+
+bool arc::http::detail::DecodeHuffman(std::string_view data,
+                                      std::string* out) {
+  const HuffmanTable& table = GetHuffmanTable();
+  std::uint32_t code = 0;
+  int length = 0;
+  for (unsigned char c : data) {
+    for (int bit = 7; bit >= 0; bit--) {
+      code = (code << 1) | ((c >> bit) & 1U);
+      length++;
+      if (length > kMaxHuffmanCodeLength) {
+        return false;
+      }
+      // below the first code of the length if it wraps around
+      std::uint32_t index = code - table.first_codes[length];
+      if (index < table.counts[length]) {
+        std::uint16_t symbol = table.symbols[table.offsets[length] + index];
+        if (symbol == kHuffmanEos) {
+          return false;
+        }
+        out->push_back(static_cast<char>(symbol));
+        code = 0;
+        length = 0;
+      }
+    }
+  }
+  // only up to 7 bits of padding, all of them ones
+  return length < 8 && code == (1U << length) - 1;
+}
+
+bool arc::http::detail::HpackTable::Get(std::size_t index,
+                                        std::string_view* name,
+                                        std::string_view* value) const {
+  if (index == 0) {
+    return false;
+  }
+  if (index <= kStaticTableSize) {
+    *name = kStaticTable[index - 1].first;
+    *value = kStaticTable[index - 1].second;
+    return true;
+  }
+  index -= kStaticTableSize + 1;
+  if (index >= entries_.size()) {
+    return false;
+  }
+  *name = entries_[index].name;
+  *value = entries_[index].value;
+  return true;
+}
+
+std::size_t arc::http::detail::HpackTable::Find(
+    std::string_view name, std::string_view value,
+    bool* is_value_matched) const {
+  std::size_t name_index = 0;
+  for (std::size_t i = 0; i < kStaticTableSize; i++) {
+    if (kStaticTable[i].first == name) {
+      if (kStaticTable[i].second == value) {
+        *is_value_matched = true;
+        return i + 1;
+      }
+      if (name_index == 0) {
+        name_index = i + 1;
+      }
+    }
+  }
+  for (std::size_t i = 0; i < entries_.size(); i++) {
+    if (entries_[i].name == name) {
+      if (entries_[i].value == value) {
+        *is_value_matched = true;
+        return kStaticTableSize + 1 + i;
+      }
+      if (name_index == 0) {
+        name_index = kStaticTableSize + 1 + i;
+      }
+    }
+  }
+  *is_value_matched = false;
+  return name_index;
+}
+
+void arc::http::detail::HpackTable::Add(std::string_view name,
+                                        std::string_view value) {
+  std::size_t entry_size = name.size() + value.size() + kEntryOverhead;
+  if (entry_size > max_size_) {
+    // empties the table without being added
+    Evict(0);
+    return;
+  }
+  // name may refer to an entry evicted below
+  Entry entry{std::string(name), std::string(value)};
+  Evict(max_size_ - entry_size);
+  entries_.push_front(std::move(entry));
+  size_ += entry_size;
+}
+
+void arc::http::detail::HpackTable::SetMaxSize(std::size_t max_size) {
+  max_size_ = max_size;
+  Evict(max_size);
+}
+
+void arc::http::detail::HpackTable::Evict(std::size_t max_size) {
+  while (size_ > max_size) {
+    const Entry& oldest = entries_.back();
+    size_ -= oldest.name.size() + oldest.value.size() + kEntryOverhead;
+    entries_.pop_back();
+  }
+}
+
+HpackDecoder::HpackDecoder(std::size_t max_table_size)
+    : table_(max_table_size), max_table_size_(max_table_size) {}
+
+bool HpackDecoder::Decode(
+    std::string_view block,
+    const std::function<void(std::string_view, std::string_view)>&
+        on_field) {
+  bool is_field_decoded = false;
+  while (!block.empty()) {
+    auto first = static_cast<std::uint8_t>(block.front());
+    std::uint64_t index = 0;
+    std::string_view name;
+    std::string_view value;
+    if ((first & 0x80U) != 0) {
+      // an indexed field
+      if (!detail::DecodeHpackInteger(&block, 7, &index) ||
+          !table_.Get(index, &name, &value)) {
+        return false;
+      }
+      on_field(name, value);
+      is_field_decoded = true;
+      continue;
+    }
+    if ((first & 0xE0U) == 0x20U) {
+      // a table size update, only allowed at the start of a block
+      std::uint64_t max_size = 0;
+      if (is_field_decoded ||
+          !detail::DecodeHpackInteger(&block, 5, &max_size) ||
+          max_size > max_table_size_) {
+        return false;
+      }
+      table_.SetMaxSize(max_size);
+      continue;
+    }
+
+    // a literal field, added to the table or not
+    bool is_indexed = (first & 0xC0U) == 0x40U;
+    if (!detail::DecodeHpackInteger(&block, is_indexed ? 6 : 4, &index)) {
+      return false;
+    }
+    if (index == 0) {
+      if (!DecodeString(&block, &name_buffer_, &name)) {
+        return false;
+      }
+    } else if (!table_.Get(index, &name, &value)) {
+      return false;
+    }
+    if (!DecodeString(&block, &value_buffer_, &value)) {
+      return false;
+    }
+    on_field(name, value);
+    if (is_indexed) {
+      table_.Add(name, value);
+    }
+    is_field_decoded = true;
+  }
+  return true;
+}
+
+bool HpackDecoder::DecodeString(std::string_view* data, std::string* buffer,
+                                std::string_view* str) {
+  if (data->empty()) {
+    return false;
+  }
+  bool is_huffman = (static_cast<std::uint8_t>(data->front()) & 0x80U) != 0;
+  std::uint64_t size = 0;
+  if (!detail::DecodeHpackInteger(data, 7, &size) || size > data->size()) {
+    return false;
+  }
+  std::string_view raw = data->substr(0, size);
+  data->remove_prefix(size);
+  if (!is_huffman) {
+    *str = raw;
+    return true;
+  }
+  buffer->clear();
+  if (!detail::DecodeHuffman(raw, buffer)) {
+    return false;
+  }
+  *str = *buffer;
+  return true;
+}
+
+void HpackEncoder::SetMaxTableSize(std::size_t max_size) {
+  max_size = std::min(max_size, kDefaultTableSize);
+  if (!is_table_size_changed_) {
+    if (max_size == table_.GetMaxSize()) {
+      return;
+    }
+    min_pending_table_size_ = max_size;
+    is_table_size_changed_ = true;
+  }
+  min_pending_table_size_ = std::min(min_pending_table_size_, max_size);
+  table_.SetMaxSize(max_size);
+}
+
+void HpackEncoder::BeginBlock(std::string* block) {
+  if (!is_table_size_changed_) {
+    return;
+  }
+  detail::EncodeHpackInteger(min_pending_table_size_, 5, 0x20U, block);
+  if (table_.GetMaxSize() != min_pending_table_size_) {
+    detail::EncodeHpackInteger(table_.GetMaxSize(), 5, 0x20U, block);
+  }
+  is_table_size_changed_ = false;
+}
+
+void HpackEncoder::Encode(std::string_view name, std::string_view value,
+                          std::string* block) {
+  bool is_value_matched = false;
+  std::size_t index = table_.Find(name, value, &is_value_matched);
+  if (is_value_matched) {
+    detail::EncodeHpackInteger(index, 7, 0x80U, block);
+    return;
+  }
+  bool is_indexed = IsIndexable(name);
+  if (is_indexed) {
+    detail::EncodeHpackInteger(index, 6, 0x40U, block);
+  } else {
+    detail::EncodeHpackInteger(index, 4, 0x00U, block);
+  }
+  if (index == 0) {
+    EncodeString(name, block);
+  }
+  EncodeString(value, block);
+  if (is_indexed) {
+    table_.Add(name, value);
+  }
+}
+
+void HpackEncoder::EncodeString(std::string_view str, std::string* block) {
+  std::size_t huffman_size = detail::GetHuffmanEncodedSize(str);
+  if (huffman_size < str.size()) {
+    detail::EncodeHpackInteger(huffman_size, 7, 0x80U, block);
+    detail::EncodeHuffman(str, block);
+  } else {
+    detail::EncodeHpackInteger(str.size(), 7, 0x00U, block);
+    block->append(str);
+  }
+}
@@ -0,0 +1,992 @@
+/*
+ * File: http2.cc
+ * Project: libarc
+ * File Created: Saturday, 17th October 2026 11:41:22 pm
+ * Author: Minjun Xu (mjxu96@outlook.com)
+ * -----
+ * MIT License
+ * Copyright (c) 2022 Minjun Xu
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <arc/http/http2.h>
+#include <arc/http/http_server.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+
+using namespace arc::http;
+using namespace arc::http::detail;
+using namespace arc::coro;
+using namespace arc;
+
+namespace {
+
+const std::uint8_t kEndStreamFlag = 0x1U;
+const std::uint8_t kAckFlag = 0x1U;
+const std::uint8_t kEndHeadersFlag = 0x4U;
+const std::uint8_t kPaddedFlag = 0x8U;
+const std::uint8_t kPriorityFlag = 0x20U;
+
+const std::uint16_t kSettingsHeaderTableSize = 0x1U;
+const std::uint16_t kSettingsEnablePush = 0x2U;
+const std::uint16_t kSettingsMaxConcurrentStreams = 0x3U;
+const std::uint16_t kSettingsInitialWindowSize = 0x4U;
+const std::uint16_t kSettingsMaxFrameSize = 0x5U;
+const std::uint16_t kSettingsMaxHeaderListSize = 0x6U;
+
+const std::uint32_t kMaxFrameSizeLimit = 0xFFFFFFU;
+
+// what a header field counts as towards SETTINGS_MAX_HEADER_LIST_SIZE
+inline std::size_t GetHeaderFieldSize(std::string_view name,
+                                      std::string_view value) {
+  return name.size() + value.size() + 32;
+}
+
+inline std::uint32_t ReadUint32(const char* data) {
+  auto bytes = reinterpret_cast<const unsigned char*>(data);
+  return (static_cast<std::uint32_t>(bytes[0]) << 24) |
+         (static_cast<std::uint32_t>(bytes[1]) << 16) |
+         (static_cast<std::uint32_t>(bytes[2]) << 8) | bytes[3];
+}
+
+inline void AppendUint32(std::uint32_t value, std::string* out) {
+  out->push_back(static_cast<char>(value >> 24));
+  out->push_back(static_cast<char>(value >> 16));
+  out->push_back(static_cast<char>(value >> 8));
+  out->push_back(static_cast<char>(value));
+}
+
+inline void AppendSetting(std::uint16_t id, std::uint32_t value,
+                          std::string* out) {
+  out->push_back(static_cast<char>(id >> 8));
+  out->push_back(static_cast<char>(id));
+  AppendUint32(value, out);
+}
+
+void AppendFrameHeader(std::uint32_t length, Http2FrameType type,
+                       std::uint8_t flags, std::uint32_t stream_id,
+                       std::string* out) {
+  char head[kHttp2FrameHeaderSize];
+  WriteHttp2FrameHeader({length, type, flags, stream_id}, head);
+  out->append(head, kHttp2FrameHeaderSize);
+}
+
+// strips the padding off the payload of a DATA or HEADERS frame
+bool RemovePadding(std::uint8_t flags, std::string_view* payload) {
+  if ((flags & kPaddedFlag) == 0) {
+    return true;
+  }
+  if (payload->empty()) {
+    return false;
+  }
+  std::size_t padding_size = static_cast<unsigned char>(payload->front());
+  if (padding_size >= payload->size()) {
+    return false;
+  }
+  *payload = payload->substr(1, payload->size() - 1 - padding_size);
+  return true;
+}
+
+HttpMethod ToHttpMethod(std::string_view method, bool* is_valid) {
+  *is_valid = true;
+#define XX(num, name, string)    \
+  if (method == #string) {       \
+    return HttpMethod::HTTP_##name; \
+  }
+  HTTP_METHOD_MAP(XX)
+#undef XX
+  *is_valid = false;
+  return HttpMethod::HTTP_GET;
+}
+
+// the fields of HTTP/1 connection management, which HTTP/2 does not have
+bool IsConnectionSpecific(std::string_view name) {
+  return EqualsIgnoreCase(name, "connection") ||
+         EqualsIgnoreCase(name, "keep-alive") ||
+         EqualsIgnoreCase(name, "proxy-connection") ||
+         EqualsIgnoreCase(name, "transfer-encoding") ||
+         EqualsIgnoreCase(name, "upgrade");
+}
+
+}  // namespace
+
+void arc::http::detail::ParseHttp2FrameHeader(const char* data,
+                                              Http2FrameHeader* header) {
+  auto bytes = reinterpret_cast<const unsigned char*>(data);
+  header->length = (static_cast<std::uint32_t>(bytes[0]) << 16) |
+                   (static_cast<std::uint32_t>(bytes[1]) << 8) | bytes[2];
+  header->type = static_cast<Http2FrameType>(bytes[3]);
+  header->flags = bytes[4];
+  // without the reserved bit
+  header->stream_id = ReadUint32(data + 5) & 0x7FFFFFFFU;
+}
+
+void arc::http::detail::WriteHttp2FrameHeader(const Http2FrameHeader& header,
+                                              char* out) {
+  auto bytes = reinterpret_cast<unsigned char*>(out);
+  bytes[0] = header.length >> 16;
+  bytes[1] = header.length >> 8;
+  bytes[2] = header.length;
+  bytes[3] = static_cast<std::uint8_t>(header.type);
+  bytes[4] = header.flags;
+  bytes[5] = header.stream_id >> 24;
+  bytes[6] = header.stream_id >> 16;
+  bytes[7] = header.stream_id >> 8;
+  bytes[8] = header.stream_id;
+}
+
+arc::http::detail::Http2Stream::~Http2Stream() {
+  if (body_fd >= 0) {
+    close(body_fd);
+  }
+}
+
+arc::http::detail::Http2Connection::Http2Connection(
+    HttpServer* server,
+    arc::io::Socket<arc::net::Domain::IPV4, arc::net::Protocol::TCP,
+                    arc::io::Pattern::ASYNC>&& socket,
+    std::string_view received)
+    : server_(server),
+      socket_(std::move(socket)),
+      buffer_(std::max<std::size_t>(server->config_.read_buffer_size,
+                                    received.size())) {
+  if (!received.empty()) {
+    std::memcpy(buffer_.PrepareWrite(received.size()), received.data(),
+                received.size());
+    buffer_.Commit(received.size());
+  }
+  // every write is a whole frame already, and a frame header sent ahead of
+  // its file data must not wait for the ACK of the previous segment
+  int is_no_delay = 1;
+  setsockopt(socket_.GetFd(), IPPROTO_TCP, TCP_NODELAY, &is_no_delay,
+             sizeof(is_no_delay));
+}
+
+Task<void> arc::http::detail::Http2Connection::Run() {
+  // the settings which differ from the defaults, and the connection window
+  // opened up to its full size
+  std::string preface;
+  AppendFrameHeader(18, Http2FrameType::SETTINGS, 0, 0, &preface);
+  AppendSetting(kSettingsMaxConcurrentStreams, kMaxConcurrentStreams_,
+                &preface);
+  AppendSetting(kSettingsInitialWindowSize, kStreamWindowSize_, &preface);
+  AppendSetting(kSettingsMaxHeaderListSize, kMaxHeaderListSize_, &preface);
+  AppendFrameHeader(4, Http2FrameType::WINDOW_UPDATE, 0, 0, &preface);
+  AppendUint32(kConnectionWindowSize_ - kDefaultWindowSize_, &preface);
+  co_await write_lock_.Acquire();
+  bool is_sent = co_await SendAll(preface);
+  write_lock_.Release();
+
+  while (is_sent && !is_broken_ && !is_goaway_sent_) {
+    Http2FrameHeader header;
+    std::size_t frame_size = 0;
+    if (buffer_.Size() >= kHttp2FrameHeaderSize) {
+      ParseHttp2FrameHeader(buffer_.Data(), &header);
+      if (header.length > kDefaultMaxFrameSize_) {
+        co_await GoAway(Http2ErrorCode::FRAME_SIZE_ERROR);
+        break;
+      }
+      frame_size = kHttp2FrameHeaderSize + header.length;
+    }
+    if (frame_size > 0 && buffer_.Size() >= frame_size) {
+      auto error = co_await HandleFrame(
+          header, std::string_view(buffer_.Data() + kHttp2FrameHeaderSize,
+                                   header.length));
+      buffer_.Consume(frame_size);
+      if (error) {
+        co_await GoAway(*error);
+      }
+      continue;
+    }
+
+    // room for the whole frame if its size is known, not before a partial
+    // frame header is completed
+    const HttpConfig& config = server_->config_;
+    std::size_t missing_size =
+        frame_size > buffer_.Size() ? frame_size - buffer_.Size() : 0;
+    char* recv_ptr = buffer_.PrepareWrite(
+        std::max<std::size_t>(config.read_buffer_size, missing_size));
+    ssize_t recv_bytes = 0;
+    if (streams_.empty() && config.keep_alive_timeout_ms > 0) {
+      recv_bytes = co_await socket_.Recv(
+          recv_ptr, buffer_.WritableSize(),
+          std::chrono::milliseconds(config.keep_alive_timeout_ms));
+    } else {
+      recv_bytes = co_await socket_.Recv(recv_ptr, buffer_.WritableSize());
+    }
+    if (recv_bytes <= 0) {
+      if (recv_bytes < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+        config.logger->LogDebug("Timed out reading from connection");
+        co_await GoAway(Http2ErrorCode::NO_ERROR);
+      }
+      break;
+    }
+    buffer_.Commit(recv_bytes);
+  }
+  // nothing more can be received, so the streams still sending would never
+  // see their windows open
+  is_broken_ = true;
+  window_condition_.NotifyAll();
+}
+
+Task<Http2Connection::MaybeError> arc::http::detail::Http2Connection::
+    HandleFrame(const Http2FrameHeader& header, std::string_view payload) {
+  if (!is_settings_received_ && header.type != Http2FrameType::SETTINGS) {
+    co_return Http2ErrorCode::PROTOCOL_ERROR;
+  }
+  if (header_block_stream_id_ != 0 &&
+      (header.type != Http2FrameType::CONTINUATION ||
+       header.stream_id != header_block_stream_id_)) {
+    co_return Http2ErrorCode::PROTOCOL_ERROR;
+  }
+
+  switch (header.type) {
+    case Http2FrameType::DATA:
+      co_return co_await HandleData(header, payload);
+    case Http2FrameType::HEADERS: {
+      if (header.stream_id == 0 || header.stream_id % 2 == 0 ||
+          !RemovePadding(header.flags, &payload)) {
+        co_return Http2ErrorCode::PROTOCOL_ERROR;
+      }
+      if ((header.flags & kPriorityFlag) != 0) {
+        if (payload.size() < 5) {
+          co_return Http2ErrorCode::FRAME_SIZE_ERROR;
+        }
+        payload.remove_prefix(5);
+      }
+      if ((header.flags & kEndHeadersFlag) == 0) {
+        header_block_stream_id_ = header.stream_id;
+        header_block_flags_ = header.flags;
+        header_block_.assign(payload);
+        co_return std::nullopt;
+      }
+      co_return co_await HandleHeaders(header.stream_id, header.flags,
+                                       payload);
+    }
+    case Http2FrameType::CONTINUATION: {
+      if (header_block_stream_id_ == 0) {
+        co_return Http2ErrorCode::PROTOCOL_ERROR;
+      }
+      if (header_block_.size() + payload.size() > kMaxHeaderBlockSize_) {
+        co_return Http2ErrorCode::ENHANCE_YOUR_CALM;
+      }
+      header_block_.append(payload);
+      if ((header.flags & kEndHeadersFlag) == 0) {
+        co_return std::nullopt;
+      }
+      header_block_stream_id_ = 0;
+      co_return co_await HandleHeaders(header.stream_id, header_block_flags_,
+                                       header_block_);
+    }
+    case Http2FrameType::PRIORITY:
+      if (header.stream_id == 0) {
+        co_return Http2ErrorCode::PROTOCOL_ERROR;
+      }
+      if (payload.size() != 5) {
+        co_return Http2ErrorCode::FRAME_SIZE_ERROR;
+      }
+      // every stream is handled as soon as it can be
+      co_return std::nullopt;
+    case Http2FrameType::RST_STREAM:
+      if (header.stream_id == 0 || header.stream_id > last_stream_id_) {
+        co_return Http2ErrorCode::PROTOCOL_ERROR;
+      }
+      if (payload.size() != 4) {
+        co_return Http2ErrorCode::FRAME_SIZE_ERROR;
+      }
+      // the handler still runs, but nothing is sent for it any more
+      if (EraseStream(header.stream_id)) {
+        auto now = EventLoop::GetLocalInstance().Now();
+        if (now - peer_reset_window_begin_ >= std::chrono::seconds(1)) {
+          peer_reset_window_begin_ = now;
+          peer_reset_num_ = 0;
+        }
+        if (++peer_reset_num_ > kMaxPeerResetsPerSecond_) {
+          co_return Http2ErrorCode::ENHANCE_YOUR_CALM;
+        }
+      }
+      co_return std::nullopt;
+    case Http2FrameType::SETTINGS:
+      co_return co_await HandleSettings(header, payload);
+    case Http2FrameType::PUSH_PROMISE:
+      // clients cannot push
+      co_return Http2ErrorCode::PROTOCOL_ERROR;
+    case Http2FrameType::PING:
+      if (header.stream_id != 0) {
+        co_return Http2ErrorCode::PROTOCOL_ERROR;
+      }
+      if (payload.size() != 8) {
+        co_return Http2ErrorCode::FRAME_SIZE_ERROR;
+      }
+      if ((header.flags & kAckFlag) == 0) {
+        co_await SendFrame(Http2FrameType::PING, kAckFlag, 0, payload);
+      }
+      co_return std::nullopt;
+    case Http2FrameType::GOAWAY:
+      if (header.stream_id != 0) {
+        co_return Http2ErrorCode::PROTOCOL_ERROR;
+      }
+      // the streams opened so far are still answered, the peer closes the
+      // connection once it has got what it wants
+      co_return std::nullopt;
+    case Http2FrameType::WINDOW_UPDATE:
+      co_return co_await HandleWindowUpdate(header, payload);
+    default:
+      // unknown frame types are ignored
+      co_return std::nullopt;
+  }
+}
+
+Task<Http2Connection::MaybeError> arc::http::detail::Http2Connection::
+    HandleData(const Http2FrameHeader& header, std::string_view payload) {
+  if (header.stream_id == 0 || header.stream_id > last_stream_id_) {
+    co_return Http2ErrorCode::PROTOCOL_ERROR;
+  }
+  // padding counts against the windows as well
+  if (header.length > recv_window_) {
+    co_return Http2ErrorCode::FLOW_CONTROL_ERROR;
+  }
+  recv_window_ -= header.length;
+  if (recv_window_ <= kConnectionWindowSize_ / 2) {
+    std::uint32_t increment = kConnectionWindowSize_ - recv_window_;
+    recv_window_ = kConnectionWindowSize_;
+    co_await SendWindowUpdate(0, increment);
+  }
+  if (!RemovePadding(header.flags, &payload)) {
+    co_return Http2ErrorCode::PROTOCOL_ERROR;
+  }
+
+  auto stream_itr = streams_.find(header.stream_id);
+  if (stream_itr == streams_.end() ||
+      stream_itr->second->is_end_stream_received) {
+    co_await ResetStream(header.stream_id, Http2ErrorCode::STREAM_CLOSED);
+    co_return std::nullopt;
+  }
+  auto stream = stream_itr->second;
+  if (header.length > stream->recv_window) {
+    co_await ResetStream(header.stream_id,
+                         Http2ErrorCode::FLOW_CONTROL_ERROR);
+    co_return std::nullopt;
+  }
+  stream->recv_window -= header.length;
+  std::size_t max_body_size = server_->config_.max_request_body_size;
+  if (max_body_size > 0 && stream->body_size + payload.size() > max_body_size) {
+    // answered before the rest of the body, which is not wanted any more
+    HttpResponse response;
+    response.status = HttpStatus::HTTP_STATUS_PAYLOAD_TOO_LARGE;
+    co_await SendResponse(header.stream_id, &response, false);
+    co_await ResetStream(header.stream_id, Http2ErrorCode::NO_ERROR);
+    co_return std::nullopt;
+  }
+  if (!WriteBody(stream.get(), payload)) {
+    server_->config_.logger->LogWarning(
+        "Cannot write request body to a temporary file in %s",
+        server_->config_.body_temp_dir.c_str());
+    co_await ResetStream(header.stream_id, Http2ErrorCode::INTERNAL_ERROR);
+    co_return std::nullopt;
+  }
+
+  if ((header.flags & kEndStreamFlag) != 0) {
+    stream->is_end_stream_received = true;
+    Dispatch(stream);
+  } else if (stream->recv_window <= kStreamWindowSize_ / 2) {
+    std::uint32_t increment = kStreamWindowSize_ - stream->recv_window;
+    stream->recv_window = kStreamWindowSize_;
+    co_await SendWindowUpdate(header.stream_id, increment);
+  }
+  co_return std::nullopt;
+}
+
+Task<Http2Connection::MaybeError> arc::http::detail::Http2Connection::
+    HandleHeaders(std::uint32_t stream_id, std::uint8_t flags,
+                  std::string_view block) {
+  auto stream_itr = streams_.find(stream_id);
+  if (stream_itr != streams_.end() || stream_id <= last_stream_id_) {
+    // trailers, which end the stream and are not passed on, but still have
+    // to be decoded to keep the table in sync
+    std::size_t list_size = 0;
+    bool is_decoded = decoder_.Decode(
+        block, [&list_size](std::string_view name, std::string_view value) {
+          list_size += GetHeaderFieldSize(name, value);
+        });
+    if (!is_decoded) {
+      co_return Http2ErrorCode::COMPRESSION_ERROR;
+    }
+    if (list_size > kMaxHeaderListSize_) {
+      co_return Http2ErrorCode::ENHANCE_YOUR_CALM;
+    }
+    if (stream_itr == streams_.end()) {
+      co_return Http2ErrorCode::STREAM_CLOSED;
+    }
+    auto stream = stream_itr->second;
+    if (stream->is_end_stream_received || (flags & kEndStreamFlag) == 0) {
+      co_await ResetStream(stream_id, Http2ErrorCode::PROTOCOL_ERROR);
+      co_return std::nullopt;
+    }
+    stream->is_end_stream_received = true;
+    Dispatch(stream);
+    co_return std::nullopt;
+  }
+
+  last_stream_id_ = stream_id;
+  auto stream = std::make_shared<Http2Stream>();
+  stream->id = stream_id;
+  stream->send_window = peer_initial_window_size_;
+  stream->recv_window = kStreamWindowSize_;
+  MaybeError error;
+  bool is_valid = DecodeRequest(block, stream.get(), &error);
+  if (error) {
+    co_return error;
+  }
+  if (!is_valid) {
+    co_await ResetStream(stream_id, Http2ErrorCode::PROTOCOL_ERROR);
+    co_return std::nullopt;
+  }
+  if (streams_.size() + erased_running_stream_num_ >=
+      kMaxConcurrentStreams_) {
+    co_await ResetStream(stream_id, Http2ErrorCode::REFUSED_STREAM);
+    co_return std::nullopt;
+  }
+  streams_[stream_id] = stream;
+  if ((flags & kEndStreamFlag) != 0) {
+    stream->is_end_stream_received = true;
+    Dispatch(stream);
+  }
+  co_return std::nullopt;
+}
+
+bool arc::http::detail::Http2Connection::DecodeRequest(std::string_view block,
+                                                       Http2Stream* stream,
+                                                       MaybeError* error) {
+  HttpSpan method;
+  HttpSpan path;
+  HttpSpan authority;
+  bool has_scheme = false;
+  bool has_host = false;
+  bool is_valid = true;
+  bool is_regular_field_seen = false;
+  // a small block can refer to large table entries over and over again
+  std::size_t list_size = 0;
+  // cookies may be split into several fields, which are joined for HTTP/1
+  // style handlers
+  std::string cookie;
+  arc::utils::SmallVector<HttpFieldSpan, HttpHeaders::kInlineFieldNum>
+      fields;
+  std::string& storage = stream->fields;
+
+  auto store = [&storage](std::string_view str) {
+    HttpSpan span{storage.size(), str.size()};
+    storage.append(str);
+    return span;
+  };
+  bool is_decoded = decoder_.Decode(block, [&](std::string_view name,
+                                               std::string_view value) {
+    list_size += GetHeaderFieldSize(name, value);
+    if (!is_valid || list_size > kMaxHeaderListSize_) {
+      return;
+    }
+    if (!name.empty() && name.front() == ':') {
+      HttpSpan* pseudo_field = nullptr;
+      if (name == ":method") {
+        pseudo_field = &method;
+      } else if (name == ":path") {
+        pseudo_field = &path;
+      } else if (name == ":authority") {
+        pseudo_field = &authority;
+      } else if (name == ":scheme" && !has_scheme) {
+        has_scheme = true;
+        return;
+      }
+      // unknown, repeated, or after the regular ones
+      if (!pseudo_field || pseudo_field->length > 0 || value.empty() ||
+          is_regular_field_seen) {
+        is_valid = false;
+        return;
+      }
+      *pseudo_field = store(value);
+      return;
+    }
+    is_regular_field_seen = true;
+    bool has_upper_case =
+        std::any_of(name.begin(), name.end(),
+                    [](char c) { return c >= 'A' && c <= 'Z'; });
+    if (name.empty() || has_upper_case || IsConnectionSpecific(name) ||
+        (name == "te" && value != "trailers")) {
+      is_valid = false;
+      return;
+    }
+    if (name == "cookie") {
+      if (!cookie.empty()) {
+        cookie += "; ";
+      }
+      cookie += value;
+      return;
+    }
+    has_host = has_host || name == "host";
+    fields.push_back({store(name), store(value)});
+  });
+  if (!is_decoded) {
+    *error = Http2ErrorCode::COMPRESSION_ERROR;
+    return false;
+  }
+  if (list_size > kMaxHeaderListSize_) {
+    *error = Http2ErrorCode::ENHANCE_YOUR_CALM;
+    return false;
+  }
+  if (!is_valid || method.length == 0 || path.length == 0 || !has_scheme) {
+    return false;
+  }
+  if (!cookie.empty()) {
+    fields.push_back({store("cookie"), store(cookie)});
+  }
+  if (!has_host && authority.length > 0) {
+    fields.push_back({store("host"), authority});
+  }
+
+  // the views are taken once nothing is appended to the storage any more
+  const char* data = storage.data();
+  HttpRequest& request = stream->request;
+  request.method_string = method.ToView(data);
+  bool is_known_method = false;
+  request.method = ToHttpMethod(request.method_string, &is_known_method);
+  if (!is_known_method) {
+    return false;
+  }
+  std::string_view full_path = path.ToView(data);
+  auto query_begin = full_path.find('?');
+  request.path = full_path.substr(0, query_begin);
+  if (query_begin != std::string_view::npos) {
+    request.query_string = full_path.substr(query_begin + 1);
+  }
+  request.http_major_version = 2;
+  request.http_minor_version = 0;
+  for (const auto& field : fields) {
+    request.headers.Add(field.key.ToView(data), field.value.ToView(data));
+  }
+  return true;
+}
+
+bool arc::http::detail::Http2Connection::WriteBody(Http2Stream* stream,
+                                                   std::string_view data) {
+  stream->body_size += data.size();
+  const HttpConfig& config = server_->config_;
+  if (stream->body_fd < 0) {
+    if (config.max_buffered_body_size == 0 ||
+        stream->body_size <= config.max_buffered_body_size) {
+      stream->body.append(data);
+      return true;
+    }
+    // too large to be kept in memory from now on
+    stream->body_fd = OpenTempFile(config.body_temp_dir);
+    if (stream->body_fd < 0) {
+      return false;
+    }
+    std::string kept = std::move(stream->body);
+    stream->body = std::string();
+    kept.append(data);
+    data = kept;
+    while (!data.empty()) {
+      ssize_t written = write(stream->body_fd, data.data(), data.size());
+      if (written < 0) {
+        return false;
+      }
+      data.remove_prefix(written);
+    }
+    return true;
+  }
+  while (!data.empty()) {
+    ssize_t written = write(stream->body_fd, data.data(), data.size());
+    if (written < 0) {
+      return false;
+    }
+    data.remove_prefix(written);
+  }
+  return true;
+}
+
+bool arc::http::detail::Http2Connection::EraseStream(std::uint32_t stream_id) {
+  auto stream_itr = streams_.find(stream_id);
+  if (stream_itr == streams_.end()) {
+    return false;
+  }
+  if (stream_itr->second->is_dispatched) {
+    erased_running_stream_num_++;
+  }
+  streams_.erase(stream_itr);
+  window_condition_.NotifyAll();
+  return true;
+}
+
+void arc::http::detail::Http2Connection::Dispatch(
+    std::shared_ptr<Http2Stream> stream) {
+  HttpRequest& request = stream->request;
+  if (stream->body_fd >= 0) {
+    struct stat file_stat;
+    if (fstat(stream->body_fd, &file_stat) == 0) {
+      request.body_file = std::make_shared<HttpFile>(stream->body_fd,
+                                                     file_stat);
+      // closed by the file from now on
+      stream->body_fd = -1;
+    }
+  } else {
+    request.body = stream->body;
+  }
+  request.is_complete = true;
+  stream->is_dispatched = true;
+  EnsureFuture(RunStream(shared_from_this(), std::move(stream)));
+}
+
+// self keeps the connection alive until the stream is done, even after
+// Run() has returned
+Task<void> arc::http::detail::Http2Connection::RunStream(
+    [[maybe_unused]] std::shared_ptr<Http2Connection> self,
+    std::shared_ptr<Http2Stream> stream) {
+  HttpResponse response;
+  bool is_head = stream->request.method == HttpMethod::HTTP_HEAD;
+  HttpResponseWriter writer(this, stream->id, &response, is_head);
+  Context context{.conn = &socket_, .writer = &writer};
+  co_await server_->HandleRequest(&stream->request, &response, &context);
+  if (writer.IsStarted()) {
+    co_await writer.Finish();
+  } else {
+    co_await SendResponse(stream->id, &response, is_head);
+  }
+  // both sides have ended the stream by now, unless it has been reset
+  auto stream_itr = streams_.find(stream->id);
+  if (stream_itr != streams_.end() && stream_itr->second == stream) {
+    streams_.erase(stream_itr);
+  } else {
+    erased_running_stream_num_--;
+  }
+}
+
+Task<bool> arc::http::detail::Http2Connection::SendResponse(
+    std::uint32_t stream_id, HttpResponse* response, bool is_head) {
+  std::size_t file_length = response->file ? response->file_length : 0;
+  if (response->headers.find("Content-Length") == response->headers.end()) {
+    response->headers["Content-Length"] =
+        std::to_string(response->body.size() + file_length);
+  }
+  bool has_body = !is_head && (!response->body.empty() || file_length > 0);
+  if (!co_await SendHeaders(stream_id, response, !has_body)) {
+    co_return false;
+  }
+  if (!has_body) {
+    co_return true;
+  }
+  if (!response->body.empty() &&
+      !co_await SendDataFrames(stream_id, response->body, nullptr, 0,
+                               response->body.size(), file_length == 0)) {
+    co_return false;
+  }
+  if (file_length > 0) {
+    co_return co_await SendDataFrames(stream_id, std::string_view(),
+                                      response->file.get(),
+                                      response->file_offset, file_length,
+                                      true);
+  }
+  co_return true;
+}
+
+Task<bool> arc::http::detail::Http2Connection::SendHeaders(
+    std::uint32_t stream_id, HttpResponse* response, bool is_end_stream) {
+  co_await write_lock_.Acquire();
+  bool is_sent = false;
+  if (!is_broken_ && streams_.find(stream_id) != streams_.end()) {
+    // encoded with the lock held, in the order the blocks go out
+    std::string block;
+    encoder_.BeginBlock(&block);
+    encoder_.Encode(":status",
+                    std::to_string(static_cast<int>(response->status)),
+                    &block);
+    std::string name;
+    for (const auto& [key, value] : response->headers) {
+      if (IsConnectionSpecific(key)) {
+        continue;
+      }
+      name.resize(key.size());
+      std::transform(key.begin(), key.end(), name.begin(),
+                     [](unsigned char c) { return std::tolower(c); });
+      encoder_.Encode(name, value, &block);
+    }
+
+    // a HEADERS frame and as many CONTINUATION frames as it takes
+    std::string frames;
+    std::string_view rest = block;
+    Http2FrameType type = Http2FrameType::HEADERS;
+    std::uint8_t flags = is_end_stream ? kEndStreamFlag : 0;
+    do {
+      std::string_view fragment = rest.substr(0, peer_max_frame_size_);
+      rest.remove_prefix(fragment.size());
+      AppendFrameHeader(fragment.size(), type,
+                        flags | (rest.empty() ? kEndHeadersFlag : 0),
+                        stream_id, &frames);
+      frames.append(fragment);
+      type = Http2FrameType::CONTINUATION;
+      flags = 0;
+    } while (!rest.empty());
+    is_sent = co_await SendAll(frames);
+  }
+  write_lock_.Release();
+  co_return is_sent;
+}
+
+Task<bool> arc::http::detail::Http2Connection::SendData(
+    std::uint32_t stream_id, std::string_view data, bool is_end_stream) {
+  co_return co_await SendDataFrames(stream_id, data, nullptr, 0, data.size(),
+                                    is_end_stream);
+}
+
+Task<bool> arc::http::detail::Http2Connection::SendDataFrames(
+    std::uint32_t stream_id, std::string_view data, const HttpFile* file,
+    std::size_t file_offset, std::size_t size, bool is_end_stream) {
+  std::size_t sent_size = 0;
+  do {
+    auto stream_itr = streams_.find(stream_id);
+    if (is_broken_ || stream_itr == streams_.end()) {
+      co_return false;
+    }
+    Http2Stream* stream = stream_itr->second.get();
+    std::int64_t window =
+        std::min({send_window_, stream->send_window,
+                  static_cast<std::int64_t>(peer_max_frame_size_)});
+    std::size_t frame_size = std::min<std::size_t>(
+        size - sent_size, std::max<std::int64_t>(window, 0));
+    if (frame_size == 0 && sent_size < size) {
+      co_await window_condition_.Wait();
+      continue;
+    }
+    // taken before waiting for the lock so that no one else takes it
+    send_window_ -= frame_size;
+    stream->send_window -= frame_size;
+    bool is_last_frame = sent_size + frame_size == size;
+    char head[kHttp2FrameHeaderSize];
+    WriteHttp2FrameHeader(
+        {static_cast<std::uint32_t>(frame_size), Http2FrameType::DATA,
+         static_cast<std::uint8_t>(
+             is_end_stream && is_last_frame ? kEndStreamFlag : 0),
+         stream_id},
+        head);
+
+    co_await write_lock_.Acquire();
+    bool is_sent = false;
+    if (!is_broken_ && streams_.find(stream_id) != streams_.end()) {
+      if (file) {
+        is_sent = co_await SendAll(std::string_view(head, sizeof(head)));
+        if (is_sent && frame_size > 0) {
+          try {
+            is_sent = co_await server_->SendFileAll(
+                socket_, *file, file_offset + sent_size, frame_size);
+          } catch (const std::exception& e) {
+            server_->config_.logger->LogWarning(e.what());
+            is_sent = false;
+          }
+          is_broken_ = is_broken_ || !is_sent;
+        }
+      } else {
+        iovec iov[2] = {
+            {head, sizeof(head)},
+            {const_cast<char*>(data.data()) + sent_size, frame_size}};
+        try {
+          is_sent = co_await server_->SendAll(socket_, iov, 2);
+        } catch (const std::exception& e) {
+          server_->config_.logger->LogWarning(e.what());
+        }
+        is_broken_ = is_broken_ || !is_sent;
+      }
+    }
+    write_lock_.Release();
+    if (!is_sent) {
+      // the stream has been reset while waiting for the lock, or the
+      // connection is broken, so the frame does not count against the
+      // connection window shared with the other streams
+      send_window_ += frame_size;
+      window_condition_.NotifyAll();
+      co_return false;
+    }
+    sent_size += frame_size;
+  } while (sent_size < size);
+  co_return true;
+}
+
+Task<Http2Connection::MaybeError> arc::http::detail::Http2Connection::
+    HandleSettings(const Http2FrameHeader& header, std::string_view payload) {
+  if (header.stream_id != 0) {
+    co_return Http2ErrorCode::PROTOCOL_ERROR;
+  }
+  if ((header.flags & kAckFlag) != 0) {
+    if (!payload.empty()) {
+      co_return Http2ErrorCode::FRAME_SIZE_ERROR;
+    }
+    co_return std::nullopt;
+  }
+  if (payload.size() % 6 != 0) {
+    co_return Http2ErrorCode::FRAME_SIZE_ERROR;
+  }
+  is_settings_received_ = true;
+  for (std::size_t i = 0; i < payload.size(); i += 6) {
+    auto id = static_cast<std::uint16_t>(
+        (static_cast<unsigned char>(payload[i]) << 8) |
+        static_cast<unsigned char>(payload[i + 1]));
+    std::uint32_t value = ReadUint32(payload.data() + i + 2);
+    switch (id) {
+      case kSettingsHeaderTableSize:
+        encoder_.SetMaxTableSize(value);
+        break;
+      case kSettingsEnablePush:
+        if (value > 1) {
+          co_return Http2ErrorCode::PROTOCOL_ERROR;
+        }
+        break;
+      case kSettingsInitialWindowSize: {
+        if (value > kMaxWindowSize_) {
+          co_return Http2ErrorCode::FLOW_CONTROL_ERROR;
+        }
+        // applies to the streams open already as well
+        std::int64_t delta =
+            static_cast<std::int64_t>(value) - peer_initial_window_size_;
+        for (auto& [stream_id, stream] : streams_) {
+          stream->send_window += delta;
+          if (stream->send_window > kMaxWindowSize_) {
+            co_return Http2ErrorCode::FLOW_CONTROL_ERROR;
+          }
+        }
+        peer_initial_window_size_ = value;
+        break;
+      }
+      case kSettingsMaxFrameSize:
+        if (value < kDefaultMaxFrameSize_ || value > kMaxFrameSizeLimit) {
+          co_return Http2ErrorCode::PROTOCOL_ERROR;
+        }
+        peer_max_frame_size_ = value;
+        break;
+      default:
+        // no streams are pushed, so MAX_CONCURRENT_STREAMS does not matter,
+        // and unknown settings are ignored
+        break;
+    }
+  }
+  window_condition_.NotifyAll();
+  co_await SendFrame(Http2FrameType::SETTINGS, kAckFlag, 0,
+                     std::string_view());
+  co_return std::nullopt;
+}
+
+Task<Http2Connection::MaybeError> arc::http::detail::Http2Connection::
+    HandleWindowUpdate(const Http2FrameHeader& header,
+                       std::string_view payload) {
+  if (payload.size() != 4) {
+    co_return Http2ErrorCode::FRAME_SIZE_ERROR;
+  }
+  std::uint32_t increment = ReadUint32(payload.data()) & 0x7FFFFFFFU;
+  if (header.stream_id == 0) {
+    if (increment == 0) {
+      co_return Http2ErrorCode::PROTOCOL_ERROR;
+    }
+    send_window_ += increment;
+    if (send_window_ > kMaxWindowSize_) {
+      co_return Http2ErrorCode::FLOW_CONTROL_ERROR;
+    }
+  } else {
+    if (header.stream_id > last_stream_id_) {
+      co_return Http2ErrorCode::PROTOCOL_ERROR;
+    }
+    auto stream_itr = streams_.find(header.stream_id);
+    if (stream_itr == streams_.end()) {
+      // may have crossed the end of the stream
+      co_return std::nullopt;
+    }
+    Http2Stream* stream = stream_itr->second.get();
+    if (increment == 0) {
+      co_await ResetStream(header.stream_id, Http2ErrorCode::PROTOCOL_ERROR);
+      co_return std::nullopt;
+    }
+    stream->send_window += increment;
+    if (stream->send_window > kMaxWindowSize_) {
+      co_await ResetStream(header.stream_id,
+                           Http2ErrorCode::FLOW_CONTROL_ERROR);
+      co_return std::nullopt;
+    }
+  }
+  window_condition_.NotifyAll();
+  co_return std::nullopt;
+}
+
+Task<bool> arc::http::detail::Http2Connection::SendFrame(
+    Http2FrameType type, std::uint8_t flags, std::uint32_t stream_id,
+    std::string_view payload) {
+  std::string frame;
+  AppendFrameHeader(payload.size(), type, flags, stream_id, &frame);
+  frame.append(payload);
+  co_await write_lock_.Acquire();
+  bool is_sent = !is_broken_ && co_await SendAll(frame);
+  write_lock_.Release();
+  co_return is_sent;
+}
+
+Task<bool> arc::http::detail::Http2Connection::SendWindowUpdate(
+    std::uint32_t stream_id, std::uint32_t increment) {
+  std::string payload;
+  AppendUint32(increment, &payload);
+  co_return co_await SendFrame(Http2FrameType::WINDOW_UPDATE, 0, stream_id,
+                               payload);
+}
+
+Task<bool> arc::http::detail::Http2Connection::ResetStream(
+    std::uint32_t stream_id, Http2ErrorCode code) {
+  EraseStream(stream_id);
+  std::string payload;
+  AppendUint32(static_cast<std::uint32_t>(code), &payload);
+  co_return co_await SendFrame(Http2FrameType::RST_STREAM, 0, stream_id,
+                               payload);
+}
+
+Task<bool> arc::http::detail::Http2Connection::GoAway(Http2ErrorCode code) {
+  if (code != Http2ErrorCode::NO_ERROR) {
+    server_->config_.logger->LogDebug("Close HTTP/2 connection with error %u",
+                                      static_cast<unsigned int>(code));
+  }
+  is_goaway_sent_ = true;
+  std::string payload;
+  AppendUint32(last_stream_id_, &payload);
+  AppendUint32(static_cast<std::uint32_t>(code), &payload);
+  co_return co_await SendFrame(Http2FrameType::GOAWAY, 0, 0, payload);
+}
+
+Task<bool> arc::http::detail::Http2Connection::SendAll(std::string_view data) {
+  iovec iov = {const_cast<char*>(data.data()), data.size()};
+  bool is_sent = false;
+  try {
+    is_sent = co_await server_->SendAll(socket_, &iov, 1);
+  } catch (const std::exception& e) {
+    server_->config_.logger->LogWarning(e.what());
+  }
+  if (!is_sent) {
+    is_broken_ = true;
+    window_condition_.NotifyAll();
+  }
+  co_return is_sent;
+}
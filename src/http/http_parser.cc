@@ -2589,8 +2589,12 @@ void http_parser_set_max_header_size(uint32_t size) { max_header_size = size; }
  */
 
 #include <arc/http/http_parser.h>
+#include <arc/http/http_static.h>
 #include <curl/curl.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
+#include <cstring>
 #include <functional>
 #include <iostream>
 #include <unordered_set>
@@ -2620,156 +2624,402 @@ std::string EncodeCharToHex(const std::string &input) {
   return ret;
 }
 
-void ParseOnePair(HttpRequest *request, const std::string &query) {
+void ParseOnePair(std::unordered_map<std::string, std::string> *queries,
+                  std::string_view query) {
   // TODO do check on this pair
   auto equal_sign_pos = query.find('=');
   if (equal_sign_pos != std::string::npos && query.size() >= 3 &&
       equal_sign_pos > 0 && equal_sign_pos < query.size() - 1) {
-    request->queries[DecodeHexToChar(query.substr(0, equal_sign_pos))] =
-        DecodeHexToChar(query.substr(equal_sign_pos + 1,
-                                     query.size() - equal_sign_pos - 1));
+    (*queries)[DecodeHexToChar(std::string(query.substr(0, equal_sign_pos)))] =
+        DecodeHexToChar(std::string(query.substr(
+            equal_sign_pos + 1, query.size() - equal_sign_pos - 1)));
   }
 }
 
-void ParseQuery(HttpRequest *request, const std::string &queries) {
+void ParseQuery(std::unordered_map<std::string, std::string> *queries,
+                std::string_view query_string) {
   std::size_t start_itr = 0;
   std::size_t stop_itr = std::string::npos;
   do {
-    stop_itr = queries.find('&', start_itr);
-    ParseOnePair(request, queries.substr(start_itr, stop_itr - start_itr));
+    stop_itr = query_string.find('&', start_itr);
+    ParseOnePair(queries,
+                 query_string.substr(start_itr, stop_itr - start_itr));
     if (stop_itr != std::string::npos) {
       start_itr = stop_itr + 1;
     } else {
       break;
     }
-  } while (start_itr <= queries.size());
+  } while (start_itr <= query_string.size());
 }
 
-template <typename HttpType>
-int OnUrl(http_parser *parser, const char *at, size_t length) {
-  if constexpr (std::is_same_v<HttpType, HttpResponse>) {
-    return 0;
+bool arc::http::EqualsIgnoreCase(std::string_view a, std::string_view b) {
+  if (a.size() != b.size()) {
+    return false;
+  }
+  for (std::size_t i = 0; i < a.size(); i++) {
+    if (a[i] != b[i] && tolower((unsigned char)a[i]) !=
+                            tolower((unsigned char)b[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+std::unordered_map<std::string, std::string> HttpRequest::GetQueries() const {
+  std::unordered_map<std::string, std::string> queries;
+  if (!query_string.empty()) {
+    ParseQuery(&queries, query_string);
+  }
+  return queries;
+}
+
+OwnedHttpRequest HttpRequest::ToOwned() const {
+  OwnedHttpRequest owned_request;
+  owned_request.method_string = method_string;
+  owned_request.method = method;
+  owned_request.path = path;
+  owned_request.http_major_version = http_major_version;
+  owned_request.http_minor_version = http_minor_version;
+  for (const auto &[key, value] : headers) {
+    owned_request.headers.emplace(key, value);
+  }
+  owned_request.queries = GetQueries();
+  owned_request.body = body;
+  for (const auto &[key, value] : RESTful_params) {
+    owned_request.RESTful_params.emplace(key, value);
+  }
+  return owned_request;
+}
+
+void HttpRequest::Clear() {
+  method_string = {};
+  method = HttpMethod::HTTP_GET;
+  path = {};
+  query_string = {};
+  http_major_version = 1;
+  http_minor_version = 1;
+  headers.clear();
+  body = {};
+  body_file = nullptr;
+  is_complete = false;
+  RESTful_params.clear();
+}
+
+HttpBuffer::HttpBuffer(std::size_t initial_capacity)
+    : data_(new char[initial_capacity]), capacity_(initial_capacity) {}
+
+char *HttpBuffer::PrepareWrite(std::size_t min_size) {
+  if (capacity_ - end_ >= min_size) {
+    return data_.get() + end_;
+  }
+  std::size_t size = end_ - begin_;
+  if (capacity_ - size >= min_size) {
+    // enough room once the consumed bytes are dropped
+    std::memmove(data_.get(), data_.get() + begin_, size);
   } else {
-    HttpType *request = (HttpType *)parser->data;
-    assert(request != nullptr);
-    http_parser_url url_parser;
-    http_parser_url_init(&url_parser);
-    http_parser_parse_url(at, length, 1, &url_parser);
-    for (int i = (int)(http_parser_url_fields::UF_SCHEMA);
-         i < (int)(http_parser_url_fields::UF_MAX); i++) {
-      auto mask = 1 << i;
-      if ((url_parser.field_set & mask) != 0) {
-        switch (i) {
-          case UF_SCHEMA:
-            break;
-          case UF_HOST:
-            break;
-          case UF_PORT:
-            break;
-          [[likely]] case UF_PATH:
-            request->path = std::string(at + url_parser.field_data[i].off,
-                                        url_parser.field_data[i].len);
-            break;
-          [[likely]] case UF_QUERY:
-            ParseQuery(request, std::string(at + url_parser.field_data[i].off,
-                                            url_parser.field_data[i].len));
-            break;
-          case UF_FRAGMENT:
-            break;
-          case UF_USERINFO:
-            break;
-          default:
-            break;
-        }
-      }
+    std::size_t capacity = capacity_ * 2;
+    while (capacity - size < min_size) {
+      capacity *= 2;
     }
+    std::unique_ptr<char[]> data(new char[capacity]);
+    std::memcpy(data.get(), data_.get() + begin_, size);
+    data_ = std::move(data);
+    capacity_ = capacity;
+  }
+  begin_ = 0;
+  end_ = size;
+  return data_.get() + end_;
+}
+
+void HttpBuffer::Erase(std::size_t offset, std::size_t size) {
+  char *data = Data();
+  std::memmove(data + offset, data + offset + size,
+               Size() - offset - size);
+  end_ -= size;
+}
+
+void HttpBuffer::Consume(std::size_t size) {
+  begin_ += size;
+  if (begin_ == end_) {
+    begin_ = 0;
+    end_ = 0;
+  }
+}
+
+namespace {
+
+using arc::http::detail::HttpRequestParseState;
+using arc::http::detail::HttpSpan;
+
+// a field may be handed over in several pieces, which are adjacent as the
+// whole message stays in one buffer
+inline void AppendToSpan(HttpSpan *span, std::size_t offset,
+                         std::size_t length) {
+  if (span->length == 0) {
+    span->offset = offset;
+  }
+  assert(span->End() == offset);
+  span->length += length;
+}
+
+inline std::size_t GetOffset(http_parser *parser, const char *at) {
+  auto state = static_cast<HttpRequestParseState *>(parser->data);
+  return at - state->message;
+}
+
+int OnRequestUrl(http_parser *parser, const char *at, size_t length) {
+  auto state = static_cast<HttpRequestParseState *>(parser->data);
+  AppendToSpan(&state->url, GetOffset(parser, at), length);
+  return 0;
+}
+
+// false if not all of it could be written
+bool WriteAll(int fd, const char *data, std::size_t size) {
+  while (size > 0) {
+    ssize_t written = write(fd, data, size);
+    if (written < 0 && errno == EINTR) {
+      continue;
+    }
+    if (written <= 0) {
+      return false;
+    }
+    data += written;
+    size -= written;
+  }
+  return true;
+}
+
+int OnRequestHeaderField(http_parser *parser, const char *at, size_t length) {
+  auto state = static_cast<HttpRequestParseState *>(parser->data);
+  if (state->body_fd >= 0) {
+    // trailers of a spilled body, their bytes are released
+    return 0;
+  }
+  if (state->last_field != HttpRequestParseState::LastField::HEADER_KEY) {
+    state->headers.push_back({});
+    state->last_field = HttpRequestParseState::LastField::HEADER_KEY;
+  }
+  AppendToSpan(&(state->headers.back().key), GetOffset(parser, at), length);
+  return 0;
+}
+
+int OnRequestHeaderValue(http_parser *parser, const char *at, size_t length) {
+  auto state = static_cast<HttpRequestParseState *>(parser->data);
+  if (state->body_fd >= 0) {
     return 0;
   }
+  assert(!state->headers.empty());
+  state->last_field = HttpRequestParseState::LastField::HEADER_VALUE;
+  AppendToSpan(&(state->headers.back().value), GetOffset(parser, at),
+               length);
+  return 0;
+}
+
+int OnRequestHeadersComplete(http_parser *parser) {
+  auto state = static_cast<HttpRequestParseState *>(parser->data);
+  state->is_headers_complete = true;
+  return 0;
+}
+
+int OnRequestBody(http_parser *parser, const char *at, size_t length) {
+  auto state = static_cast<HttpRequestParseState *>(parser->data);
+  state->body_size += length;
+  if (state->body_fd >= 0) {
+    return WriteAll(state->body_fd, at, length) ? 0 : 1;
+  }
+  std::size_t offset = GetOffset(parser, at);
+  if (state->body.length > 0 && state->body.End() != offset) {
+    // chunked, move this chunk right behind the previous one over the
+    // already parsed chunk header
+    std::memmove(state->message + state->body.End(), at, length);
+    offset = state->body.End();
+  }
+  AppendToSpan(&state->body, offset, length);
+  return 0;
 }
 
-template <typename HttpType>
-int OnStatus(http_parser *parser, const char *at, size_t length) {
+int OnRequestComplete(http_parser *parser) {
+  auto state = static_cast<HttpRequestParseState *>(parser->data);
+  HttpRequest *request = state->request;
+  const char *message = state->message;
+
+  std::string_view url = state->url.ToView(message);
+  http_parser_url url_parser;
+  http_parser_url_init(&url_parser);
+  if (http_parser_parse_url(url.data(), url.size(),
+                            parser->method == HTTP_CONNECT, &url_parser) == 0) {
+    if (url_parser.field_set & (1 << UF_PATH)) [[likely]] {
+      request->path = url.substr(url_parser.field_data[UF_PATH].off,
+                                 url_parser.field_data[UF_PATH].len);
+    }
+    if (url_parser.field_set & (1 << UF_QUERY)) {
+      request->query_string =
+          url.substr(url_parser.field_data[UF_QUERY].off,
+                     url_parser.field_data[UF_QUERY].len);
+    }
+  }
+  for (const auto &[key, value] : state->headers) {
+    request->headers.Add(key.ToView(message), value.ToView(message));
+  }
+  request->body = state->body.ToView(message);
+  if (state->body_fd >= 0) {
+    struct stat file_stat;
+    if (fstat(state->body_fd, &file_stat) != 0) {
+      return 1;
+    }
+    request->body_file =
+        std::make_shared<const HttpFile>(state->body_fd, file_stat);
+    state->body_fd = -1;
+  }
+  request->method = (HttpMethod)parser->method;
+  request->method_string = http_method_str(request->method);
+  request->http_major_version = parser->http_major;
+  request->http_minor_version = parser->http_minor;
+  request->is_complete = true;
+
+  // stop here, what follows is the next request
+  http_parser_pause(parser, 1);
   return 0;
 }
 
-template <typename HttpType>
-int OnHeaderField(http_parser *parser, const char *at, size_t length) {
-  HttpType *request = (HttpType *)parser->data;
-  request->temporary_store = std::string(at, length);
+const http_parser_settings request_setting{
+    .on_message_begin = 0,
+    .on_url = OnRequestUrl,
+    .on_status = 0,
+    .on_header_field = OnRequestHeaderField,
+    .on_header_value = OnRequestHeaderValue,
+    .on_headers_complete = OnRequestHeadersComplete,
+    .on_body = OnRequestBody,
+    .on_message_complete = OnRequestComplete,
+    .on_chunk_header = 0,
+    .on_chunk_complete = 0};
+
+int OnResponseHeaderField(http_parser *parser, const char *at, size_t length) {
+  HttpResponse *response = (HttpResponse *)parser->data;
+  response->temporary_store = std::string(at, length);
   return 0;
 }
 
-template <typename HttpType>
-int OnHeaderValue(http_parser *parser, const char *at, size_t length) {
-  HttpType *request = (HttpType *)parser->data;
-  assert(!request->temporary_store.empty());
-  assert(request != nullptr);
-  request->headers[std::move(request->temporary_store)] =
+int OnResponseHeaderValue(http_parser *parser, const char *at, size_t length) {
+  HttpResponse *response = (HttpResponse *)parser->data;
+  assert(response != nullptr);
+  assert(!response->temporary_store.empty());
+  response->headers[std::move(response->temporary_store)] =
       std::string(at, length);
   return 0;
 }
 
-template <typename HttpType>
-int OnBody(http_parser *parser, const char *at, size_t length) {
-  HttpType *request = (HttpType *)parser->data;
-  assert(request != nullptr);
-  request->body += std::string(at, length);
+int OnResponseBody(http_parser *parser, const char *at, size_t length) {
+  HttpResponse *response = (HttpResponse *)parser->data;
+  assert(response != nullptr);
+  response->body.append(at, length);
   return 0;
 }
 
-template <typename HttpType>
-int OnMessageComplete(http_parser *parser) {
-  HttpType *request = (HttpType *)parser->data;
-  request->is_complete = true;
+int OnResponseComplete(http_parser *parser) {
+  HttpResponse *response = (HttpResponse *)parser->data;
+  response->is_complete = true;
   return 0;
 }
 
-template <typename HttpType>
-const http_parser_settings setting{
+const http_parser_settings response_setting{
     .on_message_begin = 0,
-    .on_url = OnUrl<HttpType>,
-    .on_status = OnStatus<HttpType>,
-    .on_header_field = OnHeaderField<HttpType>,
-    .on_header_value = OnHeaderValue<HttpType>,
+    .on_url = 0,
+    .on_status = 0,
+    .on_header_field = OnResponseHeaderField,
+    .on_header_value = OnResponseHeaderValue,
     .on_headers_complete = 0,
-    .on_body = OnBody<HttpType>,
-    .on_message_complete = OnMessageComplete<HttpType>,
+    .on_body = OnResponseBody,
+    .on_message_complete = OnResponseComplete,
     .on_chunk_header = 0,
     .on_chunk_complete = 0};
 
-arc::http::HttpParser::HttpParser(http_parser_type http_type) {
+}  // namespace
+
+arc::http::HttpParser::HttpParser(http_parser_type http_type)
+    : http_type_(http_type) {
   http_parser_init(&parser_, http_type);
 }
 
-int arc::http::HttpParser::ParseOnce(const std::string &recv,
-                                     HttpRequest *request_ptr) {
-  parser_.data = request_ptr;
-  int nparsed = http_parser_execute(&parser_, &(setting<HttpRequest>),
-                                    recv.c_str(), recv.size());
-  if (parser_.upgrade) {
-    // TODO implement this
-    assert(false);
-  } else {
-    if (nparsed != recv.size()) {
-      return -1;
+arc::http::HttpParser::~HttpParser() {
+  if (state_.body_fd >= 0) {
+    close(state_.body_fd);
+  }
+}
+
+bool arc::http::HttpParser::IsExpectingContinue(const char *data) const {
+  if (parser_.http_major * 10 + parser_.http_minor < 11) {
+    return false;
+  }
+  for (const auto &[key, value] : state_.headers) {
+    if (EqualsIgnoreCase(key.ToView(data), "Expect")) {
+      return EqualsIgnoreCase(value.ToView(data), "100-continue");
     }
   }
+  return false;
+}
+
+std::size_t arc::http::HttpParser::GetExpectedBodySize() const {
+  // the content length left to parse, which is per chunk if chunked
+  std::size_t remaining_size =
+      parser_.content_length != ULLONG_MAX ? parser_.content_length : 0;
+  return state_.body_size + remaining_size;
+}
+
+bool arc::http::HttpParser::SpillBody(const char *data, int fd) {
+  assert(state_.body_fd < 0);
+  state_.body_fd = fd;
+  if (!WriteAll(fd, data + state_.body.offset, state_.body.length)) {
+    return false;
+  }
+  // the chunks are joined in place, so what is behind the start of the body
+  // has been parsed into it
+  state_.spill_begin =
+      state_.body.length > 0 ? state_.body.offset : state_.parsed_size;
+  state_.body = {};
+  return true;
+}
+
+detail::HttpSpan arc::http::HttpParser::ReleaseSpilledBody() {
+  assert(state_.body_fd >= 0);
+  detail::HttpSpan released{state_.spill_begin,
+                            state_.parsed_size - state_.spill_begin};
+  state_.parsed_size = state_.spill_begin;
+  return released;
+}
+
+int arc::http::HttpParser::ParseRequest(char *data, std::size_t size,
+                                        HttpRequest *request_ptr) {
+  assert(size >= state_.parsed_size);
+  state_.message = data;
+  state_.request = request_ptr;
+  parser_.data = &state_;
+  std::size_t to_parse_size = size - state_.parsed_size;
+  if (to_parse_size == 0) {
+    return 0;
+  }
+  std::size_t nparsed = http_parser_execute(
+      &parser_, &request_setting, data + state_.parsed_size, to_parse_size);
+  state_.parsed_size += nparsed;
+  if (HTTP_PARSER_ERRNO(&parser_) == http_errno::HPE_PAUSED) {
+    // paused at the end of the request
+    http_parser_pause(&parser_, 0);
+    return 0;
+  }
   if (parser_.http_errno != http_errno::HPE_OK) {
     return -parser_.http_errno;
   }
-
-  request_ptr->method = (HttpMethod)parser_.method;
-  request_ptr->method_string = http_method_str(request_ptr->method);
-  request_ptr->http_major_version = parser_.http_major;
-  request_ptr->http_minor_version = parser_.http_minor;
+  if (nparsed != to_parse_size) {
+    return -1;
+  }
   return 0;
 }
 
 int arc::http::HttpParser::ParseResponse(const std::string &recv,
                                          HttpResponse *response_ptr) {
   parser_.data = response_ptr;
-  int nparsed = http_parser_execute(&parser_, &(setting<HttpResponse>),
-                                    recv.c_str(), recv.size());
+  int nparsed = http_parser_execute(&parser_, &response_setting, recv.c_str(),
+                                    recv.size());
   if (nparsed != recv.size()) {
     return -1;
   }
@@ -2783,27 +3033,54 @@ int arc::http::HttpParser::ParseResponse(const std::string &recv,
   return 0;
 }
 
-std::string arc::http::GetReturnStringFromHttpResponse(HttpResponse *response) {
-  std::string ret;
-  ret.reserve((response->body.size() > 0u ? response->body.size() : 10u));
-  ret += protocol + slash + std::to_string(response->http_major_version) + dot +
-         std::to_string(response->http_minor_version) + space +
-         std::to_string(response->status) + space +
-         http_status_str(response->status) + new_line;
-
-  if (response->headers.find("Content-Length") == response->headers.end()) {
-    response->headers["Content-Length"] = std::to_string(response->body.size());
+void arc::http::HttpParser::Reset() {
+  http_parser_init(&parser_, http_type_);
+  state_.message = nullptr;
+  state_.request = nullptr;
+  state_.parsed_size = 0;
+  state_.url = {};
+  state_.headers.clear();
+  state_.last_field = detail::HttpRequestParseState::LastField::NONE;
+  state_.body = {};
+  state_.body_size = 0;
+  state_.is_headers_complete = false;
+  if (state_.body_fd >= 0) {
+    close(state_.body_fd);
+    state_.body_fd = -1;
   }
-  for (auto &[header_key, header_value] : response->headers) {
-    ret += header_key + colon + space + header_value + new_line;
+  state_.spill_begin = 0;
+}
+
+void arc::http::WriteHttpResponseHead(HttpResponse *response,
+                                      std::string *head) {
+  if (response->headers.find("Content-Length") == response->headers.end() &&
+      response->headers.find("Transfer-Encoding") ==
+          response->headers.end()) {
+    std::size_t body_size =
+        response->body.size() + (response->file ? response->file_length : 0);
+    response->headers["Content-Length"] = std::to_string(body_size);
+  }
+  head->append(protocol).append(slash);
+  head->append(std::to_string(response->http_major_version)).append(dot);
+  head->append(std::to_string(response->http_minor_version)).append(space);
+  head->append(std::to_string(response->status)).append(space);
+  head->append(http_status_str(response->status)).append(new_line);
+  for (const auto &[header_key, header_value] : response->headers) {
+    head->append(header_key).append(colon).append(space);
+    head->append(header_value).append(new_line);
   }
+  head->append(new_line);
+}
 
-  ret += new_line + response->body;
+std::string arc::http::GetReturnStringFromHttpResponse(HttpResponse *response) {
+  std::string ret;
+  WriteHttpResponseHead(response, &ret);
+  ret += response->body;
   return ret;
 }
 
 std::string arc::http::GetReturnStringFromHttpRequest(
-    const HttpRequest &request) {
+    const OwnedHttpRequest &request) {
   std::string ret;
   std::string query_string;
   int query_cnt = 0;
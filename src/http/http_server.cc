@@ -28,11 +28,91 @@
 
 #include <arc/http/http_server.h>
 #include <assert.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <linux/filter.h>
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
 
 using namespace arc::http;
 using namespace arc::coro;
 using namespace arc;
 
+namespace {
+
+const char kContinueResponse[] = "HTTP/1.1 100 Continue\r\n\r\n";
+
+bool PinCurrentThread(int cpu) {
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  CPU_SET(cpu, &cpu_set);
+  return pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set) ==
+         0;
+}
+
+}  // namespace
+
+int arc::http::detail::OpenTempFile(const std::string& dir) {
+  int fd = open(dir.c_str(), O_TMPFILE | O_RDWR | O_CLOEXEC, 0600);
+  if (fd >= 0 || (errno != EOPNOTSUPP && errno != EISDIR)) {
+    return fd;
+  }
+  // not supported by the file system
+  std::string path = dir + "/arc_http_body_XXXXXX";
+  fd = mkostemp(path.data(), O_CLOEXEC);
+  if (fd >= 0) {
+    unlink(path.c_str());
+  }
+  return fd;
+}
+
+int arc::http::detail::GetWorkerCpu(const HttpConfig& config,
+                                    unsigned int i) {
+  return config.worker_cpus[i % config.worker_cpus.size()];
+}
+
+std::vector<std::pair<int, unsigned int>> arc::http::detail::GetCpuSteering(
+    const HttpConfig& config) {
+  std::vector<std::pair<int, unsigned int>> steering;
+  if (config.worker_cpus.empty()) {
+    return steering;
+  }
+  for (unsigned int i = 0; i < config.working_thread_num; i++) {
+    int cpu = GetWorkerCpu(config, i);
+    if (std::find_if(steering.begin(), steering.end(), [cpu](auto& steered) {
+          return steered.first == cpu;
+        }) == steering.end()) {
+      steering.emplace_back(cpu, i);
+    }
+  }
+  return steering;
+}
+
+bool arc::http::detail::AttachCpuSteeringProgram(int fd,
+                                                 const HttpConfig& config) {
+  std::vector<sock_filter> program;
+  program.push_back(BPF_STMT(BPF_LD | BPF_W | BPF_ABS,
+                             static_cast<__u32>(SKF_AD_OFF + SKF_AD_CPU)));
+  for (auto [cpu, i] : GetCpuSteering(config)) {
+    program.push_back(BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K,
+                               static_cast<__u32>(cpu), 0, 1));
+    program.push_back(BPF_STMT(BPF_RET | BPF_K, i));
+  }
+  // an index out of range makes the kernel fall back to hashing
+  program.push_back(BPF_STMT(BPF_RET | BPF_K, 0xFFFFFFFFU));
+  sock_fprog fprog{.len = static_cast<unsigned short>(program.size()),
+                   .filter = program.data()};
+  return setsockopt(fd, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &fprog,
+                    sizeof(fprog)) == 0;
+}
+
 HttpServer::HttpServer(const HttpConfig& config) : config_(config) {
   InitDefaultHandlers();
 }
@@ -46,11 +126,6 @@ void HttpServer::RegisterHandler(
     const std::string& path, HttpMethod method,
     const std::function<coro::Task<void>(const HttpRequest*, HttpResponse*,
                                          const Context*)>& func) {
-  if (handlers_.find(path) == handlers_.end()) {
-    handlers_[path] = std::unordered_map<
-        HttpMethod, std::function<coro::Task<void>(
-                        const HttpRequest*, HttpResponse*, const Context*)>>();
-  }
   handlers_[path][method] = func;
   config_.logger->LogInfo("Register handler with method %s and path %s",
                           http_method_str(method), path.c_str());
@@ -70,25 +145,47 @@ void HttpServer::RegisterRESTfulHandler(
     const std::string& path, HttpMethod method,
     const std::function<coro::Task<void>(const HttpRequest*, HttpResponse*,
                                          const Context*)>& func) {
-  std::vector<std::string> names = GenerateInitialRESTfulNames(path);
-  if (names.empty()) {
+  if (!RESTful_router_.Insert(method, path, func)) {
     config_.logger->LogWarning(
-        "Cannot register RESTful handler because of no {} pair exsits.");
+        "Cannot register RESTful handler with path %s, which is malformed "
+        "or has too many params",
+        path.c_str());
     return;
   }
-  std::string regex_str = GenerateRegexStr(path);
-  if (RESTful_handlers_.find(regex_str) == RESTful_handlers_.end()) {
-    RESTful_handlers_[regex_str] = std::unordered_map<
-        HttpMethod,
-        std::pair<std::vector<std::string>,
-                  std::function<coro::Task<void>(
-                      const HttpRequest*, HttpResponse*, const Context*)>>>();
-  }
-  RESTful_handlers_[regex_str][method] = {names, func};
   config_.logger->LogInfo("Register RESTful handler with method %s and path %s",
                           http_method_str(method), path.c_str());
 }
 
+void HttpServer::RegisterStaticHandler(const std::string& path,
+                                       const std::string& root_dir,
+                                       std::size_t cache_capacity) {
+  auto static_files =
+      std::make_shared<HttpStaticFiles>(root_dir, cache_capacity);
+  auto func = [static_files](const HttpRequest* request,
+                             HttpResponse* response,
+                             const Context* context) -> Task<void> {
+    static_files->Serve(*request, *request->RESTful_params.Get("*"),
+                        response);
+    co_return;
+  };
+  std::string pattern = path;
+  if (pattern.empty() || pattern.back() != '/') {
+    pattern += '/';
+  }
+  pattern += '*';
+  RegisterRESTfulHandler(pattern, HttpMethod::HTTP_GET, func);
+  RegisterRESTfulHandler(pattern, HttpMethod::HTTP_HEAD, func);
+}
+
+void HttpServer::RegisterWebSocketHandler(
+    const std::string& path,
+    const std::function<coro::Task<void>(const HttpRequest*, WebSocket*)>&
+        func) {
+  websocket_handlers_[path] = func;
+  config_.logger->LogInfo("Register websocket handler with path %s",
+                          path.c_str());
+}
+
 void HttpServer::InitDefaultHandlers() {
   RegisterDefaultHandler(arc::http::HttpStatus::HTTP_STATUS_BAD_REQUEST,
                          [](const HttpRequest* request, HttpResponse* response,
@@ -106,14 +203,28 @@ void HttpServer::InitDefaultHandlers() {
                            response->body = "404 Not found";
                            co_return;
                          });
+  RegisterDefaultHandler(
+      arc::http::HttpStatus::HTTP_STATUS_PAYLOAD_TOO_LARGE,
+      [](const HttpRequest* request, HttpResponse* response,
+         const Context* context) -> arc::coro::Task<void> {
+        response->status = arc::http::HttpStatus::HTTP_STATUS_PAYLOAD_TOO_LARGE;
+        response->body = "413 Payload too large";
+        co_return;
+      });
 }
 
 bool HttpServer::Bind(const std::string& ip, uint16_t port) {
-  for (int i = 0; i < config_.working_thread_num; i++) {
+  for (unsigned int i = 0; i < config_.working_thread_num; i++) {
     auto listen_socket_ptr = std::make_shared<
         io::Acceptor<arc::net::Domain::IPV4, arc::io::Pattern::ASYNC>>();
     listen_socket_ptr->SetOption(arc::net::SocketOption::REUSEADDR, 1);
     listen_socket_ptr->SetOption(arc::net::SocketOption::REUSEPORT, 1);
+    listen_socket_ptr->SetAcceptBatchSize(config_.accept_batch_size);
+    if (!config_.worker_cpus.empty()) {
+      // preferred by the kernel for connections received on that CPU
+      listen_socket_ptr->SetOption(arc::net::SocketOption::INCOMING_CPU,
+                                   detail::GetWorkerCpu(config_, i));
+    }
     listen_socket_ptr->Bind({ip, port});
     listen_socket_ptrs_.push_back(listen_socket_ptr);
   }
@@ -124,132 +235,362 @@ Task<void> HttpServer::HandleNewConn(
     io::Socket<arc::net::Domain::IPV4, arc::net::Protocol::TCP,
                arc::io::Pattern::ASYNC>
         socket) {
-  bool is_need_return = true;
   HttpParser parser(HTTP_REQUEST);
-  HttpRequest* request = new HttpRequest{};
-  std::shared_ptr<char[]> data(new char[config_.read_buffer_size]);
-  do {
-    std::string recv;
-    while (true) {
-      auto recv_bytes =
-          co_await socket.Recv(data.get(), config_.read_buffer_size);
+  HttpRequest request;
+  HttpBuffer buffer(config_.read_buffer_size);
+  detail::PipelinedResponses responses;
+  Context context{.conn = &socket};
+  // when the first byte of the request being read arrived
+  auto request_begin = EventLoop::GetLocalInstance().Now();
+  bool is_need_return = false;
+  bool is_continue_sent = false;
+  // only the first bytes of a connection may be the HTTP/2 preface
+  bool is_first_request = config_.enable_h2c;
+  while (!is_need_return) {
+    int ret = 0;
+    bool is_preface_prefix = false;
+    if (is_first_request) {
+      std::string_view received(buffer.Data(), buffer.Size());
+      if (received.starts_with(detail::kHttp2Preface)) {
+        auto connection = std::make_shared<detail::Http2Connection>(
+            this, std::move(socket),
+            received.substr(detail::kHttp2Preface.size()));
+        co_await connection->Run();
+        break;
+      }
+      is_preface_prefix = detail::kHttp2Preface.starts_with(received);
+    }
+    if (!is_preface_prefix && buffer.Size() > parser.GetParsedSize()) {
+      ret = parser.ParseRequest(buffer.Data(), buffer.Size(), &request);
+    }
+    // answered before the rest of it is read, or a 100 Continue is sent
+    bool is_body_too_large =
+        ret == 0 && config_.max_request_body_size > 0 &&
+        parser.IsHeadersComplete() &&
+        parser.GetExpectedBodySize() > config_.max_request_body_size;
+    if (ret == 0 && !request.is_complete && !is_body_too_large) {
+      if (parser.IsHeadersComplete()) {
+        if (!parser.IsBodySpilled() && config_.max_buffered_body_size > 0 &&
+            parser.GetExpectedBodySize() > config_.max_buffered_body_size) {
+          int fd = detail::OpenTempFile(config_.body_temp_dir);
+          if (fd < 0 || !parser.SpillBody(buffer.Data(), fd)) {
+            config_.logger->LogWarning(
+                "Cannot write request body to a temporary file in %s",
+                config_.body_temp_dir.c_str());
+            break;
+          }
+        }
+        if (parser.IsBodySpilled()) {
+          auto released = parser.ReleaseSpilledBody();
+          buffer.Erase(released.offset, released.length);
+        }
+      }
+
+      // nothing more to answer before the next read
+      if (responses.Count() > 0 &&
+          !co_await SendResponses(socket, &responses)) {
+        break;
+      }
+      if (!is_continue_sent && parser.IsHeadersComplete() &&
+          parser.IsExpectingContinue(buffer.Data())) {
+        iovec iov = {const_cast<char*>(kContinueResponse),
+                     sizeof(kContinueResponse) - 1};
+        if (!co_await SendAll(socket, &iov, 1)) {
+          break;
+        }
+        is_continue_sent = true;
+      }
+      bool is_idle = buffer.Size() == 0;
+      auto now = EventLoop::GetLocalInstance().Now();
+      std::chrono::milliseconds timeout{0};
+      if (is_idle) {
+        timeout = std::chrono::milliseconds(config_.keep_alive_timeout_ms);
+      } else if (!parser.IsHeadersComplete()) {
+        if (config_.header_read_timeout_ms > 0) {
+          // a deadline for all of the headers, not only for this read
+          timeout = std::chrono::duration_cast<std::chrono::milliseconds>(
+              request_begin +
+              std::chrono::milliseconds(config_.header_read_timeout_ms) - now);
+          if (timeout.count() <= 0) {
+            config_.logger->LogDebug("Timed out reading request headers");
+            break;
+          }
+        }
+      } else {
+        timeout = std::chrono::milliseconds(config_.body_read_timeout_ms);
+      }
+
+      char* recv_ptr = buffer.PrepareWrite(config_.read_buffer_size);
+      ssize_t recv_bytes = 0;
+      if (timeout.count() > 0) {
+        recv_bytes =
+            co_await socket.Recv(recv_ptr, buffer.WritableSize(), timeout);
+      } else {
+        recv_bytes = co_await socket.Recv(recv_ptr, buffer.WritableSize());
+      }
       if (recv_bytes <= 0) {
+        if (recv_bytes < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+          config_.logger->LogDebug("Timed out reading from connection");
+        }
         break;
       }
-      recv.append(data.get(), recv_bytes);
-      if (recv_bytes < config_.read_buffer_size) {
+      buffer.Commit(recv_bytes);
+      if (is_idle) {
+        request_begin = EventLoop::GetLocalInstance().Now();
+      }
+      continue;
+    }
+
+    if (ret == 0 && !is_body_too_large) {
+      auto websocket_itr = websocket_handlers_.find(request.path);
+      if (websocket_itr != websocket_handlers_.end() &&
+          IsWebSocketUpgrade(request)) {
+        std::size_t parsed_size = parser.GetParsedSize();
+        co_await HandleWebSocket(
+            socket, request,
+            std::string_view(buffer.Data() + parsed_size,
+                             buffer.Size() - parsed_size),
+            &responses, websocket_itr->second);
         break;
       }
     }
 
-    if (recv.empty()) {
+    HttpResponse response;
+    bool is_head = ret == 0 && request.method == HttpMethod::HTTP_HEAD;
+    HttpResponseWriter writer(this, &socket, &responses, &response, is_head);
+    context.writer = &writer;
+    if (ret != 0) {
+      config_.logger->LogDebug(
+          "Receive bad request from %s:%u, content: %s",
+          socket.GetAddr().GetHost().c_str(), socket.GetAddr().GetPort(),
+          std::string(buffer.Data(), buffer.Size()).c_str());
+      co_await default_handlers_
+          [arc::http::HttpStatus::HTTP_STATUS_BAD_REQUEST](&request, &response,
+                                                           &context);
+      // the rest of the stream cannot be parsed any more
+      is_need_return = true;
+    } else if (is_body_too_large) {
+      config_.logger->LogDebug("Receive too large request body from %s:%u",
+                               socket.GetAddr().GetHost().c_str(),
+                               socket.GetAddr().GetPort());
+      co_await default_handlers_
+          [arc::http::HttpStatus::HTTP_STATUS_PAYLOAD_TOO_LARGE](
+              &request, &response, &context);
+      // the rest of the body is not read
       is_need_return = true;
     } else {
-      config_.logger->LogDebug("Read content %s from client", recv.c_str());
-      auto ret = parser.ParseOnce(recv, request);
-      if (ret == 0 && !request->is_complete) {
-        is_need_return = false;
-        continue;
+      is_need_return = !IsKeepAlive(request);
+      co_await HandleRequest(&request, &response, &context);
+    }
+
+    if (writer.IsStarted()) {
+      if (!co_await writer.Finish()) {
+        break;
       }
-      HttpResponse* response = new HttpResponse();
-      const Context* context = new Context{.conn = &socket};
-      if (ret != 0) {
-        config_.logger->LogDebug("Receive bad request from %s:%u, content: %s",
-                                 socket.GetAddr().GetHost().c_str(),
-                                 socket.GetAddr().GetPort(), recv.c_str());
-        co_await default_handlers_
-            [arc::http::HttpStatus::HTTP_STATUS_BAD_REQUEST](request, response,
-                                                             context);
-        is_need_return = false;
-      } else {
-        // Keep alive setting
-        unsigned short http_version =
-            request->http_major_version * 10 + request->http_minor_version;
-        auto keep_alive_itr = request->headers.find("Connection");
-        if (http_version < 11) {
-          if (keep_alive_itr != request->headers.end() &&
-              keep_alive_itr->second == "Keep-alive") {
-            is_need_return = false;
-          } else {
-            is_need_return = true;
-          }
-        } else {
-          if (keep_alive_itr != request->headers.end() &&
-              keep_alive_itr->second == "close") {
-            config_.logger->LogDebug("Client requests closing the socket.");
-            is_need_return = true;
-          } else {
-            is_need_return = false;
-          }
-        }
-        if (handlers_.find(request->path) == handlers_.end() ||
-            handlers_[request->path].find(request->method) ==
-                handlers_[request->path].end()) {
-          // First search RESTful handlers
-          bool is_RESTful_handler_found = false;
-          for (auto& [RESTful_regex_str, handler_method_map] :
-               RESTful_handlers_) {
-            if (handler_method_map.find(request->method) ==
-                handler_method_map.end()) {
-              continue;
-            }
-            std::regex current_regex(RESTful_regex_str);
-            std::smatch match;
-            if (std::regex_search(request->path, match, current_regex)) {
-              for (int i = 1; i < match.size(); i++) {
-                request->RESTful_params.insert(
-                    {handler_method_map[request->method].first[i - 1],
-                     match[i].str()});
-              }
-              is_RESTful_handler_found = true;
-              response->http_major_version = request->http_major_version;
-              response->http_minor_version = request->http_minor_version;
-              co_await handler_method_map[request->method].second(
-                  request, response, context);
-              break;
-            }
-          }
+    } else {
+      responses.Add(std::move(response), is_head);
+    }
+    context.writer = nullptr;
 
-          if (!is_RESTful_handler_found) {
-            config_.logger->LogDebug("Unkown caught %s request %s",
-                                     request->method_string.c_str(),
-                                     request->path.c_str());
-            co_await default_handlers_
-                [arc::http::HttpStatus::HTTP_STATUS_NOT_FOUND](
-                    request, response, context);
-          }
+    // the request views are gone from here
+    buffer.Consume(parser.GetParsedSize());
+    parser.Reset();
+    request.Clear();
+    is_continue_sent = false;
+    is_first_request = false;
+    // the next request may be buffered already
+    request_begin = EventLoop::GetLocalInstance().Now();
 
-        } else {
-          response->http_major_version = request->http_major_version;
-          response->http_minor_version = request->http_minor_version;
-          co_await handlers_[request->path][request->method](request, response,
-                                                             context);
-        }
+    if (is_need_return || responses.Count() >= kMaxPipelinedResponseCount_ ||
+        responses.Size() >= kMaxPipelinedResponseSize_) {
+      if (!co_await SendResponses(socket, &responses)) {
+        break;
       }
+    }
+  }
+  config_.logger->LogDebug("Connection lost");
+}
+
+Task<void> HttpServer::HandleWebSocket(
+    arc::io::Socket<arc::net::Domain::IPV4, arc::net::Protocol::TCP,
+                    arc::io::Pattern::ASYNC>& socket,
+    const HttpRequest& request, std::string_view received,
+    detail::PipelinedResponses* responses,
+    const std::function<coro::Task<void>(const HttpRequest*, WebSocket*)>&
+        func) {
+  // the responses to earlier requests go first
+  if (responses->Count() > 0 && !co_await SendResponses(socket, responses)) {
+    co_return;
+  }
+  bool is_deflate_enabled =
+      config_.websocket_compression && IsWebSocketDeflateOffered(request);
+  std::string head =
+      "HTTP/1.1 101 Switching Protocols\r\n"
+      "Upgrade: websocket\r\n"
+      "Connection: Upgrade\r\n"
+      "Sec-WebSocket-Accept: ";
+  head += GetWebSocketAccept(*request.headers.Get("Sec-WebSocket-Key"));
+  head += "\r\n";
+  if (is_deflate_enabled) {
+    head +=
+        "Sec-WebSocket-Extensions: permessage-deflate; "
+        "server_no_context_takeover; client_no_context_takeover\r\n";
+  }
+  head += "\r\n";
+  iovec iov = {head.data(), head.size()};
+  if (!co_await SendAll(socket, &iov, 1)) {
+    co_return;
+  }
 
-      try {
-        auto response_ptr = std::make_shared<std::string>(
-            std::move(GetReturnStringFromHttpResponse(response)));
-        co_await socket.Send(response_ptr->c_str(), response_ptr->size());
-      } catch (const std::exception& e) {
-        config_.logger->LogWarning(e.what());
+  WebSocket websocket(this, &socket, received, is_deflate_enabled);
+  co_await func(&request, &websocket);
+  if (!websocket.IsClosed()) {
+    co_await websocket.Close();
+  }
+}
+
+Task<bool> HttpServer::SendResponses(
+    arc::io::Socket<arc::net::Domain::IPV4, arc::net::Protocol::TCP,
+                    arc::io::Pattern::ASYNC>& socket,
+    detail::PipelinedResponses* responses) {
+  bool is_sent = true;
+  try {
+    // gather everything up to and including the next response with a file
+    // body, which is sent on its own after that
+    std::size_t begin = 0;
+    for (std::size_t i = 0; is_sent && i < responses->Count(); i++) {
+      const HttpResponse& response = responses->Get(i);
+      if (!response.file && i + 1 < responses->Count()) {
+        continue;
+      }
+      auto& iov = responses->GetIOVec(begin, i + 1);
+      is_sent = co_await SendAll(socket, iov.data(), iov.size());
+      if (is_sent && response.file) {
+        is_sent = co_await SendFileAll(socket, *response.file,
+                                       response.file_offset,
+                                       response.file_length);
       }
+      begin = i + 1;
+    }
+  } catch (const std::exception& e) {
+    is_sent = false;
+    config_.logger->LogWarning(e.what());
+  }
+  responses->Clear();
+  co_return is_sent;
+}
 
-      delete request;
-      request = new HttpRequest();
-      delete response;
-      delete context;
-      parser = HttpParser(HTTP_REQUEST);
+Task<bool> HttpServer::SendFileAll(
+    arc::io::Socket<arc::net::Domain::IPV4, arc::net::Protocol::TCP,
+                    arc::io::Pattern::ASYNC>& socket,
+    const HttpFile& file, std::size_t offset, std::size_t length) {
+  off_t file_offset = offset;
+  std::size_t end = offset + length;
+  while (static_cast<std::size_t>(file_offset) < end) {
+    std::size_t count = end - file_offset;
+    ssize_t sent = 0;
+    if (config_.write_timeout_ms > 0) {
+      sent = co_await socket.SendFile(
+          file.GetFd(), &file_offset, count,
+          std::chrono::milliseconds(config_.write_timeout_ms));
+    } else {
+      sent = co_await socket.SendFile(file.GetFd(), &file_offset, count);
+    }
+    if (sent <= 0) {
+      // 0 if the file has been truncated meanwhile
+      if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+        config_.logger->LogDebug("Timed out writing to connection");
+      }
+      co_return false;
     }
+  }
+  co_return true;
+}
 
-  } while (!is_need_return);
-  if (request) {
-    delete request;
+Task<bool> HttpServer::SendAll(
+    arc::io::Socket<arc::net::Domain::IPV4, arc::net::Protocol::TCP,
+                    arc::io::Pattern::ASYNC>& socket,
+    iovec* iov, int iovcnt) {
+  while (true) {
+    while (iovcnt > 0 && iov->iov_len == 0) {
+      iov++;
+      iovcnt--;
+    }
+    if (iovcnt == 0) {
+      co_return true;
+    }
+    ssize_t sent = 0;
+    if (config_.write_timeout_ms > 0) {
+      sent = co_await socket.SendV(
+          iov, std::min(iovcnt, IOV_MAX),
+          std::chrono::milliseconds(config_.write_timeout_ms));
+    } else {
+      sent = co_await socket.SendV(iov, std::min(iovcnt, IOV_MAX));
+    }
+    if (sent < 0) {
+      if (errno == EAGAIN || errno == EWOULDBLOCK) {
+        config_.logger->LogDebug("Timed out writing to connection");
+      }
+      co_return false;
+    }
+    // skip what has been sent, the last buffer may be sent only partly
+    while (sent > 0) {
+      std::size_t sent_part = std::min<std::size_t>(sent, iov->iov_len);
+      iov->iov_base = static_cast<char*>(iov->iov_base) + sent_part;
+      iov->iov_len -= sent_part;
+      sent -= sent_part;
+      if (iov->iov_len == 0) {
+        iov++;
+        iovcnt--;
+      }
+    }
   }
-  config_.logger->LogDebug("Connection lost");
 }
 
-Task<void> HttpServer::StartAccept(int i) {
+bool HttpServer::IsKeepAlive(const HttpRequest& request) {
+  unsigned short http_version =
+      request.http_major_version * 10 + request.http_minor_version;
+  auto connection = request.headers.Get("Connection");
+  if (http_version < 11) {
+    return connection && EqualsIgnoreCase(*connection, "keep-alive");
+  }
+  if (connection && EqualsIgnoreCase(*connection, "close")) {
+    config_.logger->LogDebug("Client requests closing the socket.");
+    return false;
+  }
+  return true;
+}
+
+Task<void> HttpServer::HandleRequest(HttpRequest* request,
+                                     HttpResponse* response,
+                                     const Context* context) {
+  response->http_major_version = request->http_major_version;
+  response->http_minor_version = request->http_minor_version;
+  auto handlers_itr = handlers_.find(request->path);
+  if (handlers_itr != handlers_.end()) {
+    auto handler_itr = handlers_itr->second.find(request->method);
+    if (handler_itr != handlers_itr->second.end()) {
+      co_await handler_itr->second(request, response, context);
+      co_return;
+    }
+  }
+
+  // then search RESTful handlers
+  auto RESTful_handler = RESTful_router_.Find(
+      request->method, request->path, &request->RESTful_params);
+  if (RESTful_handler) {
+    co_await (*RESTful_handler)(request, response, context);
+    co_return;
+  }
+
+  config_.logger->LogDebug("Unkown caught %s request %s",
+                           std::string(request->method_string).c_str(),
+                           std::string(request->path).c_str());
+  co_await default_handlers_[arc::http::HttpStatus::HTTP_STATUS_NOT_FOUND](
+      request, response, context);
+}
+
+Task<void> HttpServer::StartAccept(unsigned int i) {
   config_.logger->LogDebug("Start waiting accept with thread: 0x%x",
                            std::this_thread::get_id());
   while (true) {
@@ -262,10 +603,37 @@ Task<void> HttpServer::StartAccept(int i) {
 }
 
 void HttpServer::InnerStart() {
+  // sendfile cannot be told not to raise it on a connection closed by the
+  // peer, unlike send, and any response may carry a file
+  signal(SIGPIPE, SIG_IGN);
+
+  // in order, which is the order of the sockets in the SO_REUSEPORT group
+  // that the steering program refers to
+  for (auto& listen_socket_ptr : listen_socket_ptrs_) {
+    listen_socket_ptr->Listen();
+  }
+  if (config_.steer_connections_by_cpu) {
+    if (config_.worker_cpus.empty()) {
+      config_.logger->LogWarning(
+          "Connections are not steered by CPU without worker_cpus");
+    } else if (!detail::AttachCpuSteeringProgram(
+                   listen_socket_ptrs_[0]->GetFd(), config_)) {
+      config_.logger->LogWarning(
+          "Cannot attach the CPU steering program, connections are spread "
+          "by hash");
+    }
+  }
+
   std::vector<std::thread> threads;
-  for (int i = 0; i < config_.working_thread_num; i++) {
+  for (unsigned int i = 0; i < config_.working_thread_num; i++) {
     threads.emplace_back([i, this]() {
-      listen_socket_ptrs_[i]->Listen();
+      if (!config_.worker_cpus.empty()) {
+        int cpu = detail::GetWorkerCpu(config_, i);
+        if (!PinCurrentThread(cpu)) {
+          config_.logger->LogWarning("Cannot pin working thread %u to CPU %d",
+                                     i, cpu);
+        }
+      }
       StartEventLoop(StartAccept(i));
     });
   }
@@ -274,26 +642,201 @@ void HttpServer::InnerStart() {
   }
 }
 
-std::string HttpServer::GenerateRegexStr(const std::string& path) {
-  std::string valid_url_word_regex =
-      "([0-9a-zA-Z%\\.\\-_~!\\$&'\\(\\)\\*\\+,;=:@]+)";
-  std::regex replace_bracket_regex("(\\{\\w+\\})");
-  return std::regex_replace(path, replace_bracket_regex, valid_url_word_regex);
+void arc::http::detail::PipelinedResponses::Add(HttpResponse&& response,
+                                                bool is_head) {
+  HttpResponse& added = responses_.emplace_back(std::move(response));
+  WriteHttpResponseHead(&added, &heads_);
+  head_ends_.push_back(heads_.size());
+  if (is_head) {
+    // the head still tells the length of the body left out
+    added.body.clear();
+    added.file.reset();
+    added.file_length = 0;
+  }
+  size_ += added.body.size();
 }
 
-std::vector<std::string> HttpServer::GenerateInitialRESTfulNames(
-    const std::string& path) {
-  std::vector<std::string> names;
-  std::regex replace_bracket_regex("(\\{\\w+\\})");
-  auto word_begin_itr =
-      std::sregex_iterator(path.begin(), path.end(), replace_bracket_regex);
-  auto word_end_itr = std::sregex_iterator();
-  for (auto itr = word_begin_itr; itr != word_end_itr; itr++) {
-    std::string name = itr->str();
-    if (name.size() <= 2 || name.front() != '{' || name.back() != '}') {
-      return {};
+std::vector<iovec>& arc::http::detail::PipelinedResponses::GetIOVec(
+    std::size_t begin, std::size_t end) {
+  iov_.clear();
+  std::size_t head_begin = begin > 0 ? head_ends_[begin - 1] : 0;
+  for (std::size_t i = begin; i < end; i++) {
+    iov_.push_back({heads_.data() + head_begin, head_ends_[i] - head_begin});
+    iov_.push_back({responses_[i].body.data(), responses_[i].body.size()});
+    head_begin = head_ends_[i];
+  }
+  return iov_;
+}
+
+void arc::http::detail::PipelinedResponses::Clear() {
+  responses_.clear();
+  heads_.clear();
+  head_ends_.clear();
+  size_ = 0;
+}
+
+HttpResponseWriter::HttpResponseWriter(
+    HttpServer* server,
+    arc::io::Socket<arc::net::Domain::IPV4, arc::net::Protocol::TCP,
+                    arc::io::Pattern::ASYNC>* socket,
+    detail::PipelinedResponses* responses, HttpResponse* response,
+    bool is_head)
+    : server_(server),
+      socket_(socket),
+      responses_(responses),
+      response_(response),
+      is_head_(is_head) {}
+
+HttpResponseWriter::HttpResponseWriter(detail::Http2Connection* connection,
+                                       std::uint32_t stream_id,
+                                       HttpResponse* response, bool is_head)
+    : response_(response),
+      http2_connection_(connection),
+      stream_id_(stream_id),
+      is_head_(is_head) {}
+
+Task<bool> HttpResponseWriter::Start() {
+  auto length_itr = response_->headers.find("Content-Length");
+  if (length_itr != response_->headers.end()) {
+    const std::string& value = length_itr->second;
+    std::size_t length = 0;
+    auto [ptr, ec] =
+        std::from_chars(value.data(), value.data() + value.size(), length);
+    if (ec != std::errc() || ptr != value.data() + value.size()) {
+      // not a length a body can be checked against, chunked instead
+      response_->headers.erase(length_itr);
+    } else {
+      content_length_ = length;
+    }
+  }
+  if (http2_connection_) {
+    // frames need no chunking, the headers go out right away
+    is_started_ = true;
+    if (!co_await http2_connection_->SendHeaders(stream_id_, response_,
+                                                 is_head_)) {
+      is_broken_ = true;
+      co_return false;
     }
-    names.push_back(name.substr(1, name.size() - 2));
+    co_return true;
+  }
+  unsigned short http_version =
+      response_->http_major_version * 10 + response_->http_minor_version;
+  if (http_version < 11 && !content_length_) {
+    // cannot be chunked, sent once complete
+    co_return true;
+  }
+  is_started_ = true;
+  // the responses to earlier requests go first
+  if (responses_->Count() > 0 &&
+      !co_await server_->SendResponses(*socket_, responses_)) {
+    is_broken_ = true;
+    co_return false;
+  }
+  if (!content_length_) {
+    response_->headers["Transfer-Encoding"] = "chunked";
+    // the head says what a GET would get, but there are no chunks to frame
+    is_chunked_ = !is_head_;
+  }
+  WriteHttpResponseHead(response_, &head_);
+  co_return true;
+}
+
+Task<bool> HttpResponseWriter::Break() {
+  is_broken_ = true;
+  if (http2_connection_) {
+    co_await http2_connection_->ResetStream(
+        stream_id_, detail::Http2ErrorCode::INTERNAL_ERROR);
+  }
+  co_return false;
+}
+
+Task<bool> HttpResponseWriter::Write(std::string_view data) {
+  if (is_broken_ || is_finished_) {
+    co_return false;
+  }
+  if (!is_started_ && !co_await Start()) {
+    co_return false;
+  }
+  if (!is_started_) {
+    // for the Content-Length, dropped after the head for HEAD requests
+    response_->body.append(data);
+    co_return true;
+  }
+  if (is_head_) {
+    // only the head goes out, once the handler is done
+    co_return true;
+  }
+  if (content_length_ && data.size() > *content_length_ - written_size_) {
+    co_return co_await Break();
+  }
+  written_size_ += data.size();
+  if (http2_connection_) {
+    if (!data.empty() &&
+        !co_await http2_connection_->SendData(stream_id_, data, false)) {
+      is_broken_ = true;
+      co_return false;
+    }
+    co_return true;
+  }
+  if (data.empty() && head_.empty()) {
+    // an empty chunk would end the body
+    co_return true;
+  }
+
+  iovec iov[4];
+  int iovcnt = 0;
+  if (!head_.empty()) {
+    iov[iovcnt++] = {head_.data(), head_.size()};
+  }
+  if (is_chunked_ && !data.empty()) {
+    int size = snprintf(chunk_head_, sizeof(chunk_head_), "%zx\r\n",
+                        data.size());
+    iov[iovcnt++] = {chunk_head_, static_cast<std::size_t>(size)};
+  }
+  iov[iovcnt++] = {const_cast<char*>(data.data()), data.size()};
+  if (is_chunked_ && !data.empty()) {
+    iov[iovcnt++] = {const_cast<char*>("\r\n"), 2};
+  }
+  if (!co_await server_->SendAll(*socket_, iov, iovcnt)) {
+    is_broken_ = true;
+    co_return false;
+  }
+  head_.clear();
+  co_return true;
+}
+
+Task<bool> HttpResponseWriter::Finish() {
+  if (is_broken_) {
+    co_return false;
+  }
+  if (!is_started_ || is_finished_) {
+    co_return true;
+  }
+  is_finished_ = true;
+  if (!is_head_ && content_length_ && written_size_ != *content_length_) {
+    // the peer would wait for the rest or take what follows for it
+    co_return co_await Break();
+  }
+  if (http2_connection_) {
+    if (!is_head_ &&
+        !co_await http2_connection_->SendData(stream_id_, {}, true)) {
+      is_broken_ = true;
+      co_return false;
+    }
+    co_return true;
+  }
+  iovec iov[2];
+  int iovcnt = 0;
+  if (!head_.empty()) {
+    iov[iovcnt++] = {head_.data(), head_.size()};
+  }
+  if (is_chunked_) {
+    iov[iovcnt++] = {const_cast<char*>("0\r\n\r\n"), 5};
+  }
+  if (iovcnt > 0 && !co_await server_->SendAll(*socket_, iov, iovcnt)) {
+    is_broken_ = true;
+    co_return false;
   }
-  return names;
+  head_.clear();
+  co_return true;
 }
@@ -0,0 +1,363 @@
+/*
+ * File: http_static.cc
+ * Project: libarc
+ * File Created: Saturday, 17th October 2026 3:42:18 pm
+ * Author: Minjun Xu (mjxu96@outlook.com)
+ * -----
+ * MIT License
+ * Copyright (c) 2022 Minjun Xu
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <arc/exception/io.h>
+#include <arc/http/http_static.h>
+#include <curl/curl.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <charconv>
+
+using namespace arc::http;
+
+namespace {
+
+const std::unordered_map<std::string_view, std::string_view> kContentTypes = {
+    {"html", "text/html; charset=utf-8"},
+    {"htm", "text/html; charset=utf-8"},
+    {"css", "text/css; charset=utf-8"},
+    {"js", "text/javascript; charset=utf-8"},
+    {"mjs", "text/javascript; charset=utf-8"},
+    {"json", "application/json"},
+    {"txt", "text/plain; charset=utf-8"},
+    {"xml", "application/xml"},
+    {"svg", "image/svg+xml"},
+    {"png", "image/png"},
+    {"jpg", "image/jpeg"},
+    {"jpeg", "image/jpeg"},
+    {"gif", "image/gif"},
+    {"webp", "image/webp"},
+    {"ico", "image/x-icon"},
+    {"wasm", "application/wasm"},
+    {"pdf", "application/pdf"},
+    {"woff", "font/woff"},
+    {"woff2", "font/woff2"},
+    {"mp4", "video/mp4"},
+};
+
+std::string_view GetContentType(std::string_view path) {
+  auto dot_pos = path.rfind('.');
+  if (dot_pos != std::string_view::npos &&
+      path.find('/', dot_pos) == std::string_view::npos) {
+    auto itr = kContentTypes.find(path.substr(dot_pos + 1));
+    if (itr != kContentTypes.end()) {
+      return itr->second;
+    }
+  }
+  return "application/octet-stream";
+}
+
+std::string FormatHttpDate(time_t time) {
+  tm gmt;
+  gmtime_r(&time, &gmt);
+  char date[32];
+  std::size_t size =
+      strftime(date, sizeof(date), "%a, %d %b %Y %H:%M:%S GMT", &gmt);
+  return std::string(date, size);
+}
+
+bool ParseSize(std::string_view str, std::size_t* size) {
+  auto [ptr, ec] = std::from_chars(str.data(), str.data() + str.size(), *size);
+  return ec == std::errc() && ptr == str.data() + str.size();
+}
+
+}  // namespace
+
+std::string arc::http::detail::DecodePath(std::string_view path) {
+  int decoded_size = 0;
+  char* decoded =
+      curl_easy_unescape(nullptr, path.data(), path.size(), &decoded_size);
+  if (!decoded) {
+    return {};
+  }
+  std::string ret(decoded, decoded_size);
+  curl_free(decoded);
+
+  std::size_t begin = ret.find_first_not_of('/');
+  if (begin == std::string::npos || ret.find('\0') != std::string::npos) {
+    return {};
+  }
+  ret.erase(0, begin);
+  std::size_t segment_begin = 0;
+  while (segment_begin <= ret.size()) {
+    std::size_t segment_end = ret.find('/', segment_begin);
+    if (segment_end == std::string::npos) {
+      segment_end = ret.size();
+    }
+    std::string_view segment(ret.data() + segment_begin,
+                             segment_end - segment_begin);
+    if (segment == "..") {
+      return {};
+    }
+    segment_begin = segment_end + 1;
+  }
+  return ret;
+}
+
+detail::RangeResult arc::http::detail::ParseRange(std::string_view range,
+                                                  std::size_t file_size,
+                                                  std::size_t* offset,
+                                                  std::size_t* length) {
+  constexpr std::string_view kUnit = "bytes=";
+  if (!range.starts_with(kUnit)) {
+    return RangeResult::NONE;
+  }
+  range.remove_prefix(kUnit.size());
+  auto dash_pos = range.find('-');
+  if (dash_pos == std::string_view::npos ||
+      range.find(',') != std::string_view::npos) {
+    return RangeResult::NONE;
+  }
+  std::string_view first = range.substr(0, dash_pos);
+  std::string_view last = range.substr(dash_pos + 1);
+
+  if (first.empty()) {
+    // the last bytes of the file
+    std::size_t suffix_length = 0;
+    if (!ParseSize(last, &suffix_length)) {
+      return RangeResult::NONE;
+    }
+    if (suffix_length == 0 || file_size == 0) {
+      return RangeResult::UNSATISFIABLE;
+    }
+    *length = std::min(suffix_length, file_size);
+    *offset = file_size - *length;
+    return RangeResult::SATISFIABLE;
+  }
+
+  std::size_t first_pos = 0;
+  std::size_t last_pos = file_size > 0 ? file_size - 1 : 0;
+  if (!ParseSize(first, &first_pos) ||
+      (!last.empty() &&
+       (!ParseSize(last, &last_pos) || last_pos < first_pos))) {
+    return RangeResult::NONE;
+  }
+  if (first_pos >= file_size) {
+    return RangeResult::UNSATISFIABLE;
+  }
+  last_pos = std::min(last_pos, file_size - 1);
+  *offset = first_pos;
+  *length = last_pos - first_pos + 1;
+  return RangeResult::SATISFIABLE;
+}
+
+bool arc::http::detail::MatchesETag(std::string_view if_none_match,
+                                    std::string_view etag) {
+  while (!if_none_match.empty()) {
+    auto comma_pos = if_none_match.find(',');
+    std::string_view candidate = if_none_match.substr(0, comma_pos);
+    while (!candidate.empty() && candidate.front() == ' ') {
+      candidate.remove_prefix(1);
+    }
+    while (!candidate.empty() && candidate.back() == ' ') {
+      candidate.remove_suffix(1);
+    }
+    // weak comparison
+    if (candidate.starts_with("W/")) {
+      candidate.remove_prefix(2);
+    }
+    if (candidate == "*" || candidate == etag) {
+      return true;
+    }
+    if (comma_pos == std::string_view::npos) {
+      break;
+    }
+    if_none_match.remove_prefix(comma_pos + 1);
+  }
+  return false;
+}
+
+HttpFile::HttpFile(int fd, const struct stat& file_stat)
+    : fd_(fd),
+      size_(file_stat.st_size),
+      dev_(file_stat.st_dev),
+      ino_(file_stat.st_ino),
+      mtime_(file_stat.st_mtim) {
+  // A file replaced or written again within the same second still gets a
+  // new one, from its inode or the nanoseconds of its mtime.
+  char etag[80];
+  int etag_size = snprintf(
+      etag, sizeof(etag), "\"%llx-%llx.%lx-%llx\"",
+      static_cast<unsigned long long>(ino_),
+      static_cast<unsigned long long>(mtime_.tv_sec),
+      static_cast<unsigned long>(mtime_.tv_nsec),
+      static_cast<unsigned long long>(size_));
+  etag_.assign(etag, etag_size);
+  last_modified_ = FormatHttpDate(mtime_.tv_sec);
+}
+
+HttpFile::~HttpFile() {
+  if (fd_ >= 0) {
+    close(fd_);
+  }
+}
+
+bool HttpFile::IsStale(const struct stat& file_stat) const {
+  return file_stat.st_dev != dev_ || file_stat.st_ino != ino_ ||
+         static_cast<std::size_t>(file_stat.st_size) != size_ ||
+         file_stat.st_mtim.tv_sec != mtime_.tv_sec ||
+         file_stat.st_mtim.tv_nsec != mtime_.tv_nsec;
+}
+
+HttpFileCache::HttpFileCache(const std::string& root_dir,
+                             std::size_t capacity)
+    : capacity_(capacity) {
+  root_fd_ = open(root_dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (root_fd_ < 0) {
+    throw arc::exception::IOException("Cannot Open Directory " + root_dir);
+  }
+}
+
+HttpFileCache::~HttpFileCache() { close(root_fd_); }
+
+std::shared_ptr<const HttpFile> HttpFileCache::Open(const std::string& path) {
+  auto now = std::chrono::steady_clock::now();
+  {
+    std::lock_guard<std::mutex> guard(lock_);
+    auto itr = entries_.find(path);
+    if (itr != entries_.end()) {
+      Entry& entry = itr->second;
+      bool is_valid = now - entry.validated_at < kRevalidateInterval;
+      if (!is_valid) {
+        struct stat file_stat;
+        is_valid = fstatat(root_fd_, path.c_str(), &file_stat, 0) == 0 &&
+                   !entry.file->IsStale(file_stat);
+        entry.validated_at = now;
+      }
+      if (is_valid) {
+        lru_.splice(lru_.begin(), lru_, entry.lru_itr);
+        return entry.file;
+      }
+      lru_.erase(entry.lru_itr);
+      entries_.erase(itr);
+    }
+  }
+
+  // open outside of the lock, a file opened twice meanwhile does no harm
+  auto file = OpenFile(path);
+  if (!file || capacity_ == 0) {
+    return file;
+  }
+  std::lock_guard<std::mutex> guard(lock_);
+  auto itr = entries_.find(path);
+  if (itr != entries_.end()) {
+    return itr->second.file;
+  }
+  if (entries_.size() >= capacity_) {
+    // the file stays open for the responses still referring to it
+    entries_.erase(lru_.back());
+    lru_.pop_back();
+  }
+  lru_.push_front(path);
+  entries_.emplace(path,
+                   Entry{.file = file, .validated_at = now,
+                         .lru_itr = lru_.begin()});
+  return file;
+}
+
+std::shared_ptr<const HttpFile> HttpFileCache::OpenFile(
+    const std::string& path) {
+  int fd = openat(root_fd_, path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return nullptr;
+  }
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) != 0 || !S_ISREG(file_stat.st_mode)) {
+    close(fd);
+    return nullptr;
+  }
+  return std::make_shared<const HttpFile>(fd, file_stat);
+}
+
+HttpStaticFiles::HttpStaticFiles(const std::string& root_dir,
+                                 std::size_t cache_capacity)
+    : cache_(root_dir, cache_capacity) {}
+
+void HttpStaticFiles::Serve(const HttpRequest& request, std::string_view path,
+                            HttpResponse* response) {
+  std::string file_path = detail::DecodePath(path);
+  std::shared_ptr<const HttpFile> file;
+  if (!file_path.empty()) {
+    file = cache_.Open(file_path);
+  }
+  if (!file) {
+    response->status = HttpStatus::HTTP_STATUS_NOT_FOUND;
+    response->body = "404 Not Found";
+    return;
+  }
+
+  response->headers["ETag"] = file->GetETag();
+  response->headers["Last-Modified"] = file->GetLastModified();
+  response->headers["Accept-Ranges"] = "bytes";
+
+  auto if_none_match = request.headers.Get("If-None-Match");
+  auto if_modified_since = request.headers.Get("If-Modified-Since");
+  if ((if_none_match && detail::MatchesETag(*if_none_match, file->GetETag())) ||
+      (!if_none_match && if_modified_since &&
+       *if_modified_since == file->GetLastModified())) {
+    response->status = HttpStatus::HTTP_STATUS_NOT_MODIFIED;
+    response->headers["Content-Length"] = std::to_string(file->GetSize());
+    return;
+  }
+
+  std::size_t offset = 0;
+  std::size_t length = file->GetSize();
+  auto range = request.headers.Get("Range");
+  auto if_range = request.headers.Get("If-Range");
+  // a range of another version of the file is of no use
+  if (range && (!if_range || *if_range == file->GetETag() ||
+                *if_range == file->GetLastModified())) {
+    switch (detail::ParseRange(*range, file->GetSize(), &offset, &length)) {
+      case detail::RangeResult::SATISFIABLE:
+        response->status = HttpStatus::HTTP_STATUS_PARTIAL_CONTENT;
+        response->headers["Content-Range"] =
+            "bytes " + std::to_string(offset) + "-" +
+            std::to_string(offset + length - 1) + "/" +
+            std::to_string(file->GetSize());
+        break;
+      case detail::RangeResult::UNSATISFIABLE:
+        response->status = HttpStatus::HTTP_STATUS_RANGE_NOT_SATISFIABLE;
+        response->headers["Content-Range"] =
+            "bytes */" + std::to_string(file->GetSize());
+        response->headers["Content-Length"] = "0";
+        return;
+      default:
+        break;
+    }
+  }
+
+  response->headers["Content-Type"] = GetContentType(file_path);
+  response->headers["Content-Length"] = std::to_string(length);
+  if (request.method != HttpMethod::HTTP_HEAD) {
+    response->file = std::move(file);
+    response->file_offset = offset;
+    response->file_length = length;
+  }
+}
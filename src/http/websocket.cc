@@ -0,0 +1,623 @@
+/*
+ * File: websocket.cc
+ * Project: libarc
+ * File Created: Saturday, 17th October 2026 9:26:52 pm
+ * Author: Minjun Xu (mjxu96@outlook.com)
+ * -----
+ * MIT License
+ * Copyright (c) 2022 Minjun Xu
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <arc/http/http_server.h>
+#include <arc/http/websocket.h>
+#include <openssl/evp.h>
+#include <openssl/sha.h>
+#include <zlib.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+
+using namespace arc::http;
+using namespace arc::coro;
+using namespace arc;
+
+namespace {
+
+const char kWebSocketGuid[] = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+// what a deflated message ends with after a sync flush, left out on the wire
+const unsigned char kDeflateTail[] = {0x00, 0x00, 0xFF, 0xFF};
+
+std::string_view Trim(std::string_view str) {
+  while (!str.empty() && (str.front() == ' ' || str.front() == '\t')) {
+    str.remove_prefix(1);
+  }
+  while (!str.empty() && (str.back() == ' ' || str.back() == '\t')) {
+    str.remove_suffix(1);
+  }
+  return str;
+}
+
+// splits off the next item of a list separated by delimiter
+std::string_view NextItem(std::string_view* list, char delimiter) {
+  auto pos = list->find(delimiter);
+  std::string_view item = Trim(list->substr(0, pos));
+  if (pos == std::string_view::npos) {
+    *list = std::string_view();
+  } else {
+    list->remove_prefix(pos + 1);
+  }
+  return item;
+}
+
+// whether a comma separated header value has the token, ignoring case
+bool HasToken(std::string_view list, std::string_view token) {
+  while (!list.empty()) {
+    if (EqualsIgnoreCase(NextItem(&list, ','), token)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+inline bool IsControlFrame(WebSocketOpcode opcode) {
+  return (static_cast<std::uint8_t>(opcode) & 0x8U) != 0;
+}
+
+}  // namespace
+
+std::size_t arc::http::detail::ParseWebSocketFrameHeader(
+    const char* data, std::size_t size, WebSocketFrameHeader* header) {
+  if (size < 2) {
+    return 0;
+  }
+  auto bytes = reinterpret_cast<const unsigned char*>(data);
+  std::size_t header_size = 2;
+  std::uint64_t payload_size = bytes[1] & 0x7FU;
+  if (payload_size == 126) {
+    header_size += 2;
+  } else if (payload_size == 127) {
+    header_size += 8;
+  }
+  bool is_masked = (bytes[1] & 0x80U) != 0;
+  if (is_masked) {
+    header_size += 4;
+  }
+  if (size < header_size) {
+    return 0;
+  }
+
+  if (payload_size >= 126) {
+    std::size_t length_size = payload_size == 126 ? 2 : 8;
+    payload_size = 0;
+    for (std::size_t i = 0; i < length_size; i++) {
+      payload_size = (payload_size << 8) | bytes[2 + i];
+    }
+  }
+  header->is_fin = (bytes[0] & 0x80U) != 0;
+  header->is_compressed = (bytes[0] & 0x40U) != 0;
+  header->has_reserved_bits = (bytes[0] & 0x30U) != 0;
+  header->opcode = static_cast<WebSocketOpcode>(bytes[0] & 0x0FU);
+  header->is_masked = is_masked;
+  header->payload_size = payload_size;
+  if (is_masked) {
+    std::memcpy(header->mask, bytes + header_size - 4, 4);
+  }
+  return header_size;
+}
+
+std::size_t arc::http::detail::WriteWebSocketFrameHeader(
+    WebSocketOpcode opcode, bool is_fin, bool is_compressed,
+    std::uint64_t payload_size, char* out) {
+  auto bytes = reinterpret_cast<unsigned char*>(out);
+  bytes[0] = (is_fin ? 0x80U : 0U) | (is_compressed ? 0x40U : 0U) |
+             static_cast<std::uint8_t>(opcode);
+  if (payload_size < 126) {
+    bytes[1] = payload_size;
+    return 2;
+  }
+  std::size_t length_size = 8;
+  bytes[1] = 127;
+  if (payload_size <= 0xFFFF) {
+    length_size = 2;
+    bytes[1] = 126;
+  }
+  for (std::size_t i = 0; i < length_size; i++) {
+    bytes[2 + i] = payload_size >> (8 * (length_size - 1 - i));
+  }
+  return 2 + length_size;
+}
+
+void arc::http::detail::UnmaskWebSocketPayload(char* data, std::size_t size,
+                                               const unsigned char mask[4]) {
+  // the mask repeated over a word, which lines up with it at every multiple
+  // of 8 bytes
+  unsigned char word_mask_bytes[8];
+  std::memcpy(word_mask_bytes, mask, 4);
+  std::memcpy(word_mask_bytes + 4, mask, 4);
+  std::uint64_t word_mask = 0;
+  std::memcpy(&word_mask, word_mask_bytes, 8);
+
+  std::size_t i = 0;
+  for (; i + 8 <= size; i += 8) {
+    std::uint64_t word = 0;
+    std::memcpy(&word, data + i, 8);
+    word ^= word_mask;
+    std::memcpy(data + i, &word, 8);
+  }
+  for (; i < size; i++) {
+    data[i] ^= mask[i & 3];
+  }
+}
+
+bool arc::http::detail::IsValidUtf8(std::string_view data) {
+  auto bytes = reinterpret_cast<const unsigned char*>(data.data());
+  std::size_t size = data.size();
+  std::size_t i = 0;
+  while (i < size) {
+    // skip ASCII a word at a time
+    if (i + 8 <= size) {
+      std::uint64_t word = 0;
+      std::memcpy(&word, bytes + i, 8);
+      if ((word & 0x8080808080808080ULL) == 0) {
+        i += 8;
+        continue;
+      }
+    }
+    unsigned char lead = bytes[i];
+    if (lead < 0x80U) {
+      i++;
+      continue;
+    }
+    std::size_t continuation_num = 0;
+    std::uint32_t code_point = 0;
+    if ((lead & 0xE0U) == 0xC0U) {
+      continuation_num = 1;
+      code_point = lead & 0x1FU;
+    } else if ((lead & 0xF0U) == 0xE0U) {
+      continuation_num = 2;
+      code_point = lead & 0x0FU;
+    } else if ((lead & 0xF8U) == 0xF0U) {
+      continuation_num = 3;
+      code_point = lead & 0x07U;
+    } else {
+      return false;
+    }
+    if (size - i <= continuation_num) {
+      return false;
+    }
+    for (std::size_t j = 1; j <= continuation_num; j++) {
+      if ((bytes[i + j] & 0xC0U) != 0x80U) {
+        return false;
+      }
+      code_point = (code_point << 6) | (bytes[i + j] & 0x3FU);
+    }
+    // overlong encodings, surrogates and beyond the last code point
+    const std::uint32_t kMinCodePoints[] = {0, 0x80, 0x800, 0x10000};
+    if (code_point < kMinCodePoints[continuation_num] ||
+        code_point > 0x10FFFF ||
+        (code_point >= 0xD800 && code_point <= 0xDFFF)) {
+      return false;
+    }
+    i += continuation_num + 1;
+  }
+  return true;
+}
+
+bool arc::http::detail::IsValidWebSocketCloseCode(std::uint16_t code) {
+  // 1000-1003 and 1007-1014 are defined, 3000-4999 are left to libraries
+  // and applications
+  return (code >= 1000 && code <= 1003) || (code >= 1007 && code <= 1014) ||
+         (code >= 3000 && code <= 4999);
+}
+
+bool arc::http::IsWebSocketUpgrade(const HttpRequest& request) {
+  if (request.method != HttpMethod::HTTP_GET ||
+      request.http_major_version * 10 + request.http_minor_version < 11) {
+    return false;
+  }
+  auto upgrade = request.headers.Get("Upgrade");
+  auto connection = request.headers.Get("Connection");
+  auto version = request.headers.Get("Sec-WebSocket-Version");
+  auto key = request.headers.Get("Sec-WebSocket-Key");
+  // the key is 16 bytes in base64
+  return upgrade && HasToken(*upgrade, "websocket") && connection &&
+         HasToken(*connection, "upgrade") && version &&
+         Trim(*version) == "13" && key && Trim(*key).size() == 24;
+}
+
+bool arc::http::IsWebSocketDeflateOffered(const HttpRequest& request) {
+  auto extensions = request.headers.Get("Sec-WebSocket-Extensions");
+  if (!extensions) {
+    return false;
+  }
+  std::string_view offers = *extensions;
+  while (!offers.empty()) {
+    std::string_view params = NextItem(&offers, ',');
+    if (!EqualsIgnoreCase(NextItem(&params, ';'), "permessage-deflate")) {
+      continue;
+    }
+    bool is_acceptable = true;
+    while (is_acceptable && !params.empty()) {
+      std::string_view param = NextItem(&params, ';');
+      std::string_view name = NextItem(&param, '=');
+      if (EqualsIgnoreCase(name, "server_max_window_bits")) {
+        // a smaller window than the default one is not supported
+        is_acceptable = Trim(param) == "15" || Trim(param) == "\"15\"";
+      } else if (!EqualsIgnoreCase(name, "server_no_context_takeover") &&
+                 !EqualsIgnoreCase(name, "client_no_context_takeover") &&
+                 !EqualsIgnoreCase(name, "client_max_window_bits")) {
+        is_acceptable = false;
+      }
+    }
+    if (is_acceptable) {
+      return true;
+    }
+  }
+  return false;
+}
+
+std::string arc::http::GetWebSocketAccept(std::string_view key) {
+  std::string input(Trim(key));
+  input += kWebSocketGuid;
+  unsigned char digest[SHA_DIGEST_LENGTH];
+  SHA1(reinterpret_cast<const unsigned char*>(input.data()), input.size(),
+       digest);
+  // 4 base64 characters for every 3 bytes, and the terminating null
+  char accept[(SHA_DIGEST_LENGTH + 2) / 3 * 4 + 1];
+  int size = EVP_EncodeBlock(reinterpret_cast<unsigned char*>(accept), digest,
+                             SHA_DIGEST_LENGTH);
+  return std::string(accept, size);
+}
+
+WebSocket::WebSocket(
+    HttpServer* server,
+    arc::io::Socket<arc::net::Domain::IPV4, arc::net::Protocol::TCP,
+                    arc::io::Pattern::ASYNC>* socket,
+    std::string_view received, bool is_deflate_enabled)
+    : server_(server),
+      socket_(socket),
+      max_message_size_(server->config_.websocket_max_message_size),
+      is_deflate_enabled_(is_deflate_enabled),
+      buffer_(std::max<std::size_t>(server->config_.read_buffer_size,
+                                    received.size())) {
+  if (!received.empty()) {
+    std::memcpy(buffer_.PrepareWrite(received.size()), received.data(),
+                received.size());
+    buffer_.Commit(received.size());
+  }
+}
+
+WebSocket::~WebSocket() {
+  if (deflater_) {
+    deflateEnd(deflater_);
+    delete deflater_;
+  }
+  if (inflater_) {
+    inflateEnd(inflater_);
+    delete inflater_;
+  }
+}
+
+Task<std::optional<WebSocketMessage>> WebSocket::Receive() {
+  buffer_.Consume(consumed_size_);
+  consumed_size_ = 0;
+  // the payloads of the message so far are moved to the front of the buffer,
+  // the next frame starts at frame_begin
+  std::size_t message_size = 0;
+  std::size_t frame_begin = 0;
+  bool is_in_message = false;
+  bool is_compressed = false;
+  // whether the peer has been pinged since it last sent something
+  bool is_idle_pinged = false;
+  WebSocketMessage message;
+  while (!is_closed_) {
+    detail::WebSocketFrameHeader header;
+    std::size_t available = buffer_.Size() - frame_begin;
+    std::size_t header_size = detail::ParseWebSocketFrameHeader(
+        buffer_.Data() + frame_begin, available, &header);
+    if (header_size > 0) {
+      if (!header.is_masked || header.has_reserved_bits) {
+        co_return co_await Fail(WebSocketCloseCode::PROTOCOL_ERROR);
+      }
+      if (IsControlFrame(header.opcode)) {
+        if (!header.is_fin || header.is_compressed ||
+            header.payload_size > 125) {
+          co_return co_await Fail(WebSocketCloseCode::PROTOCOL_ERROR);
+        }
+      } else if (header.payload_size > max_message_size_ - message_size) {
+        // refused before it is received
+        co_return co_await Fail(WebSocketCloseCode::MESSAGE_TOO_BIG);
+      }
+    }
+    if (header_size == 0 || available - header_size < header.payload_size) {
+      // room for the whole frame if its size is known
+      std::size_t min_size = server_->config_.read_buffer_size;
+      if (header_size > 0) {
+        min_size = std::max<std::size_t>(
+            min_size, header_size + header.payload_size - available);
+      }
+      char* recv_ptr = buffer_.PrepareWrite(min_size);
+      auto timeout = std::chrono::milliseconds(
+          server_->config_.websocket_idle_timeout_ms);
+      ssize_t recv_bytes = 0;
+      if (timeout.count() > 0) {
+        recv_bytes =
+            co_await socket_->Recv(recv_ptr, buffer_.WritableSize(), timeout);
+      } else {
+        recv_bytes = co_await socket_->Recv(recv_ptr, buffer_.WritableSize());
+      }
+      if (recv_bytes < 0 && (errno == EAGAIN || errno == EWOULDBLOCK) &&
+          !is_close_sent_) {
+        if (is_idle_pinged) {
+          server_->config_.logger->LogDebug("Timed out reading from websocket");
+          co_return co_await Fail(WebSocketCloseCode::GOING_AWAY);
+        }
+        // a live peer answers before the next timeout
+        is_idle_pinged = true;
+        co_await SendFrame(WebSocketOpcode::PING, {});
+        continue;
+      }
+      if (recv_bytes <= 0) {
+        is_closed_ = true;
+        co_return std::nullopt;
+      }
+      is_idle_pinged = false;
+      buffer_.Commit(recv_bytes);
+      continue;
+    }
+
+    char* payload = buffer_.Data() + frame_begin + header_size;
+    std::size_t payload_size = header.payload_size;
+    std::size_t frame_size = header_size + payload_size;
+    detail::UnmaskWebSocketPayload(payload, payload_size, header.mask);
+    switch (header.opcode) {
+      case WebSocketOpcode::PING:
+        if (!is_close_sent_) {
+          co_await SendFrame(WebSocketOpcode::PONG,
+                             std::string_view(payload, payload_size));
+        }
+        buffer_.Erase(frame_begin, frame_size);
+        continue;
+      case WebSocketOpcode::PONG:
+        buffer_.Erase(frame_begin, frame_size);
+        continue;
+      case WebSocketOpcode::CLOSE:
+        if (payload_size == 1 ||
+            (payload_size >= 2 &&
+             !detail::IsValidWebSocketCloseCode(
+                 static_cast<unsigned char>(payload[0]) << 8 |
+                 static_cast<unsigned char>(payload[1]))) ||
+            (payload_size > 2 &&
+             !detail::IsValidUtf8(
+                 std::string_view(payload + 2, payload_size - 2)))) {
+          co_return co_await Fail(WebSocketCloseCode::PROTOCOL_ERROR);
+        }
+        if (!is_close_sent_) {
+          // echoes the status code
+          is_close_sent_ = true;
+          co_await SendFrame(
+              WebSocketOpcode::CLOSE,
+              std::string_view(payload, std::min<std::size_t>(payload_size, 2)));
+        }
+        is_closed_ = true;
+        co_return std::nullopt;
+      case WebSocketOpcode::TEXT:
+      case WebSocketOpcode::BINARY:
+        if (is_in_message || (header.is_compressed && !is_deflate_enabled_)) {
+          co_return co_await Fail(WebSocketCloseCode::PROTOCOL_ERROR);
+        }
+        is_in_message = true;
+        is_compressed = header.is_compressed;
+        message.opcode = header.opcode;
+        break;
+      case WebSocketOpcode::CONTINUATION:
+        if (!is_in_message || header.is_compressed) {
+          co_return co_await Fail(WebSocketCloseCode::PROTOCOL_ERROR);
+        }
+        break;
+      default:
+        co_return co_await Fail(WebSocketCloseCode::PROTOCOL_ERROR);
+    }
+
+    std::memmove(buffer_.Data() + message_size, payload, payload_size);
+    message_size += payload_size;
+    frame_begin += frame_size;
+    if (!header.is_fin) {
+      continue;
+    }
+    consumed_size_ = frame_begin;
+    message.data = std::string_view(buffer_.Data(), message_size);
+    if (is_compressed) {
+      auto error = Inflate(message.data);
+      if (error) {
+        co_return co_await Fail(*error);
+      }
+      message.data = inflated_;
+    }
+    if (message.opcode == WebSocketOpcode::TEXT &&
+        !detail::IsValidUtf8(message.data)) {
+      co_return co_await Fail(WebSocketCloseCode::INVALID_PAYLOAD);
+    }
+    co_return message;
+  }
+  co_return std::nullopt;
+}
+
+Task<bool> WebSocket::Send(std::string_view data, WebSocketOpcode opcode) {
+  if (IsClosed()) {
+    co_return false;
+  }
+  co_return co_await SendFrame(opcode, data);
+}
+
+Task<bool> WebSocket::Ping(std::string_view data) {
+  if (IsClosed() || data.size() > 125) {
+    co_return false;
+  }
+  co_return co_await SendFrame(WebSocketOpcode::PING, data);
+}
+
+Task<bool> WebSocket::Close(WebSocketCloseCode code, std::string_view reason) {
+  if (IsClosed()) {
+    co_return false;
+  }
+  // nothing is sent after it, even by the ones waiting to send already
+  is_close_sent_ = true;
+  char payload[125];
+  std::size_t payload_size = 0;
+  // 1005 only stands for a close without a code, it is never sent
+  if (code != WebSocketCloseCode::NO_STATUS) {
+    auto code_value = static_cast<std::uint16_t>(code);
+    payload[0] = code_value >> 8;
+    payload[1] = code_value & 0xFFU;
+    payload_size = std::min<std::size_t>(reason.size(), 123);
+    std::memcpy(payload + 2, reason.data(), payload_size);
+    payload_size += 2;
+  }
+  co_return co_await SendFrame(WebSocketOpcode::CLOSE,
+                               std::string_view(payload, payload_size));
+}
+
+Task<bool> WebSocket::SendFrame(WebSocketOpcode opcode,
+                                std::string_view data) {
+  co_await send_lock_.Acquire();
+  bool is_sent = false;
+  // closed while waiting, only the close frame itself may still go out
+  if (!is_closed_ && (!is_close_sent_ || opcode == WebSocketOpcode::CLOSE)) {
+    bool is_compressed = false;
+    if (is_deflate_enabled_ && !IsControlFrame(opcode) &&
+        data.size() >= kMinDeflateSize_ && Deflate(data)) {
+      data = deflated_;
+      is_compressed = true;
+    }
+    char head[detail::kMaxWebSocketFrameHeaderSize];
+    std::size_t head_size = detail::WriteWebSocketFrameHeader(
+        opcode, true, is_compressed, data.size(), head);
+    iovec iov[2] = {{head, head_size},
+                    {const_cast<char*>(data.data()), data.size()}};
+    try {
+      is_sent = co_await server_->SendAll(*socket_, iov, 2);
+    } catch (const std::exception& e) {
+      server_->config_.logger->LogWarning(e.what());
+    }
+    if (!is_sent) {
+      is_closed_ = true;
+    }
+  }
+  send_lock_.Release();
+  co_return is_sent;
+}
+
+Task<std::optional<WebSocketMessage>> WebSocket::Fail(
+    WebSocketCloseCode code) {
+  server_->config_.logger->LogDebug("Fail websocket connection with code %u",
+                                    static_cast<unsigned int>(code));
+  co_await Close(code);
+  is_closed_ = true;
+  co_return std::nullopt;
+}
+
+bool WebSocket::Deflate(std::string_view data) {
+  if (!deflater_) {
+    deflater_ = new z_stream();
+    // raw deflate, without zlib header and trailer
+    if (deflateInit2(deflater_, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS,
+                     8, Z_DEFAULT_STRATEGY) != Z_OK) {
+      delete deflater_;
+      deflater_ = nullptr;
+      is_deflate_enabled_ = false;
+      return false;
+    }
+  }
+  // room for the empty block of the flush as well
+  deflated_.resize(deflateBound(deflater_, data.size()) + 16);
+  deflater_->next_in =
+      reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+  deflater_->avail_in = data.size();
+  deflater_->next_out = reinterpret_cast<Bytef*>(deflated_.data());
+  deflater_->avail_out = deflated_.size();
+  int ret = deflate(deflater_, Z_SYNC_FLUSH);
+  std::size_t deflated_size = deflated_.size() - deflater_->avail_out;
+  bool is_done = ret == Z_OK && deflater_->avail_in == 0 &&
+                 deflater_->avail_out > 0 && deflated_size >= 4;
+  // no context takeover, every message starts afresh
+  deflateReset(deflater_);
+  if (!is_done || deflated_size - 4 >= data.size()) {
+    return false;
+  }
+  deflated_.resize(deflated_size - 4);
+  return true;
+}
+
+std::optional<WebSocketCloseCode> WebSocket::Inflate(std::string_view data) {
+  if (!inflater_) {
+    inflater_ = new z_stream();
+    if (inflateInit2(inflater_, -MAX_WBITS) != Z_OK) {
+      delete inflater_;
+      inflater_ = nullptr;
+      return WebSocketCloseCode::INTERNAL_ERROR;
+    }
+  }
+  std::optional<WebSocketCloseCode> error;
+  std::size_t inflated_size = 0;
+  std::string_view inputs[] = {
+      data, std::string_view(reinterpret_cast<const char*>(kDeflateTail),
+                             sizeof(kDeflateTail))};
+  bool is_stream_end = false;
+  for (std::size_t i = 0; !error && !is_stream_end && i < 2; i++) {
+    inflater_->next_in =
+        reinterpret_cast<Bytef*>(const_cast<char*>(inputs[i].data()));
+    inflater_->avail_in = inputs[i].size();
+    while (true) {
+      if (inflated_size == inflated_.size()) {
+        if (inflated_size >= max_message_size_) {
+          error = WebSocketCloseCode::MESSAGE_TOO_BIG;
+          break;
+        }
+        inflated_.resize(std::min<std::size_t>(
+            std::max<std::size_t>(2 * inflated_size, 4096),
+            max_message_size_));
+      }
+      inflater_->next_out =
+          reinterpret_cast<Bytef*>(inflated_.data() + inflated_size);
+      inflater_->avail_out = inflated_.size() - inflated_size;
+      int ret = inflate(inflater_, Z_SYNC_FLUSH);
+      inflated_size = inflated_.size() - inflater_->avail_out;
+      if (ret == Z_STREAM_END) {
+        is_stream_end = true;
+        break;
+      }
+      if (ret != Z_OK && ret != Z_BUF_ERROR) {
+        error = WebSocketCloseCode::INVALID_PAYLOAD;
+        break;
+      }
+      // all taken and nothing more to give
+      if (inflater_->avail_in == 0 && inflater_->avail_out > 0) {
+        break;
+      }
+    }
+  }
+  inflateReset(inflater_);
+  inflated_.resize(inflated_size);
+  return error;
+}
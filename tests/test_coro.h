@@ -108,6 +108,59 @@ class BasicCoroTest : public ::testing::Test {
     co_return;
   }
 
+  coro::Task<void> FrameReuseTestCoro() {
+    void* first_address = nullptr;
+    {
+      auto task = ReturnInt(1);
+      first_address = task.GetCoroutine().address();
+      co_await task;
+    }
+    // a freed frame is handed out again to the next frame of its size
+    auto task = ReturnInt(1);
+    EXPECT_EQ(task.GetCoroutine().address(), first_address);
+    co_await task;
+  }
+
+  template <typename T>
+  struct CountingAllocator {
+    using value_type = T;
+
+    CountingAllocator(int* count) : count(count) {}
+    template <typename U>
+    CountingAllocator(const CountingAllocator<U>& other)
+        : count(other.count) {}
+
+    T* allocate(std::size_t n) {
+      (*count)++;
+      return std::allocator<T>().allocate(n);
+    }
+
+    void deallocate(T* ptr, std::size_t n) {
+      (*count)--;
+      std::allocator<T>().deallocate(ptr, n);
+    }
+
+    int* count;
+  };
+
+  coro::Task<int> ReturnIntWithAllocator(std::allocator_arg_t,
+                                         const CountingAllocator<char>& alloc,
+                                         int i) {
+    co_return i;
+  }
+
+  coro::Task<void> CustomFrameAllocatorTestCoro() {
+    int count = 0;
+    CountingAllocator<char> alloc(&count);
+    {
+      auto task = ReturnIntWithAllocator(std::allocator_arg, alloc, 1);
+      EXPECT_EQ(count, 1);
+      int ret = co_await task;
+      EXPECT_EQ(ret, 1);
+    }
+    EXPECT_EQ(count, 0);
+  }
+
   void Fail() { FAIL() << "Expected std::logic_error"; }
 
   coro::Task<void> ExceptionTestCoro() {
@@ -139,6 +192,25 @@ TEST_F(BasicCoroTest, ExceptionTest) {
   coro::StartEventLoop(ExceptionTestCoro());
 }
 
+TEST_F(BasicCoroTest, EventReuseTest) {
+  coro::EventBase* event =
+      new coro::IOEvent(0, io::IOType::READ, std::coroutine_handle<void>());
+  void* first_address = event;
+  delete event;
+  // a freed event block is handed out again to the next event of its size
+  event = new coro::IOEvent(0, io::IOType::WRITE, std::coroutine_handle<void>());
+  EXPECT_EQ(static_cast<void*>(event), first_address);
+  delete event;
+}
+
+TEST_F(BasicCoroTest, FrameReuseTest) {
+  coro::StartEventLoop(FrameReuseTestCoro());
+}
+
+TEST_F(BasicCoroTest, CustomFrameAllocatorTest) {
+  coro::StartEventLoop(CustomFrameAllocatorTestCoro());
+}
+
 }  // namespace test
 }  // namespace arc
 
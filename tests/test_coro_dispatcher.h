@@ -46,6 +46,8 @@ class DispatcherCoroTest : public ::testing::Test {
   coro::Condition consumer_prepare_cond_;
   int finished_produce_count_{0};
   int prepared_consumer_count_{0};
+  coro::ConsumerPolicy consumer_policy_{coro::ConsumerPolicy::NO_STEALING};
+  std::atomic<int> executed_count_{0};
 
  public:
   coro::Task<void> DispatchedTask() {
@@ -56,7 +58,7 @@ class DispatcherCoroTest : public ::testing::Test {
 
   coro::Task<void> LongRunTask(int producer_count) {
     co_await lock_.Acquire();
-    coro::EventLoop::GetLocalInstance().ResigerConsumer();
+    coro::EventLoop::GetLocalInstance().ResigerConsumer(consumer_policy_);
     prepared_consumer_count_++;
     consumer_prepare_cond_.NotifyAll();
     lock_.Release();
@@ -94,6 +96,92 @@ class DispatcherCoroTest : public ::testing::Test {
     lock_.Release();
   }
 
+  coro::Task<void> BlockingTask(int milliseconds = 300) {
+    // an expensive request which holds its event loop
+    std::this_thread::sleep_for(std::chrono::milliseconds(milliseconds));
+    co_return;
+  }
+
+  coro::Task<void> SkewedProduceTask(int produce_count, int consumer_count,
+                                     coro::EventLoopWakeUpHandle busy_target) {
+    coro::EventLoop::GetLocalInstance().ResigerProducer();
+    co_await lock_.Acquire();
+    while (prepared_consumer_count_ < consumer_count) {
+      co_await consumer_prepare_cond_.Wait(lock_);
+    }
+    lock_.Release();
+    coro::EventLoop::GetLocalInstance().DispatchTo(BlockingTask(),
+                                                   busy_target);
+    // make sure the busy target is blocked
+    co_await coro::SleepFor(std::chrono::milliseconds(50));
+    for (int i = 0; i < produce_count; i++) {
+      coro::EventLoop::GetLocalInstance().Dispatch(DispatchedTask());
+      co_await coro::Yield();
+    }
+    coro::EventLoop::GetLocalInstance().DeResigerProducer();
+    // consumers quit once notified, leave some time for stealing before the
+    // busy target is unblocked
+    co_await coro::SleepFor(std::chrono::milliseconds(100));
+    co_await lock_.Acquire();
+    finished_produce_count_++;
+    cond_.NotifyAll();
+    lock_.Release();
+  }
+
+  coro::Task<void> CountedTask() {
+    co_await coro::SleepFor(std::chrono::milliseconds(1));
+    executed_count_++;
+  }
+
+  coro::Task<void> ShortRunTask(int round) {
+    for (int i = 0; i < round; i++) {
+      coro::EventLoop::GetLocalInstance().ResigerConsumer();
+      co_await coro::SleepFor(std::chrono::milliseconds(2));
+      coro::EventLoop::GetLocalInstance().DeResigerConsumer();
+    }
+    co_await lock_.Acquire();
+    finished_produce_count_++;
+    cond_.NotifyAll();
+    lock_.Release();
+  }
+
+  coro::Task<void> CountedProduceTask(int produce_count) {
+    coro::EventLoop::GetLocalInstance().ResigerProducer();
+    for (int i = 0; i < produce_count; i++) {
+      coro::EventLoop::GetLocalInstance().Dispatch(CountedTask());
+      co_await coro::Yield();
+    }
+    coro::EventLoop::GetLocalInstance().DeResigerProducer();
+    co_await lock_.Acquire();
+    finished_produce_count_++;
+    cond_.NotifyAll();
+    lock_.Release();
+  }
+
+  coro::Task<void> LoadAwareProduceTask(int produce_count, int consumer_count,
+                                        coro::EventLoopWakeUpHandle slow_target,
+                                        coro::DispatchPolicy policy) {
+    coro::EventLoop::GetLocalInstance().ResigerProducer();
+    co_await lock_.Acquire();
+    while (prepared_consumer_count_ < consumer_count) {
+      co_await consumer_prepare_cond_.Wait(lock_);
+    }
+    lock_.Release();
+    // slows down the average loop iteration of the target
+    coro::EventLoop::GetLocalInstance().DispatchTo(BlockingTask(100),
+                                                   slow_target);
+    co_await coro::SleepFor(std::chrono::milliseconds(150));
+    for (int i = 0; i < produce_count; i++) {
+      coro::EventLoop::GetLocalInstance().Dispatch(DispatchedTask(), policy);
+      co_await coro::Yield();
+    }
+    coro::EventLoop::GetLocalInstance().DeResigerProducer();
+    co_await lock_.Acquire();
+    finished_produce_count_++;
+    cond_.NotifyAll();
+    lock_.Release();
+  }
+
   void StartLongRunTask(int expected_count, int produce_count) {
     coro::StartEventLoop(LongRunTask(produce_count));
     EXPECT_EQ(expected_count, GetThreadLocalCounter());
@@ -103,6 +191,50 @@ class DispatcherCoroTest : public ::testing::Test {
                          coro::EventLoopWakeUpHandle target) {
     coro::StartEventLoop(ProduceTask(produce_count, consumer_count, target));
   }
+
+  void StartShortRunTask(int round) {
+    coro::StartEventLoop(ShortRunTask(round));
+  }
+
+  void StartCountedProducerTask(int produce_count) {
+    coro::StartEventLoop(CountedProduceTask(produce_count));
+  }
+
+  void StartLoadAwareProducerTask(int produce_count, int consumer_count,
+                                  coro::EventLoopWakeUpHandle slow_target,
+                                  coro::DispatchPolicy policy) {
+    coro::StartEventLoop(LoadAwareProduceTask(produce_count, consumer_count,
+                                              slow_target, policy));
+  }
+
+  void LoadAwareDispatch(coro::DispatchPolicy policy) {
+    finished_produce_count_ = 0;
+    prepared_consumer_count_ = 0;
+    int produce_count = 20;
+
+    // all dispatched tasks should go to the fast consumer
+    std::thread slow_consumer_thread(&DispatcherCoroTest::StartLongRunTask,
+                                     this, 0, 1);
+    // make sure we register above consumer
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    coro::EventLoopWakeUpHandle slow_target =
+        coro::CoroutineDispatcher::GetInstance()
+            .GetAvailableDispatchDestinations()[0];
+    std::thread fast_consumer_thread(&DispatcherCoroTest::StartLongRunTask,
+                                     this, produce_count, 1);
+    std::thread producer_thread(&DispatcherCoroTest::StartLoadAwareProducerTask,
+                                this, produce_count, 2, slow_target, policy);
+
+    producer_thread.join();
+    slow_consumer_thread.join();
+    fast_consumer_thread.join();
+  }
+
+  void StartSkewedProducerTask(int produce_count, int consumer_count,
+                               coro::EventLoopWakeUpHandle busy_target) {
+    coro::StartEventLoop(
+        SkewedProduceTask(produce_count, consumer_count, busy_target));
+  }
 };
 
 TEST_F(DispatcherCoroTest, EvenlyDispatchTest) {
@@ -171,6 +303,87 @@ TEST_F(DispatcherCoroTest, BiasedDispatchTest) {
   }
 }
 
+TEST_F(DispatcherCoroTest, WorkStealingTest) {
+  finished_produce_count_ = 0;
+  prepared_consumer_count_ = 0;
+  consumer_policy_ = coro::ConsumerPolicy::WORK_STEALING;
+  int produce_count = 20;
+
+  // all dispatched tasks should be stolen from the busy consumer
+  std::thread busy_consumer_thread(&DispatcherCoroTest::StartLongRunTask, this,
+                                   0, 1);
+  std::this_thread::sleep_for(
+      std::chrono::milliseconds(100));  // make sure we register above consumer
+  coro::EventLoopWakeUpHandle busy_target =
+      coro::CoroutineDispatcher::GetInstance()
+          .GetAvailableDispatchDestinations()[0];
+  std::thread idle_consumer_thread(&DispatcherCoroTest::StartLongRunTask, this,
+                                   produce_count, 1);
+  std::thread producer_thread(&DispatcherCoroTest::StartSkewedProducerTask,
+                              this, produce_count, 2, busy_target);
+
+  producer_thread.join();
+  busy_consumer_thread.join();
+  idle_consumer_thread.join();
+  consumer_policy_ = coro::ConsumerPolicy::NO_STEALING;
+}
+
+TEST_F(DispatcherCoroTest, LeastLoadedDispatchTest) {
+  LoadAwareDispatch(coro::DispatchPolicy::LEAST_LOADED);
+}
+
+TEST_F(DispatcherCoroTest, PowerOfTwoChoicesDispatchTest) {
+  LoadAwareDispatch(coro::DispatchPolicy::POWER_OF_TWO_CHOICES);
+}
+
+TEST_F(DispatcherCoroTest, ChangingConsumersTest) {
+  finished_produce_count_ = 0;
+  prepared_consumer_count_ = 0;
+  executed_count_ = 0;
+  int produce_count = 200;
+  int producer_count = 4;
+  int short_run_consumer_count = 4;
+  std::vector<std::thread> short_run_consumer_threads;
+  std::vector<std::thread> producer_threads;
+
+  // keeps at least one consumer registered during the whole test
+  std::thread long_run_consumer_thread([&]() {
+    coro::StartEventLoop(
+        LongRunTask(producer_count + short_run_consumer_count));
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  for (int i = 0; i < short_run_consumer_count; i++) {
+    short_run_consumer_threads.emplace_back(
+        &DispatcherCoroTest::StartShortRunTask, this, 20);
+  }
+  for (int i = 0; i < producer_count; i++) {
+    producer_threads.emplace_back(&DispatcherCoroTest::StartCountedProducerTask,
+                                  this, produce_count);
+  }
+
+  for (int i = 0; i < producer_count; i++) {
+    producer_threads[i].join();
+  }
+  for (int i = 0; i < short_run_consumer_count; i++) {
+    short_run_consumer_threads[i].join();
+  }
+  long_run_consumer_thread.join();
+  EXPECT_EQ(produce_count * producer_count, executed_count_.load());
+}
+
+TEST(CoroutineQueueTest, CoalescedWakeUpTest) {
+  std::atomic<bool> is_consumer_sleeping{false};
+  coro::CoroutineQueue queue(16, 0, 1, -1, coro::ConsumerPolicy::NO_STEALING,
+                             &is_consumer_sleeping);
+  // an awake consumer will find the enqueued items by itself
+  EXPECT_FALSE(queue.TakeWakeUp());
+  // only the first producer notifies a sleeping consumer
+  is_consumer_sleeping = true;
+  EXPECT_TRUE(queue.TakeWakeUp());
+  EXPECT_FALSE(queue.TakeWakeUp());
+  EXPECT_FALSE(is_consumer_sleeping.load());
+}
+
 }  // namespace test
 }  // namespace arc
 
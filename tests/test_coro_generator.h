@@ -0,0 +1,125 @@
+/*
+ * File: test_coro_generator.h
+ * Project: libarc
+ * File Created: Saturday, 17th October 2026 10:02:16 am
+ * Author: Minjun Xu (mjxu96@outlook.com)
+ * -----
+ * MIT License
+ * Copyright (c) 2020 Minjun Xu
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef LIBARC__TESTS__TEST_CORO_GENERATOR_H
+#define LIBARC__TESTS__TEST_CORO_GENERATOR_H
+
+#include <arc/coro/async_generator.h>
+#include <arc/coro/task.h>
+#include <gtest/gtest.h>
+
+#include <string>
+
+namespace arc {
+namespace test {
+
+class GeneratorCoroTest : public ::testing::Test {
+ protected:
+  int produced_count_ = 0;
+
+  coro::Task<int> Square(int i) { co_return i * i; }
+
+  coro::AsyncGenerator<int> Squares(int count) {
+    for (int i = 0; i < count; i++) {
+      if (i % 10 == 0) {
+        co_await coro::Yield();
+      }
+      produced_count_++;
+      co_yield co_await Square(i);
+    }
+  }
+
+  coro::AsyncGenerator<std::string> Lines(int count) {
+    for (int i = 0; i < count; i++) {
+      std::string line = "line " + std::to_string(i);
+      co_yield line;
+    }
+    throw std::logic_error("Error line");
+  }
+
+  coro::Task<void> GeneratorTestCoro() {
+    int sum = 0;
+    auto squares = Squares(100);
+    // nothing is produced before it is asked for
+    EXPECT_EQ(produced_count_, 0);
+    for (auto itr = co_await squares.begin(); itr != squares.end();
+         co_await ++itr) {
+      sum += *itr;
+    }
+    EXPECT_EQ(produced_count_, 100);
+    EXPECT_EQ(sum, 328350);
+  }
+
+  coro::Task<void> GeneratorBreakTestCoro() {
+    {
+      auto squares = Squares(100);
+      for (auto itr = co_await squares.begin(); itr != squares.end();
+           co_await ++itr) {
+        if (*itr == 25) {
+          break;
+        }
+      }
+    }
+    EXPECT_EQ(produced_count_, 6);
+  }
+
+  coro::Task<void> GeneratorExceptionTestCoro() {
+    int count = 0;
+    bool is_thrown = false;
+    auto lines = Lines(3);
+    try {
+      for (auto itr = co_await lines.begin(); itr != lines.end();
+           co_await ++itr) {
+        EXPECT_EQ(*itr, "line " + std::to_string(count));
+        EXPECT_EQ(itr->size(), 6);
+        count++;
+      }
+    } catch (const std::logic_error& err) {
+      is_thrown = true;
+    }
+    EXPECT_TRUE(is_thrown);
+    EXPECT_EQ(count, 3);
+  }
+};
+
+TEST_F(GeneratorCoroTest, GeneratorTest) {
+  coro::StartEventLoop(GeneratorTestCoro());
+}
+
+TEST_F(GeneratorCoroTest, GeneratorBreakTest) {
+  coro::StartEventLoop(GeneratorBreakTestCoro());
+}
+
+TEST_F(GeneratorCoroTest, GeneratorExceptionTest) {
+  coro::StartEventLoop(GeneratorExceptionTestCoro());
+}
+
+}  // namespace test
+}  // namespace arc
+
+#endif
@@ -0,0 +1,439 @@
+/*
+ * File: test_coro_poller.h
+ * Project: libarc
+ * File Created: Friday, 16th October 2026 11:02:15 am
+ * Author: Minjun Xu (mjxu96@outlook.com)
+ * -----
+ * MIT License
+ * Copyright (c) 2020 Minjun Xu
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef LIBARC__TESTS__TEST_CORO_POLLER_H
+#define LIBARC__TESTS__TEST_CORO_POLLER_H
+
+#include <arc/coro/eventloop.h>
+#include <arc/coro/task.h>
+#include <arc/coro/utils/cancellation_token.h>
+#include <arc/io/socket.h>
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <memory>
+#include <thread>
+
+#include "utils.h"
+
+namespace arc {
+namespace test {
+
+template <coro::PollerBackend B>
+class PollerCoroTestTypeTrait {
+ public:
+  constexpr static coro::PollerBackend backend = B;
+};
+
+template <typename T>
+class PollerCoroTest : public ::testing::Test {
+ protected:
+  constexpr static int kSendLength_ = 4096;
+  constexpr static int kRepeatTimes_ = 10;
+  constexpr static int kSleepTime_ = 100;
+  constexpr static int kSubMillisecondSleep_ = 300;
+  float max_allowed_ref_error_ = 0.05;
+  std::uint16_t port_{0};
+  bool is_backend_available_{true};
+
+  virtual void SetUp() override {
+    if (IsRunningWithValgrind()) {
+      max_allowed_ref_error_ = 0.2;
+    }
+  }
+
+  void RunWithBackend(const std::function<coro::Task<void>()>& entry) {
+    coro::EventLoop::SetDefaultPollerBackend(T::backend);
+    std::thread thread([this, &entry]() {
+      is_backend_available_ =
+          (coro::EventLoop::GetLocalInstance().GetPollerBackend() ==
+           T::backend);
+      if (is_backend_available_) {
+        coro::StartEventLoop(entry());
+      }
+    });
+    thread.join();
+    coro::EventLoop::SetDefaultPollerBackend(coro::PollerBackend::EPOLL);
+    if (!is_backend_available_) {
+      GTEST_SKIP() << "Poller backend is not supported on this kernel";
+    }
+  }
+
+  coro::Task<void> SleepTask() {
+    for (int i = 0; i < 3; i++) {
+      auto now = std::chrono::steady_clock::now();
+      co_await coro::SleepFor(std::chrono::milliseconds(kSleepTime_));
+      auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+                         std::chrono::steady_clock::now() - now)
+                         .count();
+      EXPECT_NEAR(elapsed, kSleepTime_, kSleepTime_ * max_allowed_ref_error_);
+    }
+  }
+
+  coro::Task<void> SubMillisecondSleepTask() {
+    auto& event_loop = coro::EventLoop::GetLocalInstance();
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < kRepeatTimes_; i++) {
+      auto now = std::chrono::steady_clock::now();
+      co_await coro::SleepFor(std::chrono::microseconds(kSubMillisecondSleep_));
+      auto loop_now = event_loop.Now();
+      auto after = std::chrono::steady_clock::now();
+      EXPECT_GE(std::chrono::duration_cast<std::chrono::microseconds>(
+                    loop_now - now)
+                    .count(),
+                kSubMillisecondSleep_);
+      EXPECT_LE(loop_now, after);
+    }
+    // loose on purpose, scheduling noise easily adds a millisecond here and
+    // there on a busy machine
+    EXPECT_LT(std::chrono::steady_clock::now() - start,
+              std::chrono::milliseconds(2 * kRepeatTimes_));
+  }
+
+  coro::Task<void> EchoServer(
+      io::Socket<net::Domain::IPV4, net::Protocol::TCP, io::Pattern::ASYNC>
+          conn) {
+    std::unique_ptr<char[]> data(new char[kSendLength_]);
+    while (true) {
+      int recv = co_await conn.Recv(data.get(), kSendLength_);
+      if (recv <= 0) {
+        break;
+      }
+      int sent = 0;
+      while (sent < recv) {
+        sent += co_await conn.Send(data.get() + sent, recv - sent);
+      }
+    }
+  }
+
+  coro::Task<void> EchoClient() {
+    io::Socket<net::Domain::IPV4, net::Protocol::TCP, io::Pattern::ASYNC> conn;
+    co_await conn.Connect({"127.0.0.1", port_});
+    std::string sent_str(kSendLength_, 'a');
+    std::unique_ptr<char[]> data(new char[kSendLength_]);
+    for (int i = 0; i < kRepeatTimes_; i++) {
+      int sent = co_await conn.Send(sent_str.c_str(), sent_str.size());
+      EXPECT_EQ(sent, kSendLength_);
+      std::string received;
+      while (received.size() < sent_str.size()) {
+        int recv = co_await conn.Recv(data.get(), kSendLength_);
+        EXPECT_GT(recv, 0);
+        if (recv <= 0) {
+          co_return;
+        }
+        received.append(data.get(), recv);
+      }
+      EXPECT_EQ(received, sent_str);
+    }
+
+    // nothing will be echoed, so this read must time out
+    auto now = std::chrono::steady_clock::now();
+    int recv = co_await conn.Recv(data.get(), kSendLength_,
+                                  std::chrono::milliseconds(kSleepTime_));
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+                       std::chrono::steady_clock::now() - now)
+                       .count();
+    EXPECT_EQ(recv, -1);
+    EXPECT_NEAR(elapsed, kSleepTime_, kSleepTime_ * max_allowed_ref_error_);
+  }
+
+  coro::Task<void> PartialRecvServer(
+      io::Socket<net::Domain::IPV4, net::Protocol::TCP, io::Pattern::ASYNC>
+          conn) {
+    // the whole message arrives at once but is read one byte at a time, the
+    // rest of it must still be readable without any further readiness change
+    char data = 0;
+    for (int i = 0; i < kSendLength_; i++) {
+      int recv = co_await conn.Recv(&data, 1);
+      EXPECT_EQ(recv, 1);
+      if (recv != 1) {
+        co_return;
+      }
+      EXPECT_EQ(data, 'a');
+    }
+    int sent = co_await conn.Send(&data, 1);
+    EXPECT_EQ(sent, 1);
+  }
+
+  coro::Task<void> PartialRecvClient() {
+    io::Socket<net::Domain::IPV4, net::Protocol::TCP, io::Pattern::ASYNC> conn;
+    co_await conn.Connect({"127.0.0.1", port_});
+    std::string sent_str(kSendLength_, 'a');
+    int sent = co_await conn.Send(sent_str.c_str(), sent_str.size());
+    EXPECT_EQ(sent, kSendLength_);
+    char data = 0;
+    int recv = co_await conn.Recv(&data, 1);
+    EXPECT_EQ(recv, 1);
+  }
+
+  coro::Task<void> PartialRecvTask() {
+    io::Acceptor<net::Domain::IPV4, io::Pattern::ASYNC> acceptor;
+    acceptor.SetOption(net::SocketOption::REUSEADDR, 1);
+    acceptor.Bind({"127.0.0.1", 0});
+    acceptor.Listen();
+    port_ = acceptor.GetLocalAddress().GetPort();
+
+    coro::EnsureFuture(PartialRecvClient());
+    coro::EnsureFuture(PartialRecvServer(co_await acceptor.Accept()));
+  }
+
+  coro::Task<void> AcceptOne(
+      io::Acceptor<net::Domain::IPV4, io::Pattern::ASYNC>* acceptor,
+      int* accepted_count) {
+    auto conn = co_await acceptor->Accept();
+    (*accepted_count)++;
+  }
+
+  coro::Task<void> AcceptAfterRecv(
+      io::Socket<net::Domain::IPV4, net::Protocol::TCP, io::Pattern::ASYNC>*
+          conn,
+      io::Acceptor<net::Domain::IPV4, io::Pattern::ASYNC>* acceptor,
+      int* accepted_count) {
+    char data = 0;
+    EXPECT_EQ(co_await conn->Recv(&data, 1), 1);
+    co_await AcceptOne(acceptor, accepted_count);
+  }
+
+  coro::Task<void> AcceptRaceTask() {
+    io::Acceptor<net::Domain::IPV4, io::Pattern::ASYNC> acceptor;
+    acceptor.SetOption(net::SocketOption::REUSEADDR, 1);
+    acceptor.Bind({"127.0.0.1", 0});
+    acceptor.Listen();
+    port_ = acceptor.GetLocalAddress().GetPort();
+
+    io::Socket<net::Domain::IPV4, net::Protocol::TCP> writer;
+    writer.Connect({"127.0.0.1", port_});
+    auto reader = co_await acceptor.Accept();
+    int accepted_count = 0;
+    coro::EnsureFuture(AcceptOne(&acceptor, &accepted_count));
+    coro::EnsureFuture(AcceptAfterRecv(&reader, &acceptor, &accepted_count));
+    co_await coro::SleepFor(std::chrono::milliseconds(10));
+
+    // Both become ready in the same wait, the reader first. The second
+    // acceptor takes the connection before the waiting one is resumed, which
+    // then finds nothing to accept and has to wait for the next one.
+    writer.Send("a", 1);
+    io::Socket<net::Domain::IPV4, net::Protocol::TCP> first;
+    first.Connect({"127.0.0.1", port_});
+    co_await coro::SleepFor(std::chrono::milliseconds(50));
+    EXPECT_EQ(accepted_count, 1);
+
+    io::Socket<net::Domain::IPV4, net::Protocol::TCP> second;
+    second.Connect({"127.0.0.1", port_});
+    co_await coro::SleepFor(std::chrono::milliseconds(50));
+    EXPECT_EQ(accepted_count, 2);
+  }
+
+  coro::Task<void> CancelLater(coro::CancellationToken token) {
+    co_await coro::SleepFor(std::chrono::milliseconds(10));
+    token.Cancel();
+  }
+
+  coro::Task<void> RecvOne(
+      io::Socket<net::Domain::IPV4, net::Protocol::TCP, io::Pattern::ASYNC>*
+          conn,
+      int* result) {
+    char data = 0;
+    *result = co_await conn->Recv(&data, 1);
+  }
+
+  coro::Task<void> InterruptedRecvTask() {
+    if constexpr (T::backend == coro::PollerBackend::IO_URING) {
+      // so that the recvs below are left to the kernel
+      EXPECT_TRUE(coro::EventLoop::GetLocalInstance().IsCompletionBased());
+    }
+    io::Acceptor<net::Domain::IPV4, io::Pattern::ASYNC> acceptor;
+    acceptor.SetOption(net::SocketOption::REUSEADDR, 1);
+    acceptor.Bind({"127.0.0.1", 0});
+    acceptor.Listen();
+    port_ = acceptor.GetLocalAddress().GetPort();
+
+    io::Socket<net::Domain::IPV4, net::Protocol::TCP> writer;
+    writer.Connect({"127.0.0.1", port_});
+    auto reader = std::make_unique<
+        io::Socket<net::Domain::IPV4, net::Protocol::TCP, io::Pattern::ASYNC>>(
+        co_await acceptor.Accept());
+
+    // neither a timeout nor a cancellation may lose what arrives afterwards
+    char data[4] = {0};
+    int recv = co_await reader->Recv(data, sizeof(data),
+                                     std::chrono::milliseconds(10));
+    EXPECT_EQ(recv, -1);
+    EXPECT_EQ(errno, EAGAIN);
+    coro::CancellationToken token;
+    coro::EnsureFuture(CancelLater(token));
+    recv = co_await reader->Recv(data, sizeof(data), token);
+    EXPECT_EQ(recv, -1);
+    EXPECT_EQ(errno, EAGAIN);
+    writer.Send("abc", 3);
+    recv = co_await reader->Recv(data, sizeof(data));
+    EXPECT_EQ(recv, 3);
+    EXPECT_EQ(std::string(data, std::max(recv, 0)), "abc");
+
+    // closing the socket fails the recv still waiting on it
+    int result = 0;
+    coro::EnsureFuture(RecvOne(reader.get(), &result));
+    co_await coro::SleepFor(std::chrono::milliseconds(10));
+    reader.reset();
+    co_await coro::SleepFor(std::chrono::milliseconds(10));
+    EXPECT_EQ(result, -1);
+  }
+
+  coro::Task<void> EchoTask() {
+    io::Acceptor<net::Domain::IPV4, io::Pattern::ASYNC> acceptor;
+    acceptor.SetOption(net::SocketOption::REUSEADDR, 1);
+    acceptor.Bind({"127.0.0.1", 0});
+    acceptor.Listen();
+    port_ = acceptor.GetLocalAddress().GetPort();
+
+    coro::EnsureFuture(EchoClient());
+    coro::EnsureFuture(EchoServer(co_await acceptor.Accept()));
+  }
+};
+
+using PollerTestTypes = ::testing::Types<
+    PollerCoroTestTypeTrait<coro::PollerBackend::EPOLL>,
+    PollerCoroTestTypeTrait<coro::PollerBackend::IO_URING>,
+    PollerCoroTestTypeTrait<coro::PollerBackend::EPOLL_EDGE_TRIGGERED>>;
+
+TYPED_TEST_CASE(PollerCoroTest, PollerTestTypes);
+
+TYPED_TEST(PollerCoroTest, TimerTest) {
+  this->RunWithBackend([this]() { return this->SleepTask(); });
+}
+
+TYPED_TEST(PollerCoroTest, SubMillisecondTimerTest) {
+  this->RunWithBackend([this]() { return this->SubMillisecondSleepTask(); });
+}
+
+TYPED_TEST(PollerCoroTest, SocketTest) {
+  this->RunWithBackend([this]() { return this->EchoTask(); });
+}
+
+TYPED_TEST(PollerCoroTest, PartialRecvTest) {
+  this->RunWithBackend([this]() { return this->PartialRecvTask(); });
+}
+
+TYPED_TEST(PollerCoroTest, AcceptRaceTest) {
+  this->RunWithBackend([this]() { return this->AcceptRaceTask(); });
+}
+
+TYPED_TEST(PollerCoroTest, InterruptedRecvTest) {
+  this->RunWithBackend([this]() { return this->InterruptedRecvTask(); });
+}
+
+class TimerWheelTest : public ::testing::Test {
+ protected:
+  constexpr static std::int64_t kStartTime_ = 1000;
+
+  std::vector<std::unique_ptr<coro::TimeEvent>> events_;
+
+  coro::TimeEvent* NewEvent(std::int64_t wakeup_time) {
+    events_.emplace_back(new coro::TimeEvent(wakeup_time, nullptr));
+    return events_.back().get();
+  }
+
+  std::vector<std::int64_t> PopExpired(coro::detail::TimerWheel& wheel,
+                                       std::int64_t current_time) {
+    coro::TimeEvent* expired[16];
+    std::vector<std::int64_t> ret;
+    int cnt = wheel.PopExpired(current_time, expired, 16);
+    for (int i = 0; i < cnt; i++) {
+      ret.push_back(expired[i]->GetWakeupTime());
+    }
+    std::sort(ret.begin(), ret.end());
+    return ret;
+  }
+
+  coro::Task<void> MultipleSleepTask() {
+    std::vector<int> wakeup_order;
+    auto sleep = [&wakeup_order](int milliseconds) -> coro::Task<void> {
+      co_await coro::SleepFor(std::chrono::milliseconds(milliseconds));
+      wakeup_order.push_back(milliseconds);
+    };
+    coro::EnsureFuture(sleep(300));
+    coro::EnsureFuture(sleep(10));
+    coro::EnsureFuture(sleep(257));
+    coro::EnsureFuture(sleep(100));
+    co_await coro::SleepFor(std::chrono::milliseconds(350));
+    EXPECT_EQ(wakeup_order, (std::vector<int>{10, 100, 257, 300}));
+  }
+};
+
+TEST_F(TimerWheelTest, ExpireTest) {
+  coro::detail::TimerWheel wheel(kStartTime_);
+  EXPECT_EQ(wheel.GetNextExpireTime(), -1);
+
+  // spread over all the levels, including a parked far away one
+  std::vector<std::int64_t> delays{0, 1, 255, 256, 300, 70000, 1LL << 33};
+  for (auto delay : delays) {
+    wheel.Add(NewEvent(kStartTime_ + delay));
+  }
+  auto removed = NewEvent(kStartTime_ + 280);
+  wheel.Add(removed);
+  EXPECT_EQ(wheel.Size(), delays.size() + 1);
+  EXPECT_EQ(wheel.GetNextExpireTime(), kStartTime_);
+
+  EXPECT_EQ(PopExpired(wheel, kStartTime_),
+            (std::vector<std::int64_t>{kStartTime_}));
+  EXPECT_EQ(wheel.GetNextExpireTime(), kStartTime_ + 1);
+  EXPECT_EQ(PopExpired(wheel, kStartTime_ + 255),
+            (std::vector<std::int64_t>{kStartTime_ + 1, kStartTime_ + 255}));
+
+  wheel.Remove(removed);
+  wheel.Remove(removed);
+  EXPECT_EQ(wheel.Size(), 4);
+  EXPECT_EQ(PopExpired(wheel, kStartTime_ + 299),
+            (std::vector<std::int64_t>{kStartTime_ + 256}));
+  EXPECT_EQ(PopExpired(wheel, kStartTime_ + 69999),
+            (std::vector<std::int64_t>{kStartTime_ + 300}));
+  EXPECT_LE(wheel.GetNextExpireTime(), kStartTime_ + 70000);
+  EXPECT_EQ(PopExpired(wheel, kStartTime_ + 70000),
+            (std::vector<std::int64_t>{kStartTime_ + 70000}));
+
+  EXPECT_EQ(PopExpired(wheel, kStartTime_ + (1LL << 33) - 1).size(), 0);
+  EXPECT_EQ(PopExpired(wheel, kStartTime_ + (1LL << 33)),
+            (std::vector<std::int64_t>{kStartTime_ + (1LL << 33)}));
+  EXPECT_TRUE(wheel.Empty());
+}
+
+TEST_F(TimerWheelTest, EventLoopTest) {
+  coro::EventLoop::SetDefaultTimerBackend(coro::TimerBackend::TIMER_WHEEL);
+  std::thread thread([this]() {
+    EXPECT_EQ(coro::EventLoop::GetLocalInstance().GetTimerBackend(),
+              coro::TimerBackend::TIMER_WHEEL);
+    coro::StartEventLoop(MultipleSleepTask());
+  });
+  thread.join();
+  coro::EventLoop::SetDefaultTimerBackend(coro::TimerBackend::PRIORITY_QUEUE);
+}
+
+}  // namespace test
+}  // namespace arc
+
+#endif
@@ -246,6 +246,128 @@ TYPED_TEST(SocketCoroTest, BasicSocketTest) {
   coro::StartEventLoop(this->Accept());
 }
 
+coro::Task<void> SendVClient(std::uint16_t port,
+                             std::vector<std::string> parts) {
+  io::Socket<net::Domain::IPV4, net::Protocol::TCP, io::Pattern::ASYNC> sock;
+  co_await sock.Connect({"localhost", port});
+  std::vector<iovec> iov;
+  for (auto& part : parts) {
+    iov.push_back({part.data(), part.size()});
+  }
+  int sent = co_await sock.SendV(iov.data(), iov.size());
+  EXPECT_GT(sent, 0);
+}
+
+coro::Task<void> SendVAccept() {
+  std::vector<std::string> parts = {"GET / HTTP/1.1\r\n", "",
+                                    std::string(4096, 'b'), "end"};
+  io::Acceptor<net::Domain::IPV4, io::Pattern::ASYNC> acceptor;
+  acceptor.SetOption(arc::net::SocketOption::REUSEADDR, 1);
+  acceptor.Bind({"localhost", 0});
+  acceptor.Listen();
+  coro::EnsureFuture(SendVClient(acceptor.GetLocalAddress().GetPort(), parts));
+
+  auto in_sock = co_await acceptor.Accept();
+  std::string received;
+  char data[1024];
+  while (true) {
+    auto recv = co_await in_sock.Recv(data, sizeof(data));
+    if (recv <= 0) {
+      break;
+    }
+    received.append(data, recv);
+  }
+  std::string expected;
+  for (const auto& part : parts) {
+    expected += part;
+  }
+  EXPECT_EQ(received, expected);
+}
+
+TEST(SocketSendVCoroTest, GatherTest) { coro::StartEventLoop(SendVAccept()); }
+
+coro::Task<void> DatagramTest() {
+  using UdpSocket =
+      io::Socket<net::Domain::IPV4, net::Protocol::UDP, io::Pattern::ASYNC>;
+  UdpSocket receiver;
+  receiver.Bind({"127.0.0.1", 0});
+  auto receiver_addr = receiver.GetLocalAddress();
+  UdpSocket sender;
+  sender.Bind({"127.0.0.1", 0});
+  auto sender_port = sender.GetLocalAddress().GetPort();
+
+  // one at a time
+  std::string message = "ping";
+  int sent = co_await sender.SendTo(message.data(), message.size(),
+                                    receiver_addr);
+  EXPECT_EQ(sent, message.size());
+  char buf[512];
+  net::Address<net::Domain::IPV4> from;
+  int received = co_await receiver.RecvFrom(buf, sizeof(buf), from);
+  EXPECT_EQ(std::string(buf, received), message);
+  EXPECT_EQ(from.GetPort(), sender_port);
+
+  // batched
+  const int kBatchSize = 8;
+  std::vector<std::string> messages;
+  for (int i = 0; i < kBatchSize; i++) {
+    messages.push_back("message " + std::to_string(i));
+  }
+  // pointers are taken once the vector does not move the strings any more
+  std::vector<io::Datagram<net::Domain::IPV4>> datagrams(kBatchSize);
+  for (int i = 0; i < kBatchSize; i++) {
+    datagrams[i].data = messages[i].data();
+    datagrams[i].size = messages[i].size();
+    datagrams[i].addr = receiver_addr;
+  }
+  sent = co_await sender.SendBatch(datagrams.data(), kBatchSize);
+  EXPECT_EQ(sent, kBatchSize);
+  std::vector<std::string> buffers(kBatchSize, std::string(64, '\0'));
+  for (int i = 0; i < kBatchSize; i++) {
+    datagrams[i] = {};
+    datagrams[i].data = buffers[i].data();
+    datagrams[i].capacity = buffers[i].size();
+  }
+  int total = 0;
+  while (total < kBatchSize) {
+    received = co_await receiver.RecvBatch(datagrams.data() + total,
+                                           kBatchSize - total);
+    EXPECT_GT(received, 0);
+    if (received <= 0) {
+      co_return;
+    }
+    total += received;
+  }
+  for (int i = 0; i < kBatchSize; i++) {
+    EXPECT_EQ(std::string(datagrams[i].data, datagrams[i].size), messages[i]);
+    EXPECT_EQ(datagrams[i].addr.GetPort(), sender_port);
+  }
+
+  // split by the kernel into segments of 100 bytes
+  std::string large(350, 'c');
+  io::Datagram<net::Domain::IPV4> segmented;
+  segmented.data = large.data();
+  segmented.size = large.size();
+  segmented.addr = receiver_addr;
+  segmented.segment_size = 100;
+  sent = co_await sender.SendBatch(&segmented, 1);
+  EXPECT_EQ(sent, 1);
+  std::vector<std::size_t> sizes;
+  while (sizes.size() < 4) {
+    received = co_await receiver.RecvFrom(buf, sizeof(buf), from);
+    EXPECT_GT(received, 0);
+    if (received <= 0) {
+      co_return;
+    }
+    sizes.push_back(received);
+  }
+  EXPECT_EQ(sizes, std::vector<std::size_t>({100, 100, 100, 50}));
+}
+
+TEST(SocketDatagramCoroTest, BatchTest) {
+  coro::StartEventLoop(DatagramTest());
+}
+
 }  // namespace test
 }  // namespace arc
 
@@ -0,0 +1,178 @@
+/*
+ * File: test_coro_task_group.h
+ * Project: libarc
+ * File Created: Saturday, 17th October 2026 9:14:52 am
+ * Author: Minjun Xu (mjxu96@outlook.com)
+ * -----
+ * MIT License
+ * Copyright (c) 2020 Minjun Xu
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef LIBARC__TESTS__TEST_CORO_TASK_GROUP_H
+#define LIBARC__TESTS__TEST_CORO_TASK_GROUP_H
+
+#include <arc/coro/locks/condition.h>
+#include <arc/coro/task_group.h>
+#include <gtest/gtest.h>
+
+#include "utils.h"
+
+namespace arc {
+namespace test {
+
+class TaskGroupCoroTest : public ::testing::Test {
+ protected:
+  float max_allowed_ref_error_ = 0.5;
+  int step_milliseconds_ = 100;
+  int finished_count_ = 0;
+  coro::Condition cond_;
+
+  virtual void SetUp() override {
+    if (IsRunningWithValgrind()) {
+      max_allowed_ref_error_ = 10;
+    }
+  }
+
+  std::int64_t ElapsedSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+               std::chrono::steady_clock::now() - start)
+        .count();
+  }
+
+  coro::Task<int> SleepAndReturn(int steps) {
+    co_await coro::SleepFor(
+        std::chrono::milliseconds(steps * step_milliseconds_));
+    finished_count_++;
+    co_return steps;
+  }
+
+  coro::Task<void> Sleep(int steps) { co_await SleepAndReturn(steps); }
+
+  coro::Task<void> SleepAndThrow(int steps) {
+    co_await coro::SleepFor(
+        std::chrono::milliseconds(steps * step_milliseconds_));
+    finished_count_++;
+    throw std::logic_error("Error sleep");
+  }
+
+  coro::Task<int> WaitUntilCancelled(coro::CancellationToken token) {
+    co_await cond_.Wait(token);
+    finished_count_++;
+    co_return -1;
+  }
+
+  coro::Task<void> WaitUntilCancelledVoid(coro::CancellationToken token) {
+    co_await WaitUntilCancelled(token);
+  }
+
+  coro::Task<void> WhenAllTestCoro() {
+    auto start = std::chrono::steady_clock::now();
+    auto [first, second, third] =
+        co_await coro::WhenAll(SleepAndReturn(3), SleepAndReturn(1), Sleep(2));
+    // the tasks run concurrently, so it takes as long as the slowest one
+    EXPECT_NEAR(ElapsedSince(start), 3 * step_milliseconds_,
+                3 * step_milliseconds_ * max_allowed_ref_error_);
+    EXPECT_EQ(first, 3);
+    EXPECT_EQ(second, 1);
+    EXPECT_EQ(finished_count_, 3);
+
+    std::vector<coro::Task<int>> tasks;
+    for (int i = 1; i <= 3; i++) {
+      tasks.push_back(SleepAndReturn(i));
+    }
+    auto results = co_await coro::WhenAll(std::move(tasks));
+    EXPECT_EQ(results, std::vector<int>({1, 2, 3}));
+  }
+
+  coro::Task<void> WhenAllExceptionTestCoro() {
+    bool is_thrown = false;
+    try {
+      co_await coro::WhenAll(SleepAndThrow(1), SleepAndReturn(2));
+    } catch (const std::logic_error& err) {
+      is_thrown = true;
+    }
+    EXPECT_TRUE(is_thrown);
+    // the failure is only reported after all tasks have finished
+    EXPECT_EQ(finished_count_, 2);
+  }
+
+  coro::Task<void> WhenAnyTestCoro() {
+    auto start = std::chrono::steady_clock::now();
+    coro::CancellationToken token;
+    auto [index, result] = co_await coro::WhenAny(
+        token, WaitUntilCancelled(token), SleepAndReturn(1),
+        WaitUntilCancelled(token));
+    EXPECT_NEAR(ElapsedSince(start), step_milliseconds_,
+                step_milliseconds_ * max_allowed_ref_error_);
+    EXPECT_EQ(index, 1);
+    EXPECT_EQ(result, 1);
+    // the losers are cancelled and finish in the next loop iterations
+    co_await coro::SleepFor(std::chrono::milliseconds(step_milliseconds_));
+    EXPECT_EQ(finished_count_, 3);
+  }
+
+  coro::Task<void> TaskGroupTestCoro() {
+    auto start = std::chrono::steady_clock::now();
+    coro::TaskGroup group;
+    for (int i = 0; i < 10; i++) {
+      group.Spawn(Sleep(1));
+    }
+    group.Spawn(Sleep(2));
+    co_await group.Join();
+    EXPECT_NEAR(ElapsedSince(start), 2 * step_milliseconds_,
+                2 * step_milliseconds_ * max_allowed_ref_error_);
+    EXPECT_EQ(finished_count_, 11);
+
+    // a failed task cancels the others in the group
+    group.Spawn(WaitUntilCancelledVoid(group.GetCancellationToken()));
+    group.Spawn(SleepAndThrow(1));
+    bool is_thrown = false;
+    try {
+      co_await group.Join();
+    } catch (const std::logic_error& err) {
+      is_thrown = true;
+    }
+    EXPECT_TRUE(is_thrown);
+    EXPECT_EQ(finished_count_, 13);
+  }
+
+};
+
+TEST_F(TaskGroupCoroTest, WhenAllTest) {
+  coro::StartEventLoop(WhenAllTestCoro());
+}
+
+TEST_F(TaskGroupCoroTest, WhenAllExceptionTest) {
+  coro::StartEventLoop(WhenAllExceptionTestCoro());
+}
+
+TEST_F(TaskGroupCoroTest, WhenAnyTest) {
+  coro::StartEventLoop(WhenAnyTestCoro());
+}
+
+TEST_F(TaskGroupCoroTest, TaskGroupTest) {
+  coro::StartEventLoop(TaskGroupTestCoro());
+}
+
+}  // namespace test
+}  // namespace arc
+
+#endif
@@ -0,0 +1,432 @@
+/*
+ * File: test_http_h2c.h
+ * Project: libarc
+ * File Created: Sunday, 18th October 2026 10:48:05 am
+ * Author: Minjun Xu (mjxu96@outlook.com)
+ * -----
+ * MIT License
+ * Copyright (c) 2020 Minjun Xu
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef LIBARC__TESTS__TEST_HTTP_H2C_H
+#define LIBARC__TESTS__TEST_HTTP_H2C_H
+
+#include <arc/coro/eventloop.h>
+#include <arc/coro/task.h>
+#include <arc/http/http2.h>
+#include <arc/http/http_server.h>
+#include <arc/io/socket.h>
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+#include "utils.h"
+
+namespace arc {
+namespace test {
+
+using Http2TestSocket =
+    io::Socket<net::Domain::IPV4, net::Protocol::TCP, io::Pattern::ASYNC>;
+
+struct Http2TestFrame {
+  http::detail::Http2FrameHeader header;
+  std::string payload;
+};
+
+std::string MakeHttp2Frame(http::detail::Http2FrameType type,
+                           std::uint8_t flags, std::uint32_t stream_id,
+                           std::string_view payload) {
+  char head[http::detail::kHttp2FrameHeaderSize];
+  http::detail::WriteHttp2FrameHeader(
+      {static_cast<std::uint32_t>(payload.size()), type, flags, stream_id},
+      head);
+  return std::string(head, sizeof(head)).append(payload);
+}
+
+// the next whole frame, std::nullopt if none arrives within the timeout
+coro::Task<std::optional<Http2TestFrame>> ReadHttp2Frame(
+    Http2TestSocket* socket, std::string* buffer,
+    std::chrono::milliseconds timeout = std::chrono::milliseconds(2000)) {
+  while (true) {
+    if (buffer->size() >= http::detail::kHttp2FrameHeaderSize) {
+      Http2TestFrame frame;
+      http::detail::ParseHttp2FrameHeader(buffer->data(), &frame.header);
+      std::size_t frame_size =
+          http::detail::kHttp2FrameHeaderSize + frame.header.length;
+      if (buffer->size() >= frame_size) {
+        frame.payload = buffer->substr(http::detail::kHttp2FrameHeaderSize,
+                                       frame.header.length);
+        buffer->erase(0, frame_size);
+        co_return frame;
+      }
+    }
+    char data[4096];
+    auto recv = co_await socket->Recv(data, sizeof(data), timeout);
+    if (recv <= 0) {
+      co_return std::nullopt;
+    }
+    buffer->append(data, recv);
+  }
+}
+
+coro::Task<void> ServeHttp2(
+    http::HttpServer* server,
+    io::Acceptor<net::Domain::IPV4, io::Pattern::ASYNC>* acceptor) {
+  auto socket = co_await acceptor->Accept();
+  // the connection takes over after the preface, like HttpServer does with
+  // the bytes it has read while looking for one
+  std::string received;
+  while (received.size() < http::detail::kHttp2Preface.size()) {
+    char data[4096];
+    auto recv = co_await socket.Recv(data, sizeof(data));
+    if (recv <= 0) {
+      break;
+    }
+    received.append(data, recv);
+  }
+  EXPECT_TRUE(received.starts_with(http::detail::kHttp2Preface));
+  if (!received.starts_with(http::detail::kHttp2Preface)) {
+    co_return;
+  }
+  auto connection = std::make_shared<http::detail::Http2Connection>(
+      server, std::move(socket),
+      std::string_view(received).substr(http::detail::kHttp2Preface.size()));
+  co_await connection->Run();
+}
+
+coro::Task<void> Http2PriorKnowledgeTest() {
+  const std::string kBody(100, 'b');
+  http::HttpServer server;
+  server.RegisterHandler(
+      "/body", http::HttpMethod::HTTP_GET,
+      [&kBody](const http::HttpRequest* request, http::HttpResponse* response,
+               const http::Context* context) -> coro::Task<void> {
+        EXPECT_EQ(request->http_major_version, 2);
+        EXPECT_EQ(request->headers.Get("host"), "localhost");
+        response->headers["X-Test"] = "yes";
+        response->body = kBody;
+        co_return;
+      });
+  io::Acceptor<net::Domain::IPV4, io::Pattern::ASYNC> acceptor;
+  acceptor.SetOption(arc::net::SocketOption::REUSEADDR, 1);
+  acceptor.Bind({"localhost", 0});
+  acceptor.Listen();
+  coro::EnsureFuture(ServeHttp2(&server, &acceptor));
+
+  Http2TestSocket socket;
+  co_await socket.Connect({"localhost", acceptor.GetLocalAddress().GetPort()});
+  // a stream window of 10 bytes holds the body back after its first bytes
+  std::string settings = FromHex("0004 0000 000a");
+  http::HpackEncoder encoder;
+  std::string block;
+  encoder.BeginBlock(&block);
+  encoder.Encode(":method", "GET", &block);
+  encoder.Encode(":scheme", "http", &block);
+  encoder.Encode(":path", "/body", &block);
+  encoder.Encode(":authority", "localhost", &block);
+  std::string request =
+      std::string(http::detail::kHttp2Preface) +
+      MakeHttp2Frame(http::detail::Http2FrameType::SETTINGS, 0, 0, settings) +
+      MakeHttp2Frame(http::detail::Http2FrameType::HEADERS, 0x5U, 1, block);
+  EXPECT_EQ(co_await socket.Send(request.data(), request.size()),
+            request.size());
+
+  std::string buffer;
+  bool is_settings_received = false;
+  bool is_settings_acked = false;
+  std::string received_body;
+  http::HpackDecoder decoder;
+  while (received_body.empty()) {
+    auto frame = co_await ReadHttp2Frame(&socket, &buffer);
+    EXPECT_TRUE(frame.has_value());
+    if (!frame) {
+      co_return;
+    }
+    switch (frame->header.type) {
+      case http::detail::Http2FrameType::SETTINGS:
+        if (frame->header.flags & 0x1U) {
+          is_settings_acked = true;
+        } else {
+          // the server speaks first
+          EXPECT_FALSE(is_settings_acked);
+          is_settings_received = true;
+        }
+        break;
+      case http::detail::Http2FrameType::HEADERS: {
+        EXPECT_EQ(frame->header.stream_id, 1);
+        EXPECT_TRUE(frame->header.flags & 0x4U);
+        std::unordered_map<std::string, std::string> fields;
+        EXPECT_TRUE(decoder.Decode(
+            frame->payload,
+            [&fields](std::string_view name, std::string_view value) {
+              fields.emplace(name, value);
+            }));
+        EXPECT_EQ(fields[":status"], "200");
+        EXPECT_EQ(fields["x-test"], "yes");
+        EXPECT_EQ(fields["content-length"], "100");
+        break;
+      }
+      case http::detail::Http2FrameType::DATA:
+        EXPECT_EQ(frame->header.stream_id, 1);
+        EXPECT_EQ(frame->header.length, 10);
+        EXPECT_FALSE(frame->header.flags & 0x1U);
+        received_body = frame->payload;
+        break;
+      default:
+        break;
+    }
+  }
+  EXPECT_TRUE(is_settings_received);
+  EXPECT_TRUE(is_settings_acked);
+
+  // nothing more until the window is opened
+  auto frame = co_await ReadHttp2Frame(&socket, &buffer,
+                                       std::chrono::milliseconds(100));
+  EXPECT_FALSE(frame.has_value());
+  std::string window_update = MakeHttp2Frame(
+      http::detail::Http2FrameType::WINDOW_UPDATE, 0, 1, FromHex("0000 1000"));
+  EXPECT_EQ(co_await socket.Send(window_update.data(), window_update.size()),
+            window_update.size());
+  bool is_end_stream = false;
+  while (!is_end_stream) {
+    frame = co_await ReadHttp2Frame(&socket, &buffer);
+    EXPECT_TRUE(frame.has_value());
+    if (!frame) {
+      co_return;
+    }
+    EXPECT_EQ(frame->header.type, http::detail::Http2FrameType::DATA);
+    received_body += frame->payload;
+    is_end_stream = frame->header.flags & 0x1U;
+  }
+  EXPECT_EQ(received_body, kBody);
+}
+
+coro::Task<void> Http2HeadWriterTest() {
+  http::HttpServer server;
+  server.RegisterHandler(
+      "/stream", http::HttpMethod::HTTP_HEAD,
+      [](const http::HttpRequest* request, http::HttpResponse* response,
+         const http::Context* context) -> coro::Task<void> {
+        EXPECT_TRUE(co_await context->writer->Write("hello"));
+      });
+  io::Acceptor<net::Domain::IPV4, io::Pattern::ASYNC> acceptor;
+  acceptor.SetOption(arc::net::SocketOption::REUSEADDR, 1);
+  acceptor.Bind({"localhost", 0});
+  acceptor.Listen();
+  coro::EnsureFuture(ServeHttp2(&server, &acceptor));
+
+  Http2TestSocket socket;
+  co_await socket.Connect({"localhost", acceptor.GetLocalAddress().GetPort()});
+  http::HpackEncoder encoder;
+  std::string block;
+  encoder.BeginBlock(&block);
+  encoder.Encode(":method", "HEAD", &block);
+  encoder.Encode(":scheme", "http", &block);
+  encoder.Encode(":path", "/stream", &block);
+  encoder.Encode(":authority", "localhost", &block);
+  std::string request =
+      std::string(http::detail::kHttp2Preface) +
+      MakeHttp2Frame(http::detail::Http2FrameType::SETTINGS, 0, 0, "") +
+      MakeHttp2Frame(http::detail::Http2FrameType::HEADERS, 0x5U, 1, block);
+  EXPECT_EQ(co_await socket.Send(request.data(), request.size()),
+            request.size());
+
+  // the stream ends with the headers, what the handler writes is dropped
+  std::string buffer;
+  bool is_headers_received = false;
+  while (true) {
+    auto frame = co_await ReadHttp2Frame(&socket, &buffer,
+                                         std::chrono::milliseconds(200));
+    if (!frame) {
+      break;
+    }
+    EXPECT_NE(frame->header.type, http::detail::Http2FrameType::DATA);
+    EXPECT_NE(frame->header.type, http::detail::Http2FrameType::RST_STREAM);
+    if (frame->header.type == http::detail::Http2FrameType::HEADERS) {
+      EXPECT_EQ(frame->header.stream_id, 1);
+      EXPECT_TRUE(frame->header.flags & 0x1U);
+      is_headers_received = true;
+    }
+  }
+  EXPECT_TRUE(is_headers_received);
+}
+
+coro::Task<void> Http2HeaderListSizeTest() {
+  http::HttpServer server;
+  io::Acceptor<net::Domain::IPV4, io::Pattern::ASYNC> acceptor;
+  acceptor.SetOption(arc::net::SocketOption::REUSEADDR, 1);
+  acceptor.Bind({"localhost", 0});
+  acceptor.Listen();
+  coro::EnsureFuture(ServeHttp2(&server, &acceptor));
+
+  Http2TestSocket socket;
+  co_await socket.Connect({"localhost", acceptor.GetLocalAddress().GetPort()});
+  http::HpackEncoder encoder;
+  std::string block;
+  encoder.BeginBlock(&block);
+  encoder.Encode(":method", "GET", &block);
+  encoder.Encode(":scheme", "http", &block);
+  encoder.Encode(":path", "/", &block);
+  // a field of 4000 bytes added to the table, then referred to by its index
+  // 16 more times in a block of about 4 KiB
+  block += FromHex("4006") + "x-bomb" + FromHex("7fa11e") +
+           std::string(4000, 'b');
+  block += std::string(16, '\xBE');
+  std::string request =
+      std::string(http::detail::kHttp2Preface) +
+      MakeHttp2Frame(http::detail::Http2FrameType::SETTINGS, 0, 0, "") +
+      MakeHttp2Frame(http::detail::Http2FrameType::HEADERS, 0x5U, 1, block);
+  EXPECT_EQ(co_await socket.Send(request.data(), request.size()),
+            request.size());
+
+  std::string buffer;
+  bool is_limit_advertised = false;
+  while (true) {
+    auto frame = co_await ReadHttp2Frame(&socket, &buffer);
+    EXPECT_TRUE(frame.has_value());
+    if (!frame) {
+      co_return;
+    }
+    if (frame->header.type == http::detail::Http2FrameType::SETTINGS &&
+        (frame->header.flags & 0x1U) == 0) {
+      is_limit_advertised =
+          frame->payload.find(FromHex("0006 0001 0000")) != std::string::npos;
+    }
+    EXPECT_NE(frame->header.type, http::detail::Http2FrameType::HEADERS);
+    if (frame->header.type == http::detail::Http2FrameType::GOAWAY) {
+      EXPECT_EQ(frame->payload, FromHex("0000 0001 0000 000b"));
+      break;
+    }
+  }
+  EXPECT_TRUE(is_limit_advertised);
+}
+
+// opens stream_num streams from stream_id on, each reset right after its
+// request, in batches with a pause in between
+coro::Task<void> SendHttp2ResetStreams(Http2TestSocket* socket,
+                                       http::HpackEncoder* encoder,
+                                       std::uint32_t stream_id,
+                                       int stream_num, int batch_size,
+                                       std::chrono::milliseconds pause) {
+  std::string frames;
+  for (int i = 0; i < stream_num; i++) {
+    std::string block;
+    encoder->BeginBlock(&block);
+    encoder->Encode(":method", "GET", &block);
+    encoder->Encode(":scheme", "http", &block);
+    encoder->Encode(":path", "/slow", &block);
+    frames += MakeHttp2Frame(http::detail::Http2FrameType::HEADERS, 0x5U,
+                             stream_id, block);
+    frames += MakeHttp2Frame(http::detail::Http2FrameType::RST_STREAM, 0,
+                             stream_id, FromHex("0000 0008"));
+    stream_id += 2;
+    if ((i + 1) % batch_size == 0 || i + 1 == stream_num) {
+      EXPECT_EQ(co_await socket->Send(frames.data(), frames.size()),
+                frames.size());
+      frames.clear();
+      co_await coro::SleepFor(pause);
+    }
+  }
+}
+
+coro::Task<void> Http2RapidResetTest(std::chrono::milliseconds handler_time,
+                                     int stream_num, int batch_size,
+                                     int* refused_num, bool* is_calmed) {
+  http::HttpServer server;
+  server.RegisterHandler(
+      "/slow", http::HttpMethod::HTTP_GET,
+      [handler_time](const http::HttpRequest* request,
+                     http::HttpResponse* response,
+                     const http::Context* context) -> coro::Task<void> {
+        co_await coro::SleepFor(handler_time);
+      });
+  io::Acceptor<net::Domain::IPV4, io::Pattern::ASYNC> acceptor;
+  acceptor.SetOption(arc::net::SocketOption::REUSEADDR, 1);
+  acceptor.Bind({"localhost", 0});
+  acceptor.Listen();
+  coro::EnsureFuture(ServeHttp2(&server, &acceptor));
+
+  Http2TestSocket socket;
+  co_await socket.Connect({"localhost", acceptor.GetLocalAddress().GetPort()});
+  std::string preface =
+      std::string(http::detail::kHttp2Preface) +
+      MakeHttp2Frame(http::detail::Http2FrameType::SETTINGS, 0, 0, "");
+  EXPECT_EQ(co_await socket.Send(preface.data(), preface.size()),
+            preface.size());
+  http::HpackEncoder encoder;
+  co_await SendHttp2ResetStreams(&socket, &encoder, 1, stream_num, batch_size,
+                                 handler_time * 4);
+
+  std::string buffer;
+  while (true) {
+    auto frame = co_await ReadHttp2Frame(&socket, &buffer,
+                                         std::chrono::milliseconds(200));
+    if (!frame) {
+      break;
+    }
+    EXPECT_NE(frame->header.type, http::detail::Http2FrameType::HEADERS);
+    if (frame->header.type == http::detail::Http2FrameType::RST_STREAM &&
+        frame->payload == FromHex("0000 0007")) {
+      (*refused_num)++;
+    } else if (frame->header.type == http::detail::Http2FrameType::GOAWAY) {
+      *is_calmed = frame->payload.ends_with(FromHex("0000 000b"));
+      break;
+    }
+  }
+}
+
+TEST(Http2Test, PriorKnowledgeTest) {
+  coro::StartEventLoop(Http2PriorKnowledgeTest());
+}
+
+TEST(Http2Test, HeadWriterTest) {
+  coro::StartEventLoop(Http2HeadWriterTest());
+}
+
+TEST(Http2Test, HeaderListSizeTest) {
+  coro::StartEventLoop(Http2HeaderListSizeTest());
+}
+
+TEST(Http2Test, RapidResetTest) {
+  // the handlers of reset streams still count as open
+  int refused_num = 0;
+  bool is_calmed = false;
+  coro::StartEventLoop(Http2RapidResetTest(std::chrono::milliseconds(300),
+                                           150, 150, &refused_num,
+                                           &is_calmed));
+  EXPECT_EQ(refused_num, 50);
+  EXPECT_FALSE(is_calmed);
+
+  // resetting too many of them too fast fails the connection
+  refused_num = 0;
+  coro::StartEventLoop(Http2RapidResetTest(std::chrono::milliseconds(5), 220,
+                                           50, &refused_num, &is_calmed));
+  EXPECT_EQ(refused_num, 0);
+  EXPECT_TRUE(is_calmed);
+}
+
+}  // namespace test
+}  // namespace arc
+
+#endif
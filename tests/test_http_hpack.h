@@ -0,0 +1,248 @@
+/*
+ * File: test_http_hpack.h
+ * Project: libarc
+ * File Created: Sunday, 18th October 2026 10:12:40 am
+ * Author: Minjun Xu (mjxu96@outlook.com)
+ * -----
+ * MIT License
+ * Copyright (c) 2020 Minjun Xu
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef LIBARC__TESTS__TEST_HTTP_HPACK_H
+#define LIBARC__TESTS__TEST_HTTP_HPACK_H
+
+#include <arc/http/hpack.h>
+#include <gtest/gtest.h>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "utils.h"
+
+namespace arc {
+namespace test {
+
+using HpackFields = std::vector<std::pair<std::string, std::string>>;
+
+HpackFields DecodeHpackBlock(http::HpackDecoder* decoder,
+                             const std::string& block, bool* is_decoded) {
+  HpackFields fields;
+  *is_decoded = decoder->Decode(
+      block, [&fields](std::string_view name, std::string_view value) {
+        fields.emplace_back(name, value);
+      });
+  return fields;
+}
+
+// RFC 7541 C.1
+TEST(HpackTest, IntegerTest) {
+  std::string out;
+  http::detail::EncodeHpackInteger(10, 5, 0, &out);
+  EXPECT_EQ(out, FromHex("0a"));
+  out.clear();
+  http::detail::EncodeHpackInteger(1337, 5, 0, &out);
+  EXPECT_EQ(out, FromHex("1f 9a 0a"));
+  out.clear();
+  http::detail::EncodeHpackInteger(42, 8, 0, &out);
+  EXPECT_EQ(out, FromHex("2a"));
+
+  std::string encoded = FromHex("1f 9a 0a");
+  std::string_view data = encoded;
+  std::uint64_t value = 0;
+  EXPECT_TRUE(http::detail::DecodeHpackInteger(&data, 5, &value));
+  EXPECT_EQ(value, 1337);
+  EXPECT_TRUE(data.empty());
+
+  // the continuation never ends
+  encoded = FromHex("1f 9a");
+  data = encoded;
+  EXPECT_FALSE(http::detail::DecodeHpackInteger(&data, 5, &value));
+}
+
+TEST(HpackTest, HuffmanTest) {
+  std::string encoded;
+  http::detail::EncodeHuffman("www.example.com", &encoded);
+  EXPECT_EQ(encoded, FromHex("f1e3 c2e5 f23a 6ba0 ab90 f4ff"));
+  EXPECT_EQ(http::detail::GetHuffmanEncodedSize("www.example.com"),
+            encoded.size());
+  std::string decoded;
+  EXPECT_TRUE(http::detail::DecodeHuffman(encoded, &decoded));
+  EXPECT_EQ(decoded, "www.example.com");
+
+  // all 256 octets through the code and back
+  std::string octets;
+  for (int i = 0; i < 256; i++) {
+    octets.push_back(static_cast<char>(i));
+  }
+  encoded.clear();
+  decoded.clear();
+  http::detail::EncodeHuffman(octets, &encoded);
+  EXPECT_TRUE(http::detail::DecodeHuffman(encoded, &decoded));
+  EXPECT_EQ(decoded, octets);
+
+  // padding longer than 7 bits, and padding which is not all ones
+  decoded.clear();
+  EXPECT_FALSE(
+      http::detail::DecodeHuffman(FromHex("f1e3 c2e5 f23a 6ba0 ab90 f4ff ff"),
+                                  &decoded));
+  decoded.clear();
+  EXPECT_FALSE(http::detail::DecodeHuffman(
+      FromHex("f1e3 c2e5 f23a 6ba0 ab90 f4fe"), &decoded));
+}
+
+// RFC 7541 C.4, requests with Huffman coding sharing one table
+TEST(HpackTest, RequestExamplesTest) {
+  http::HpackDecoder decoder;
+  bool is_decoded = false;
+  auto fields = DecodeHpackBlock(
+      &decoder, FromHex("8286 8441 8cf1 e3c2 e5f2 3a6b a0ab 90f4 ff"),
+      &is_decoded);
+  EXPECT_TRUE(is_decoded);
+  EXPECT_EQ(fields, HpackFields({{":method", "GET"},
+                                 {":scheme", "http"},
+                                 {":path", "/"},
+                                 {":authority", "www.example.com"}}));
+
+  fields = DecodeHpackBlock(
+      &decoder, FromHex("8286 84be 5886 a8eb 1064 9cbf"), &is_decoded);
+  EXPECT_TRUE(is_decoded);
+  EXPECT_EQ(fields, HpackFields({{":method", "GET"},
+                                 {":scheme", "http"},
+                                 {":path", "/"},
+                                 {":authority", "www.example.com"},
+                                 {"cache-control", "no-cache"}}));
+
+  fields = DecodeHpackBlock(&decoder,
+                            FromHex("8287 85bf 4088 25a8 49e9 5ba9 7d7f 8925 "
+                                    "a849 e95b b8e8 b4bf"),
+                            &is_decoded);
+  EXPECT_TRUE(is_decoded);
+  EXPECT_EQ(fields, HpackFields({{":method", "GET"},
+                                 {":scheme", "https"},
+                                 {":path", "/index.html"},
+                                 {":authority", "www.example.com"},
+                                 {"custom-key", "custom-value"}}));
+}
+
+// RFC 7541 C.6, responses with Huffman coding and a 256 byte table, which
+// makes entries get evicted
+TEST(HpackTest, ResponseExamplesTest) {
+  http::HpackDecoder decoder(256);
+  bool is_decoded = false;
+  auto fields = DecodeHpackBlock(
+      &decoder,
+      FromHex("4882 6402 5885 aec3 771a 4b61 96d0 7abe 9410 54d4 44a8 2005 "
+              "9504 0b81 66e0 82a6 2d1b ff6e 919d 29ad 1718 63c7 8f0b 97c8 "
+              "e9ae 82ae 43d3"),
+      &is_decoded);
+  EXPECT_TRUE(is_decoded);
+  EXPECT_EQ(fields,
+            HpackFields({{":status", "302"},
+                         {"cache-control", "private"},
+                         {"date", "Mon, 21 Oct 2013 20:13:21 GMT"},
+                         {"location", "https://www.example.com"}}));
+
+  fields = DecodeHpackBlock(&decoder, FromHex("4883 640e ffc1 c0bf"),
+                            &is_decoded);
+  EXPECT_TRUE(is_decoded);
+  EXPECT_EQ(fields,
+            HpackFields({{":status", "307"},
+                         {"cache-control", "private"},
+                         {"date", "Mon, 21 Oct 2013 20:13:21 GMT"},
+                         {"location", "https://www.example.com"}}));
+
+  fields = DecodeHpackBlock(
+      &decoder,
+      FromHex("88c1 6196 d07a be94 1054 d444 a820 0595 040b 8166 e084 a62d "
+              "1bff c05a 839b d9ab 77ad 94e7 821d d7f2 e6c7 b335 dfdf cd5b "
+              "3960 d5af 2708 7f36 72c1 ab27 0fb5 291f 9587 3160 65c0 03ed "
+              "4ee5 b106 3d50 07"),
+      &is_decoded);
+  EXPECT_TRUE(is_decoded);
+  EXPECT_EQ(fields,
+            HpackFields({{":status", "200"},
+                         {"cache-control", "private"},
+                         {"date", "Mon, 21 Oct 2013 20:13:22 GMT"},
+                         {"location", "https://www.example.com"},
+                         {"content-encoding", "gzip"},
+                         {"set-cookie",
+                          "foo=ASDJKHQKBZXOQWEOPIUAXQWEOIU; max-age=3600; "
+                          "version=1"}}));
+}
+
+TEST(HpackTest, InvalidBlockTest) {
+  http::HpackDecoder decoder;
+  bool is_decoded = true;
+  // index 70 is in neither table
+  DecodeHpackBlock(&decoder, FromHex("c6"), &is_decoded);
+  EXPECT_FALSE(is_decoded);
+  // a string longer than the block
+  DecodeHpackBlock(&decoder, FromHex("400a 6162"), &is_decoded);
+  EXPECT_FALSE(is_decoded);
+  // a table size update above the size allowed
+  DecodeHpackBlock(&decoder, FromHex("3fe2 1f"), &is_decoded);
+  EXPECT_FALSE(is_decoded);
+}
+
+TEST(HpackTest, EncoderRoundTripTest) {
+  http::HpackEncoder encoder;
+  http::HpackDecoder decoder;
+  std::vector<HpackFields> blocks = {
+      {{":status", "200"},
+       {"content-type", "text/html"},
+       {"x-custom", "first"},
+       {"content-length", "1234"}},
+      {{":status", "200"},
+       {"content-type", "text/html"},
+       {"x-custom", "first"},
+       {"content-length", "99"}},
+      {{":status", "404"},
+       {"x-custom", "second"},
+       {"x-long", std::string(300, 'z')}},
+  };
+  std::size_t first_block_size = 0;
+  for (std::size_t i = 0; i < blocks.size(); i++) {
+    // shrinking the table midway has to be announced in the next block
+    if (i == 2) {
+      encoder.SetMaxTableSize(64);
+    }
+    std::string block;
+    encoder.BeginBlock(&block);
+    for (const auto& [name, value] : blocks[i]) {
+      encoder.Encode(name, value, &block);
+    }
+    if (i == 0) {
+      first_block_size = block.size();
+    } else if (i == 1) {
+      // mostly indexed by now
+      EXPECT_LT(block.size(), first_block_size);
+    }
+    bool is_decoded = false;
+    EXPECT_EQ(DecodeHpackBlock(&decoder, block, &is_decoded), blocks[i]);
+    EXPECT_TRUE(is_decoded);
+  }
+}
+
+}  // namespace test
+}  // namespace arc
+
+#endif
@@ -0,0 +1,232 @@
+/*
+ * File: test_http_parser.h
+ * Project: libarc
+ * File Created: Sunday, 18th October 2026 11:20:37 am
+ * Author: Minjun Xu (mjxu96@outlook.com)
+ * -----
+ * MIT License
+ * Copyright (c) 2020 Minjun Xu
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef LIBARC__TESTS__TEST_HTTP_PARSER_H
+#define LIBARC__TESTS__TEST_HTTP_PARSER_H
+
+#include <arc/http/http_parser.h>
+#include <arc/utils/data_structures/small_vector.h>
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <string>
+#include <string_view>
+
+namespace arc {
+namespace test {
+
+// what a read from the connection does to the buffer
+void ReceiveHttp(http::HttpBuffer* buffer, std::string_view data) {
+  std::memcpy(buffer->PrepareWrite(data.size()), data.data(), data.size());
+  buffer->Commit(data.size());
+}
+
+TEST(HttpParserTest, PipelinedTest) {
+  const std::string first = "GET /first HTTP/1.1\r\nHost: localhost\r\n\r\n";
+  const std::string second =
+      "POST /second?key=value HTTP/1.1\r\nHost: localhost\r\n"
+      "Content-Length: 4\r\n\r\nbody";
+  http::HttpBuffer buffer(1024);
+  ReceiveHttp(&buffer, first + second);
+  http::HttpParser parser(HTTP_REQUEST);
+  http::HttpRequest request;
+
+  EXPECT_EQ(parser.ParseRequest(buffer.Data(), buffer.Size(), &request), 0);
+  EXPECT_TRUE(request.is_complete);
+  EXPECT_EQ(request.method, http::HttpMethod::HTTP_GET);
+  EXPECT_EQ(request.path, "/first");
+  EXPECT_TRUE(request.body.empty());
+  // the second request is left for the next round
+  EXPECT_EQ(parser.GetParsedSize(), first.size());
+
+  buffer.Consume(parser.GetParsedSize());
+  parser.Reset();
+  request.Clear();
+  EXPECT_EQ(parser.ParseRequest(buffer.Data(), buffer.Size(), &request), 0);
+  EXPECT_TRUE(request.is_complete);
+  EXPECT_EQ(request.method, http::HttpMethod::HTTP_POST);
+  EXPECT_EQ(request.method_string, "POST");
+  EXPECT_EQ(request.path, "/second");
+  EXPECT_EQ(request.query_string, "key=value");
+  EXPECT_EQ(request.GetQueries()["key"], "value");
+  EXPECT_EQ(request.headers.size(), 2);
+  EXPECT_EQ(request.body, "body");
+  EXPECT_EQ(parser.GetParsedSize(), second.size());
+}
+
+TEST(HttpParserTest, SplitHeaderTest) {
+  const std::string message =
+      "GET /split HTTP/1.1\r\nHost: localhost\r\n"
+      "X-Split-Header: split-value\r\nContent-Length: 5\r\n\r\nhello";
+  std::size_t split = message.find("Header: split");
+  // small enough for the second read to move the received bytes
+  http::HttpBuffer buffer(split);
+  http::HttpParser parser(HTTP_REQUEST);
+  http::HttpRequest request;
+
+  ReceiveHttp(&buffer, std::string_view(message).substr(0, split));
+  EXPECT_EQ(parser.ParseRequest(buffer.Data(), buffer.Size(), &request), 0);
+  EXPECT_FALSE(request.is_complete);
+  EXPECT_FALSE(parser.IsHeadersComplete());
+
+  const char* old_data = buffer.Data();
+  ReceiveHttp(&buffer, std::string_view(message).substr(split));
+  EXPECT_NE(buffer.Data(), old_data);
+  EXPECT_EQ(parser.ParseRequest(buffer.Data(), buffer.Size(), &request), 0);
+  EXPECT_TRUE(request.is_complete);
+  EXPECT_EQ(request.path, "/split");
+  EXPECT_EQ(request.headers.Get("X-Split-Header"), "split-value");
+  EXPECT_EQ(request.headers.Get("Host"), "localhost");
+  EXPECT_EQ(request.body, "hello");
+  EXPECT_EQ(parser.GetParsedSize(), message.size());
+}
+
+TEST(HttpParserTest, SplitBodyTest) {
+  const std::string message =
+      "PUT /split HTTP/1.1\r\nContent-Length: 11\r\n\r\nhello world";
+  std::size_t split = message.find("lo world");
+  http::HttpBuffer buffer(split);
+  http::HttpParser parser(HTTP_REQUEST);
+  http::HttpRequest request;
+
+  ReceiveHttp(&buffer, std::string_view(message).substr(0, split));
+  EXPECT_EQ(parser.ParseRequest(buffer.Data(), buffer.Size(), &request), 0);
+  EXPECT_FALSE(request.is_complete);
+  EXPECT_TRUE(parser.IsHeadersComplete());
+  EXPECT_EQ(parser.GetExpectedBodySize(), 11);
+
+  ReceiveHttp(&buffer, std::string_view(message).substr(split));
+  EXPECT_EQ(parser.ParseRequest(buffer.Data(), buffer.Size(), &request), 0);
+  EXPECT_TRUE(request.is_complete);
+  EXPECT_EQ(request.method, http::HttpMethod::HTTP_PUT);
+  EXPECT_EQ(request.body, "hello world");
+}
+
+TEST(HttpParserTest, ChunkedBodyTest) {
+  const std::string message =
+      "POST /chunked HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n"
+      "5\r\nhello\r\n1\r\n \r\n5;name=value\r\nworld\r\n0\r\n\r\n";
+  std::size_t split = message.find("orld");
+  http::HttpBuffer buffer(1024);
+  http::HttpParser parser(HTTP_REQUEST);
+  http::HttpRequest request;
+
+  ReceiveHttp(&buffer, std::string_view(message).substr(0, split));
+  EXPECT_EQ(parser.ParseRequest(buffer.Data(), buffer.Size(), &request), 0);
+  EXPECT_FALSE(request.is_complete);
+  ReceiveHttp(&buffer, std::string_view(message).substr(split));
+  EXPECT_EQ(parser.ParseRequest(buffer.Data(), buffer.Size(), &request), 0);
+  EXPECT_TRUE(request.is_complete);
+  EXPECT_EQ(request.body, "hello world");
+  // joined over the chunk headers instead of being copied out
+  EXPECT_GE(request.body.data(), buffer.Data());
+  EXPECT_LE(request.body.data() + request.body.size(),
+            buffer.Data() + buffer.Size());
+  EXPECT_EQ(parser.GetParsedSize(), message.size());
+}
+
+TEST(HttpParserTest, BadRequestTest) {
+  const std::string message = "GET /bad HTTP/1.1\r\nBad Header\r\n\r\n";
+  http::HttpBuffer buffer(1024);
+  ReceiveHttp(&buffer, message);
+  http::HttpParser parser(HTTP_REQUEST);
+  http::HttpRequest request;
+  EXPECT_NE(parser.ParseRequest(buffer.Data(), buffer.Size(), &request), 0);
+  EXPECT_FALSE(request.is_complete);
+}
+
+TEST(HttpFieldsTest, IgnoreCaseTest) {
+  http::HttpHeaders headers;
+  headers.Add("Content-Type", "text/plain");
+  headers.Add("X-Repeated", "first");
+  headers.Add("x-repeated", "second");
+  EXPECT_EQ(headers.Get("content-type"), "text/plain");
+  EXPECT_EQ(headers.Get("CONTENT-TYPE"), "text/plain");
+  EXPECT_TRUE(headers.Contains("cOnTeNt-TyPe"));
+  EXPECT_FALSE(headers.Contains("Content-Typ"));
+  EXPECT_FALSE(headers.Contains("Content-Types"));
+  // the first one wins
+  EXPECT_EQ(headers.Get("X-REPEATED"), "first");
+  EXPECT_EQ(headers.size(), 3);
+
+  http::HttpParams params;
+  params.Add("Id", "1");
+  EXPECT_EQ(params.Get("Id"), "1");
+  EXPECT_FALSE(params.Get("id").has_value());
+
+  EXPECT_TRUE(http::EqualsIgnoreCase("", ""));
+  EXPECT_TRUE(http::EqualsIgnoreCase("Keep-Alive", "keep-alive"));
+  EXPECT_FALSE(http::EqualsIgnoreCase("keep-alive", "keep_alive"));
+}
+
+TEST(SmallVectorTest, GrowTest) {
+  utils::SmallVector<int, 4> vector;
+  EXPECT_TRUE(vector.empty());
+  for (int i = 0; i < 4; i++) {
+    vector.push_back(i);
+  }
+  const int* inline_data = vector.begin();
+  for (int i = 4; i < 100; i++) {
+    vector.push_back(i);
+  }
+  // moved to the heap with all the elements
+  EXPECT_NE(vector.begin(), inline_data);
+  EXPECT_EQ(vector.size(), 100);
+  for (int i = 0; i < 100; i++) {
+    EXPECT_EQ(vector[i], i);
+  }
+  EXPECT_EQ(vector.back(), 99);
+
+  utils::SmallVector<int, 4> copied(vector);
+  EXPECT_EQ(copied.size(), 100);
+  EXPECT_NE(copied.begin(), vector.begin());
+  EXPECT_EQ(copied[50], 50);
+
+  // keeps its heap storage for the next round
+  const int* heap_data = vector.begin();
+  vector.clear();
+  EXPECT_TRUE(vector.empty());
+  for (int i = 0; i < 100; i++) {
+    vector.push_back(-i);
+  }
+  EXPECT_EQ(vector.begin(), heap_data);
+  EXPECT_EQ(vector[99], -99);
+
+  utils::SmallVector<int, 4> assigned;
+  assigned.push_back(1);
+  assigned = copied;
+  EXPECT_EQ(assigned.size(), 100);
+  EXPECT_EQ(assigned[99], 99);
+  assigned = assigned;
+  EXPECT_EQ(assigned.size(), 100);
+}
+
+}  // namespace test
+}  // namespace arc
+
+#endif
@@ -0,0 +1,170 @@
+/*
+ * File: test_http_router.h
+ * Project: libarc
+ * File Created: Sunday, 18th October 2026 12:20:44 pm
+ * Author: Minjun Xu (mjxu96@outlook.com)
+ * -----
+ * MIT License
+ * Copyright (c) 2020 Minjun Xu
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef LIBARC__TESTS__TEST_HTTP_ROUTER_H
+#define LIBARC__TESTS__TEST_HTTP_ROUTER_H
+
+#include <arc/http/http_router.h>
+#include <gtest/gtest.h>
+
+#include <string>
+
+namespace arc {
+namespace test {
+
+// the value routed to, -1 if none
+int FindRoute(const http::HttpRouter<int>& router, http::HttpMethod method,
+              std::string_view path, http::HttpParams* params) {
+  params->clear();
+  const int* value = router.Find(method, path, params);
+  return value ? *value : -1;
+}
+
+TEST(HttpRouterTest, PriorityTest) {
+  http::HttpRouter<int> router;
+  EXPECT_TRUE(router.Insert(HTTP_GET, "/users/me", 0));
+  EXPECT_TRUE(router.Insert(HTTP_GET, "/users/{id}", 1));
+  EXPECT_TRUE(router.Insert(HTTP_GET, "/users/*", 2));
+  EXPECT_TRUE(router.Insert(HTTP_GET, "/users/{id}/posts/{post}", 3));
+  EXPECT_TRUE(router.Insert(HTTP_GET, "/user", 4));
+
+  http::HttpParams params;
+  EXPECT_EQ(FindRoute(router, HTTP_GET, "/users/me", &params), 0);
+  EXPECT_TRUE(params.empty());
+  EXPECT_EQ(FindRoute(router, HTTP_GET, "/users/42", &params), 1);
+  EXPECT_EQ(params.Get("id"), "42");
+  // a prefix of a static segment is a param
+  EXPECT_EQ(FindRoute(router, HTTP_GET, "/users/m", &params), 1);
+  EXPECT_EQ(params.Get("id"), "m");
+  EXPECT_EQ(FindRoute(router, HTTP_GET, "/users/mee", &params), 1);
+  EXPECT_EQ(params.Get("id"), "mee");
+  EXPECT_EQ(FindRoute(router, HTTP_GET, "/users/42/posts/7", &params), 3);
+  EXPECT_EQ(params.size(), 2);
+  EXPECT_EQ(params.Get("id"), "42");
+  EXPECT_EQ(params.Get("post"), "7");
+  EXPECT_EQ(FindRoute(router, HTTP_GET, "/user", &params), 4);
+  // the wildcard takes the rest, slashes included, and may be empty
+  EXPECT_EQ(FindRoute(router, HTTP_GET, "/users/", &params), 2);
+  EXPECT_EQ(params.Get("*"), "");
+  EXPECT_EQ(FindRoute(router, HTTP_GET, "/users/a/b/c", &params), 2);
+  EXPECT_EQ(params.Get("*"), "a/b/c");
+
+  EXPECT_EQ(FindRoute(router, HTTP_GET, "/users", &params), -1);
+  EXPECT_EQ(FindRoute(router, HTTP_GET, "/userss", &params), -1);
+  EXPECT_EQ(FindRoute(router, HTTP_GET, "/", &params), -1);
+  EXPECT_EQ(FindRoute(router, HTTP_GET, "", &params), -1);
+}
+
+TEST(HttpRouterTest, BacktrackTest) {
+  http::HttpRouter<int> router;
+  EXPECT_TRUE(router.Insert(HTTP_GET, "/files/{name}/meta", 0));
+  EXPECT_TRUE(router.Insert(HTTP_GET, "/files/*", 1));
+  EXPECT_TRUE(router.Insert(HTTP_GET, "/static/index.html", 2));
+  EXPECT_TRUE(router.Insert(HTTP_GET, "/static/{file}", 3));
+
+  http::HttpParams params;
+  EXPECT_EQ(FindRoute(router, HTTP_GET, "/files/a/meta", &params), 0);
+  EXPECT_EQ(params.Get("name"), "a");
+  // the param child matches "a" but has nothing for the rest, so the
+  // wildcard above it gets the path without the capture left behind
+  EXPECT_EQ(FindRoute(router, HTTP_GET, "/files/a/data", &params), 1);
+  EXPECT_EQ(params.size(), 1);
+  EXPECT_EQ(params.Get("*"), "a/data");
+  EXPECT_EQ(FindRoute(router, HTTP_GET, "/files/a", &params), 1);
+  EXPECT_EQ(params.Get("*"), "a");
+
+  // from a static child which only matches a prefix back to the param
+  EXPECT_EQ(FindRoute(router, HTTP_GET, "/static/index.html", &params), 2);
+  EXPECT_EQ(FindRoute(router, HTTP_GET, "/static/index.htm", &params), 3);
+  EXPECT_EQ(params.Get("file"), "index.htm");
+  EXPECT_EQ(FindRoute(router, HTTP_GET, "/static/index.html/x", &params), -1);
+}
+
+TEST(HttpRouterTest, MethodTest) {
+  http::HttpRouter<int> router;
+  EXPECT_TRUE(router.Insert(HTTP_GET, "/items/{id}", 0));
+  EXPECT_TRUE(router.Insert(HTTP_PUT, "/items/{id}", 1));
+  EXPECT_TRUE(router.Insert(HTTP_DELETE, "/items/*", 2));
+
+  http::HttpParams params;
+  EXPECT_EQ(FindRoute(router, HTTP_GET, "/items/1", &params), 0);
+  EXPECT_EQ(FindRoute(router, HTTP_PUT, "/items/1", &params), 1);
+  EXPECT_EQ(params.Get("id"), "1");
+  EXPECT_EQ(FindRoute(router, HTTP_DELETE, "/items/1", &params), 2);
+  EXPECT_EQ(params.Get("*"), "1");
+  EXPECT_EQ(FindRoute(router, HTTP_POST, "/items/1", &params), -1);
+
+  // inserting again replaces the value
+  EXPECT_TRUE(router.Insert(HTTP_GET, "/items/{id}", 3));
+  EXPECT_EQ(FindRoute(router, HTTP_GET, "/items/1", &params), 3);
+}
+
+TEST(HttpRouterTest, MalformedTest) {
+  http::HttpRouter<int> router;
+  EXPECT_FALSE(router.Insert(HTTP_GET, "/a/{id", 0));
+  EXPECT_FALSE(router.Insert(HTTP_GET, "/a/{}", 0));
+  EXPECT_FALSE(router.Insert(HTTP_GET, "/a/{id}b", 0));
+  EXPECT_FALSE(router.Insert(HTTP_GET, "/a/*/b", 0));
+  EXPECT_FALSE(router.Insert(HTTP_GET, "/v{ver}", 0));
+  EXPECT_FALSE(router.Insert(HTTP_GET, "/a/b{id}/c", 0));
+  EXPECT_FALSE(router.Insert(HTTP_GET, "/files/a*", 0));
+  EXPECT_FALSE(router.Insert(HTTP_GET, "/a/{id}*", 0));
+
+  // nothing of the rejected ones can be routed to
+  http::HttpParams params;
+  EXPECT_EQ(FindRoute(router, HTTP_GET, "/v1", &params), -1);
+  EXPECT_EQ(FindRoute(router, HTTP_GET, "/files/abc", &params), -1);
+  EXPECT_TRUE(router.Insert(HTTP_GET, "/{id}", 1));
+  EXPECT_TRUE(router.Insert(HTTP_GET, "/a/{id}/*", 2));
+}
+
+TEST(HttpRouterTest, MaxCaptureTest) {
+  constexpr std::size_t kMaxCaptureNum = http::HttpRouter<int>::kMaxCaptureNum;
+  std::string pattern;
+  std::string path;
+  for (std::size_t i = 0; i < kMaxCaptureNum; i++) {
+    pattern += "/{p" + std::to_string(i) + "}";
+    path += "/" + std::to_string(i);
+  }
+  http::HttpRouter<int> router;
+  EXPECT_TRUE(router.Insert(HTTP_GET, pattern, 0));
+  EXPECT_FALSE(router.Insert(HTTP_GET, pattern + "/{one_more}", 1));
+  EXPECT_FALSE(router.Insert(HTTP_GET, pattern + "/*", 2));
+
+  http::HttpParams params;
+  EXPECT_EQ(FindRoute(router, HTTP_GET, path, &params), 0);
+  EXPECT_EQ(params.size(), kMaxCaptureNum);
+  EXPECT_EQ(params.Get("p0"), "0");
+  EXPECT_EQ(params.Get("p31"), "31");
+  EXPECT_EQ(FindRoute(router, HTTP_GET, path + "/32", &params), -1);
+}
+
+}  // namespace test
+}  // namespace arc
+
+#endif
@@ -0,0 +1,526 @@
+/*
+ * File: test_http_server.h
+ * Project: libarc
+ * File Created: Saturday, 17th October 2026 3:12:40 pm
+ * Author: Minjun Xu (mjxu96@outlook.com)
+ * -----
+ * MIT License
+ * Copyright (c) 2020 Minjun Xu
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef LIBARC__TESTS__TEST_HTTP_SERVER_H
+#define LIBARC__TESTS__TEST_HTTP_SERVER_H
+
+#include <arc/coro/eventloop.h>
+#include <arc/coro/task.h>
+#include <arc/http/http_server.h>
+#include <arc/http/http_static.h>
+#include <arc/io/socket.h>
+#include <gtest/gtest.h>
+#include <poll.h>
+#include <sched.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace arc {
+namespace test {
+
+using namespace std::string_view_literals;
+
+using HttpServerTestSocket =
+    io::Socket<net::Domain::IPV4, net::Protocol::TCP, io::Pattern::ASYNC>;
+
+struct HttpWriterTestResult {
+  // what reached the client before the connection was closed
+  std::string sent;
+  bool is_written{true};
+  bool is_finished{false};
+  bool is_started{false};
+};
+
+// writes the body in parts on the server side of a loopback connection, the
+// way a handler does, and finishes it the way the server does
+coro::Task<HttpWriterTestResult> WriteHttpTestResponse(
+    http::HttpResponse* response, bool is_head,
+    std::vector<std::string> parts) {
+  http::HttpServer server;
+  io::Acceptor<net::Domain::IPV4, io::Pattern::ASYNC> acceptor;
+  acceptor.SetOption(arc::net::SocketOption::REUSEADDR, 1);
+  acceptor.Bind({"localhost", 0});
+  acceptor.Listen();
+  HttpServerTestSocket client;
+  co_await client.Connect({"localhost", acceptor.GetLocalAddress().GetPort()});
+
+  HttpWriterTestResult result;
+  {
+    auto socket = co_await acceptor.Accept();
+    http::detail::PipelinedResponses responses;
+    http::HttpResponseWriter writer(&server, &socket, &responses, response,
+                                    is_head);
+    for (const auto& part : parts) {
+      if (!co_await writer.Write(part)) {
+        result.is_written = false;
+        break;
+      }
+    }
+    result.is_started = writer.IsStarted();
+    result.is_finished = co_await writer.Finish();
+  }
+
+  while (true) {
+    char data[4096];
+    auto recv = co_await client.Recv(data, sizeof(data),
+                                     std::chrono::milliseconds(2000));
+    if (recv <= 0) {
+      break;
+    }
+    result.sent.append(data, recv);
+  }
+  co_return result;
+}
+
+// the head and body of a response as the server sends it when the writer
+// has not started
+std::string GetPipelinedTestResponse(http::HttpResponse&& response,
+                                     bool is_head) {
+  http::detail::PipelinedResponses responses;
+  responses.Add(std::move(response), is_head);
+  std::string sent;
+  for (const auto& iov : responses.GetIOVec(0, 1)) {
+    sent.append(static_cast<const char*>(iov.iov_base), iov.iov_len);
+  }
+  return sent;
+}
+
+coro::Task<void> HttpWriterChunkedTest() {
+  http::HttpResponse response;
+  std::vector<std::string> parts = {"hello", "", " world"};
+  auto result = co_await WriteHttpTestResponse(&response, false, parts);
+  EXPECT_TRUE(result.is_written);
+  EXPECT_TRUE(result.is_started);
+  EXPECT_TRUE(result.is_finished);
+  EXPECT_TRUE(result.sent.starts_with("HTTP/1.1 200 OK\r\n"sv));
+  EXPECT_NE(result.sent.find("Transfer-Encoding: chunked\r\n"),
+            std::string::npos);
+  EXPECT_EQ(result.sent.find("Content-Length"), std::string::npos);
+  // the empty part does not end the body early
+  EXPECT_TRUE(result.sent.ends_with(
+      "\r\n\r\n5\r\nhello\r\n6\r\n world\r\n0\r\n\r\n"sv));
+}
+
+coro::Task<void> HttpWriterContentLengthTest() {
+  http::HttpResponse response;
+  response.headers["Content-Length"] = "11";
+  std::vector<std::string> parts = {"hello", " world"};
+  auto result = co_await WriteHttpTestResponse(&response, false, parts);
+  EXPECT_TRUE(result.is_written);
+  EXPECT_TRUE(result.is_finished);
+  EXPECT_EQ(result.sent.find("Transfer-Encoding"), std::string::npos);
+  EXPECT_NE(result.sent.find("Content-Length: 11\r\n"), std::string::npos);
+  EXPECT_TRUE(result.sent.ends_with("\r\n\r\nhello world"sv));
+
+  // not a length, chunked instead
+  response = http::HttpResponse();
+  response.headers["Content-Length"] = "11x";
+  parts = {"hello"};
+  result = co_await WriteHttpTestResponse(&response, false, parts);
+  EXPECT_TRUE(result.is_finished);
+  EXPECT_EQ(result.sent.find("Content-Length"), std::string::npos);
+  EXPECT_TRUE(result.sent.ends_with("\r\n\r\n5\r\nhello\r\n0\r\n\r\n"sv));
+}
+
+coro::Task<void> HttpWriterContentLengthMismatchTest() {
+  // shorter than told, the connection cannot be used any more
+  http::HttpResponse response;
+  response.headers["Content-Length"] = "11";
+  std::vector<std::string> parts = {"hello"};
+  auto result = co_await WriteHttpTestResponse(&response, false, parts);
+  EXPECT_TRUE(result.is_written);
+  EXPECT_FALSE(result.is_finished);
+  EXPECT_TRUE(result.sent.ends_with("\r\n\r\nhello"sv));
+
+  // longer than told, the part that does not fit is not sent
+  response = http::HttpResponse();
+  response.headers["Content-Length"] = "8";
+  parts = {"hello", " world", "!"};
+  result = co_await WriteHttpTestResponse(&response, false, parts);
+  EXPECT_FALSE(result.is_written);
+  EXPECT_FALSE(result.is_finished);
+  EXPECT_TRUE(result.sent.ends_with("\r\n\r\nhello"sv));
+}
+
+coro::Task<void> HttpWriterHttp10Test() {
+  http::HttpResponse response;
+  response.http_minor_version = 0;
+  std::vector<std::string> parts = {"hello", " world"};
+  auto result = co_await WriteHttpTestResponse(&response, false, parts);
+  // collected for the server to send with a Content-Length
+  EXPECT_TRUE(result.is_written);
+  EXPECT_FALSE(result.is_started);
+  EXPECT_TRUE(result.is_finished);
+  EXPECT_EQ(result.sent, "");
+  EXPECT_EQ(response.body, "hello world");
+  std::string sent = GetPipelinedTestResponse(std::move(response), false);
+  EXPECT_TRUE(sent.starts_with("HTTP/1.0 200 OK\r\n"sv));
+  EXPECT_NE(sent.find("Content-Length: 11\r\n"), std::string::npos);
+  EXPECT_EQ(sent.find("Transfer-Encoding"), std::string::npos);
+  EXPECT_TRUE(sent.ends_with("\r\n\r\nhello world"sv));
+}
+
+coro::Task<void> HttpWriterHeadTest() {
+  // the head a GET would get, without the chunks
+  http::HttpResponse response;
+  std::vector<std::string> parts = {"hello", " world"};
+  auto result = co_await WriteHttpTestResponse(&response, true, parts);
+  EXPECT_TRUE(result.is_written);
+  EXPECT_TRUE(result.is_finished);
+  EXPECT_TRUE(result.sent.starts_with("HTTP/1.1 200 OK\r\n"sv));
+  EXPECT_NE(result.sent.find("Transfer-Encoding: chunked\r\n"),
+            std::string::npos);
+  EXPECT_TRUE(result.sent.ends_with("\r\n\r\n"sv));
+  EXPECT_EQ(result.sent.find("hello"), std::string::npos);
+
+  // the length is not checked against the body left out
+  response = http::HttpResponse();
+  response.headers["Content-Length"] = "100";
+  parts = {"hello"};
+  result = co_await WriteHttpTestResponse(&response, true, parts);
+  EXPECT_TRUE(result.is_finished);
+  EXPECT_NE(result.sent.find("Content-Length: 100\r\n"), std::string::npos);
+  EXPECT_TRUE(result.sent.ends_with("\r\n\r\n"sv));
+
+  // HTTP/1.0, the length of the collected body is still told
+  response = http::HttpResponse();
+  response.http_minor_version = 0;
+  parts = {"hello"};
+  result = co_await WriteHttpTestResponse(&response, true, parts);
+  EXPECT_FALSE(result.is_started);
+  EXPECT_EQ(result.sent, "");
+  std::string sent = GetPipelinedTestResponse(std::move(response), true);
+  EXPECT_NE(sent.find("Content-Length: 5\r\n"), std::string::npos);
+  EXPECT_TRUE(sent.ends_with("\r\n\r\n"sv));
+}
+
+// answers with the body of the request, read back from its file if spilled
+coro::Task<void> EchoHttpTestBody(const http::HttpRequest* request,
+                                  http::HttpResponse* response,
+                                  const http::Context* context) {
+  if (request->body_file) {
+    response->headers["X-Spilled"] = "yes";
+    response->body.resize(request->body_file->GetSize());
+    EXPECT_EQ(pread(request->body_file->GetFd(), response->body.data(),
+                    response->body.size(), 0),
+              response->body.size());
+  } else {
+    response->body = request->body;
+  }
+  co_return;
+}
+
+coro::Task<void> ServeHttpTestConnection(
+    http::HttpServer* server,
+    std::shared_ptr<io::Acceptor<net::Domain::IPV4, io::Pattern::ASYNC>>
+        acceptor) {
+  auto socket = co_await acceptor->Accept();
+  co_await server->HandleNewConn(std::move(socket));
+}
+
+// a client connected to server, which echoes request bodies on /echo
+coro::Task<void> ConnectHttpTestServer(http::HttpServer* server,
+                                       HttpServerTestSocket* socket) {
+  server->RegisterHandler("/echo", http::HttpMethod::HTTP_POST,
+                          EchoHttpTestBody);
+  auto acceptor =
+      std::make_shared<io::Acceptor<net::Domain::IPV4, io::Pattern::ASYNC>>();
+  acceptor->SetOption(arc::net::SocketOption::REUSEADDR, 1);
+  acceptor->Bind({"localhost", 0});
+  acceptor->Listen();
+  coro::EnsureFuture(ServeHttpTestConnection(server, acceptor));
+  co_await socket->Connect(
+      {"localhost", acceptor->GetLocalAddress().GetPort()});
+}
+
+// false if the connection is closed or stays quiet before buffer holds end
+coro::Task<bool> ReadHttpTestUntil(HttpServerTestSocket* socket,
+                                   std::string* buffer, std::string_view end) {
+  while (buffer->find(end) == std::string::npos) {
+    char data[4096];
+    auto recv = co_await socket->Recv(data, sizeof(data),
+                                      std::chrono::milliseconds(2000));
+    if (recv <= 0) {
+      co_return false;
+    }
+    buffer->append(data, recv);
+  }
+  co_return true;
+}
+
+coro::Task<bool> SendHttpTestRequest(HttpServerTestSocket* socket,
+                                     std::string_view request) {
+  co_return co_await socket->Send(request.data(), request.size()) ==
+      static_cast<ssize_t>(request.size());
+}
+
+coro::Task<void> HttpServerSpillTest() {
+  http::HttpConfig config;
+  config.max_buffered_body_size = 16;
+  http::HttpServer server(config);
+  HttpServerTestSocket socket;
+  co_await ConnectHttpTestServer(&server, &socket);
+
+  // spilled as soon as the headers are in, with a request pipelined behind
+  std::string body(100, 'a');
+  EXPECT_TRUE(co_await SendHttpTestRequest(
+      &socket,
+      "POST /echo HTTP/1.1\r\nContent-Length: 100\r\n\r\n" +
+          body.substr(0, 10)));
+  co_await coro::SleepFor(std::chrono::milliseconds(50));
+  EXPECT_TRUE(co_await SendHttpTestRequest(
+      &socket, body.substr(10) +
+                   "POST /echo HTTP/1.1\r\nContent-Length: 4\r\n\r\nnext"));
+  std::string buffer;
+  EXPECT_TRUE(co_await ReadHttpTestUntil(&socket, &buffer, "\r\n\r\nnext"));
+  std::size_t second = buffer.find("HTTP/1.1 200 OK\r\n", 1);
+  EXPECT_NE(second, std::string::npos);
+  std::string first = buffer.substr(0, second);
+  EXPECT_NE(first.find("X-Spilled: yes\r\n"), std::string::npos);
+  EXPECT_TRUE(first.ends_with("\r\n\r\n" + body));
+  EXPECT_EQ(buffer.find("X-Spilled", second), std::string::npos);
+}
+
+coro::Task<void> HttpServerChunkedSpillTest() {
+  http::HttpConfig config;
+  config.max_buffered_body_size = 16;
+  http::HttpServer server(config);
+  HttpServerTestSocket socket;
+  co_await ConnectHttpTestServer(&server, &socket);
+
+  // kept in memory at first
+  EXPECT_TRUE(co_await SendHttpTestRequest(
+      &socket,
+      "POST /echo HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n"
+      "5\r\nhello\r\n5\r\nworld\r\n"));
+  co_await coro::SleepFor(std::chrono::milliseconds(50));
+  // spilled in the middle of this chunk, along with the chunks joined before
+  std::string chunk(20, 'b');
+  EXPECT_TRUE(co_await SendHttpTestRequest(&socket,
+                                           "14\r\n" + chunk.substr(0, 10)));
+  co_await coro::SleepFor(std::chrono::milliseconds(50));
+  // the bytes of the next request stay behind the released ones
+  EXPECT_TRUE(co_await SendHttpTestRequest(
+      &socket, chunk.substr(10) + "\r\n0\r\n\r\n" +
+                   "POST /echo HTTP/1.1\r\nContent-Length: 4\r\n\r\nnext"));
+  std::string buffer;
+  EXPECT_TRUE(co_await ReadHttpTestUntil(&socket, &buffer, "\r\n\r\nnext"));
+  std::size_t second = buffer.find("HTTP/1.1 200 OK\r\n", 1);
+  EXPECT_NE(second, std::string::npos);
+  std::string first = buffer.substr(0, second);
+  EXPECT_NE(first.find("X-Spilled: yes\r\n"), std::string::npos);
+  EXPECT_TRUE(first.ends_with("\r\n\r\nhelloworld" + chunk));
+  EXPECT_EQ(buffer.find("X-Spilled", second), std::string::npos);
+}
+
+coro::Task<void> HttpServerContinueTest() {
+  http::HttpConfig config;
+  config.max_request_body_size = 10;
+  http::HttpServer server(config);
+  HttpServerTestSocket socket;
+  co_await ConnectHttpTestServer(&server, &socket);
+
+  EXPECT_TRUE(co_await SendHttpTestRequest(
+      &socket,
+      "POST /echo HTTP/1.1\r\nExpect: 100-continue\r\n"
+      "Content-Length: 5\r\n\r\n"));
+  std::string buffer;
+  EXPECT_TRUE(co_await ReadHttpTestUntil(&socket, &buffer, "\r\n\r\n"));
+  EXPECT_EQ(buffer, "HTTP/1.1 100 Continue\r\n\r\n");
+  buffer.clear();
+  EXPECT_TRUE(co_await SendHttpTestRequest(&socket, "hello"));
+  EXPECT_TRUE(co_await ReadHttpTestUntil(&socket, &buffer, "\r\n\r\nhello"));
+  EXPECT_TRUE(buffer.starts_with("HTTP/1.1 200 OK\r\n"sv));
+
+  // too large, answered without asking for the body
+  buffer.clear();
+  EXPECT_TRUE(co_await SendHttpTestRequest(
+      &socket,
+      "POST /echo HTTP/1.1\r\nExpect: 100-continue\r\n"
+      "Content-Length: 11\r\n\r\n"));
+  EXPECT_TRUE(
+      co_await ReadHttpTestUntil(&socket, &buffer, "413 Payload too large"));
+  EXPECT_TRUE(buffer.starts_with("HTTP/1.1 413 Payload Too Large\r\n"sv));
+  // and closed
+  buffer.clear();
+  EXPECT_FALSE(co_await ReadHttpTestUntil(&socket, &buffer, "HTTP/1.1"));
+  EXPECT_EQ(buffer, "");
+}
+
+coro::Task<void> HttpServerBodyTooLargeTest() {
+  http::HttpConfig config;
+  config.max_request_body_size = 10;
+  http::HttpServer server(config);
+  HttpServerTestSocket socket;
+  co_await ConnectHttpTestServer(&server, &socket);
+
+  // chunked, known to be too large only once the chunks add up
+  EXPECT_TRUE(co_await SendHttpTestRequest(
+      &socket,
+      "POST /echo HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n"
+      "5\r\nhello\r\n"));
+  co_await coro::SleepFor(std::chrono::milliseconds(50));
+  EXPECT_TRUE(co_await SendHttpTestRequest(&socket, "6\r\n world\r\n"));
+  std::string buffer;
+  EXPECT_TRUE(
+      co_await ReadHttpTestUntil(&socket, &buffer, "413 Payload too large"));
+  EXPECT_TRUE(buffer.starts_with("HTTP/1.1 413 Payload Too Large\r\n"sv));
+  // closed, the rest of the body is not read
+  buffer.clear();
+  EXPECT_FALSE(co_await ReadHttpTestUntil(&socket, &buffer, "HTTP/1.1"));
+  EXPECT_EQ(buffer, "");
+}
+
+// whether a connection is waiting to be accepted on fd
+bool IsHttpTestConnPending(int fd) {
+  pollfd poll_fd{.fd = fd, .events = POLLIN, .revents = 0};
+  return poll(&poll_fd, 1, 0) == 1;
+}
+
+// Connections received on cpu, which the thread runs on, go to the second
+// of two listening sockets in a SO_REUSEPORT group. Hashing would give the
+// first one about half of them.
+coro::Task<void> HttpServerCpuSteeringProgramTest(int cpu,
+                                                  bool* is_attached) {
+  http::HttpConfig config;
+  config.working_thread_num = 2;
+  config.worker_cpus = {cpu + 1, cpu};
+  std::vector<std::shared_ptr<
+      io::Acceptor<net::Domain::IPV4, io::Pattern::ASYNC>>>
+      acceptors;
+  std::uint16_t port = 0;
+  for (unsigned int i = 0; i < config.working_thread_num; i++) {
+    auto acceptor = std::make_shared<
+        io::Acceptor<net::Domain::IPV4, io::Pattern::ASYNC>>();
+    acceptor->SetOption(arc::net::SocketOption::REUSEADDR, 1);
+    acceptor->SetOption(arc::net::SocketOption::REUSEPORT, 1);
+    acceptor->Bind({"localhost", port});
+    acceptor->Listen();
+    port = acceptor->GetLocalAddress().GetPort();
+    acceptors.push_back(acceptor);
+  }
+  *is_attached =
+      http::detail::AttachCpuSteeringProgram(acceptors[0]->GetFd(), config);
+  if (!*is_attached) {
+    co_return;
+  }
+
+  std::vector<HttpServerTestSocket> sockets(16);
+  for (auto& socket : sockets) {
+    co_await socket.Connect({"localhost", port});
+    EXPECT_FALSE(IsHttpTestConnPending(acceptors[0]->GetFd()));
+  }
+  EXPECT_TRUE(IsHttpTestConnPending(acceptors[1]->GetFd()));
+}
+
+TEST(HttpResponseWriterTest, ChunkedTest) {
+  coro::StartEventLoop(HttpWriterChunkedTest());
+}
+
+TEST(HttpResponseWriterTest, ContentLengthTest) {
+  coro::StartEventLoop(HttpWriterContentLengthTest());
+}
+
+TEST(HttpResponseWriterTest, ContentLengthMismatchTest) {
+  coro::StartEventLoop(HttpWriterContentLengthMismatchTest());
+}
+
+TEST(HttpResponseWriterTest, Http10Test) {
+  coro::StartEventLoop(HttpWriterHttp10Test());
+}
+
+TEST(HttpResponseWriterTest, HeadTest) {
+  coro::StartEventLoop(HttpWriterHeadTest());
+}
+
+TEST(HttpServerTest, SpillTest) { coro::StartEventLoop(HttpServerSpillTest()); }
+
+TEST(HttpServerTest, ChunkedSpillTest) {
+  coro::StartEventLoop(HttpServerChunkedSpillTest());
+}
+
+TEST(HttpServerTest, ContinueTest) {
+  coro::StartEventLoop(HttpServerContinueTest());
+}
+
+TEST(HttpServerTest, BodyTooLargeTest) {
+  coro::StartEventLoop(HttpServerBodyTooLargeTest());
+}
+
+TEST(HttpServerTest, CpuSteeringTest) {
+  http::HttpConfig config;
+  config.working_thread_num = 4;
+  config.worker_cpus = {2, 3};
+  EXPECT_EQ(http::detail::GetWorkerCpu(config, 3), 3);
+  std::vector<std::pair<int, unsigned int>> expected = {{2, 0}, {3, 1}};
+  EXPECT_EQ(http::detail::GetCpuSteering(config), expected);
+
+  // the first thread pinned to a CPU gets all of its connections
+  config.working_thread_num = 3;
+  config.worker_cpus = {1, 1, 2};
+  expected = {{1, 0}, {2, 2}};
+  EXPECT_EQ(http::detail::GetCpuSteering(config), expected);
+
+  // CPUs without a thread are not steered
+  config.working_thread_num = 1;
+  config.worker_cpus = {4, 5};
+  expected = {{4, 0}};
+  EXPECT_EQ(http::detail::GetCpuSteering(config), expected);
+
+  config.worker_cpus.clear();
+  EXPECT_TRUE(http::detail::GetCpuSteering(config).empty());
+}
+
+TEST(HttpServerTest, CpuSteeringProgramTest) {
+  // loopback connections are received on the CPU they are made on
+  cpu_set_t prev_cpu_set;
+  ASSERT_EQ(sched_getaffinity(0, sizeof(prev_cpu_set), &prev_cpu_set), 0);
+  int cpu = sched_getcpu();
+  ASSERT_GE(cpu, 0);
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  CPU_SET(cpu, &cpu_set);
+  ASSERT_EQ(sched_setaffinity(0, sizeof(cpu_set), &cpu_set), 0);
+  bool is_attached = false;
+  coro::StartEventLoop(HttpServerCpuSteeringProgramTest(cpu, &is_attached));
+  sched_setaffinity(0, sizeof(prev_cpu_set), &prev_cpu_set);
+  if (!is_attached) {
+    GTEST_SKIP() << "SO_ATTACH_REUSEPORT_CBPF is not supported";
+  }
+}
+
+}  // namespace test
+}  // namespace arc
+
+#endif
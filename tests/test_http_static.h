@@ -0,0 +1,268 @@
+/*
+ * File: test_http_static.h
+ * Project: libarc
+ * File Created: Saturday, 17th October 2026 10:26:48 am
+ * Author: Minjun Xu (mjxu96@outlook.com)
+ * -----
+ * MIT License
+ * Copyright (c) 2020 Minjun Xu
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef LIBARC__TESTS__TEST_HTTP_STATIC_H
+#define LIBARC__TESTS__TEST_HTTP_STATIC_H
+
+#include <arc/http/http_static.h>
+#include <fcntl.h>
+#include <gtest/gtest.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+
+namespace arc {
+namespace test {
+
+class HttpStaticTest : public ::testing::Test {
+ protected:
+  std::string root_dir_;
+
+  virtual void SetUp() override {
+    char root_dir[] = "/tmp/libarc_static_XXXXXX";
+    ASSERT_NE(mkdtemp(root_dir), nullptr);
+    root_dir_ = root_dir;
+    WriteFile("index.html", "<html></html>");
+    std::filesystem::create_directory(root_dir_ + "/dir");
+  }
+
+  virtual void TearDown() override { std::filesystem::remove_all(root_dir_); }
+
+  void WriteFile(const std::string& path, const std::string& content) {
+    std::ofstream file(root_dir_ + "/" + path, std::ios::trunc);
+    file << content;
+  }
+
+  // the mtime of the file set to sec and nsec
+  void SetMTime(const std::string& path, time_t sec, long nsec) {
+    timespec times[2] = {{.tv_sec = 0, .tv_nsec = UTIME_OMIT},
+                         {.tv_sec = sec, .tv_nsec = nsec}};
+    ASSERT_EQ(utimensat(AT_FDCWD, (root_dir_ + "/" + path).c_str(), times, 0),
+              0);
+  }
+};
+
+TEST(HttpStaticFunctionTest, DecodePathTest) {
+  EXPECT_EQ(http::detail::DecodePath("a/b.txt"), "a/b.txt");
+  EXPECT_EQ(http::detail::DecodePath("//a/b.txt"), "a/b.txt");
+  EXPECT_EQ(http::detail::DecodePath("a%20b.txt"), "a b.txt");
+  EXPECT_EQ(http::detail::DecodePath("a/..b/c.."), "a/..b/c..");
+
+  // nothing that may leave the root directory
+  EXPECT_EQ(http::detail::DecodePath(""), "");
+  EXPECT_EQ(http::detail::DecodePath("/"), "");
+  EXPECT_EQ(http::detail::DecodePath(".."), "");
+  EXPECT_EQ(http::detail::DecodePath("../etc/passwd"), "");
+  EXPECT_EQ(http::detail::DecodePath("a/../../etc/passwd"), "");
+  EXPECT_EQ(http::detail::DecodePath("a/.."), "");
+  EXPECT_EQ(http::detail::DecodePath("%2e%2e/etc/passwd"), "");
+  EXPECT_EQ(http::detail::DecodePath("a/%2E%2E/%2e%2e/b"), "");
+  EXPECT_EQ(http::detail::DecodePath("%2F..%2Fetc"), "");
+  EXPECT_EQ(http::detail::DecodePath("index.html%00.png"), "");
+  EXPECT_EQ(http::detail::DecodePath("%00"), "");
+}
+
+TEST(HttpStaticFunctionTest, ParseRangeTest) {
+  using http::detail::RangeResult;
+  constexpr std::size_t kFileSize = 100;
+  std::size_t offset = 0;
+  std::size_t length = 0;
+  auto parse = [&](std::string_view range) {
+    offset = 0;
+    length = 0;
+    return http::detail::ParseRange(range, kFileSize, &offset, &length);
+  };
+
+  EXPECT_EQ(parse("bytes=0-9"), RangeResult::SATISFIABLE);
+  EXPECT_EQ(offset, 0);
+  EXPECT_EQ(length, 10);
+  EXPECT_EQ(parse("bytes=50-200"), RangeResult::SATISFIABLE);
+  EXPECT_EQ(offset, 50);
+  EXPECT_EQ(length, 50);
+
+  // open ended
+  EXPECT_EQ(parse("bytes=90-"), RangeResult::SATISFIABLE);
+  EXPECT_EQ(offset, 90);
+  EXPECT_EQ(length, 10);
+
+  // suffix
+  EXPECT_EQ(parse("bytes=-10"), RangeResult::SATISFIABLE);
+  EXPECT_EQ(offset, 90);
+  EXPECT_EQ(length, 10);
+  EXPECT_EQ(parse("bytes=-200"), RangeResult::SATISFIABLE);
+  EXPECT_EQ(offset, 0);
+  EXPECT_EQ(length, kFileSize);
+
+  // out of range
+  EXPECT_EQ(parse("bytes=100-"), RangeResult::UNSATISFIABLE);
+  EXPECT_EQ(parse("bytes=100-200"), RangeResult::UNSATISFIABLE);
+  EXPECT_EQ(parse("bytes=-0"), RangeResult::UNSATISFIABLE);
+  std::size_t empty_offset = 0;
+  std::size_t empty_length = 0;
+  EXPECT_EQ(
+      http::detail::ParseRange("bytes=-1", 0, &empty_offset, &empty_length),
+      RangeResult::UNSATISFIABLE);
+
+  // multiple or malformed ranges are ignored, the whole file is sent
+  EXPECT_EQ(parse("bytes=0-1,5-6"), RangeResult::NONE);
+  EXPECT_EQ(parse("bytes=0-1, 5-"), RangeResult::NONE);
+  EXPECT_EQ(parse("items=0-9"), RangeResult::NONE);
+  EXPECT_EQ(parse("bytes=9-0"), RangeResult::NONE);
+  EXPECT_EQ(parse("bytes=a-9"), RangeResult::NONE);
+  EXPECT_EQ(parse("bytes=0"), RangeResult::NONE);
+  EXPECT_EQ(parse("bytes=-"), RangeResult::NONE);
+}
+
+TEST(HttpStaticFunctionTest, MatchesETagTest) {
+  constexpr std::string_view kETag = "\"1f-2a.0-d\"";
+  EXPECT_TRUE(http::detail::MatchesETag("\"1f-2a.0-d\"", kETag));
+  EXPECT_TRUE(http::detail::MatchesETag("W/\"1f-2a.0-d\"", kETag));
+  EXPECT_TRUE(http::detail::MatchesETag("\"x\", \"1f-2a.0-d\"", kETag));
+  EXPECT_TRUE(http::detail::MatchesETag("\"x\",W/\"1f-2a.0-d\" ", kETag));
+  EXPECT_TRUE(http::detail::MatchesETag("*", kETag));
+  EXPECT_TRUE(http::detail::MatchesETag("\"x\", *", kETag));
+
+  EXPECT_FALSE(http::detail::MatchesETag("", kETag));
+  EXPECT_FALSE(http::detail::MatchesETag("\"x\", \"y\"", kETag));
+  EXPECT_FALSE(http::detail::MatchesETag("1f-2a.0-d", kETag));
+  EXPECT_FALSE(http::detail::MatchesETag("\"1f-2a.0-d", kETag));
+}
+
+TEST_F(HttpStaticTest, FileCacheTest) {
+  http::HttpFileCache cache(root_dir_, 1);
+  auto file = cache.Open("index.html");
+  ASSERT_NE(file, nullptr);
+  EXPECT_EQ(file->GetSize(), 13);
+  EXPECT_EQ(cache.Open("index.html"), file);
+
+  EXPECT_EQ(cache.Open("missing.html"), nullptr);
+  EXPECT_EQ(cache.Open("dir"), nullptr);
+
+  // the least recently used one makes room
+  WriteFile("other.html", "other");
+  EXPECT_NE(cache.Open("other.html"), nullptr);
+  auto reopened_file = cache.Open("index.html");
+  ASSERT_NE(reopened_file, nullptr);
+  EXPECT_NE(reopened_file, file);
+  EXPECT_EQ(reopened_file->GetETag(), file->GetETag());
+
+  // changes are seen once the entry is validated again
+  WriteFile("index.html", "<html>changed</html>");
+  std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+  auto changed_file = cache.Open("index.html");
+  ASSERT_NE(changed_file, nullptr);
+  EXPECT_EQ(changed_file->GetSize(), 20);
+  EXPECT_NE(changed_file->GetETag(), file->GetETag());
+}
+
+TEST_F(HttpStaticTest, ETagTest) {
+  http::HttpFileCache cache(root_dir_, 0);
+  SetMTime("index.html", 1000000000, 100);
+  auto file = cache.Open("index.html");
+  ASSERT_NE(file, nullptr);
+  EXPECT_EQ(cache.Open("index.html")->GetETag(), file->GetETag());
+
+  // written again within the same second, with the same size
+  WriteFile("index.html", "<html>same</>");
+  SetMTime("index.html", 1000000000, 200);
+  auto rewritten_file = cache.Open("index.html");
+  ASSERT_NE(rewritten_file, nullptr);
+  EXPECT_EQ(rewritten_file->GetSize(), file->GetSize());
+  EXPECT_EQ(rewritten_file->GetLastModified(), file->GetLastModified());
+  EXPECT_NE(rewritten_file->GetETag(), file->GetETag());
+
+  // replaced by another file with the same size and mtime
+  WriteFile("replacement.html", "<html>same</>");
+  SetMTime("replacement.html", 1000000000, 200);
+  ASSERT_EQ(std::rename((root_dir_ + "/replacement.html").c_str(),
+                        (root_dir_ + "/index.html").c_str()),
+            0);
+  auto replaced_file = cache.Open("index.html");
+  ASSERT_NE(replaced_file, nullptr);
+  EXPECT_NE(replaced_file->GetETag(), rewritten_file->GetETag());
+}
+
+TEST_F(HttpStaticTest, ServeTest) {
+  http::HttpStaticFiles static_files(root_dir_, 16);
+  http::HttpRequest request;
+  http::HttpResponse response;
+  static_files.Serve(request, "index.html", &response);
+  EXPECT_EQ(response.status, http::HttpStatus::HTTP_STATUS_OK);
+  EXPECT_EQ(response.headers["Content-Length"], "13");
+  EXPECT_EQ(response.headers["Content-Type"], "text/html; charset=utf-8");
+  ASSERT_NE(response.file, nullptr);
+  std::string etag = response.headers["ETag"];
+
+  http::HttpResponse not_modified_response;
+  std::string if_none_match = "\"x\", " + etag;
+  request.headers.Add("If-None-Match", if_none_match);
+  static_files.Serve(request, "index.html", &not_modified_response);
+  EXPECT_EQ(not_modified_response.status,
+            http::HttpStatus::HTTP_STATUS_NOT_MODIFIED);
+  EXPECT_EQ(not_modified_response.file, nullptr);
+
+  http::HttpResponse range_response;
+  request.headers.clear();
+  request.headers.Add("Range", "bytes=-7");
+  static_files.Serve(request, "index.html", &range_response);
+  EXPECT_EQ(range_response.status,
+            http::HttpStatus::HTTP_STATUS_PARTIAL_CONTENT);
+  EXPECT_EQ(range_response.headers["Content-Range"], "bytes 6-12/13");
+  EXPECT_EQ(range_response.file_offset, 6);
+  EXPECT_EQ(range_response.file_length, 7);
+
+  http::HttpResponse stale_range_response;
+  request.headers.Add("If-Range", "\"stale\"");
+  static_files.Serve(request, "index.html", &stale_range_response);
+  EXPECT_EQ(stale_range_response.status, http::HttpStatus::HTTP_STATUS_OK);
+  EXPECT_EQ(stale_range_response.file_length, 13);
+
+  http::HttpResponse unsatisfiable_response;
+  request.headers.clear();
+  request.headers.Add("Range", "bytes=13-");
+  static_files.Serve(request, "index.html", &unsatisfiable_response);
+  EXPECT_EQ(unsatisfiable_response.status,
+            http::HttpStatus::HTTP_STATUS_RANGE_NOT_SATISFIABLE);
+  EXPECT_EQ(unsatisfiable_response.headers["Content-Range"], "bytes */13");
+
+  http::HttpResponse traversal_response;
+  request.headers.clear();
+  static_files.Serve(request, "%2e%2e/index.html", &traversal_response);
+  EXPECT_EQ(traversal_response.status,
+            http::HttpStatus::HTTP_STATUS_NOT_FOUND);
+}
+
+}  // namespace test
+}  // namespace arc
+
+#endif
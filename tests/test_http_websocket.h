@@ -0,0 +1,492 @@
+/*
+ * File: test_http_websocket.h
+ * Project: libarc
+ * File Created: Sunday, 18th October 2026 11:52:09 am
+ * Author: Minjun Xu (mjxu96@outlook.com)
+ * -----
+ * MIT License
+ * Copyright (c) 2020 Minjun Xu
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef LIBARC__TESTS__TEST_HTTP_WEBSOCKET_H
+#define LIBARC__TESTS__TEST_HTTP_WEBSOCKET_H
+
+#include <arc/coro/eventloop.h>
+#include <arc/coro/task.h>
+#include <arc/http/http_server.h>
+#include <arc/http/websocket.h>
+#include <arc/io/socket.h>
+#include <gtest/gtest.h>
+#include <zlib.h>
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "utils.h"
+
+namespace arc {
+namespace test {
+
+using WebSocketTestSocket =
+    io::Socket<net::Domain::IPV4, net::Protocol::TCP, io::Pattern::ASYNC>;
+
+const unsigned char kWebSocketTestMask[4] = {0x37, 0xFA, 0x21, 0x3D};
+
+// a frame as a client sends it
+std::string MakeMaskedWebSocketFrame(http::WebSocketOpcode opcode, bool is_fin,
+                                     bool is_compressed,
+                                     std::string_view payload) {
+  char head[http::detail::kMaxWebSocketFrameHeaderSize];
+  std::size_t head_size = http::detail::WriteWebSocketFrameHeader(
+      opcode, is_fin, is_compressed, payload.size(), head);
+  head[1] |= 0x80;
+  std::string frame(head, head_size);
+  frame.append(reinterpret_cast<const char*>(kWebSocketTestMask), 4);
+  for (std::size_t i = 0; i < payload.size(); i++) {
+    frame.push_back(payload[i] ^ kWebSocketTestMask[i % 4]);
+  }
+  return frame;
+}
+
+TEST(WebSocketTest, AcceptTest) {
+  EXPECT_EQ(http::GetWebSocketAccept("dGhlIHNhbXBsZSBub25jZQ=="),
+            "s3pPLMBiTxaQ9kYGzzhZRbK+xOo=");
+}
+
+TEST(WebSocketTest, FrameHeaderTest) {
+  http::detail::WebSocketFrameHeader header;
+  // the examples of RFC 6455 5.7
+  std::string unmasked = FromHex("8105 4865 6c6c 6f");
+  EXPECT_EQ(http::detail::ParseWebSocketFrameHeader(unmasked.data(),
+                                                    unmasked.size(), &header),
+            2);
+  EXPECT_TRUE(header.is_fin);
+  EXPECT_FALSE(header.is_masked);
+  EXPECT_FALSE(header.is_compressed);
+  EXPECT_FALSE(header.has_reserved_bits);
+  EXPECT_EQ(header.opcode, http::WebSocketOpcode::TEXT);
+  EXPECT_EQ(header.payload_size, 5);
+
+  std::string masked = FromHex("8185 37fa 213d 7f9f 4d51 58");
+  EXPECT_EQ(http::detail::ParseWebSocketFrameHeader(masked.data(),
+                                                    masked.size(), &header),
+            6);
+  EXPECT_TRUE(header.is_masked);
+  EXPECT_EQ(header.payload_size, 5);
+  http::detail::UnmaskWebSocketPayload(masked.data() + 6, 5, header.mask);
+  EXPECT_EQ(masked.substr(6), "Hello");
+
+  std::string fragment = FromHex("0103 48 656c");
+  EXPECT_EQ(http::detail::ParseWebSocketFrameHeader(fragment.data(),
+                                                    fragment.size(), &header),
+            2);
+  EXPECT_FALSE(header.is_fin);
+  EXPECT_EQ(header.opcode, http::WebSocketOpcode::TEXT);
+
+  std::string compressed = FromHex("c107");
+  EXPECT_EQ(http::detail::ParseWebSocketFrameHeader(
+                compressed.data(), compressed.size(), &header),
+            2);
+  EXPECT_TRUE(header.is_compressed);
+  EXPECT_FALSE(header.has_reserved_bits);
+  std::string reserved = FromHex("a100");
+  http::detail::ParseWebSocketFrameHeader(reserved.data(), reserved.size(),
+                                          &header);
+  EXPECT_TRUE(header.has_reserved_bits);
+
+  // 7, 16 and 64 bit lengths, masked and unmasked
+  struct {
+    std::uint64_t payload_size;
+    std::string unmasked;
+  } cases[] = {
+      {125, FromHex("827d")},
+      {256, FromHex("827e 0100")},
+      {65535, FromHex("827e ffff")},
+      {65536, FromHex("827f 0000 0000 0001 0000")},
+      {0x123456789AULL, FromHex("827f 0000 0012 3456 789a")},
+  };
+  for (const auto& [payload_size, expected] : cases) {
+    char head[http::detail::kMaxWebSocketFrameHeaderSize];
+    std::size_t head_size = http::detail::WriteWebSocketFrameHeader(
+        http::WebSocketOpcode::BINARY, true, false, payload_size, head);
+    EXPECT_EQ(std::string(head, head_size), expected);
+
+    EXPECT_EQ(http::detail::ParseWebSocketFrameHeader(
+                  expected.data(), expected.size(), &header),
+              expected.size());
+    EXPECT_EQ(header.opcode, http::WebSocketOpcode::BINARY);
+    EXPECT_FALSE(header.is_masked);
+    EXPECT_EQ(header.payload_size, payload_size);
+    // not all of it yet
+    EXPECT_EQ(http::detail::ParseWebSocketFrameHeader(
+                  expected.data(), expected.size() - 1, &header),
+              0);
+
+    std::string masked_head = expected;
+    masked_head[1] |= 0x80;
+    masked_head += FromHex("0102 0304");
+    EXPECT_EQ(http::detail::ParseWebSocketFrameHeader(
+                  masked_head.data(), masked_head.size(), &header),
+              masked_head.size());
+    EXPECT_TRUE(header.is_masked);
+    EXPECT_EQ(header.payload_size, payload_size);
+    EXPECT_EQ(std::string(reinterpret_cast<const char*>(header.mask), 4),
+              FromHex("0102 0304"));
+    EXPECT_EQ(http::detail::ParseWebSocketFrameHeader(
+                  masked_head.data(), masked_head.size() - 1, &header),
+              0);
+  }
+}
+
+TEST(WebSocketTest, UnmaskTest) {
+  std::string payload;
+  for (int i = 0; i < 300; i++) {
+    payload.push_back(static_cast<char>(i * 7));
+  }
+  // every size around the word boundaries, at every alignment
+  for (std::size_t offset = 0; offset < 8; offset++) {
+    for (std::size_t size = 0; size + offset <= 40; size++) {
+      std::string masked = payload;
+      http::detail::UnmaskWebSocketPayload(masked.data() + offset, size,
+                                           kWebSocketTestMask);
+      for (std::size_t i = 0; i < payload.size(); i++) {
+        char expected = payload[i];
+        if (i >= offset && i < offset + size) {
+          expected ^= kWebSocketTestMask[(i - offset) % 4];
+        }
+        EXPECT_EQ(masked[i], expected);
+      }
+    }
+  }
+  std::string masked = payload;
+  http::detail::UnmaskWebSocketPayload(masked.data(), masked.size(),
+                                       kWebSocketTestMask);
+  http::detail::UnmaskWebSocketPayload(masked.data(), masked.size(),
+                                       kWebSocketTestMask);
+  EXPECT_EQ(masked, payload);
+}
+
+TEST(WebSocketTest, Utf8Test) {
+  EXPECT_TRUE(http::detail::IsValidUtf8(""));
+  EXPECT_TRUE(http::detail::IsValidUtf8("plain ascii, longer than a word"));
+  EXPECT_TRUE(http::detail::IsValidUtf8(
+      FromHex("ceba e1bd b9cf 83ce bcce b5")));  // κόσμε
+  EXPECT_TRUE(http::detail::IsValidUtf8(FromHex("f09d 849e")));  // U+1D11E
+  EXPECT_TRUE(http::detail::IsValidUtf8(FromHex("f48f bfbf")));  // U+10FFFF
+  EXPECT_TRUE(http::detail::IsValidUtf8(FromHex("ed9f bf")));    // U+D7FF
+
+  // overlong encodings of '/'
+  EXPECT_FALSE(http::detail::IsValidUtf8(FromHex("c0af")));
+  EXPECT_FALSE(http::detail::IsValidUtf8(FromHex("e080 af")));
+  EXPECT_FALSE(http::detail::IsValidUtf8(FromHex("f080 80af")));
+  // surrogates
+  EXPECT_FALSE(http::detail::IsValidUtf8(FromHex("eda0 80")));
+  EXPECT_FALSE(http::detail::IsValidUtf8(FromHex("edbf bf")));
+  // beyond U+10FFFF
+  EXPECT_FALSE(http::detail::IsValidUtf8(FromHex("f490 8080")));
+  // cut short, a lone continuation byte and an invalid lead byte
+  EXPECT_FALSE(http::detail::IsValidUtf8(FromHex("e282")));
+  EXPECT_FALSE(http::detail::IsValidUtf8(FromHex("80")));
+  EXPECT_FALSE(http::detail::IsValidUtf8(FromHex("ff")));
+  // behind ASCII skipped a word at a time
+  EXPECT_FALSE(http::detail::IsValidUtf8("0123456789abcdef" +
+                                         FromHex("eda0 80")));
+}
+
+// data as a message compressed with permessage-deflate carries it
+std::string DeflateWebSocketTestMessage(std::string_view data) {
+  z_stream stream{};
+  deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8,
+               Z_DEFAULT_STRATEGY);
+  std::string deflated(deflateBound(&stream, data.size()) + 16, '\0');
+  stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+  stream.avail_in = data.size();
+  stream.next_out = reinterpret_cast<Bytef*>(deflated.data());
+  stream.avail_out = deflated.size();
+  deflate(&stream, Z_SYNC_FLUSH);
+  deflated.resize(deflated.size() - stream.avail_out);
+  deflateEnd(&stream);
+  // without the empty block of the flush
+  EXPECT_TRUE(deflated.ends_with(FromHex("0000 ffff")));
+  deflated.resize(deflated.size() - 4);
+  return deflated;
+}
+
+// the data of a message compressed with permessage-deflate
+std::string InflateWebSocketTestMessage(std::string_view data) {
+  std::string input = std::string(data) + FromHex("0000 ffff");
+  z_stream stream{};
+  inflateInit2(&stream, -MAX_WBITS);
+  std::string inflated(65536, '\0');
+  stream.next_in = reinterpret_cast<Bytef*>(input.data());
+  stream.avail_in = input.size();
+  stream.next_out = reinterpret_cast<Bytef*>(inflated.data());
+  stream.avail_out = inflated.size();
+  inflate(&stream, Z_SYNC_FLUSH);
+  inflated.resize(inflated.size() - stream.avail_out);
+  inflateEnd(&stream);
+  return inflated;
+}
+
+struct WebSocketTestFrame {
+  http::detail::WebSocketFrameHeader header;
+  std::string payload;
+};
+
+// the next whole frame from the server, std::nullopt if none arrives in time
+coro::Task<std::optional<WebSocketTestFrame>> ReadWebSocketFrame(
+    WebSocketTestSocket* socket, std::string* buffer) {
+  while (true) {
+    WebSocketTestFrame frame;
+    std::size_t head_size = http::detail::ParseWebSocketFrameHeader(
+        buffer->data(), buffer->size(), &frame.header);
+    if (head_size > 0 &&
+        buffer->size() - head_size >= frame.header.payload_size) {
+      frame.payload = buffer->substr(head_size, frame.header.payload_size);
+      buffer->erase(0, head_size + frame.header.payload_size);
+      co_return frame;
+    }
+    char data[4096];
+    auto recv = co_await socket->Recv(data, sizeof(data),
+                                      std::chrono::milliseconds(2000));
+    if (recv <= 0) {
+      co_return std::nullopt;
+    }
+    buffer->append(data, recv);
+  }
+}
+
+// echoes every message till the connection is closed
+coro::Task<void> ServeWebSocket(
+    http::HttpServer* server,
+    io::Acceptor<net::Domain::IPV4, io::Pattern::ASYNC>* acceptor,
+    int* message_count) {
+  auto socket = co_await acceptor->Accept();
+  http::WebSocket websocket(server, &socket, std::string_view(), true);
+  while (true) {
+    auto message = co_await websocket.Receive();
+    if (!message) {
+      break;
+    }
+    (*message_count)++;
+    co_await websocket.Send(message->data, message->opcode);
+  }
+}
+
+coro::Task<void> WebSocketEchoTest() {
+  http::HttpServer server;
+  io::Acceptor<net::Domain::IPV4, io::Pattern::ASYNC> acceptor;
+  acceptor.SetOption(arc::net::SocketOption::REUSEADDR, 1);
+  acceptor.Bind({"localhost", 0});
+  acceptor.Listen();
+  int message_count = 0;
+  coro::EnsureFuture(ServeWebSocket(&server, &acceptor, &message_count));
+
+  WebSocketTestSocket socket;
+  co_await socket.Connect({"localhost", acceptor.GetLocalAddress().GetPort()});
+  std::string buffer;
+
+  // a fragmented message with a ping in between
+  std::string frames =
+      MakeMaskedWebSocketFrame(http::WebSocketOpcode::TEXT, false, false,
+                               "frag") +
+      MakeMaskedWebSocketFrame(http::WebSocketOpcode::PING, true, false,
+                               "ping") +
+      MakeMaskedWebSocketFrame(http::WebSocketOpcode::CONTINUATION, false,
+                               false, "mented ") +
+      MakeMaskedWebSocketFrame(http::WebSocketOpcode::CONTINUATION, true,
+                               false, "message");
+  EXPECT_EQ(co_await socket.Send(frames.data(), frames.size()), frames.size());
+  auto frame = co_await ReadWebSocketFrame(&socket, &buffer);
+  EXPECT_TRUE(frame.has_value());
+  if (!frame) {
+    co_return;
+  }
+  EXPECT_EQ(frame->header.opcode, http::WebSocketOpcode::PONG);
+  EXPECT_EQ(frame->payload, "ping");
+  frame = co_await ReadWebSocketFrame(&socket, &buffer);
+  EXPECT_TRUE(frame.has_value());
+  if (!frame) {
+    co_return;
+  }
+  EXPECT_EQ(frame->header.opcode, http::WebSocketOpcode::TEXT);
+  EXPECT_TRUE(frame->header.is_fin);
+  EXPECT_FALSE(frame->header.is_masked);
+  EXPECT_FALSE(frame->header.is_compressed);
+  EXPECT_EQ(frame->payload, "fragmented message");
+
+  // compressed both ways
+  std::string text;
+  for (int i = 0; i < 100; i++) {
+    text += "permessage-deflate " + std::to_string(i) + " ";
+  }
+  std::string compressed = MakeMaskedWebSocketFrame(
+      http::WebSocketOpcode::TEXT, true, true,
+      DeflateWebSocketTestMessage(text));
+  EXPECT_EQ(co_await socket.Send(compressed.data(), compressed.size()),
+            compressed.size());
+  frame = co_await ReadWebSocketFrame(&socket, &buffer);
+  EXPECT_TRUE(frame.has_value());
+  if (!frame) {
+    co_return;
+  }
+  EXPECT_EQ(frame->header.opcode, http::WebSocketOpcode::TEXT);
+  EXPECT_TRUE(frame->header.is_compressed);
+  EXPECT_LT(frame->payload.size(), text.size());
+  EXPECT_EQ(InflateWebSocketTestMessage(frame->payload), text);
+
+  // a 16 bit length
+  std::string binary(60, '\xFF');
+  binary += std::string(200, '\x01');
+  std::string binary_frame = MakeMaskedWebSocketFrame(
+      http::WebSocketOpcode::BINARY, true, false, binary);
+  EXPECT_EQ(co_await socket.Send(binary_frame.data(), binary_frame.size()),
+            binary_frame.size());
+  frame = co_await ReadWebSocketFrame(&socket, &buffer);
+  EXPECT_TRUE(frame.has_value());
+  if (!frame) {
+    co_return;
+  }
+  EXPECT_EQ(frame->header.opcode, http::WebSocketOpcode::BINARY);
+  if (frame->header.is_compressed) {
+    frame->payload = InflateWebSocketTestMessage(frame->payload);
+  }
+  EXPECT_EQ(frame->payload, binary);
+
+  // a surrogate fails the connection
+  std::string invalid = MakeMaskedWebSocketFrame(
+      http::WebSocketOpcode::TEXT, true, false, "bad " + FromHex("eda0 80"));
+  EXPECT_EQ(co_await socket.Send(invalid.data(), invalid.size()),
+            invalid.size());
+  frame = co_await ReadWebSocketFrame(&socket, &buffer);
+  EXPECT_TRUE(frame.has_value());
+  if (!frame) {
+    co_return;
+  }
+  EXPECT_EQ(frame->header.opcode, http::WebSocketOpcode::CLOSE);
+  EXPECT_EQ(frame->payload, FromHex("03ef"));  // 1007
+  EXPECT_EQ(message_count, 3);
+}
+
+coro::Task<void> WebSocketCloseTest(std::string close_payload,
+                                    std::string expected_payload) {
+  http::HttpServer server;
+  io::Acceptor<net::Domain::IPV4, io::Pattern::ASYNC> acceptor;
+  acceptor.SetOption(arc::net::SocketOption::REUSEADDR, 1);
+  acceptor.Bind({"localhost", 0});
+  acceptor.Listen();
+  int message_count = 0;
+  coro::EnsureFuture(ServeWebSocket(&server, &acceptor, &message_count));
+
+  WebSocketTestSocket socket;
+  co_await socket.Connect({"localhost", acceptor.GetLocalAddress().GetPort()});
+  std::string close = MakeMaskedWebSocketFrame(http::WebSocketOpcode::CLOSE,
+                                               true, false, close_payload);
+  EXPECT_EQ(co_await socket.Send(close.data(), close.size()), close.size());
+  std::string buffer;
+  auto frame = co_await ReadWebSocketFrame(&socket, &buffer);
+  EXPECT_TRUE(frame.has_value());
+  if (!frame) {
+    co_return;
+  }
+  EXPECT_EQ(frame->header.opcode, http::WebSocketOpcode::CLOSE);
+  EXPECT_EQ(frame->payload, expected_payload);
+}
+
+coro::Task<void> WebSocketIdleTest() {
+  http::HttpConfig config;
+  config.websocket_idle_timeout_ms = 50;
+  http::HttpServer server(config);
+  io::Acceptor<net::Domain::IPV4, io::Pattern::ASYNC> acceptor;
+  acceptor.SetOption(arc::net::SocketOption::REUSEADDR, 1);
+  acceptor.Bind({"localhost", 0});
+  acceptor.Listen();
+  int message_count = 0;
+  coro::EnsureFuture(ServeWebSocket(&server, &acceptor, &message_count));
+
+  WebSocketTestSocket socket;
+  co_await socket.Connect({"localhost", acceptor.GetLocalAddress().GetPort()});
+  std::string buffer;
+  // kept open by answering the ping
+  auto frame = co_await ReadWebSocketFrame(&socket, &buffer);
+  EXPECT_TRUE(frame.has_value());
+  if (!frame) {
+    co_return;
+  }
+  EXPECT_EQ(frame->header.opcode, http::WebSocketOpcode::PING);
+  std::string pong = MakeMaskedWebSocketFrame(http::WebSocketOpcode::PONG,
+                                              true, false, frame->payload);
+  EXPECT_EQ(co_await socket.Send(pong.data(), pong.size()), pong.size());
+  frame = co_await ReadWebSocketFrame(&socket, &buffer);
+  EXPECT_TRUE(frame.has_value());
+  if (!frame) {
+    co_return;
+  }
+  EXPECT_EQ(frame->header.opcode, http::WebSocketOpcode::PING);
+
+  // closed once the next ping goes unanswered
+  frame = co_await ReadWebSocketFrame(&socket, &buffer);
+  EXPECT_TRUE(frame.has_value());
+  if (!frame) {
+    co_return;
+  }
+  EXPECT_EQ(frame->header.opcode, http::WebSocketOpcode::CLOSE);
+  EXPECT_EQ(frame->payload, FromHex("03e9"));  // 1001
+  EXPECT_EQ(message_count, 0);
+}
+
+TEST(WebSocketTest, EchoTest) { coro::StartEventLoop(WebSocketEchoTest()); }
+
+TEST(WebSocketTest, CloseCodeTest) {
+  EXPECT_TRUE(http::detail::IsValidWebSocketCloseCode(1000));
+  EXPECT_TRUE(http::detail::IsValidWebSocketCloseCode(1003));
+  EXPECT_TRUE(http::detail::IsValidWebSocketCloseCode(1007));
+  EXPECT_TRUE(http::detail::IsValidWebSocketCloseCode(1014));
+  EXPECT_TRUE(http::detail::IsValidWebSocketCloseCode(3000));
+  EXPECT_TRUE(http::detail::IsValidWebSocketCloseCode(4999));
+  EXPECT_FALSE(http::detail::IsValidWebSocketCloseCode(0));
+  EXPECT_FALSE(http::detail::IsValidWebSocketCloseCode(999));
+  EXPECT_FALSE(http::detail::IsValidWebSocketCloseCode(1004));
+  EXPECT_FALSE(http::detail::IsValidWebSocketCloseCode(1005));
+  EXPECT_FALSE(http::detail::IsValidWebSocketCloseCode(1006));
+  EXPECT_FALSE(http::detail::IsValidWebSocketCloseCode(1015));
+  EXPECT_FALSE(http::detail::IsValidWebSocketCloseCode(2999));
+  EXPECT_FALSE(http::detail::IsValidWebSocketCloseCode(5000));
+
+  // echoed if valid, 1002 otherwise
+  coro::StartEventLoop(WebSocketCloseTest(FromHex("03e8"), FromHex("03e8")));
+  coro::StartEventLoop(
+      WebSocketCloseTest(FromHex("0fa0") + "bye", FromHex("0fa0")));
+  coro::StartEventLoop(WebSocketCloseTest("", ""));
+  coro::StartEventLoop(WebSocketCloseTest(FromHex("03ed"), FromHex("03ea")));
+  coro::StartEventLoop(WebSocketCloseTest(FromHex("03ee"), FromHex("03ea")));
+  coro::StartEventLoop(WebSocketCloseTest(FromHex("03f7"), FromHex("03ea")));
+  coro::StartEventLoop(WebSocketCloseTest(FromHex("1388"), FromHex("03ea")));
+}
+
+TEST(WebSocketTest, IdleTest) { coro::StartEventLoop(WebSocketIdleTest()); }
+
+}  // namespace test
+}  // namespace arc
+
+#endif
@@ -30,9 +30,19 @@
 #include "test_coro_cancel.h"
 #include "test_coro_dispatcher.h"
 #include "test_coro_executor.h"
+#include "test_coro_generator.h"
 #include "test_coro_lock.h"
+#include "test_coro_poller.h"
 #include "test_coro_socket.h"
+#include "test_coro_task_group.h"
 #include "test_coro_timeout.h"
+#include "test_http_h2c.h"
+#include "test_http_hpack.h"
+#include "test_http_parser.h"
+#include "test_http_router.h"
+#include "test_http_server.h"
+#include "test_http_static.h"
+#include "test_http_websocket.h"
 
 int main(int argc, char** argv) {
   ::testing::InitGoogleTest(&argc, argv);
@@ -33,6 +33,7 @@
 #include <cstring>
 #include <functional>
 #include <string>
+#include <string_view>
 
 namespace arc {
 namespace test {
@@ -67,6 +68,26 @@ int GetElapsedTimeMilliseconds(const std::function<void()>& function) {
   return elapsed;
 }
 
+// the bytes spelled by pairs of hex digits, spaces are skipped
+std::string FromHex(std::string_view hex) {
+  std::string bytes;
+  int high = -1;
+  for (char c : hex) {
+    if (c == ' ') {
+      continue;
+    }
+    int digit = (c >= 'a') ? (c - 'a' + 10) : (c >= 'A') ? (c - 'A' + 10)
+                                                          : (c - '0');
+    if (high < 0) {
+      high = digit;
+    } else {
+      bytes.push_back(static_cast<char>(high * 16 + digit));
+      high = -1;
+    }
+  }
+  return bytes;
+}
+
 int& GetThreadLocalCounter() {
   thread_local int counter;
   return counter;